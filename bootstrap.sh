@@ -19,9 +19,10 @@ mkdir -p "$dst"
 cp -Rnp "$src"/. "$dst"/
 
 # Ensure runtime-only subdirs exist (they may ship empty).
-for d in etc plrobjs plralias house \
+for d in etc plrobjs plralias plrbundles house \
          plrobjs/A-E plrobjs/F-J plrobjs/K-O plrobjs/P-T plrobjs/U-Z plrobjs/ZZZ \
-         plralias/A-E plralias/F-J plralias/K-O plralias/P-T plralias/U-Z plralias/ZZZ; do
+         plralias/A-E plralias/F-J plralias/K-O plralias/P-T plralias/U-Z plralias/ZZZ \
+         plrbundles/A-E plrbundles/F-J plrbundles/K-O plrbundles/P-T plrbundles/U-Z plrbundles/ZZZ; do
     mkdir -p "$dst/$d"
 done
 mkdir -p log
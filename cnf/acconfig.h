@@ -7,6 +7,9 @@
 /* Define if libcivetweb is available for the embedded web server.  */
 #undef HAVE_CIVETWEB
 
+/* Define if POSIX threads are available for background workers.  */
+#undef HAVE_PTHREAD
+
 /* Define if we don't have proper support for the system's crypt().  */
 #undef HAVE_UNSAFE_CRYPT
 
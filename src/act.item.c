@@ -797,6 +797,7 @@ void name_from_drinkcon(struct obj_data *obj)
   if (GET_OBJ_RNUM(obj) == NOTHING || obj->name != obj_proto[GET_OBJ_RNUM(obj)].name)
     free(obj->name);
   obj->name = new_name;
+  keyword_index_obj(obj);
 }
 
 
@@ -815,6 +816,7 @@ void name_to_drinkcon(struct obj_data *obj, int type)
     free(obj->name);
 
   obj->name = new_name;
+  keyword_index_obj(obj);
 }
 
 
@@ -1551,6 +1553,8 @@ static void eqset_load(struct char_data *ch, char *name)
     return;
   }
 
+  affect_batch_begin(ch);
+
   /* Phase 1: unequip everything we can */
   for (i = 0; i < NUM_WEARS; i++) {
     if ((obj = GET_EQ(ch, i)) == NULL)
@@ -1587,6 +1591,8 @@ static void eqset_load(struct char_data *ch, char *name)
     }
   }
 
+  affect_batch_end(ch);
+
   send_to_char(ch, "Equipment set '%s' loaded.\r\n", name);
 }
 
@@ -23,6 +23,7 @@
 #include "screen.h"
 #include "house.h"
 #include "constants.h"
+#include "webserver.h"
 
 /* extern variables */
 extern struct spell_info_type spell_info[];
@@ -83,6 +84,7 @@ ACMD(do_quit)
   } else {
     act("$n has left the game.", TRUE, ch, 0, 0, TO_ROOM);
     mudlog(NRM, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE, "%s has quit the game.", GET_NAME(ch));
+    webserver_feed_logout(ch, "quit");
     send_to_char(ch, "Goodbye, friend.. Come back soon!\r\n");
 
     /*  We used to check here for duping attempts, but we may as well
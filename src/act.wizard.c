@@ -23,6 +23,8 @@
 #include "constants.h"
 #include "olc.h"
 #include "gmcp.h"
+#include "pwhash.h"
+#include "mccp.h"
 
 /*   external vars  */
 extern FILE *player_fl;
@@ -33,6 +35,7 @@ extern int circle_shutdown, circle_reboot;
 extern int circle_restrict;
 extern int load_into_inventory;
 extern int buf_switches, buf_largecount, buf_overflows;
+extern int conn_accepted, conn_rejected;
 extern int top_of_p_table;
 
 /* for chars */
@@ -1913,10 +1916,11 @@ size_t print_zone_to_buf(char *bufptr, size_t left, zone_rnum zone)
   else
     buf[0] = '\0';
   return snprintf(bufptr, left,
-	"%3d %-30.30s Age: %3d; Reset: %3d (%1d); Empty: %3d; Range: %5d-%5d %s\r\n",
+	"%3d %-30.30s Age: %3d; Reset: %3d (%1d); Empty: %3d; %-7s Range: %5d-%5d %s\r\n",
 	zone_table[zone].number, zone_table[zone].name,
 	zone_table[zone].age, zone_table[zone].lifespan,
 	zone_table[zone].reset_mode, zone_table[zone].empty_age,
+	zone_table[zone].dormant ? "Dormant" : "Active",
 	zone_table[zone].bot, zone_table[zone].top, buf);
 }
 
@@ -2058,14 +2062,18 @@ ACMD(do_show)
 	"  %5d objects          %5d prototypes\r\n"
 	"  %5d rooms            %5d zones\r\n"
 	"  %5d large bufs\r\n"
-	"  %5d buf switches     %5d overflows\r\n",
+	"  %5d buf switches     %5d overflows\r\n"
+	"  %5d connections in   %5d turned away\r\n"
+	"  %5d compressing      %lu KB in, %lu KB out\r\n",
 	i, con,
 	top_of_p_table + 1,
 	j, top_of_mobt + 1,
 	k, top_of_objt + 1,
 	top_of_world + 1, top_of_zone_table + 1,
 	buf_largecount,
-	buf_switches, buf_overflows
+	buf_switches, buf_overflows,
+	conn_accepted, conn_rejected,
+	mccp_streams, mccp_bytes_in / 1024, mccp_bytes_out / 1024
 	);
     break;
 
@@ -2509,8 +2517,8 @@ int perform_set(struct char_data *ch, struct char_data *vict, int mode,
       send_to_char(ch, "You cannot change that.\r\n");
       return (0);
     }
-    strncpy(GET_PASSWD(vict), CRYPT(val_arg, GET_NAME(vict)), MAX_PWD_LENGTH);	/* strncpy: OK (G_P:MAX_PWD_LENGTH) */
-    *(GET_PASSWD(vict) + MAX_PWD_LENGTH) = '\0';
+    /* Not CRYPT(): the password workers may be using crypt() right now. */
+    pwhash(val_arg, GET_NAME(vict), GET_PASSWD(vict), MAX_PWD_LENGTH + 1);
     send_to_char(ch, "Password changed to '%s'.\r\n", val_arg);
     break;
   case 46:
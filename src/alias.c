@@ -15,6 +15,7 @@
 #include "utils.h"
 #include "interpreter.h"
 #include "db.h"
+#include "bundle.h"
 
 void write_aliases(struct char_data *ch);
 void read_aliases(struct char_data *ch);
@@ -26,13 +27,13 @@ void write_aliases(struct char_data *ch)
   char fn[MAX_STRING_LENGTH];
   struct alias_data *temp;
 
-  get_filename(fn, sizeof(fn), ALIAS_FILE, GET_NAME(ch));
-  remove(fn);
-
-  if (GET_ALIASES(ch) == NULL)
+  if (GET_ALIASES(ch) == NULL) {
+    plrfile_remove(ALIAS_FILE, GET_NAME(ch));
     return;
+  }
 
-  if ((file = fopen(fn, "w")) == NULL) {
+  if ((file = plrfile_open(ALIAS_FILE, GET_NAME(ch), "w")) == NULL) {
+    plrfile_path(fn, sizeof(fn), ALIAS_FILE, GET_NAME(ch));
     log("SYSERR: Couldn't save aliases for %s in '%s'.", GET_NAME(ch), fn);
     perror("SYSERR: write_aliases");
     return;
@@ -50,7 +51,7 @@ void write_aliases(struct char_data *ch)
 		temp->type);
   }
 
-  fclose(file);
+  plrfile_close(file);
 }
 
 void read_aliases(struct char_data *ch)
@@ -60,10 +61,9 @@ void read_aliases(struct char_data *ch)
   struct alias_data *t2, *prev = NULL;
   int length;
 
-  get_filename(xbuf, sizeof(xbuf), ALIAS_FILE, GET_NAME(ch));
-
-  if ((file = fopen(xbuf, "r")) == NULL) {
+  if ((file = plrfile_open(ALIAS_FILE, GET_NAME(ch), "r")) == NULL) {
     if (errno != ENOENT) {
+      plrfile_path(xbuf, sizeof(xbuf), ALIAS_FILE, GET_NAME(ch));
       log("SYSERR: Couldn't open alias file '%s' for %s.", xbuf, GET_NAME(ch));
       perror("SYSERR: read_aliases");
     }
@@ -107,7 +107,7 @@ void read_aliases(struct char_data *ch)
     t2 = t2->next;
   };
 
-  fclose(file);
+  plrfile_close(file);
   return;
 
 read_alias_error:
@@ -116,16 +116,11 @@ read_alias_error:
   free(t2);
   if (prev)
     prev->next = NULL;
-  fclose(file);
+  plrfile_close(file);
 }
 
 void delete_aliases(const char *charname)
 {
-  char filename[PATH_MAX];
-
-  if (!get_filename(filename, sizeof(filename), ALIAS_FILE, charname))
-    return;
-
-  if (remove(filename) < 0 && errno != ENOENT)
-    log("SYSERR: deleting alias file %s: %s", filename, strerror(errno));
+  if (plrfile_remove(ALIAS_FILE, charname) < 0 && errno != ENOENT)
+    log("SYSERR: deleting alias file for %s: %s", charname, strerror(errno));
 }
@@ -11,6 +11,11 @@
 #include "conf.h"
 #include "sysdep.h"
 
+#if defined(CIRCLE_UNIX)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#endif
 
 #include "structs.h"
 #include "utils.h"
@@ -25,6 +30,9 @@ struct ban_list_element *ban_list = NULL;
 /* local functions */
 void load_banned(void);
 int isbanned(char *hostname);
+void unban_all(void);
+void ban_benchmark(void);
+void circle_srandom(unsigned long initial_seed);
 void _write_one_node(FILE *fp, struct ban_list_element *node);
 void write_ban_list(void);
 ACMD(do_ban);
@@ -43,6 +51,515 @@ const char *ban_types[] = {
 };
 
 
+/*
+ * isbanned() used to strstr() the site against every ban in turn, on
+ * every connection and at every login.  The bans are now filed by kind:
+ *
+ *   1.2.3.4, 1.2.3., 1.2, 1.2.3.0/24	IPv4 ranges (partial addresses
+ *					cover whole octets)
+ *   2001:db8::/32			IPv6 ranges
+ *   example.com			that name and everything under it
+ *   .example.com			only names under it
+ *
+ * Addresses go in a radix tree per family and names in a tree of labels
+ * read from the right, so a lookup costs one walk down each and finds
+ * every ban that covers the site.  Anything else ("dialup", "aol.") is
+ * still matched as a substring of the name, as before.  As ever, the
+ * most severe matching ban wins.
+ */
+
+#define BAN_KEY_V4	0
+#define BAN_KEY_V6	1
+#define BAN_KEY_NAME	2
+#define BAN_KEY_LOOSE	3
+
+struct ban_key {
+  int kind;
+  unsigned char addr[16];	/* BAN_KEY_V4, BAN_KEY_V6 */
+  int bits;
+  const char *name;		/* BAN_KEY_NAME: no leading dot */
+  int below;			/* BAN_KEY_NAME: only names under it */
+};
+
+struct ban_radix {
+  unsigned char key[16];	/* zero past 'bits' */
+  int bits;
+  int count[BAN_ALL + 1];	/* bans of each type on exactly this range */
+  struct ban_radix *child[2];
+};
+
+struct ban_label {
+  const struct ban_label *parent;	/* NULL for a top-level domain */
+  char *label;
+  unsigned int hash;
+  int self[BAN_ALL + 1];	/* bans on this name (and what's under it) */
+  int below[BAN_ALL + 1];	/* bans on only what's under it */
+  int children;
+  struct ban_label *next;	/* hash chain */
+};
+
+struct ban_index {
+  struct ban_radix *v4, *v6;
+  struct ban_label **labels;
+  int label_size, label_count;
+  struct ban_list_element **loose;
+  int num_loose, max_loose;
+};
+
+static struct ban_index ban_index;
+
+
+/* The most severe type with any bans, or BAN_NOT. */
+static int ban_top(const int *count)
+{
+  int i;
+
+  for (i = BAN_ALL; i > BAN_NOT; i--)
+    if (count[i] > 0)
+      return (i);
+  return (BAN_NOT);
+}
+
+
+/* "1.2.3.4", "1.2.3." or "1.2" (whole octets), optionally "/bits". */
+static int ban_parse_v4(const char *site, unsigned char *addr, int *bits)
+{
+  int parts = 0, val, digits;
+  const char *p = site;
+
+  memset(addr, 0, 16);
+  if (!strchr(site, '.'))	/* "123" is just a substring. */
+    return (FALSE);
+  while (*p && *p != '/') {
+    for (val = 0, digits = 0; isdigit((unsigned char) *p); p++, digits++)
+      if ((val = val * 10 + (*p - '0')) > 255)
+	return (FALSE);
+    if (!digits || parts == 4)
+      return (FALSE);
+    addr[parts++] = val;
+    if (*p == '.')
+      p++;
+    else if (*p && *p != '/')
+      return (FALSE);
+  }
+  if (!parts)
+    return (FALSE);
+
+  *bits = parts * 8;
+  if (*p == '/') {
+    if (parts != 4 || !isdigit((unsigned char) p[1]))
+      return (FALSE);
+    *bits = atoi(p + 1);
+    for (p++; isdigit((unsigned char) *p); p++);
+    if (*p || *bits > 32)
+      return (FALSE);
+  }
+  return (TRUE);
+}
+
+
+static int ban_parse_v6(const char *site, unsigned char *addr, int *bits)
+{
+#if defined(CIRCLE_UNIX) && defined(AF_INET6)
+  char buf[BANNED_SITE_LENGTH + 1], *slash;
+
+  if (!strchr(site, ':'))
+    return (FALSE);
+
+  strlcpy(buf, site, sizeof(buf));
+  *bits = 128;
+  if ((slash = strchr(buf, '/')) != NULL) {
+    *slash++ = '\0';
+    if (!isdigit((unsigned char) *slash) || (*bits = atoi(slash)) > 128)
+      return (FALSE);
+  }
+  return (inet_pton(AF_INET6, buf, addr) == 1);
+#else
+  return (FALSE);
+#endif
+}
+
+
+/* Dotted labels of letters, digits and hyphens, at least two of them. */
+static int ban_parse_name(const char *site)
+{
+  const char *p;
+  int len = 0, dots = 0;
+
+  for (p = site; *p; p++) {
+    if (*p == '.') {
+      if (!len)
+	return (FALSE);
+      len = 0;
+      dots++;
+    } else if (isalnum((unsigned char) *p) || *p == '-' || *p == '_')
+      len++;
+    else
+      return (FALSE);
+  }
+  return (len && dots);
+}
+
+
+static void ban_parse(const char *site, struct ban_key *key)
+{
+  memset(key, 0, sizeof(*key));
+
+  if (ban_parse_v4(site, key->addr, &key->bits))
+    key->kind = BAN_KEY_V4;
+  else if (ban_parse_v6(site, key->addr, &key->bits))
+    key->kind = BAN_KEY_V6;
+  else if (ban_parse_name(site + (*site == '.'))) {
+    key->kind = BAN_KEY_NAME;
+    key->below = (*site == '.');
+    key->name = site + key->below;
+  } else
+    key->kind = BAN_KEY_LOOSE;
+}
+
+
+static int ban_bit(const unsigned char *addr, int bit)
+{
+  return ((addr[bit >> 3] >> (7 - (bit & 7))) & 1);
+}
+
+
+/* How many leading bits a and b share, up to max. */
+static int ban_common_bits(const unsigned char *a, const unsigned char *b, int max)
+{
+  int bit = 0;
+
+  while (bit + 8 <= max && a[bit >> 3] == b[bit >> 3])
+    bit += 8;
+  while (bit < max && ban_bit(a, bit) == ban_bit(b, bit))
+    bit++;
+  return (bit);
+}
+
+
+static struct ban_radix *ban_radix_node(const unsigned char *addr, int bits)
+{
+  struct ban_radix *n;
+  int i;
+
+  CREATE(n, struct ban_radix, 1);
+  n->bits = bits;
+  for (i = 0; i < bits; i++)
+    if (ban_bit(addr, i))
+      n->key[i >> 3] |= 1 << (7 - (i & 7));
+  return (n);
+}
+
+
+static void ban_radix_add(struct ban_radix **pp, const unsigned char *addr, int bits, int type)
+{
+  struct ban_radix *n, *glue, *leaf;
+  int common;
+
+  while ((n = *pp) != NULL) {
+    common = ban_common_bits(addr, n->key, MIN(bits, n->bits));
+    if (common < n->bits) {
+      leaf = ban_radix_node(addr, bits);
+      leaf->count[type]++;
+      if (common == bits)		/* The new range holds n. */
+	leaf->child[ban_bit(n->key, bits)] = n;
+      else {			/* They part ways at 'common'. */
+	glue = ban_radix_node(addr, common);
+	glue->child[ban_bit(n->key, common)] = n;
+	glue->child[ban_bit(addr, common)] = leaf;
+	leaf = glue;
+      }
+      *pp = leaf;
+      return;
+    }
+    if (n->bits == bits) {
+      n->count[type]++;
+      return;
+    }
+    pp = &n->child[ban_bit(addr, n->bits)];
+  }
+  *pp = ban_radix_node(addr, bits);
+  (*pp)->count[type]++;
+}
+
+
+/* Take one ban off; nodes left with nothing to do are spliced out. */
+static int ban_radix_remove(struct ban_radix **pp, const unsigned char *addr, int bits, int type)
+{
+  struct ban_radix *n = *pp;
+
+  if (!n || n->bits > bits || ban_common_bits(addr, n->key, n->bits) < n->bits)
+    return (FALSE);
+
+  if (n->bits == bits) {
+    if (n->count[type] <= 0)
+      return (FALSE);
+    n->count[type]--;
+  } else if (!ban_radix_remove(&n->child[ban_bit(addr, n->bits)], addr, bits, type))
+    return (FALSE);
+
+  if (ban_top(n->count) == BAN_NOT && (!n->child[0] || !n->child[1])) {
+    *pp = n->child[0] ? n->child[0] : n->child[1];
+    free(n);
+  }
+  return (TRUE);
+}
+
+
+static int ban_radix_lookup(const struct ban_radix *n, const unsigned char *addr, int bits)
+{
+  int type = BAN_NOT;
+
+  while (n && n->bits <= bits && ban_common_bits(addr, n->key, n->bits) == n->bits) {
+    type = MAX(type, ban_top(n->count));
+    if (n->bits == bits)
+      break;
+    n = n->child[ban_bit(addr, n->bits)];
+  }
+  return (type);
+}
+
+
+static int ban_radix_count(const struct ban_radix *n)
+{
+  return (n ? 1 + ban_radix_count(n->child[0]) + ban_radix_count(n->child[1]) : 0);
+}
+
+
+static void ban_radix_free(struct ban_radix *n)
+{
+  if (n) {
+    ban_radix_free(n->child[0]);
+    ban_radix_free(n->child[1]);
+    free(n);
+  }
+}
+
+
+static unsigned int ban_label_hash(const struct ban_label *parent, const char *label, size_t len)
+{
+  unsigned int h = (unsigned int) ((unsigned long) parent >> 4) * 2654435761U;
+
+  while (len--)
+    h = (h ^ (unsigned char) LOWER(*label++)) * 16777619U;
+  return (h);
+}
+
+
+static struct ban_label *ban_label_find(struct ban_index *idx, const struct ban_label *parent,
+		const char *label, size_t len)
+{
+  struct ban_label *l;
+  unsigned int h;
+
+  if (!idx->label_size)
+    return (NULL);
+
+  h = ban_label_hash(parent, label, len);
+  for (l = idx->labels[h & (idx->label_size - 1)]; l; l = l->next)
+    if (l->hash == h && l->parent == parent && !strncmp(l->label, label, len) && !l->label[len])
+      return (l);
+  return (NULL);
+}
+
+
+static struct ban_label *ban_label_add(struct ban_index *idx, struct ban_label *parent,
+		const char *label, size_t len)
+{
+  struct ban_label *l, *next, **table;
+  int i, size;
+
+  if ((l = ban_label_find(idx, parent, label, len)) != NULL)
+    return (l);
+
+  if (idx->label_count >= idx->label_size) {
+    size = idx->label_size ? idx->label_size * 2 : 256;
+    CREATE(table, struct ban_label *, size);
+    for (i = 0; i < idx->label_size; i++)
+      for (l = idx->labels[i]; l; l = next) {
+	next = l->next;
+	l->next = table[l->hash & (size - 1)];
+	table[l->hash & (size - 1)] = l;
+      }
+    if (idx->labels)
+      free(idx->labels);
+    idx->labels = table;
+    idx->label_size = size;
+  }
+
+  CREATE(l, struct ban_label, 1);
+  l->parent = parent;
+  CREATE(l->label, char, len + 1);
+  for (i = 0; i < (int) len; i++)
+    l->label[i] = LOWER(label[i]);
+  l->hash = ban_label_hash(parent, label, len);
+  l->next = idx->labels[l->hash & (idx->label_size - 1)];
+  idx->labels[l->hash & (idx->label_size - 1)] = l;
+  idx->label_count++;
+  if (parent)
+    parent->children++;
+  return (l);
+}
+
+
+/* Drop labels that no longer hold any bans, from l upwards. */
+static void ban_label_prune(struct ban_index *idx, struct ban_label *l)
+{
+  struct ban_label *parent, **prev;
+
+  while (l && !l->children && ban_top(l->self) == BAN_NOT && ban_top(l->below) == BAN_NOT) {
+    for (prev = &idx->labels[l->hash & (idx->label_size - 1)]; *prev != l; prev = &(*prev)->next);
+    *prev = l->next;
+    idx->label_count--;
+    parent = (struct ban_label *) l->parent;
+    if (parent)
+      parent->children--;
+    free(l->label);
+    free(l);
+    l = parent;
+  }
+}
+
+
+/*
+ * Walk a name's labels from the right.  With create, the labels are
+ * added as needed and the last one is returned; otherwise the most
+ * severe ban covering the name is.
+ */
+static struct ban_label *ban_label_walk(struct ban_index *idx, const char *name,
+		int create, int *type)
+{
+  const char *end = name + strlen(name), *p;
+  struct ban_label *l = NULL, *next;
+
+  if (end > name && end[-1] == '.')	/* "example.com." */
+    end--;
+
+  while (end > name) {
+    for (p = end; p > name && p[-1] != '.'; p--);
+    if (create)
+      next = ban_label_add(idx, l, p, end - p);
+    else if (!(next = ban_label_find(idx, l, p, end - p)))
+      break;
+    l = next;
+    if (type) {
+      *type = MAX(*type, ban_top(l->self));
+      if (p > name)		/* Still more to the left. */
+	*type = MAX(*type, ban_top(l->below));
+    }
+    end = (p > name ? p - 1 : name);
+  }
+  return (l);
+}
+
+
+static void ban_index_add(struct ban_index *idx, struct ban_list_element *b)
+{
+  struct ban_key key;
+  struct ban_label *l;
+
+  ban_parse(b->site, &key);
+  switch (key.kind) {
+  case BAN_KEY_V4:
+    ban_radix_add(&idx->v4, key.addr, key.bits, b->type);
+    break;
+  case BAN_KEY_V6:
+    ban_radix_add(&idx->v6, key.addr, key.bits, b->type);
+    break;
+  case BAN_KEY_NAME:
+    l = ban_label_walk(idx, key.name, TRUE, NULL);
+    if (key.below)
+      l->below[b->type]++;
+    else
+      l->self[b->type]++;
+    break;
+  default:
+    if (idx->num_loose >= idx->max_loose) {
+      idx->max_loose = MAX(16, idx->max_loose * 2);
+      RECREATE(idx->loose, struct ban_list_element *, idx->max_loose);
+    }
+    idx->loose[idx->num_loose++] = b;
+    break;
+  }
+}
+
+
+static void ban_index_remove(struct ban_index *idx, struct ban_list_element *b)
+{
+  struct ban_key key;
+  struct ban_label *l;
+  int i;
+
+  ban_parse(b->site, &key);
+  switch (key.kind) {
+  case BAN_KEY_V4:
+    ban_radix_remove(&idx->v4, key.addr, key.bits, b->type);
+    break;
+  case BAN_KEY_V6:
+    ban_radix_remove(&idx->v6, key.addr, key.bits, b->type);
+    break;
+  case BAN_KEY_NAME:
+    if (!(l = ban_label_walk(idx, key.name, FALSE, NULL)))
+      break;
+    if (key.below)
+      l->below[b->type] = MAX(0, l->below[b->type] - 1);
+    else
+      l->self[b->type] = MAX(0, l->self[b->type] - 1);
+    ban_label_prune(idx, l);
+    break;
+  default:
+    for (i = 0; i < idx->num_loose; i++)
+      if (idx->loose[i] == b) {
+	idx->loose[i] = idx->loose[--idx->num_loose];
+	break;
+      }
+    break;
+  }
+}
+
+
+/* host must already be in lower case. */
+static int ban_index_lookup(struct ban_index *idx, const char *host)
+{
+  unsigned char addr[16];
+  int type = BAN_NOT, bits, i;
+
+  if (ban_parse_v4(host, addr, &bits) && bits == 32)
+    type = ban_radix_lookup(idx->v4, addr, 32);
+  else if (ban_parse_v6(host, addr, &bits) && bits == 128)
+    type = ban_radix_lookup(idx->v6, addr, 128);
+  else if (idx->label_count)
+    ban_label_walk(idx, host, FALSE, &type);
+
+  for (i = 0; i < idx->num_loose && type < BAN_ALL; i++)
+    if (strstr(host, idx->loose[i]->site))
+      type = MAX(type, idx->loose[i]->type);
+
+  return (type);
+}
+
+
+static void ban_index_free(struct ban_index *idx)
+{
+  struct ban_label *l, *next;
+  int i;
+
+  ban_radix_free(idx->v4);
+  ban_radix_free(idx->v6);
+  for (i = 0; i < idx->label_size; i++)
+    for (l = idx->labels[i]; l; l = next) {
+      next = l->next;
+      free(l->label);
+      free(l);
+    }
+  if (idx->labels)
+    free(idx->labels);
+  if (idx->loose)
+    free(idx->loose);
+  memset(idx, 0, sizeof(*idx));
+}
+
+
 void load_banned(void)
 {
   FILE *fl;
@@ -52,6 +569,7 @@ void load_banned(void)
   struct ban_list_element *next_node;
 
   ban_list = 0;
+  ban_index_free(&ban_index);
 
   if (!(fl = fopen(BAN_FILE, "r"))) {
     if (errno != ENOENT) {
@@ -72,8 +590,12 @@ void load_banned(void)
       if (!strcmp(ban_type, ban_types[i]))
 	next_node->type = i;
 
+    for (i = 0; next_node->site[i]; i++)
+      next_node->site[i] = LOWER(next_node->site[i]);
+
     next_node->next = ban_list;
     ban_list = next_node;
+    ban_index_add(&ban_index, next_node);
   }
 
   fclose(fl);
@@ -82,22 +604,23 @@ void load_banned(void)
 
 int isbanned(char *hostname)
 {
-  int i;
-  struct ban_list_element *banned_node;
   char *nextchar;
 
   if (!hostname || !*hostname)
     return (0);
 
-  i = 0;
   for (nextchar = hostname; *nextchar; nextchar++)
     *nextchar = LOWER(*nextchar);
 
-  for (banned_node = ban_list; banned_node; banned_node = banned_node->next)
-    if (strstr(hostname, banned_node->site))	/* if hostname is a substring */
-      i = MAX(i, banned_node->type);
+  return (ban_index_lookup(&ban_index, hostname));
+}
+
 
-  return (i);
+/* SIGUSR2: forget every ban (the list itself is left to leak, as ever). */
+void unban_all(void)
+{
+  ban_list = NULL;
+  ban_index_free(&ban_index);
 }
 
 
@@ -194,6 +717,7 @@ ACMD(do_ban)
 
   ban_node->next = ban_list;
   ban_list = ban_node;
+  ban_index_add(&ban_index, ban_node);
 
   mudlog(NRM, MAX(LVL_GOD, GET_INVIS_LEV(ch)), TRUE, "%s has banned %s for %s players.",
 	GET_NAME(ch), site, ban_types[ban_node->type]);
@@ -227,6 +751,7 @@ ACMD(do_unban)
     return;
   }
   REMOVE_FROM_LIST(ban_node, ban_list, next);
+  ban_index_remove(&ban_index, ban_node);
   send_to_char(ch, "Site unbanned.\r\n");
   mudlog(NRM, MAX(LVL_GOD, GET_INVIS_LEV(ch)), TRUE, "%s removed the %s-player ban on %s.",
 	GET_NAME(ch), ban_types[ban_node->type], ban_node->site);
@@ -313,3 +838,166 @@ void Read_Invalid_List(void)
 
   fclose(fp);
 }
+
+
+/*
+ * circle -b: time isbanned() against the old substring scan over a
+ * made-up list of 50,000 bans, and check every answer against a plain
+ * scan that matches the same way the index does.
+ */
+#define BENCH_BANS	50000
+#define BENCH_LOOSE	20
+#define BENCH_LOOKUPS	200000
+#define BENCH_CHECKED	2000
+#define BENCH_HOST	(BANNED_SITE_LENGTH + 16)
+
+static int ban_bench_match(const struct ban_key *key, const struct ban_list_element *b,
+		const char *host)
+{
+  unsigned char addr[16];
+  size_t hlen, nlen;
+  int bits;
+
+  switch (key->kind) {
+  case BAN_KEY_V4:
+    return (ban_parse_v4(host, addr, &bits) && bits == 32 &&
+	    ban_common_bits(addr, key->addr, key->bits) == key->bits);
+  case BAN_KEY_V6:
+    return (ban_parse_v6(host, addr, &bits) && bits == 128 &&
+	    ban_common_bits(addr, key->addr, key->bits) == key->bits);
+  case BAN_KEY_NAME:
+    if (ban_parse_v4(host, addr, &bits) && bits == 32)
+      return (FALSE);
+    hlen = strlen(host);
+    nlen = strlen(key->name);
+    if (hlen == nlen)
+      return (!key->below && !strcmp(host, key->name));
+    return (hlen > nlen && host[hlen - nlen - 1] == '.' && !strcmp(host + hlen - nlen, key->name));
+  default:
+    return (strstr(host, b->site) != NULL);
+  }
+}
+
+
+static void ban_bench_site(char *buf, size_t len, int i)
+{
+  int a = rand_number(1, 223), b = rand_number(0, 255), c = rand_number(0, 255);
+
+  switch (i % 10) {
+  case 0: case 1: case 2: case 3:
+    snprintf(buf, len, "%d.%d.%d.%d", a, b, c, rand_number(0, 255));
+    break;
+  case 4: case 5:
+    snprintf(buf, len, "%d.%d.%d.", a, b, c);
+    break;
+  case 6:
+    snprintf(buf, len, "2001:db8:%x:%x::/64", b, c);
+    break;
+  case 7: case 8:
+    snprintf(buf, len, "host%d.isp%d.net", i, b);
+    break;
+  default:
+    snprintf(buf, len, ".pool%d.isp%d.com", i, b);
+    break;
+  }
+}
+
+
+static void ban_bench_host(char *buf, size_t len, struct ban_list_element *bans, int nbans)
+{
+  const char *site = bans[rand_number(0, nbans - 1)].site;
+  int covered = rand_number(0, 1);
+
+  if (covered && isdigit((unsigned char) *site) && site[strlen(site) - 1] == '.')
+    snprintf(buf, len, "%s%d", site, rand_number(0, 255));
+  else if (covered && isdigit((unsigned char) *site))
+    strlcpy(buf, site, len);
+  else if (covered && strchr(site, ':'))
+    snprintf(buf, len, "%.*s%x", (int) (strchr(site, '/') - site), site, rand_number(1, 65535));
+  else if (covered && *site == '.')
+    snprintf(buf, len, "dsl%d%s", rand_number(1, 9999), site);
+  else if (covered)
+    strlcpy(buf, site, len);
+  else if (rand_number(0, 1))
+    snprintf(buf, len, "%d.%d.%d.%d", rand_number(1, 223), rand_number(0, 255), rand_number(0, 255), rand_number(0, 255));
+  else
+    snprintf(buf, len, "user%d.dialup%d.example.org", rand_number(1, 99999), rand_number(0, BENCH_LOOSE * 2));
+}
+
+
+void ban_benchmark(void)
+{
+  struct ban_index idx;
+  struct ban_list_element *bans;
+  struct ban_key *keys;
+  struct timeval start, mid, end;
+  char *hosts;
+  long found_new = 0, found_old = 0, differ = 0;
+  int i, j, type, ref;
+  double t_build, t_new, t_old;
+
+  memset(&idx, 0, sizeof(idx));
+  circle_srandom(1);	/* The same list every time. */
+  CREATE(bans, struct ban_list_element, BENCH_BANS);
+  CREATE(keys, struct ban_key, BENCH_BANS);
+  CREATE(hosts, char, BENCH_LOOKUPS * BENCH_HOST);
+
+  for (i = 0; i < BENCH_BANS; i++) {
+    if (i < BENCH_LOOSE)
+      snprintf(bans[i].site, sizeof(bans[i].site), "dialup%d.", i);
+    else
+      ban_bench_site(bans[i].site, sizeof(bans[i].site), i);
+    bans[i].type = rand_number(BAN_NEW, BAN_ALL);
+    ban_parse(bans[i].site, &keys[i]);
+  }
+  for (i = 0; i < BENCH_LOOKUPS; i++)
+    ban_bench_host(hosts + i * BENCH_HOST, BENCH_HOST, bans, BENCH_BANS);
+
+  gettimeofday(&start, NULL);
+  for (i = 0; i < BENCH_BANS; i++)
+    ban_index_add(&idx, &bans[i]);
+  gettimeofday(&mid, NULL);
+  t_build = (mid.tv_sec - start.tv_sec) * 1e3 + (mid.tv_usec - start.tv_usec) / 1e3;
+
+  gettimeofday(&start, NULL);
+  for (i = 0; i < BENCH_LOOKUPS; i++)
+    found_new += (ban_index_lookup(&idx, hosts + i * BENCH_HOST) != BAN_NOT);
+  gettimeofday(&mid, NULL);
+  for (i = 0; i < BENCH_CHECKED; i++)
+    for (type = BAN_NOT, j = 0; j < BENCH_BANS; j++)
+      if (strstr(hosts + i * BENCH_HOST, bans[j].site))
+	type = MAX(type, bans[j].type);
+  gettimeofday(&end, NULL);
+
+  t_new = (mid.tv_sec - start.tv_sec) * 1e9 + (mid.tv_usec - start.tv_usec) * 1e3;
+  t_old = (end.tv_sec - mid.tv_sec) * 1e9 + (end.tv_usec - mid.tv_usec) * 1e3;
+
+  for (i = 0; i < BENCH_CHECKED; i++) {
+    for (ref = BAN_NOT, j = 0; j < BENCH_BANS; j++)
+      if (ban_bench_match(&keys[j], &bans[j], hosts + i * BENCH_HOST))
+	ref = MAX(ref, bans[j].type);
+    found_old += (ref != BAN_NOT);
+    if (ref != ban_index_lookup(&idx, hosts + i * BENCH_HOST))
+      differ++;
+  }
+
+  log("Ban benchmark: %d bans (%d v4 nodes, %d names, %d substrings), built in %.1f ms.",
+	BENCH_BANS, ban_radix_count(idx.v4), idx.label_count, idx.num_loose, t_build);
+  log("  substring scan: %10.1f ns/lookup (%d lookups)", t_old / BENCH_CHECKED, BENCH_CHECKED);
+  log("  ban index:      %10.1f ns/lookup (%d lookups, %ld banned)", t_new / BENCH_LOOKUPS, BENCH_LOOKUPS, found_new);
+  if (differ)
+    log("SYSERR: ban index and a full scan disagree on %ld of %d sites.", differ, BENCH_CHECKED);
+  else
+    log("  ban index agrees with a full scan on %d sites (%ld banned).", BENCH_CHECKED, found_old);
+
+  /* Taking them all back out should leave nothing behind. */
+  for (i = 0; i < BENCH_BANS; i++)
+    ban_index_remove(&idx, &bans[i]);
+  if (idx.v4 || idx.v6 || idx.label_count || idx.num_loose)
+    log("SYSERR: ban index not empty after removing every ban.");
+
+  ban_index_free(&idx);
+  free(hosts);
+  free(keys);
+  free(bans);
+}
@@ -0,0 +1,444 @@
+/* ************************************************************************
+*   File: bench.c                                       Part of CircleMUD *
+*  Usage: main() for bin/circle-bench, the game run without sockets       *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+/*
+ * circle-bench boots the world just as the game does, logs in a crowd of
+ * players that have no connection behind them, and runs the heartbeat
+ * flat out for a fixed number of pulses.  Every so many pulses each
+ * player types the next line of a script, which goes through the same
+ * process_commands() as real input, and their output is counted and
+ * thrown away.  When it's done it prints one line of JSON to stdout:
+ * pulses per second, the time spent in each stage of the pulse and how
+ * many allocations were made, so that runs before and after a change can
+ * be compared.  The log goes to stderr.
+ */
+
+#define CIRCLE_BENCH
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "interpreter.h"
+#include "handler.h"
+#include "db.h"
+#include "bench.h"
+
+/* external variables */
+extern FILE *logfile;
+extern const char *DFLT_DIR;
+extern int auto_save;
+extern int no_rent_check;
+extern long top_idnum;
+extern struct txt_block *bufpool;
+extern const char *circlemud_version;
+
+/* external functions */
+void boot_db(void);
+void heartbeat(int pulse);
+void process_commands(void);
+char *make_prompt(struct descriptor_data *d);
+void nanny(struct descriptor_data *d, char *arg);
+
+/* local functions */
+int main(int argc, char **argv);
+static void bench_usage(const char *prog);
+static void bench_read_script(const char *filename);
+static struct descriptor_data *bench_player(int num, int fd);
+static void bench_enter(struct descriptor_data *d);
+static void bench_output(void);
+static void bench_report(int pulses, int players, double secs);
+
+#define BENCH_PULSES	3000		/* five minutes of game time */
+#define BENCH_PLAYERS	100
+#define BENCH_INTERVAL	(2 RL_SEC)	/* pulses between a player's commands */
+
+/*
+ * What the players type unless given a script: a walk from the temple
+ * down to the market and back, with a little of everything on the way
+ * and a go at the blob that lives in the market.
+ */
+static const char *bench_default_script[] = {
+  "look",
+  "south",
+  "who",
+  "say Hello there.",
+  "south",
+  "kill blob",
+  "score",
+  "consider cityguard",
+  "inventory",
+  "north",
+  "equipment",
+  "time",
+  "north",
+  "exits",
+  "where",
+  NULL
+};
+
+static const char *bench_stage_names[NUM_BENCH_STAGES] = {
+  "input",
+  "zone",
+  "idle_passwords",
+  "mobile",
+  "mobile_entry",
+  "violence",
+  "who",
+  "hourly",
+  "autosave",
+  "usage",
+  "olc",
+  "crash_sweep",
+  "extract",
+  "output"
+};
+
+static struct {
+  long calls;
+  long long usec;
+} bench_stages[NUM_BENCH_STAGES];
+
+static char **bench_script;
+static int bench_script_len;
+static long bench_commands = 0, bench_output_bytes = 0, bench_entries = 0;
+
+
+/*
+ * Allocation counts.  glibc lets us put our own malloc() in front of
+ * its own; under AddressSanitizer, which has its own, we don't count.
+ */
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__)
+#define BENCH_ALLOCS
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+static long bench_mallocs = 0, bench_reallocs = 0, bench_frees = 0;
+static long long bench_alloc_bytes = 0;
+
+void *malloc(size_t size)
+{
+  __atomic_add_fetch(&bench_mallocs, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&bench_alloc_bytes, size, __ATOMIC_RELAXED);
+  return (__libc_malloc(size));
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+  __atomic_add_fetch(&bench_mallocs, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&bench_alloc_bytes, nmemb * size, __ATOMIC_RELAXED);
+  return (__libc_calloc(nmemb, size));
+}
+
+void *realloc(void *ptr, size_t size)
+{
+  __atomic_add_fetch(ptr ? &bench_reallocs : &bench_mallocs, 1, __ATOMIC_RELAXED);
+  __atomic_add_fetch(&bench_alloc_bytes, size, __ATOMIC_RELAXED);
+  return (__libc_realloc(ptr, size));
+}
+
+void free(void *ptr)
+{
+  if (ptr)
+    __atomic_add_fetch(&bench_frees, 1, __ATOMIC_RELAXED);
+  __libc_free(ptr);
+}
+#endif
+
+
+void bench_stage_begin(struct timeval *start)
+{
+  gettimeofday(start, NULL);
+}
+
+
+void bench_stage_end(int stage, struct timeval *start)
+{
+  struct timeval end;
+
+  gettimeofday(&end, NULL);
+  bench_stages[stage].calls++;
+  bench_stages[stage].usec += (end.tv_sec - start->tv_sec) * 1000000LL + (end.tv_usec - start->tv_usec);
+}
+
+
+int main(int argc, char **argv)
+{
+  struct descriptor_data **players, *d;
+  struct timeval start, end;
+  FILE *devnull;
+  const char *dir = DFLT_DIR, *script = NULL, *arg = NULL;
+  int pulses = BENCH_PULSES, num_players = BENCH_PLAYERS;
+  int interval = BENCH_INTERVAL, seed = 1, pos = 1, pulse, i, opt;
+#ifdef BENCH_ALLOCS
+  long mallocs, reallocs, frees;
+  long long alloc_bytes;
+#endif
+
+  while (pos < argc && *argv[pos] == '-') {
+    opt = argv[pos][1];
+    if (argv[pos][2])
+      arg = argv[pos] + 2;
+    else if (++pos < argc)
+      arg = argv[pos];
+    else
+      bench_usage(argv[0]);
+
+    switch (opt) {
+    case 'd': dir = arg; break;
+    case 'i': interval = atoi(arg); break;
+    case 'n': pulses = atoi(arg); break;
+    case 'p': num_players = atoi(arg); break;
+    case 'r': seed = atoi(arg); break;
+    case 's': script = arg; break;
+    default: bench_usage(argv[0]);
+    }
+    pos++;
+  }
+  if (pos < argc || pulses <= 0 || num_players < 0 || interval <= 0)
+    bench_usage(argv[0]);
+
+  logfile = stderr;
+  log("%s", circlemud_version);
+  log("Benchmark: %d players for %d pulses, a command every %d pulses.",
+	num_players, pulses, interval);
+
+  if (script)
+    bench_read_script(script);
+  else {
+    for (bench_script_len = 0; bench_default_script[bench_script_len]; bench_script_len++)
+      ;
+    bench_script = (char **) bench_default_script;
+  }
+
+  if (chdir(dir) < 0) {
+    perror("SYSERR: Fatal error changing to data directory");
+    exit(1);
+  }
+  log("Using %s as data directory.", dir);
+
+  /* The same run every time, and nothing written to the player files. */
+  circle_srandom(seed);
+  no_rent_check = 1;
+  boot_db();
+  auto_save = FALSE;
+
+  /* Anything written straight to a player's "socket" goes here. */
+  if (!(devnull = fopen("/dev/null", "w"))) {
+    perror("SYSERR: Opening /dev/null");
+    exit(1);
+  }
+  CREATE(players, struct descriptor_data *, MAX(num_players, 1));
+  for (i = 0; i < num_players; i++)
+    bench_enter(players[i] = bench_player(i, fileno(devnull)));
+  bench_output();
+  memset(bench_stages, 0, sizeof(bench_stages));
+
+#ifdef BENCH_ALLOCS
+  mallocs = bench_mallocs;
+  reallocs = bench_reallocs;
+  frees = bench_frees;
+  alloc_bytes = bench_alloc_bytes;
+#endif
+
+  gettimeofday(&start, NULL);
+  for (pulse = 1; pulse <= pulses; pulse++) {
+    /* Players type, each at their own point in the script. */
+    for (i = 0; i < num_players; i++) {
+      d = players[i];
+      if ((pulse + i) % interval || d->input.head)
+	continue;
+      write_to_q(bench_script[(pulse / interval + i) % bench_script_len], &d->input, 0);
+      bench_commands++;
+    }
+    BENCH_STAGE(BENCH_INPUT, process_commands());
+
+    heartbeat(pulse);
+
+    BENCH_STAGE(BENCH_OUTPUT, bench_output());
+
+    /* The dead, and anyone who quit, go straight back in. */
+    for (i = 0; i < num_players; i++)
+      if (STATE(players[i]) != CON_PLAYING && IN_ROOM(players[i]->character) == NOWHERE)
+	bench_enter(players[i]);
+  }
+  gettimeofday(&end, NULL);
+
+#ifdef BENCH_ALLOCS
+  mallocs = bench_mallocs - mallocs;
+  reallocs = bench_reallocs - reallocs;
+  frees = bench_frees - frees;
+  alloc_bytes = bench_alloc_bytes - alloc_bytes;
+#endif
+
+  bench_report(pulses, num_players, (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6);
+#ifdef BENCH_ALLOCS
+  printf(",\"allocs\":{\"malloc\":%ld,\"realloc\":%ld,\"free\":%ld,\"bytes\":%lld,\"per_pulse\":%.1f}}\n",
+	mallocs, reallocs, frees, alloc_bytes, (double) (mallocs + reallocs) / pulses);
+#else
+  printf(",\"allocs\":null}\n");
+#endif
+
+  log("Done.");
+  return (0);
+}
+
+
+static void bench_usage(const char *prog)
+{
+  fprintf(stderr,
+	"Usage: %s [-d pathname] [-n pulses] [-p players] [-i pulses] [-s script] [-r seed]\n"
+	"  -d <directory> Specify library directory (defaults to '%s').\n"
+	"  -i <pulses>    Pulses between each player's commands (%d).\n"
+	"  -n <pulses>    How many pulses to run (%d).\n"
+	"  -p <players>   How many players to log in (%d).\n"
+	"  -r <seed>      Seed for the random numbers (1).\n"
+	"  -s <file>      Commands for the players to type, one per line.\n",
+	prog, DFLT_DIR, BENCH_INTERVAL, BENCH_PULSES, BENCH_PLAYERS);
+  exit(1);
+}
+
+
+/* One command a line; blank lines and lines starting with '#' are skipped. */
+static void bench_read_script(const char *filename)
+{
+  char line[MAX_INPUT_LENGTH + 2], *cmd;
+  FILE *fl;
+
+  if (!(fl = fopen(filename, "r"))) {
+    log("SYSERR: Opening benchmark script %s: %s", filename, strerror(errno));
+    exit(1);
+  }
+  while (get_line(fl, line)) {
+    cmd = line;
+    skip_spaces(&cmd);
+    if (!*cmd || *cmd == '#')
+      continue;
+    RECREATE(bench_script, char *, bench_script_len + 1);
+    bench_script[bench_script_len++] = strdup(cmd);
+  }
+  fclose(fl);
+
+  if (!bench_script_len) {
+    log("SYSERR: Benchmark script %s has no commands in it.", filename);
+    exit(1);
+  }
+}
+
+
+/* A new character with a descriptor that leads nowhere, at the menu. */
+static struct descriptor_data *bench_player(int num, int fd)
+{
+  struct descriptor_data *d;
+  struct char_data *ch;
+  char name[MAX_NAME_LENGTH + 1];
+
+  CREATE(d, struct descriptor_data, 1);
+  d->descriptor = fd;
+  strcpy(d->host, "bench");	/* strcpy: OK (HOST_LENGTH > 5) */
+  d->output = d->small_outbuf;
+  d->bufspace = SMALL_BUFSIZE - 1;
+  d->login_time = time(0);
+  d->ignore_proxy = TRUE;
+  d->desc_num = num + 1;
+  CREATE(d->history, char *, HISTORY_SIZE);
+  d->next = descriptor_list;
+  descriptor_list = d;
+
+  CREATE(ch, struct char_data, 1);
+  clear_char(ch);
+  CREATE(ch->player_specials, struct player_special_data, 1);
+  ch->desc = d;
+  d->character = ch;
+
+  snprintf(name, sizeof(name), "Bench%d", num + 1);
+  ch->player.name = strdup(name);
+  GET_SEX(ch) = (num % 2) ? SEX_FEMALE : SEX_MALE;
+  GET_CLASS(ch) = num % NUM_CLASSES;
+  GET_IDNUM(ch) = ++top_idnum;
+  GET_LOADROOM(ch) = NOWHERE;
+  ch->player.time.birth = ch->player.time.logon = time(0);
+  GET_HOME(ch) = 1;
+  for (num = 0; num < 3; num++)
+    GET_COND(ch, num) = 24;
+
+  STATE(d) = CON_MENU;
+  return (d);
+}
+
+
+/* In through the menu like anyone else; GET_PFILEPOS of -1 keeps them off disk. */
+static void bench_enter(struct descriptor_data *d)
+{
+  char arg[] = "1";
+
+  STATE(d) = CON_MENU;
+  nanny(d, arg);
+  bench_entries++;
+}
+
+
+/* What process_output() would have sent, counted rather than sent. */
+static void bench_output(void)
+{
+  struct descriptor_data *d;
+
+  for (d = descriptor_list; d; d = d->next) {
+    if (*d->output) {
+      bench_output_bytes += d->bufptr + strlen(make_prompt(d));
+      if (d->large_outbuf) {
+	d->large_outbuf->next = bufpool;
+	bufpool = d->large_outbuf;
+	d->large_outbuf = NULL;
+	d->output = d->small_outbuf;
+      }
+      d->bufspace = SMALL_BUFSIZE - 1;
+      d->bufptr = 0;
+      *d->output = '\0';
+      d->has_prompt = TRUE;
+    } else if (!d->has_prompt) {
+      bench_output_bytes += strlen(make_prompt(d));
+      d->has_prompt = TRUE;
+    }
+  }
+}
+
+
+/* Everything but the allocation counts, which main() adds to close it. */
+static void bench_report(int pulses, int players, double secs)
+{
+  struct char_data *ch;
+  struct obj_data *obj;
+  long chars = 0, objs = 0;
+  int i;
+
+  for (ch = character_list; ch; ch = ch->next)
+    chars++;
+  for (obj = object_list; obj; obj = obj->next)
+    objs++;
+
+  log("Benchmark: %d pulses in %.3f seconds, %.0f pulses/sec.", pulses, secs, pulses / secs);
+
+  printf("{\"pulses\":%d,\"seconds\":%.6f,\"pulses_per_sec\":%.1f,\"usec_per_pulse\":%.2f",
+	pulses, secs, pulses / secs, secs * 1e6 / pulses);
+  printf(",\"players\":%d,\"commands\":%ld,\"output_bytes\":%ld,\"reentries\":%ld",
+	players, bench_commands, bench_output_bytes, bench_entries - players);
+  printf(",\"characters\":%ld,\"objects\":%ld", chars, objs);
+  printf(",\"stages\":{");
+  for (i = 0; i < NUM_BENCH_STAGES; i++)
+    printf("%s\"%s\":{\"calls\":%ld,\"usec\":%lld}", i ? "," : "",
+	bench_stage_names[i], bench_stages[i].calls, bench_stages[i].usec);
+  printf("}");
+}
@@ -0,0 +1,42 @@
+/* ************************************************************************
+*   File: bench.h                                       Part of CircleMUD *
+*  Usage: header file for the headless benchmark, bin/circle-bench        *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+/*
+ * comm.c is compiled a second time with CIRCLE_BENCH for circle-bench,
+ * which leaves out main() and times each stage of heartbeat().  In the
+ * game itself BENCH_STAGE() is just the call.
+ */
+
+#define BENCH_INPUT		0	/* process_commands() */
+#define BENCH_ZONE		1
+#define BENCH_IDLEPWD		2
+#define BENCH_MOBILE		3
+#define BENCH_MOBILE_ENTRY	4
+#define BENCH_VIOLENCE		5
+#define BENCH_WHO		6
+#define BENCH_HOURLY		7	/* weather, affects and points */
+#define BENCH_AUTOSAVE		8
+#define BENCH_USAGE		9
+#define BENCH_OLC		10
+#define BENCH_CRASH_SWEEP	11
+#define BENCH_EXTRACT		12
+#define BENCH_OUTPUT		13	/* prompts and emptying the buffers */
+#define NUM_BENCH_STAGES	14
+
+#ifdef CIRCLE_BENCH
+void	bench_stage_begin(struct timeval *start);
+void	bench_stage_end(int stage, struct timeval *start);
+
+#define BENCH_STAGE(stage, ...)	do { struct timeval bench_start; \
+		bench_stage_begin(&bench_start); __VA_ARGS__; \
+		bench_stage_end(stage, &bench_start); } while (0)
+#else
+#define BENCH_STAGE(stage, ...)	do { __VA_ARGS__; } while (0)
+#endif
@@ -0,0 +1,915 @@
+/* ************************************************************************
+*   File: bundle.c                                      Part of CircleMUD *
+*  Usage: per-player bundle files for rent, aliases and equipment sets    *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+#define _GNU_SOURCE	/* fopencookie() */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#if defined(CIRCLE_UNIX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "db.h"
+#include "bundle.h"
+
+/*
+ * The plrfile_*() calls stand in for get_filename() + fopen()/fclose()/
+ * remove() on a player's crash, alias and eqset files.  With
+ * player_bundles off they are exactly that.  With it on, a stream is an
+ * in-memory view of one section of the player's bundle: reads come out
+ * of a copy of the section, and closing a stream opened for writing (or
+ * one opened "r+" whose contents changed) rewrites the bundle.
+ *
+ * The most recently used bundle is kept in memory, so entering the game
+ * (read_aliases(), read_eqsets(), Crash_load()) costs one open() and one
+ * read().  A player who has no bundle yet gets one built from their
+ * old-style files, which are removed once the bundle has been written.
+ *
+ * On top of that, nanny() asks for a player's files to be read ahead by
+ * a background thread while the password is being typed in (see
+ * plrfile_prefetch()).  That works with player_bundles off too: the
+ * prefetched files are served from memory until the player is in the
+ * game, and anything written meanwhile goes straight to the real file.
+ */
+
+extern int player_bundles;
+
+/* get_filename() mode of each bundle section. */
+static const int bundle_modes[NUM_BUNDLE_SECTIONS] = {
+  CRASH_FILE,		/* BUNDLE_OBJECTS */
+  ALIAS_FILE,		/* BUNDLE_ALIASES */
+  EQSET_FILE		/* BUNDLE_EQSETS  */
+};
+
+#if defined(CIRCLE_UNIX)
+
+struct bundle_image {
+  char name[MAX_INPUT_LENGTH];
+  char *data[NUM_BUNDLE_SECTIONS];
+  size_t length[NUM_BUNDLE_SECTIONS];
+  bool legacy;		/* Built from old-style files, not yet written. */
+};
+
+struct plrfile_stream {
+  FILE *fl;
+  char name[MAX_INPUT_LENGTH];
+  int type;
+  bool commit;		/* Write the section back on close.	*/
+  char *buf;		/* Stream contents.			*/
+  size_t len;
+  size_t pos;		/* Read/write offset into buf.		*/
+  char *orig;		/* For "r+": contents when opened.	*/
+  size_t orig_len;
+  struct plrfile_stream *next;
+};
+
+static struct bundle_image bundle_cache;
+static bool bundle_cached = FALSE;
+static bool bundle_primed = FALSE;	/* Prefetched, player_bundles off. */
+static struct plrfile_stream *plrfile_streams = NULL;
+
+static void plrfile_prefetch_stale(const char *name);
+
+
+/* Section type for a get_filename() mode, or -1 if it isn't bundled. */
+static int bundle_section(int mode)
+{
+  int i;
+
+  for (i = 0; i < NUM_BUNDLE_SECTIONS; i++)
+    if (bundle_modes[i] == mode)
+      return (i);
+  return (-1);
+}
+
+
+static int bundle_type(int mode)
+{
+  return (player_bundles ? bundle_section(mode) : -1);
+}
+
+
+/* Like bundle_type(), but also true for a prefetched player's files. */
+static int bundle_cached_type(int mode, const char *name)
+{
+  if (player_bundles)
+    return (bundle_section(mode));
+  if (bundle_primed && !str_cmp(bundle_cache.name, name))
+    return (bundle_section(mode));
+  return (-1);
+}
+
+
+static void bundle_free(struct bundle_image *img)
+{
+  int i;
+
+  for (i = 0; i < NUM_BUNDLE_SECTIONS; i++)
+    if (img->data[i])
+      free(img->data[i]);
+  memset(img, 0, sizeof(*img));
+}
+
+
+static void bundle_forget(void)
+{
+  bundle_free(&bundle_cache);
+  bundle_cached = bundle_primed = FALSE;
+}
+
+
+/* Read all of a file.  *data is NULL if the file is empty. */
+static int bundle_slurp(const char *filename, char **data, size_t *length)
+{
+  struct stat st;
+  size_t done = 0;
+  ssize_t got;
+  int fd, err;
+
+  *data = NULL;
+  *length = 0;
+
+  if ((fd = open(filename, O_RDONLY)) < 0)
+    return (-1);
+  if (fstat(fd, &st) < 0) {
+    err = errno;
+    close(fd);
+    errno = err;
+    return (-1);
+  }
+  if (st.st_size > 0) {
+    CREATE(*data, char, st.st_size);
+    while (done < (size_t)st.st_size) {
+      if ((got = read(fd, *data + done, st.st_size - done)) < 0) {
+        if (errno == EINTR)
+          continue;
+        err = errno;
+        free(*data);
+        *data = NULL;
+        close(fd);
+        errno = err;
+        return (-1);
+      }
+      if (got == 0)
+        break;
+      done += got;
+    }
+  }
+  close(fd);
+
+  if (done == 0 && *data) {
+    free(*data);
+    *data = NULL;
+  }
+  *length = done;
+  return (0);
+}
+
+
+/* Write a file under a temporary name and rename it into place. */
+static int bundle_spill(const char *filename, const char *buf, size_t len)
+{
+  char tmpname[PATH_MAX + 8];
+  size_t done = 0;
+  ssize_t wrote;
+  int fd, err;
+  bool ok;
+
+  snprintf(tmpname, sizeof(tmpname), "%s.new", filename);
+  if ((fd = open(tmpname, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+    return (-1);
+
+  while (done < len) {
+    if ((wrote = write(fd, buf + done, len - done)) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    done += wrote;
+  }
+
+  ok = (done == len);
+  err = errno;
+  if (close(fd) < 0 && ok) {
+    ok = FALSE;
+    err = errno;
+  }
+  if (ok && rename(tmpname, filename) < 0) {
+    ok = FALSE;
+    err = errno;
+  }
+  if (!ok) {
+    remove(tmpname);
+    errno = err;
+    return (-1);
+  }
+  return (0);
+}
+
+
+static int bundle_parse(struct bundle_image *img, const char *buf, size_t len)
+{
+  struct bundle_header hdr;
+  struct bundle_section sect;
+  size_t pos = sizeof(hdr);
+  int i;
+
+  if (len < sizeof(hdr))
+    return (0);
+  memcpy(&hdr, buf, sizeof(hdr));
+  if (hdr.magic != BUNDLE_MAGIC || hdr.version != BUNDLE_VERSION)
+    return (0);
+
+  for (i = 0; i < hdr.num_sections; i++) {
+    if (len - pos < sizeof(sect))
+      return (0);
+    memcpy(&sect, buf + pos, sizeof(sect));
+    pos += sizeof(sect);
+    if (sect.length < 0 || len - pos < (size_t)sect.length)
+      return (0);
+    if (sect.type >= 0 && sect.type < NUM_BUNDLE_SECTIONS &&
+	!img->data[sect.type] && sect.length > 0) {
+      CREATE(img->data[sect.type], char, sect.length);
+      memcpy(img->data[sect.type], buf + pos, sect.length);
+      img->length[sect.type] = sect.length;
+    }
+    pos += sect.length;
+  }
+  return (1);
+}
+
+
+/*
+ * Read a player's files into an empty image: their bundle if 'bundled',
+ * falling back to the old-style files.  Doesn't log or touch any game
+ * state, so it is safe to call from the prefetch thread; on failure the
+ * offending file is left in 'failed' and errno is EINVAL for a corrupt
+ * bundle.
+ */
+static int bundle_read(struct bundle_image *img, const char *name, bool bundled,
+			char *failed, size_t failsize)
+{
+  char *buf;
+  size_t len;
+  int i, err;
+
+  if (name != img->name)	/* The prefetch thread passes img->name. */
+    strlcpy(img->name, name, sizeof(img->name));
+
+  if (bundled) {
+    if (!get_filename(failed, failsize, BUNDLE_FILE, name)) {
+      errno = EINVAL;
+      return (-1);
+    }
+    if (bundle_slurp(failed, &buf, &len) == 0) {
+      i = bundle_parse(img, buf, len);
+      if (buf)
+        free(buf);
+      if (!i) {
+        bundle_free(img);
+        errno = EINVAL;
+        return (-1);
+      }
+      return (0);
+    } else if (errno != ENOENT)
+      return (-1);
+  }
+
+  /* Not converted yet: pick up whatever old-style files there are. */
+  for (i = 0; i < NUM_BUNDLE_SECTIONS; i++) {
+    get_filename(failed, failsize, bundle_modes[i], name);
+    if (bundle_slurp(failed, &img->data[i], &img->length[i]) < 0 && errno != ENOENT) {
+      err = errno;
+      bundle_free(img);
+      errno = (err == EINVAL ? EIO : err);
+      return (-1);
+    }
+    if (img->data[i] && bundled)
+      img->legacy = TRUE;
+  }
+  return (0);
+}
+
+
+static struct bundle_image *bundle_load(const char *name)
+{
+  char filename[PATH_MAX];
+  int err;
+
+  if (bundle_cached && !str_cmp(bundle_cache.name, name))
+    return (&bundle_cache);
+
+  bundle_forget();
+  if (bundle_read(&bundle_cache, name, TRUE, filename, sizeof(filename)) < 0) {
+    err = errno;
+    if (err == EINVAL)
+      log("SYSERR: %s is not a valid player bundle.", filename);
+    else
+      log("SYSERR: reading %s: %s", filename, strerror(err));
+    bundle_forget();
+    errno = err;
+    return (NULL);
+  }
+
+  bundle_cached = TRUE;
+  return (&bundle_cache);
+}
+
+
+/* Write the bundle to a temporary file and rename it into place. */
+static int bundle_store(struct bundle_image *img)
+{
+  char filename[PATH_MAX], *buf, *p;
+  struct bundle_header hdr;
+  struct bundle_section sect;
+  size_t len = sizeof(hdr);
+  int i, ret;
+
+  if (!get_filename(filename, sizeof(filename), BUNDLE_FILE, img->name))
+    return (-1);
+
+  hdr.magic = BUNDLE_MAGIC;
+  hdr.version = BUNDLE_VERSION;
+  hdr.num_sections = 0;
+  for (i = 0; i < NUM_BUNDLE_SECTIONS; i++)
+    if (img->length[i]) {
+      hdr.num_sections++;
+      len += sizeof(sect) + img->length[i];
+    }
+
+  if (hdr.num_sections == 0) {
+    if (remove(filename) < 0 && errno != ENOENT) {
+      log("SYSERR: deleting player bundle %s: %s", filename, strerror(errno));
+      return (-1);
+    }
+  } else {
+    CREATE(buf, char, len);
+    memcpy(buf, &hdr, sizeof(hdr));
+    p = buf + sizeof(hdr);
+    for (i = 0; i < NUM_BUNDLE_SECTIONS; i++) {
+      if (!img->length[i])
+        continue;
+      sect.type = i;
+      sect.length = img->length[i];
+      memcpy(p, &sect, sizeof(sect));
+      memcpy(p + sizeof(sect), img->data[i], img->length[i]);
+      p += sizeof(sect) + img->length[i];
+    }
+    ret = bundle_spill(filename, buf, len);
+    free(buf);
+    if (ret < 0) {
+      log("SYSERR: writing player bundle %s: %s", filename, strerror(errno));
+      return (-1);
+    }
+  }
+
+  if (img->legacy) {
+    for (i = 0; i < NUM_BUNDLE_SECTIONS; i++) {
+      get_filename(filename, sizeof(filename), bundle_modes[i], img->name);
+      if (remove(filename) < 0 && errno != ENOENT)
+        log("SYSERR: deleting %s: %s", filename, strerror(errno));
+    }
+    img->legacy = FALSE;
+  }
+  return (0);
+}
+
+
+/* With player_bundles off, a prefetched section goes back to its own file. */
+static int bundle_store_section(struct bundle_image *img, int type)
+{
+  char filename[PATH_MAX];
+
+  if (!get_filename(filename, sizeof(filename), bundle_modes[type], img->name))
+    return (-1);
+
+  if (img->length[type] == 0) {
+    if (remove(filename) < 0 && errno != ENOENT) {
+      log("SYSERR: deleting %s: %s", filename, strerror(errno));
+      return (-1);
+    }
+  } else if (bundle_spill(filename, img->data[type], img->length[type]) < 0) {
+    log("SYSERR: writing %s: %s", filename, strerror(errno));
+    return (-1);
+  }
+  return (0);
+}
+
+
+/* Replace one section of a player's bundle.  Takes ownership of data. */
+static int bundle_put(const char *name, int type, char *data, size_t len)
+{
+  struct bundle_image *img;
+  int ret;
+
+  if ((img = bundle_load(name)) == NULL) {
+    if (data)
+      free(data);
+    return (-1);
+  }
+
+  if (img->data[type])
+    free(img->data[type]);
+  if (len == 0 && data) {
+    free(data);
+    data = NULL;
+  }
+  img->data[type] = data;
+  img->length[type] = len;
+
+  if (bundle_primed)
+    ret = bundle_store_section(img, type);
+  else
+    ret = bundle_store(img);
+
+  if (ret < 0) {
+    /* Don't let the cache disagree with the disk. */
+    bundle_forget();
+    return (-1);
+  }
+  return (0);
+}
+
+#else /* !CIRCLE_UNIX */
+
+static int bundle_type(int mode)
+{
+  return (-1);
+}
+
+#endif /* CIRCLE_UNIX */
+
+
+/* Name of the file holding a player's data of the given kind. */
+int plrfile_path(char *filename, size_t fbufsize, int mode, const char *name)
+{
+  if (bundle_type(mode) >= 0)
+    mode = BUNDLE_FILE;
+  return (get_filename(filename, fbufsize, mode, name));
+}
+
+
+/*
+ * A cached section is read, or rewritten in place, through a stream on
+ * s->buf that behaves like a file of s->len bytes and grows if written
+ * past its end.  fmemopen() won't do: it treats the buffer as a string,
+ * and depending on the C library an "r+" write can store a NUL after the
+ * bytes written, clobbering whatever follows a rewritten rent header.
+ */
+#if defined(__GLIBC__)
+typedef off64_t plrfile_off_t;
+#else
+typedef off_t plrfile_off_t;
+#endif
+
+static ssize_t plrfile_mem_read(void *cookie, char *buf, size_t size)
+{
+  struct plrfile_stream *s = cookie;
+  size_t n = 0;
+
+  if (s->pos < s->len)
+    n = (size < s->len - s->pos ? size : s->len - s->pos);
+  memcpy(buf, s->buf + s->pos, n);
+  s->pos += n;
+  return (n);
+}
+
+static ssize_t plrfile_mem_write(void *cookie, const char *buf, size_t size)
+{
+  struct plrfile_stream *s = cookie;
+
+  if (s->pos + size > s->len) {
+    RECREATE(s->buf, char, s->pos + size);
+    if (s->pos > s->len)
+      memset(s->buf + s->len, 0, s->pos - s->len);
+    s->len = s->pos + size;
+  }
+  memcpy(s->buf + s->pos, buf, size);
+  s->pos += size;
+  return (size);
+}
+
+static int plrfile_mem_seek(void *cookie, plrfile_off_t *offset, int whence)
+{
+  struct plrfile_stream *s = cookie;
+  plrfile_off_t where;
+
+  switch (whence) {
+  case SEEK_SET: where = *offset; break;
+  case SEEK_CUR: where = (plrfile_off_t) s->pos + *offset; break;
+  case SEEK_END: where = (plrfile_off_t) s->len + *offset; break;
+  default: errno = EINVAL; return (-1);
+  }
+  if (where < 0) {
+    errno = EINVAL;
+    return (-1);
+  }
+  s->pos = where;
+  *offset = where;
+  return (0);
+}
+
+#if defined(__GLIBC__)
+static FILE *plrfile_mem_open(struct plrfile_stream *s, const char *how)
+{
+  cookie_io_functions_t io = { plrfile_mem_read, plrfile_mem_write, plrfile_mem_seek, NULL };
+
+  return (fopencookie(s, how, io));
+}
+#else	/* BSD funopen() */
+static int plrfile_mem_readfn(void *cookie, char *buf, int size)
+{
+  return ((int) plrfile_mem_read(cookie, buf, size));
+}
+
+static int plrfile_mem_writefn(void *cookie, const char *buf, int size)
+{
+  return ((int) plrfile_mem_write(cookie, buf, size));
+}
+
+static fpos_t plrfile_mem_seekfn(void *cookie, fpos_t offset, int whence)
+{
+  plrfile_off_t where = offset;
+
+  return (plrfile_mem_seek(cookie, &where, whence) < 0 ? -1 : where);
+}
+
+static FILE *plrfile_mem_open(struct plrfile_stream *s, const char *how)
+{
+  return (funopen(s, plrfile_mem_readfn, strchr(how, '+') ? plrfile_mem_writefn : NULL,
+		  plrfile_mem_seekfn, NULL));
+}
+#endif
+
+
+FILE *plrfile_open(int mode, const char *name, const char *how)
+{
+  char filename[PATH_MAX];
+#if defined(CIRCLE_UNIX)
+  struct plrfile_stream *s;
+  struct bundle_image *img;
+  int type, err;
+
+  if (*how != 'r' || strchr(how, '+'))
+    plrfile_prefetch_stale(name);
+
+  if ((type = bundle_cached_type(mode, name)) >= 0) {
+    CREATE(s, struct plrfile_stream, 1);
+    strlcpy(s->name, name, sizeof(s->name));
+    s->type = type;
+
+    if (*how == 'w') {
+      s->commit = TRUE;
+      s->fl = open_memstream(&s->buf, &s->len);
+    } else if ((img = bundle_load(name)) == NULL) {
+      free(s);
+      return (NULL);
+    } else if (img->length[type] == 0) {
+      free(s);
+      errno = ENOENT;
+      return (NULL);
+    } else {
+      s->len = img->length[type];
+      CREATE(s->buf, char, s->len);
+      memcpy(s->buf, img->data[type], s->len);
+      if (strchr(how, '+')) {
+        s->commit = TRUE;
+        CREATE(s->orig, char, s->len);
+        memcpy(s->orig, s->buf, s->len);
+        s->orig_len = s->len;
+      }
+      s->fl = plrfile_mem_open(s, how);
+    }
+
+    if (s->fl == NULL) {
+      err = errno;
+      if (s->buf)
+        free(s->buf);
+      if (s->orig)
+        free(s->orig);
+      free(s);
+      errno = err;
+      return (NULL);
+    }
+    s->next = plrfile_streams;
+    plrfile_streams = s;
+    return (s->fl);
+  }
+#endif
+
+  if (!get_filename(filename, sizeof(filename), mode, name)) {
+    errno = EINVAL;
+    return (NULL);
+  }
+  return (fopen(filename, how));
+}
+
+
+int plrfile_close(FILE *fl)
+{
+#if defined(CIRCLE_UNIX)
+  struct plrfile_stream *s, **prev;
+  int result;
+
+  for (prev = &plrfile_streams; *prev; prev = &(*prev)->next)
+    if ((*prev)->fl == fl)
+      break;
+
+  if ((s = *prev) != NULL) {
+    *prev = s->next;
+    result = fclose(fl);	/* Flushes into s->buf/s->len. */
+
+    if (result == 0 && s->commit &&
+	(!s->orig || s->len != s->orig_len || memcmp(s->buf, s->orig, s->len)))
+      result = bundle_put(s->name, s->type, s->buf, s->len);
+    else if (s->buf)
+      free(s->buf);
+
+    if (s->orig)
+      free(s->orig);
+    free(s);
+    return (result);
+  }
+#endif
+
+  return (fclose(fl));
+}
+
+
+/* Like remove(): -1 with errno ENOENT if the player has no such data. */
+int plrfile_remove(int mode, const char *name)
+{
+  char filename[PATH_MAX];
+#if defined(CIRCLE_UNIX)
+  struct bundle_image *img;
+  int type;
+
+  plrfile_prefetch_stale(name);
+
+  if ((type = bundle_cached_type(mode, name)) >= 0) {
+    if ((img = bundle_load(name)) == NULL)
+      return (-1);
+    if (img->length[type] == 0) {
+      errno = ENOENT;
+      return (-1);
+    }
+    return (bundle_put(name, type, NULL, 0));
+  }
+#endif
+
+  if (!get_filename(filename, sizeof(filename), mode, name)) {
+    errno = EINVAL;
+    return (-1);
+  }
+  return (remove(filename));
+}
+
+
+/*
+ * Login prefetch.  nanny() calls plrfile_prefetch() as soon as it knows
+ * which player is connecting, and a worker thread reads that player's
+ * files while the password prompt is up.  When the player enters the
+ * game plrfile_prefetch_use() hands the result to the cache above, so
+ * read_aliases(), read_eqsets() and Crash_load() don't touch the disk.
+ * process_commands() holds the menu choice while plrfile_prefetch_busy(),
+ * so the game loop never waits for the thread.
+ * A wrong password, a reconnect or a dropped link cancels the request.
+ *
+ * Anything that writes a player's files marks that player's outstanding
+ * prefetches stale; a stale result is thrown away and the files are read
+ * the ordinary way.
+ */
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+
+#define PREFETCH_QUEUED		0
+#define PREFETCH_RUNNING	1
+#define PREFETCH_DONE		2
+#define PREFETCH_CANCELLED	3
+
+struct plrfile_prefetch {
+  struct bundle_image img;
+  bool bundled;		/* Read as a bundle (player_bundles was on).	*/
+  bool stale;		/* Files were written after it was queued.	*/
+  int state;
+  int error;		/* errno if the read failed.			*/
+  struct plrfile_prefetch *next;
+};
+
+static pthread_mutex_t prefetch_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t prefetch_work = PTHREAD_COND_INITIALIZER;
+static struct plrfile_prefetch *prefetch_list = NULL;
+static bool prefetch_thread_started = FALSE;
+
+
+static void prefetch_unlink(struct plrfile_prefetch *p)
+{
+  struct plrfile_prefetch **prev;
+
+  for (prev = &prefetch_list; *prev; prev = &(*prev)->next)
+    if (*prev == p) {
+      *prev = p->next;
+      break;
+    }
+}
+
+
+static void *prefetch_thread(void *arg)
+{
+  struct plrfile_prefetch *p;
+  struct bundle_image img;
+  char failed[PATH_MAX];
+  int ret, err;
+
+  pthread_mutex_lock(&prefetch_mutex);
+  for (;;) {
+    for (p = prefetch_list; p; p = p->next)
+      if (p->state == PREFETCH_QUEUED)
+        break;
+    if (p == NULL) {
+      pthread_cond_wait(&prefetch_work, &prefetch_mutex);
+      continue;
+    }
+    p->state = PREFETCH_RUNNING;
+    memset(&img, 0, sizeof(img));
+    strlcpy(img.name, p->img.name, sizeof(img.name));
+    pthread_mutex_unlock(&prefetch_mutex);
+
+    ret = bundle_read(&img, img.name, p->bundled, failed, sizeof(failed));
+    err = errno;
+
+    pthread_mutex_lock(&prefetch_mutex);
+    if (p->state == PREFETCH_CANCELLED) {
+      bundle_free(&img);
+      prefetch_unlink(p);
+      free(p);
+      continue;
+    }
+    p->img = img;
+    p->error = (ret < 0 ? err : 0);
+    p->state = PREFETCH_DONE;
+  }
+  return (NULL);
+}
+
+
+struct plrfile_prefetch *plrfile_prefetch(const char *name)
+{
+  struct plrfile_prefetch *p;
+  pthread_t thread;
+
+  if (!prefetch_thread_started) {
+    if (pthread_create(&thread, NULL, prefetch_thread, NULL) != 0) {
+      log("SYSERR: plrfile_prefetch: can't start thread: %s", strerror(errno));
+      return (NULL);
+    }
+    pthread_detach(thread);
+    prefetch_thread_started = TRUE;
+  }
+
+  CREATE(p, struct plrfile_prefetch, 1);
+  strlcpy(p->img.name, name, sizeof(p->img.name));
+  p->bundled = player_bundles;
+  p->state = PREFETCH_QUEUED;
+
+  pthread_mutex_lock(&prefetch_mutex);
+  p->next = prefetch_list;
+  prefetch_list = p;
+  pthread_cond_signal(&prefetch_work);
+  pthread_mutex_unlock(&prefetch_mutex);
+  return (p);
+}
+
+
+void plrfile_prefetch_cancel(struct plrfile_prefetch *p)
+{
+  if (p == NULL)
+    return;
+
+  pthread_mutex_lock(&prefetch_mutex);
+  if (p->state == PREFETCH_RUNNING)
+    p->state = PREFETCH_CANCELLED;	/* The thread frees it. */
+  else {
+    prefetch_unlink(p);
+    bundle_free(&p->img);
+    free(p);
+  }
+  pthread_mutex_unlock(&prefetch_mutex);
+}
+
+
+/* Still being read?  Don't let the player in yet if so. */
+bool plrfile_prefetch_busy(struct plrfile_prefetch *p)
+{
+  bool busy;
+
+  if (p == NULL)
+    return (FALSE);
+
+  pthread_mutex_lock(&prefetch_mutex);
+  busy = (p->state == PREFETCH_QUEUED || p->state == PREFETCH_RUNNING);
+  pthread_mutex_unlock(&prefetch_mutex);
+  return (busy);
+}
+
+
+/*
+ * Cache a finished prefetch's result.  One that isn't finished is
+ * cancelled instead, and the files are read the ordinary way.
+ */
+void plrfile_prefetch_use(struct plrfile_prefetch *p)
+{
+  bool usable;
+
+  if (p == NULL)
+    return;
+
+  pthread_mutex_lock(&prefetch_mutex);
+  if (p->state != PREFETCH_DONE) {
+    pthread_mutex_unlock(&prefetch_mutex);
+    plrfile_prefetch_cancel(p);
+    return;
+  }
+  prefetch_unlink(p);
+  pthread_mutex_unlock(&prefetch_mutex);
+
+  usable = (!p->stale && !p->error && p->bundled == (player_bundles != 0));
+  if (usable) {
+    bundle_forget();
+    bundle_cache = p->img;
+    bundle_cached = TRUE;
+    bundle_primed = !player_bundles;
+  } else
+    bundle_free(&p->img);
+  free(p);
+}
+
+
+/* The player is in the game; stop serving their old-style files from memory. */
+void plrfile_prefetch_done(void)
+{
+  if (bundle_primed)
+    bundle_forget();
+}
+
+
+static void plrfile_prefetch_stale(const char *name)
+{
+  struct plrfile_prefetch *p;
+
+  pthread_mutex_lock(&prefetch_mutex);
+  for (p = prefetch_list; p; p = p->next)
+    if (!str_cmp(p->img.name, name))
+      p->stale = TRUE;
+  pthread_mutex_unlock(&prefetch_mutex);
+}
+
+#else /* !(CIRCLE_UNIX && HAVE_PTHREAD) */
+
+struct plrfile_prefetch *plrfile_prefetch(const char *name)
+{
+  return (NULL);
+}
+
+
+void plrfile_prefetch_cancel(struct plrfile_prefetch *p)
+{
+}
+
+
+bool plrfile_prefetch_busy(struct plrfile_prefetch *p)
+{
+  return (FALSE);
+}
+
+
+void plrfile_prefetch_use(struct plrfile_prefetch *p)
+{
+}
+
+
+void plrfile_prefetch_done(void)
+{
+}
+
+#if defined(CIRCLE_UNIX)
+static void plrfile_prefetch_stale(const char *name)
+{
+}
+#endif
+
+#endif /* CIRCLE_UNIX && HAVE_PTHREAD */
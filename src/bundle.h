@@ -0,0 +1,53 @@
+/* ************************************************************************
+*   File: bundle.h                                      Part of CircleMUD *
+*  Usage: header file for per-player bundle files                         *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+/*
+ * A bundle holds, in one file, the per-player data that otherwise lives
+ * in plrobjs/, plralias/ and plreqsets/.  Each section is a byte-for-byte
+ * copy of the legacy file, so the parsers don't change and converting
+ * between the two layouts is plain concatenation.
+ *
+ * Layout: a bundle_header followed by num_sections sections, each a
+ * bundle_section followed by 'length' bytes of data.  Empty sections are
+ * not stored.  A bundle with no sections left is removed.
+ */
+
+#define BUNDLE_MAGIC		0x444e4243	/* "CBND" */
+#define BUNDLE_VERSION		1
+
+/* Section types */
+#define BUNDLE_OBJECTS		0	/* rent_info + obj_file_elem's	*/
+#define BUNDLE_ALIASES		1	/* alias file text		*/
+#define BUNDLE_EQSETS		2	/* eqset file text		*/
+#define NUM_BUNDLE_SECTIONS	3
+
+struct bundle_header {
+  int magic;
+  int version;
+  int num_sections;
+};
+
+struct bundle_section {
+  int type;
+  int length;
+};
+
+#ifndef CIRCLE_UTIL
+int	plrfile_path(char *filename, size_t fbufsize, int mode, const char *name);
+FILE	*plrfile_open(int mode, const char *name, const char *how);
+int	plrfile_close(FILE *fl);
+int	plrfile_remove(int mode, const char *name);
+
+struct plrfile_prefetch *plrfile_prefetch(const char *name);
+void	plrfile_prefetch_cancel(struct plrfile_prefetch *p);
+bool	plrfile_prefetch_busy(struct plrfile_prefetch *p);
+void	plrfile_prefetch_use(struct plrfile_prefetch *p);
+void	plrfile_prefetch_done(void);
+#endif
@@ -1480,6 +1480,7 @@ void roll_real_abils(struct char_data *ch)
 {
   roll_abils(ch, &ch->real_abils);
   ch->aff_abils = ch->real_abils;
+  INVALIDATE_COMBAT(ch);
 }
 
 
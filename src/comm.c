@@ -61,6 +61,12 @@
 #include "house.h"
 #include "gmcp.h"
 #include "webserver.h"
+#include "bundle.h"
+#include "resolver.h"
+#include "pwhash.h"
+#include "mccp.h"
+#include "json.h"
+#include "bench.h"
 
 #ifdef HAVE_ARPA_TELNET_H
 #include <arpa/telnet.h>
@@ -73,7 +79,6 @@
 #endif
 
 /* externs */
-extern struct ban_list_element *ban_list;
 extern int num_invalid;
 extern char *GREETINGS;
 extern const char *circlemud_version;
@@ -87,6 +92,9 @@ extern const char *DFLT_IP;
 extern const char *LOGNAME;
 extern int max_playing;
 extern int nameserver_is_slow;	/* see config.c */
+extern int site_connect_burst;	/* see config.c */
+extern int site_connect_rate;	/* see config.c */
+extern int site_max_connections; /* see config.c */
 extern int auto_save;		/* see config.c */
 extern int autosave_time;	/* see config.c */
 extern int *cmd_sort_info;
@@ -100,12 +108,18 @@ struct txt_block *bufpool = 0;	/* pool of large output buffers */
 int buf_largecount = 0;		/* # of large buffers which exist */
 int buf_overflows = 0;		/* # of overflows of output */
 int buf_switches = 0;		/* # of switches from small to large buf */
+int conn_accepted = 0;		/* # of connections let in */
+int conn_rejected = 0;		/* # of connections turned away */
 int circle_shutdown = 0;	/* clean shutdown */
 int circle_reboot = 0;		/* reboot the game after a shutdown */
 int no_specials = 0;		/* Suppress ass. of special routines */
 int max_players = 0;		/* max descriptors available */
 int tics = 0;			/* for extern checkpointing */
 int scheck = 0;			/* for syntax checking mode */
+int keyword_bench = 0;		/* time isname() vs. keyword sets */
+int ban_bench = 0;		/* time isbanned() on a big ban list */
+int combat_bench = 0;		/* time rounds of combat */
+int json_bench = 0;		/* time and fuzz the JSON tokenizer */
 struct timeval null_time;	/* zero-valued time structure */
 byte reread_wizlist;		/* signal: SIGUSR1 */
 byte emergency_unban;		/* signal: SIGUSR2 */
@@ -129,6 +143,8 @@ void signal_setup(void);
 void game_loop(socket_t mother_desc);
 socket_t init_socket(ush_int port);
 int new_descriptor(socket_t s);
+static int site_admit(struct in_addr addr, struct conn_site **sitep);
+static void site_release(struct descriptor_data *d);
 int get_max_players(void);
 int process_output(struct descriptor_data *t);
 int process_input(struct descriptor_data *t);
@@ -137,10 +153,11 @@ void timeadd(struct timeval *sum, struct timeval *a, struct timeval *b);
 void flush_queues(struct descriptor_data *d);
 void nonblock(socket_t s);
 int perform_subst(struct descriptor_data *t, char *orig, char *subst);
-void record_usage(void);
+void record_usage(int log_it);
 char *make_prompt(struct descriptor_data *point);
 void check_idle_passwords(void);
 void heartbeat(int pulse);
+void process_commands(void);
 struct in_addr *get_bind_addr(void);
 int parse_ip(const char *addr, struct in_addr *inaddr);
 int set_sendbuf(socket_t s);
@@ -156,9 +173,13 @@ void reboot_wizlists(void);
 void boot_world(void);
 void affect_update(void);	/* In magic.c */
 void mobile_activity(void);
+void mobile_entry_checks(void);
 void perform_violence(void);
 void show_string(struct descriptor_data *d, char *input);
 int isbanned(char *hostname);
+void unban_all(void);
+void ban_benchmark(void);
+void combat_benchmark(void);
 void weather_and_time(int mode);
 int perform_alias(struct descriptor_data *d, char *orig, size_t maxlen);
 void clear_free_list(void);
@@ -206,6 +227,7 @@ void gettimeofday(struct timeval *t, struct timezone *dummy)
 #endif	/* CIRCLE_WINDOWS || CIRCLE_MACINTOSH */
 
 
+#ifndef CIRCLE_BENCH	/* circle-bench has its own; see bench.c */
 int main(int argc, char **argv)
 {
   ush_int port;
@@ -260,6 +282,26 @@ int main(int argc, char **argv)
       scheck = 1;
       puts("Syntax check mode enabled.");
       break;
+    case 'b':
+      scheck = 1;
+      ban_bench = 1;
+      puts("Ban list benchmark.");
+      break;
+    case 'f':
+      scheck = 1;
+      combat_bench = 1;
+      puts("Combat benchmark.");
+      break;
+    case 'j':
+      scheck = 1;
+      json_bench = 1;
+      puts("JSON tokenizer benchmark.");
+      break;
+    case 'k':
+      scheck = 1;
+      keyword_bench = 1;
+      puts("Keyword matching benchmark.");
+      break;
     case 'q':
       no_rent_check = 1;
       puts("Quick boot mode -- rent check supressed.");
@@ -274,10 +316,14 @@ int main(int argc, char **argv)
       break;
     case 'h':
       /* From: Anil Mahajan <amahajan@proxicom.com> */
-      printf("Usage: %s [-c] [-m] [-q] [-r] [-s] [-d pathname] [port #]\n"
+      printf("Usage: %s [-b] [-c] [-f] [-j] [-k] [-m] [-q] [-r] [-s] [-d pathname] [port #]\n"
+              "  -b             Boot the world, time ban matching and exit.\n"
               "  -c             Enable syntax check mode.\n"
               "  -d <directory> Specify library directory (defaults to 'lib').\n"
+              "  -f             Boot the world, time rounds of combat and exit.\n"
               "  -h             Print this command line argument help.\n"
+              "  -j             Boot the world, time and fuzz the JSON tokenizer and exit.\n"
+              "  -k             Boot the world, time keyword matching and exit.\n"
               "  -m             Start in mini-MUD mode.\n"
 	      "  -o <file>      Write log to <file> instead of stderr.\n"
               "  -q             Quick boot (doesn't scan rent for object limits)\n"
@@ -295,7 +341,7 @@ int main(int argc, char **argv)
 
   if (pos < argc) {
     if (!isdigit(*argv[pos])) {
-      printf("Usage: %s [-c] [-m] [-q] [-r] [-s] [-d pathname] [port #]\n", argv[0]);
+      printf("Usage: %s [-b] [-c] [-f] [-j] [-k] [-m] [-q] [-r] [-s] [-d pathname] [port #]\n", argv[0]);
       exit(1);
     } else if ((port = atoi(argv[pos])) <= 1024) {
       printf("SYSERR: Illegal port number %d.\n", port);
@@ -318,9 +364,17 @@ int main(int argc, char **argv)
   }
   log("Using %s as data directory.", dir);
 
-  if (scheck)
+  if (scheck) {
     boot_world();
-  else {
+    if (keyword_bench)
+      keyword_benchmark();
+    if (ban_bench)
+      ban_benchmark();
+    if (json_bench)
+      json_benchmark();
+    if (combat_bench)
+      combat_benchmark();
+  } else {
     log("Running game on port %d.", port);
     init_game(port);
   }
@@ -344,7 +398,7 @@ int main(int argc, char **argv)
   log("Done.");
   return (0);
 }
-
+#endif	/* CIRCLE_BENCH */
 
 
 /* Init sockets, run game, and cleanup sockets */
@@ -357,14 +411,15 @@ void init_game(ush_int port)
 
   circle_srandom(time(0));
 
-  log("Finding player limit.");
-  max_players = get_max_players();
-
   log("Opening mother connection.");
   mother_desc = init_socket(port);
 
   boot_db();
 
+  /* After boot_db(), which reads max_playing from etc/config. */
+  log("Finding player limit.");
+  max_players = get_max_players();
+
   webserver_init(".");
 
 #if defined(CIRCLE_UNIX) || defined(CIRCLE_MACINTOSH)
@@ -495,8 +550,19 @@ socket_t init_socket(ush_int port)
     CLOSE_SOCKET(s);
     exit(1);
   }
+#if !defined(CIRCLE_WINDOWS)
+  if (s >= FD_SETSIZE) {
+    log("SYSERR: Mother socket is descriptor %d, past what select() can watch.", (int) s);
+    exit(1);
+  }
+#endif
   nonblock(s);
+  /* Room for a rush; new_descriptor() drains the queue every pass. */
+#ifdef SOMAXCONN
+  listen(s, SOMAXCONN);
+#else
   listen(s, 5);
+#endif
   return (s);
 }
 
@@ -570,6 +636,14 @@ int get_max_players(void)
   max_descs = max_playing + NUM_RESERVED_DESCS;
 #endif
 
+  /*
+   * The game loop uses select(), which can't watch descriptors past
+   * FD_SETSIZE.  The web server, the resolver and open files take
+   * descriptors too, so leave them room below it; new_descriptor() turns
+   * away anything that still lands past it.
+   */
+  max_descs = MIN(max_descs, FD_SETSIZE - NUM_SPARE_SELECT_DESCS);
+
   /* now calculate max _players_ based on max descs */
   max_descs = MIN(max_playing, max_descs - NUM_RESERVED_DESCS);
 
@@ -597,9 +671,8 @@ void game_loop(socket_t mother_desc)
   fd_set input_set, output_set, exc_set, null_set;
   struct timeval last_time, opt_time, process_time, temp_time;
   struct timeval before_sleep, now, timeout;
-  char comm[MAX_INPUT_LENGTH];
   struct descriptor_data *d, *next_d;
-  int pulse = 0, missed_pulses, maxdesc, aliased;
+  int pulse = 0, missed_pulses, maxdesc;
 
   /* initialize various time values */
   null_time.tv_sec = 0;
@@ -698,9 +771,16 @@ void game_loop(socket_t mother_desc)
       perror("SYSERR: Select poll");
       return;
     }
-    /* If there are new connections waiting, accept them. */
+    /* If there are new connections waiting, accept them all. */
     if (FD_ISSET(mother_desc, &input_set))
-      new_descriptor(mother_desc);
+      while (new_descriptor(mother_desc) > 0)
+	;
+
+    /* Pick up any site names that have been looked up since. */
+    resolver_poll();
+
+    /* Carry on with logins whose passwords have been hashed. */
+    pwhash_poll();
 
     /* Kick out the freaky folks in the exception set and marked for close */
     for (d = descriptor_list; d; d = next_d) {
@@ -721,74 +801,7 @@ void game_loop(socket_t mother_desc)
     }
 
     /* Process commands we just read from process_input */
-    for (d = descriptor_list; d; d = next_d) {
-      next_d = d->next;
-
-      /*
-       * Not combined to retain --(d->wait) behavior. -gg 2/20/98
-       * If no wait state, no subtraction.  If there is a wait
-       * state then 1 is subtracted. Therefore we don't go less
-       * than 0 ever and don't require an 'if' bracket. -gg 2/27/99
-       */
-      if (d->character) {
-        GET_WAIT_STATE(d->character) -= (GET_WAIT_STATE(d->character) > 0);
-
-        if (GET_WAIT_STATE(d->character))
-          continue;
-      }
-
-      if (!get_from_q(&d->input, comm, &aliased))
-        continue;
-
-      if (d->character) {
-	/* Reset the idle timer & pull char back from void if necessary */
-	d->character->char_specials.timer = 0;
-	if (STATE(d) == CON_PLAYING && GET_WAS_IN(d->character) != NOWHERE) {
-	  if (IN_ROOM(d->character) != NOWHERE)
-	    char_from_room(d->character);
-	  char_to_room(d->character, GET_WAS_IN(d->character));
-	  GET_WAS_IN(d->character) = NOWHERE;
-	  act("$n has returned.", TRUE, d->character, 0, 0, TO_ROOM);
-	}
-        GET_WAIT_STATE(d->character) = 1;
-      }
-      d->has_prompt = FALSE;
-
-      /*
-       * If connection made via stunnel4 or other proxy that supports
-       * HAPROXY, then the first line sent to the mud after the
-       * connection will be the proxy information.  The ignore_proxy
-       * field is used to only do these checks for the first line
-       * received.  We will only accept the PROXY line if it is the
-       * first line and if the original connection was from the
-       * localhost.
-       */
-      if (!d->ignore_proxy) {
-	int ipfrom[4], portfrom;
-
-	if (strcmp(d->host, "localhost") == 0 &&
-	    sscanf(comm, "PROXY TCP4 %d.%d.%d.%d %*d.%*d.%*d.%*d %d %*d",
-		   &ipfrom[0], &ipfrom[1], &ipfrom[2], &ipfrom[3], &portfrom) == 5) {
-	  sprintf(d->host, "%d.%d.%d.%d", ipfrom[0], ipfrom[1], ipfrom[2], ipfrom[3]);
-	  continue;
-	}
-      }
-      d->ignore_proxy = 1;
-
-      if (d->str)		/* Writing boards, mail, etc. */
-	string_add(d, comm);
-      else if (d->showstr_count) /* Reading something w/ pager */
-	show_string(d, comm);
-      else if (STATE(d) != CON_PLAYING) /* In menus, etc. */
-	nanny(d, comm);
-      else {			/* else: we're playing normally. */
-	if (aliased)		/* To prevent recursive aliases. */
-	  d->has_prompt = TRUE;	/* To get newline before next cmd output. */
-	else if (perform_alias(d, comm, sizeof(comm)))    /* Run it through aliasing system */
-	  get_from_q(&d->input, comm, &aliased);
-	command_interpreter(d->character, comm); /* Send it to interpreter */
-      }
-    }
+    process_commands();
 
     /* Send queued output out to the operating system (ultimately to user). */
     for (d = descriptor_list; d; d = next_d) {
@@ -805,11 +818,18 @@ void game_loop(socket_t mother_desc)
     /* Print prompts for other descriptors who had no other output */
     for (d = descriptor_list; d; d = d->next) {
       if (!d->has_prompt && d->bufptr == 0) {
-	write_to_descriptor(d->descriptor, make_prompt(d));
+	char *prompt = make_prompt(d);
+
+	write_to_client(d, prompt, strlen(prompt));
 	d->has_prompt = TRUE;
       }
     }
 
+    /* Send on whatever is still in the compressors (GMCP, mostly). */
+    for (d = descriptor_list; d; d = d->next)
+      if (d->mccp && mccp_flush(d) < 0)
+	STATE(d) = CON_DISCONNECT;
+
     /* Kick out folks in the CON_CLOSE or CON_DISCONNECT state */
     for (d = descriptor_list; d; d = next_d) {
       next_d = d->next;
@@ -848,7 +868,7 @@ void game_loop(socket_t mother_desc)
     if (emergency_unban) {
       emergency_unban = FALSE;
       mudlog(BRF, LVL_IMMORT, TRUE, "Received SIGUSR2 - completely unrestricting game (emergent)");
-      ban_list = NULL;
+      unban_all();
       circle_restrict = 0;
       num_invalid = 0;
     }
@@ -865,27 +885,137 @@ void game_loop(socket_t mother_desc)
 }
 
 
+/*
+ * Run one command for each descriptor that has one waiting and isn't
+ * lagged.  bin/circle-bench drives its players through here as well.
+ */
+void process_commands(void)
+{
+  char comm[MAX_INPUT_LENGTH];
+  struct descriptor_data *d, *next_d;
+  int aliased;
+
+  for (d = descriptor_list; d; d = next_d) {
+    next_d = d->next;
+
+    /*
+     * Not combined to retain --(d->wait) behavior. -gg 2/20/98
+     * If no wait state, no subtraction.  If there is a wait
+     * state then 1 is subtracted. Therefore we don't go less
+     * than 0 ever and don't require an 'if' bracket. -gg 2/27/99
+     */
+    if (d->character) {
+      GET_WAIT_STATE(d->character) -= (GET_WAIT_STATE(d->character) > 0);
+
+      if (GET_WAIT_STATE(d->character))
+	continue;
+    }
+
+    /* Hold them at the name prompt until we know where they're from. */
+    if (d->dns && STATE(d) == CON_GET_NAME)
+      continue;
+
+    /* Nor can they type ahead of a password check. */
+    if (STATE(d) == CON_VERIFYING)
+      continue;
+
+    /* Or go into the game before their files have been read ahead. */
+    if (STATE(d) == CON_MENU && plrfile_prefetch_busy(d->prefetch))
+      continue;
+
+    if (!get_from_q(&d->input, comm, &aliased))
+      continue;
+
+    if (d->character) {
+      /* Reset the idle timer & pull char back from void if necessary */
+      d->character->char_specials.timer = 0;
+      if (STATE(d) == CON_PLAYING && GET_WAS_IN(d->character) != NOWHERE) {
+	if (IN_ROOM(d->character) != NOWHERE)
+	  char_from_room(d->character);
+	char_to_room(d->character, GET_WAS_IN(d->character));
+	GET_WAS_IN(d->character) = NOWHERE;
+	act("$n has returned.", TRUE, d->character, 0, 0, TO_ROOM);
+      }
+      GET_WAIT_STATE(d->character) = 1;
+    }
+    d->has_prompt = FALSE;
+
+    /*
+     * If connection made via stunnel4 or other proxy that supports
+     * HAPROXY, then the first line sent to the mud after the
+     * connection will be the proxy information.  The ignore_proxy
+     * field is used to only do these checks for the first line
+     * received.  We will only accept the PROXY line if it is the
+     * first line and if the original connection was from the
+     * localhost.
+     */
+    if (!d->ignore_proxy) {
+      int ipfrom[4], portfrom;
+      struct in_addr addr;
+
+      if (strcmp(d->host, "localhost") == 0 &&
+	  sscanf(comm, "PROXY TCP4 %d.%d.%d.%d %*d.%*d.%*d.%*d %d %*d",
+		 &ipfrom[0], &ipfrom[1], &ipfrom[2], &ipfrom[3], &portfrom) == 5) {
+	sprintf(d->host, "%d.%d.%d.%d", ipfrom[0], ipfrom[1], ipfrom[2], ipfrom[3]);
+	strcpy(d->ip, d->host);	/* strcpy: OK (same size) */
+	/* Treat the real client like any other new connection. */
+	if (parse_ip(d->host, &addr)) {
+	  site_release(d);
+	  if (!site_admit(addr, &d->site)) {
+	    STATE(d) = CON_CLOSE;
+	    continue;
+	  }
+	  if (!nameserver_is_slow && isbanned(d->host) != BAN_ALL)
+	    resolver_lookup(d, addr);
+	}
+	if (isbanned(d->host) == BAN_ALL) {
+	  mudlog(CMP, LVL_GOD, TRUE, "Connection attempt denied from [%s]", d->host);
+	  STATE(d) = CON_CLOSE;
+	}
+	continue;
+      }
+    }
+    d->ignore_proxy = 1;
+
+    if (d->str)		/* Writing boards, mail, etc. */
+      string_add(d, comm);
+    else if (d->showstr_count) /* Reading something w/ pager */
+      show_string(d, comm);
+    else if (STATE(d) != CON_PLAYING) /* In menus, etc. */
+      nanny(d, comm);
+    else {			/* else: we're playing normally. */
+      if (aliased)		/* To prevent recursive aliases. */
+	d->has_prompt = TRUE;	/* To get newline before next cmd output. */
+      else if (perform_alias(d, comm, sizeof(comm)))    /* Run it through aliasing system */
+	get_from_q(&d->input, comm, &aliased);
+      command_interpreter(d->character, comm); /* Send it to interpreter */
+    }
+  }
+}
+
+
 void heartbeat(int pulse)
 {
   static int mins_since_crashsave = 0;
 
   if (!(pulse % PULSE_ZONE))
-    zone_update();
+    BENCH_STAGE(BENCH_ZONE, zone_update());
 
   if (!(pulse % PULSE_IDLEPWD))		/* 15 seconds */
-    check_idle_passwords();
+    BENCH_STAGE(BENCH_IDLEPWD, check_idle_passwords());
 
   if (!(pulse % PULSE_MOBILE))
-    mobile_activity();
+    BENCH_STAGE(BENCH_MOBILE, mobile_activity());
+  BENCH_STAGE(BENCH_MOBILE_ENTRY, mobile_entry_checks());
 
   if (!(pulse % PULSE_VIOLENCE))
-    perform_violence();
+    BENCH_STAGE(BENCH_VIOLENCE, perform_violence());
 
   if (!(pulse % (30 * PASSES_PER_SEC)))
-    make_who2html();
+    BENCH_STAGE(BENCH_WHO, make_who2html());
 
   if (!(pulse % PASSES_PER_SEC))
-    webserver_refresh_who();
+    BENCH_STAGE(BENCH_WHO, webserver_refresh_who());
 
   if (!(pulse % (60 RL_SEC))) {
     struct descriptor_data *gmcp_d;
@@ -894,9 +1024,7 @@ void heartbeat(int pulse)
   }
 
   if (!(pulse % (SECS_PER_MUD_HOUR * PASSES_PER_SEC))) {
-    weather_and_time(1);
-    affect_update();
-    point_update();
+    BENCH_STAGE(BENCH_HOURLY, weather_and_time(1); affect_update(); point_update());
     { struct descriptor_data *gmcp_d;
       for (gmcp_d = descriptor_list; gmcp_d; gmcp_d = gmcp_d->next)
         if (STATE(gmcp_d) == CON_PLAYING && gmcp_d->character)
@@ -907,21 +1035,22 @@ void heartbeat(int pulse)
   if (auto_save && !(pulse % PULSE_AUTOSAVE)) {	/* 1 minute */
     if (++mins_since_crashsave >= autosave_time) {
       mins_since_crashsave = 0;
-      Crash_save_all();
-      House_save_all();
+      BENCH_STAGE(BENCH_AUTOSAVE, Crash_save_all(); House_save_all());
     }
   }
 
-  if (!(pulse % PULSE_USAGE))
-    record_usage();
+  if (!(pulse % PULSE_USAGE_FEED))
+    BENCH_STAGE(BENCH_USAGE, record_usage(!(pulse % PULSE_USAGE)));
 
   if (!(pulse % PULSE_TIMESAVE))
     save_mud_time(&time_info);
 
-  webserver_olc_heartbeat();
+  BENCH_STAGE(BENCH_OLC, webserver_olc_heartbeat());
+
+  BENCH_STAGE(BENCH_CRASH_SWEEP, Crash_sweep_pulse());
 
   /* Every pulse! Don't want them to stink the place up... */
-  extract_pending_chars();
+  BENCH_STAGE(BENCH_EXTRACT, extract_pending_chars());
 }
 
 
@@ -977,7 +1106,8 @@ void timeadd(struct timeval *rslt, struct timeval *a, struct timeval *b)
 }
 
 
-void record_usage(void)
+/* Every minute for the web status feed, and into the log now and then. */
+void record_usage(int log_it)
 {
   int sockets_connected = 0, sockets_playing = 0;
   struct descriptor_data *d;
@@ -988,6 +1118,10 @@ void record_usage(void)
       sockets_playing++;
   }
 
+  webserver_feed_usage(sockets_connected, sockets_playing);
+  if (!log_it)
+    return;
+
   log("nusage: %-3d sockets connected, %-3d sockets playing",
 	  sockets_connected, sockets_playing);
 
@@ -1363,29 +1497,216 @@ int set_sendbuf(socket_t s)
   return (0);
 }
 
+/*
+ * Limits on connections from any one address, checked before anything
+ * is allocated for a new connection.  Each address has a token bucket
+ * that holds site_connect_burst connections and refills at
+ * site_connect_rate a minute, and may have no more than
+ * site_max_connections sockets open at once.  Connections from this
+ * machine aren't limited: they are usually a proxy, and the address it
+ * passes on in its PROXY line is counted instead.
+ */
+#define SITE_HASH_SIZE		256	/* hash buckets */
+#define SITE_MAX		4096	/* addresses before pruning */
+#define SITE_TOKEN		60	/* one connection's worth of tokens */
+
+struct conn_site {
+  struct in_addr addr;
+  int tokens;
+  time_t refilled;
+  int open;			/* descriptors counted against us */
+  int refusing;			/* turned away since last let in */
+  struct conn_site *next;
+};
+
+static struct conn_site *conn_sites[SITE_HASH_SIZE];
+static int conn_site_count = 0;
+
+
+static int site_hash(struct in_addr addr)
+{
+  unsigned long a = ntohl(addr.s_addr);
+
+  return ((a ^ (a >> 8) ^ (a >> 16) ^ (a >> 24)) & (SITE_HASH_SIZE - 1));
+}
+
+
+/* Top up the bucket for the time gone by. */
+static void site_refill(struct conn_site *site, time_t now)
+{
+  int cap = site_connect_burst * SITE_TOKEN;
+
+  if (now > site->refilled) {
+    /* Rate is per minute and a connection costs 60, so 1 a second each. */
+    site->tokens += MIN((now - site->refilled) * site_connect_rate, cap);
+    site->tokens = MIN(site->tokens, cap);
+    site->refilled = now;
+  }
+}
+
+
+/* Forget addresses with nothing open and a full bucket, or failing that, nothing open. */
+static void site_prune(time_t now)
+{
+  struct conn_site *site, **prev;
+  int i, pass;
+
+  for (pass = 0; pass < 2 && conn_site_count >= SITE_MAX; pass++)
+    for (i = 0; i < SITE_HASH_SIZE; i++)
+      for (prev = &conn_sites[i]; (site = *prev) != NULL; ) {
+	site_refill(site, now);
+	if (!site->open && (pass || site->tokens >= site_connect_burst * SITE_TOKEN)) {
+	  *prev = site->next;
+	  free(site);
+	  conn_site_count--;
+	} else
+	  prev = &site->next;
+      }
+}
+
+
+static struct conn_site *site_find(struct in_addr addr)
+{
+  struct conn_site *site;
+  time_t now = time(0);
+
+  for (site = conn_sites[site_hash(addr)]; site; site = site->next)
+    if (site->addr.s_addr == addr.s_addr) {
+      site_refill(site, now);
+      return (site);
+    }
+
+  if (conn_site_count >= SITE_MAX)
+    site_prune(now);
+  CREATE(site, struct conn_site, 1);
+  site->addr = addr;
+  site->tokens = site_connect_burst * SITE_TOKEN;
+  site->refilled = now;
+  site->next = conn_sites[site_hash(addr)];
+  conn_sites[site_hash(addr)] = site;
+  conn_site_count++;
+  return (site);
+}
+
+
+/*
+ * Count a new connection from addr against its limits.  Returns TRUE if
+ * it may come in, in which case *sitep is what to hang on the descriptor.
+ */
+static int site_admit(struct in_addr addr, struct conn_site **sitep)
+{
+  struct conn_site *site;
+  const char *why = NULL;
+
+  *sitep = NULL;
+  if ((ntohl(addr.s_addr) >> 24) == 127)
+    return (TRUE);
+
+  site = site_find(addr);
+  if (site_max_connections > 0 && site->open >= site_max_connections)
+    why = "too many connections open";
+  else if (site_connect_rate > 0 && site_connect_burst > 0 && site->tokens < SITE_TOKEN)
+    why = "connecting too often";
+
+  if (why) {
+    /* Just once per flood. */
+    if (!site->refusing++)
+      mudlog(CMP, LVL_GOD, TRUE, "Refusing connections from [%s]: %s", inet_ntoa(addr), why);
+    conn_rejected++;
+    return (FALSE);
+  }
+
+  if (site_connect_rate > 0 && site_connect_burst > 0)
+    site->tokens -= SITE_TOKEN;
+  site->refusing = 0;
+  site->open++;
+  *sitep = site;
+  return (TRUE);
+}
+
+
+static void site_release(struct descriptor_data *d)
+{
+  if (d->site) {
+    d->site->open--;
+    d->site = NULL;
+  }
+}
+
+
+/*
+ * Take one connection off the mother socket.  Returns 1 if there may be
+ * more waiting, 0 if there are none left and -1 on error.
+ */
 int new_descriptor(socket_t s)
 {
   socket_t desc;
-  int sockets_connected = 0;
+  int sockets_connected = 0, banned;
   socklen_t i;
   static int last_desc = 0;	/* last descriptor number */
   struct descriptor_data *newd;
   struct sockaddr_in peer;
-  struct hostent *from;
+  struct conn_site *site;
 
   /* accept the new connection */
   i = sizeof(peer);
-  if ((desc = accept(s, (struct sockaddr *) &peer, &i)) == INVALID_SOCKET) {
+#if defined(HAVE_ACCEPT4) && defined(SOCK_NONBLOCK)
+  desc = accept4(s, (struct sockaddr *) &peer, &i, SOCK_NONBLOCK);
+#else
+  desc = accept(s, (struct sockaddr *) &peer, &i);
+#endif
+  if (desc == INVALID_SOCKET) {
+#if defined(CIRCLE_WINDOWS)
+    if (WSAGetLastError() == WSAEWOULDBLOCK)
+      return (0);
+#else
+#ifdef EAGAIN		/* POSIX */
+    if (errno == EAGAIN)
+      return (0);
+#endif
+#ifdef EWOULDBLOCK	/* BSD */
+    if (errno == EWOULDBLOCK)
+      return (0);
+#endif
+#ifdef EINTR
+    if (errno == EINTR)
+      return (1);
+#endif
+#ifdef ECONNABORTED	/* Gave up before we got to it. */
+    if (errno == ECONNABORTED)
+      return (1);
+#endif
+#endif /* CIRCLE_WINDOWS */
     perror("SYSERR: accept");
     return (-1);
   }
+#if !defined(HAVE_ACCEPT4) || !defined(SOCK_NONBLOCK)
   /* keep it from blocking */
   nonblock(desc);
+#endif
+
+#if !defined(CIRCLE_WINDOWS)
+  /* select() can't watch it; FD_SET() would write past the fd_set. */
+  if (desc >= FD_SETSIZE) {
+    conn_rejected++;
+    write_to_descriptor(desc, "Sorry, CircleMUD is full right now... please try again later!\r\n");
+    CLOSE_SOCKET(desc);
+    return (1);
+  }
+#endif
+
+  /* Turn away sites that are hammering us before they cost anything. */
+  if (!site_admit(peer.sin_addr, &site)) {
+    CLOSE_SOCKET(desc);
+    return (1);
+  }
 
   /* set the send buffer size */
   if (set_sendbuf(desc) < 0) {
+    if (site)
+      site->open--;
     CLOSE_SOCKET(desc);
-    return (0);
+    return (1);
   }
 
   /* make sure we have room for it */
@@ -1393,35 +1714,41 @@ int new_descriptor(socket_t s)
     sockets_connected++;
 
   if (sockets_connected >= max_players) {
+    if (site)
+      site->open--;
+    conn_rejected++;
     write_to_descriptor(desc, "Sorry, CircleMUD is full right now... please try again later!\r\n");
     CLOSE_SOCKET(desc);
-    return (0);
+    return (1);
   }
   /* create a new descriptor */
   CREATE(newd, struct descriptor_data, 1);
+  newd->site = site;
 
-  /* find the sitename */
-  if (nameserver_is_slow || !(from = gethostbyaddr((char *) &peer.sin_addr,
-				      sizeof(peer.sin_addr), AF_INET))) {
-
-    /* resolution failed */
-    if (!nameserver_is_slow)
-      perror("SYSERR: gethostbyaddr");
+  /* find the numeric site address */
+  strncpy(newd->host, (char *)inet_ntoa(peer.sin_addr), HOST_LENGTH);	/* strncpy: OK (n->host:HOST_LENGTH+1) */
+  *(newd->host + HOST_LENGTH) = '\0';
+  strcpy(newd->ip, newd->host);	/* strcpy: OK (same size) */
 
-    /* find the numeric site address */
-    strncpy(newd->host, (char *)inet_ntoa(peer.sin_addr), HOST_LENGTH);	/* strncpy: OK (n->host:HOST_LENGTH+1) */
-    *(newd->host + HOST_LENGTH) = '\0';
-  } else {
-    strncpy(newd->host, from->h_name, HOST_LENGTH);	/* strncpy: OK (n->host:HOST_LENGTH+1) */
-    *(newd->host + HOST_LENGTH) = '\0';
-  }
-
-  /* determine if the site is banned */
-  if (isbanned(newd->host) == BAN_ALL) {
+  /*
+   * Determine if the site is banned: by number first, then by name if
+   * the name is cached.  Otherwise it's looked up in the background and
+   * resolver_poll() checks it again.
+   */
+  banned = (isbanned(newd->host) == BAN_ALL);
+  if (!banned && !nameserver_is_slow) {
+    resolver_lookup(newd, peer.sin_addr);
+    banned = (strcmp(newd->host, inet_ntoa(peer.sin_addr)) &&
+	      isbanned(newd->host) == BAN_ALL);
+  }
+  if (banned) {
+    resolver_cancel(newd);
+    site_release(newd);
+    conn_rejected++;
     CLOSE_SOCKET(desc);
     mudlog(CMP, LVL_GOD, TRUE, "Connection attempt denied from [%s]", newd->host);
     free(newd);
-    return (0);
+    return (1);
   }
 #if 0
   /*
@@ -1461,7 +1788,8 @@ int new_descriptor(socket_t s)
   write_to_output(newd, "%s", GREETINGS);
   gmcp_send_will(newd);
 
-  return (0);
+  conn_accepted++;
+  return (1);
 }
 
 
@@ -1480,6 +1808,14 @@ int process_output(struct descriptor_data *t)
   char i[MAX_SOCK_BUF], *osb = i + 2;
   int result;
 
+  /* Compressed output from last time goes first. */
+  if (t->mccp && (result = mccp_flush(t)) <= 0) {
+    if (result == 0)
+      return (0);
+    close_socket(t);
+    return (-1);
+  }
+
   /* we may need this \r\n for later -- see below */
   strcpy(i, "\r\n");	/* strcpy: OK (for 'MAX_SOCK_BUF >= 3') */
 
@@ -1503,11 +1839,15 @@ int process_output(struct descriptor_data *t)
    */
   if (t->has_prompt) {
     t->has_prompt = FALSE;
-    result = write_to_descriptor(t->descriptor, i);
+    result = write_to_client(t, i, strlen(i));
     if (result >= 2)
       result -= 2;
   } else
-    result = write_to_descriptor(t->descriptor, osb);
+    result = write_to_client(t, osb, strlen(osb));
+
+  /* That's a prompt, so the client should see it all now. */
+  if (t->mccp && result >= 0 && mccp_flush(t) < 0)
+    result = -1;
 
   if (result < 0) {	/* Oops, fatal error. Bye! */
     close_socket(t);
@@ -1717,6 +2057,19 @@ int write_to_descriptor_n(socket_t desc, const char *txt, size_t len)
 }
 
 
+/*
+ * Text for a connected client goes through here, so that it's compressed
+ * if the client asked for MCCP.  Returns as write_to_descriptor_n() does;
+ * compressed text is always all taken.
+ */
+int write_to_client(struct descriptor_data *d, const char *txt, size_t len)
+{
+  if (d->mccp)
+    return (mccp_write(d, txt, len));
+  return (write_to_descriptor_n(d->descriptor, txt, len));
+}
+
+
 /*
  * Same information about perform_socket_write applies here. I like
  * standards, there are so many of them. -gg 6/30/98
@@ -1897,7 +2250,7 @@ int process_input(struct descriptor_data *t)
       char buffer[MAX_INPUT_LENGTH + 64];
 
       snprintf(buffer, sizeof(buffer), "Line too long.  Truncated to:\r\n%s\r\n", tmp);
-      if (write_to_descriptor(t->descriptor, buffer) < 0)
+      if (write_to_client(t, buffer, strlen(buffer)) < 0)
 	return (-1);
     }
     if (t->snoop_by)
@@ -2017,6 +2370,7 @@ void close_socket(struct descriptor_data *d)
   struct descriptor_data *temp;
 
   gmcp_send_goodbye(d);
+  mccp_stop(d);
   REMOVE_FROM_LIST(d, descriptor_list, next);
   CLOSE_SOCKET(d->descriptor);
   flush_queues(d);
@@ -2048,6 +2402,7 @@ void close_socket(struct descriptor_data *d)
 
       /* We are guaranteed to have a person. */
       act("$n has lost $s link.", TRUE, link_challenged, 0, 0, TO_ROOM);
+      webserver_feed_logout(link_challenged, "link");
       save_char(link_challenged);
       mudlog(NRM, MAX(LVL_IMMORT, GET_INVIS_LEV(link_challenged)), TRUE, "Closing link to: %s.", GET_NAME(link_challenged));
     } else {
@@ -2057,6 +2412,12 @@ void close_socket(struct descriptor_data *d)
   } else
     mudlog(CMP, LVL_IMMORT, TRUE, "Losing descriptor without char.");
 
+  /* Nobody is going to use the player files read ahead at login. */
+  plrfile_prefetch_cancel(d->prefetch);
+  resolver_cancel(d);
+  pwhash_cancel(d);
+  site_release(d);
+
   /* JE 2/22/95 -- part of my unending quest to make switch stable */
   if (d->original && d->original->desc)
     d->original->desc = NULL;
@@ -9,6 +9,7 @@
 ************************************************************************ */
 
 #define NUM_RESERVED_DESCS	8
+#define NUM_SPARE_SELECT_DESCS	64	/* web, resolver, files below FD_SETSIZE */
 
 /* comm.c */
 size_t	send_to_char(struct char_data *ch, const char *messg, ...) __attribute__ ((format (printf, 2, 3)));
@@ -33,6 +34,7 @@ void	act(const char *str, int hide_invisible, struct char_data *ch,
 void	write_to_q(const char *txt, struct txt_q *queue, int aliased);
 int	write_to_descriptor(socket_t desc, const char *txt);
 int	write_to_descriptor_n(socket_t desc, const char *txt, size_t len);
+int	write_to_client(struct descriptor_data *d, const char *txt, size_t len);
 size_t	write_to_output(struct descriptor_data *d, const char *txt, ...) __attribute__ ((format (printf, 2, 3)));
 size_t	vwrite_to_output(struct descriptor_data *d, const char *format, va_list args);
 void	string_add(struct descriptor_data *d, char *str);
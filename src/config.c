@@ -119,6 +119,16 @@ int track_through_doors = YES;
  */
 int immort_level_ok = 0;
 
+/*
+ * Mobiles in a zone that has had no players in it or next door (in a
+ * zone with an exit to it) for half a minute are left alone, acting only
+ * every dormant_mob_pulses mobile pulses (10 seconds each), or not at
+ * all if that is 0.  Set dormant_zones to NO to keep every zone going
+ * all the time; 'zedit <zone> active' does that for one zone.
+ */
+int dormant_zones = YES;
+int dormant_mob_pulses = 6;
+
 
 /****************************************************************************/
 /****************************************************************************/
@@ -160,6 +170,24 @@ int crash_file_timeout = 10;
 /* Lifetime of normal rent files in days */
 int rent_file_timeout = 30;
 
+/*
+ * How many rent files the boot-time expiry sweep examines per pulse once
+ * the game is running.  0 means sweep all of them during boot as usual;
+ * a positive value lets a MUD with a huge player base start accepting
+ * connections before the sweep has finished.
+ */
+int rent_sweep_per_pulse = 0;
+
+/*
+ * Keep each player's rent, aliases and equipment sets together in one
+ * file under plrbundles/ instead of separate plrobjs/, plralias/ and
+ * plreqsets/ files, so entering the game is a single read.  Players are
+ * converted as they are saved; bin/plrbundle converts (or, with -u,
+ * unconverts) everyone at once.  Don't turn this off again without
+ * running 'plrbundle -u' first.
+ */
+int player_bundles = NO;
+
 
 /****************************************************************************/
 /****************************************************************************/
@@ -257,6 +285,15 @@ int max_filesize = 50000;
 /* maximum number of password attempts before disconnection */
 int max_bad_pws = 3;
 
+/*
+ * A site that gets the password wrong login_fail_limit times (over any
+ * number of connections, here or at the web OLC login) within
+ * login_fail_window seconds is refused until the window is up.  Set
+ * login_fail_limit to 0 to allow any number of guesses.
+ */
+int login_fail_limit = 10;
+int login_fail_window = 600;
+
 /*
  * Rationale for enabling this, as explained by naved@bird.taponline.com.
  *
@@ -288,6 +325,35 @@ int siteok_everyone = TRUE;
 
 int nameserver_is_slow = NO;
 
+/*
+ * Site names are looked up in the background (when the server was built
+ * with pthreads), so a slow nameserver no longer lags the game.  A new
+ * connection is held at the name prompt for up to dns_timeout seconds
+ * waiting for its name, so that bans on site names apply before anyone
+ * logs in; after that it carries on under its numeric address.  Answers
+ * are remembered for dns_cache_ttl seconds (0 to not remember them).
+ */
+int dns_timeout = 5;
+int dns_cache_ttl = 3600;
+
+/*
+ * Limits on connections from any one address, applied as they are
+ * accepted.  An address may open site_connect_burst connections in a
+ * row, after which it gets site_connect_rate more a minute; it may have
+ * at most site_max_connections open at once.  0 turns a limit off.
+ * Connections from localhost are not limited (see new_descriptor()).
+ */
+int site_connect_burst = 10;
+int site_connect_rate = 30;
+int site_max_connections = 10;
+
+/*
+ * Clients that ask for MCCP (v2) get their output compressed with zlib
+ * at this level: 1 is fastest, 9 squeezes hardest.  0 stops us offering
+ * it.  Needs a server built with zlib.
+ */
+int mccp_level = 6;
+
 
 const char *MENU =
 "\r\n"
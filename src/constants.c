@@ -242,6 +242,11 @@ const char *connected_types[] = {
   "Self-Delete 1",
   "Self-Delete 2",
   "Disconnecting",
+  "Remort reroll",
+  "Remort stat 1",
+  "Remort stat 2",
+  "OLC editing",
+  "Verifying PW",
   "\n"
 };
 
@@ -25,6 +25,7 @@
 #include "house.h"
 #include "locker.h"
 #include "constants.h"
+#include "webserver.h"
 
 /**************************************************************************
 *  declarations of most of the 'global' variables                         *
@@ -108,6 +109,7 @@ void load_help(FILE *fl);
 void assign_mobiles(void);
 void assign_objects(void);
 void assign_rooms(void);
+void assign_spec_triggers(void);
 void assign_the_shopkeepers(void);
 void build_player_index(void);
 int is_empty(zone_rnum zone_nr);
@@ -186,9 +188,15 @@ void load_config(void)
   extern int max_npc_corpse_time, max_pc_corpse_time;
   extern int idle_void, idle_rent_time;
   extern int dts_are_dumps, load_into_inventory, track_through_doors;
-  extern int immort_level_ok, free_rent, max_obj_save, min_rent_cost;
+  extern int immort_level_ok, dormant_zones, dormant_mob_pulses;
+  extern int free_rent, max_obj_save, min_rent_cost;
   extern int auto_save, autosave_time, crash_file_timeout, rent_file_timeout;
-  extern int max_filesize, max_bad_pws, siteok_everyone, nameserver_is_slow;
+  extern int rent_sweep_per_pulse, player_bundles;
+  extern int max_playing, max_filesize, max_bad_pws, siteok_everyone, nameserver_is_slow;
+  extern int login_fail_limit, login_fail_window;
+  extern int dns_timeout, dns_cache_ttl;
+  extern int site_connect_burst, site_connect_rate, site_max_connections;
+  extern int mccp_level;
   extern int use_autowiz, movement_is_free;
   extern int max_locker_name_length, max_locker_vnum_count, max_locker_vnum_types;
   extern int max_lockers_owned, max_lockers_shared;
@@ -213,6 +221,8 @@ void load_config(void)
     { "load_into_inventory",  &load_into_inventory  },
     { "track_through_doors",  &track_through_doors  },
     { "immort_level_ok",      &immort_level_ok      },
+    { "dormant_zones",        &dormant_zones        },
+    { "dormant_mob_pulses",   &dormant_mob_pulses   },
     { "free_rent",            &free_rent            },
     { "max_obj_save",         &max_obj_save         },
     { "min_rent_cost",        &min_rent_cost        },
@@ -220,10 +230,21 @@ void load_config(void)
     { "autosave_time",        &autosave_time        },
     { "crash_file_timeout",   &crash_file_timeout   },
     { "rent_file_timeout",    &rent_file_timeout    },
+    { "rent_sweep_per_pulse", &rent_sweep_per_pulse },
+    { "player_bundles",       &player_bundles       },
+    { "max_playing",          &max_playing          },
     { "max_filesize",         &max_filesize         },
     { "max_bad_pws",          &max_bad_pws          },
+    { "login_fail_limit",     &login_fail_limit     },
+    { "login_fail_window",    &login_fail_window    },
     { "siteok_everyone",      &siteok_everyone      },
     { "nameserver_is_slow",   &nameserver_is_slow   },
+    { "dns_timeout",          &dns_timeout          },
+    { "dns_cache_ttl",        &dns_cache_ttl        },
+    { "site_connect_burst",   &site_connect_burst   },
+    { "site_connect_rate",    &site_connect_rate    },
+    { "site_max_connections", &site_max_connections },
+    { "mccp_level",           &mccp_level           },
     { "use_autowiz",          &use_autowiz          },
     { "movement_is_free",     &movement_is_free     },
     { "max_locker_name_length", &max_locker_name_length },
@@ -419,6 +440,8 @@ void boot_world(void)
 
   log("Loading zone permissions.");
   olc_load_permissions();
+
+  build_zone_neighbors();
 }
 
 
@@ -489,6 +512,7 @@ void destroy_db(void)
     if (obj_proto[cnt].action_description)
       free(obj_proto[cnt].action_description);
     free_extra_descriptions(obj_proto[cnt].ex_description);
+    keyword_set_free(obj_index[cnt].keywords);
   }
   free(obj_proto);
   free(obj_index);
@@ -508,6 +532,7 @@ void destroy_db(void)
 
     while (mob_proto[cnt].affected)
       affect_remove(&mob_proto[cnt], mob_proto[cnt].affected);
+    keyword_set_free(mob_index[cnt].keywords);
   }
   free(mob_proto);
   free(mob_index);
@@ -521,6 +546,8 @@ void destroy_db(void)
       free(zone_table[cnt].name);
     if (zone_table[cnt].cmd)
       free(zone_table[cnt].cmd);
+    if (zone_table[cnt].neighbors)
+      free(zone_table[cnt].neighbors);
   }
   free(zone_table);
 }
@@ -581,6 +608,8 @@ void boot_db(void)
     assign_objects();
     log("   Rooms.");
     assign_rooms();
+    log("   Triggers.");
+    assign_spec_triggers();
   }
 
   log("Assigning spell and skill levels.");
@@ -1107,6 +1136,7 @@ void parse_room(FILE *fl, int virtual_nr)
   world[room_nr].func = NULL;
   world[room_nr].contents = NULL;
   world[room_nr].people = NULL;
+  world[room_nr].spec_count = 0;
   world[room_nr].light = 0;	/* Zero light sources */
 
   for (i = 0; i < NUM_OF_DIRS; i++)
@@ -1500,6 +1530,7 @@ void parse_mobile(FILE *mob_f, int nr)
 
   /***** String data *****/
   mob_proto[i].player.name = fread_string(mob_f, buf2);
+  mob_index[i].keywords = keyword_set_build(mob_proto[i].player.name);
   tmpptr = mob_proto[i].player.short_descr = fread_string(mob_f, buf2);
   if (tmpptr && *tmpptr)
     if (!str_cmp(fname(tmpptr), "a") || !str_cmp(fname(tmpptr), "an") ||
@@ -1596,6 +1627,7 @@ char *parse_object(FILE *obj_f, int nr)
     log("SYSERR: Null obj name or format error at or near %s", buf2);
     exit(1);
   }
+  obj_index[i].keywords = keyword_set_build(obj_proto[i].name);
   tmpptr = obj_proto[i].short_description = fread_string(obj_f, buf2);
   if (tmpptr && *tmpptr)
     if (!str_cmp(fname(tmpptr), "a") || !str_cmp(fname(tmpptr), "an") ||
@@ -1959,6 +1991,7 @@ struct char_data *create_char(void)
   clear_char(ch);
   ch->next = character_list;
   character_list = ch;
+  keyword_index_char(ch);
 
   return (ch);
 }
@@ -1983,6 +2016,8 @@ struct char_data *read_mobile(mob_vnum nr, int type) /* and mob_rnum */
   *mob = mob_proto[i];
   mob->next = character_list;
   character_list = mob;
+  keyword_index_char(mob);
+  char_lists_update(mob);
 
   mob->points.max_hit = dice(mob->mob_specials.hpnodice,
 			     mob->mob_specials.hpsizedice) + mob->mob_specials.hpextra;
@@ -2012,6 +2047,7 @@ struct obj_data *create_obj(void)
   clear_object(obj);
   obj->next = object_list;
   object_list = obj;
+  keyword_index_obj(obj);
 
   return (obj);
 }
@@ -2033,6 +2069,7 @@ struct obj_data *read_object(obj_vnum nr, int type) /* and obj_rnum */
   *obj = obj_proto[i];
   obj->next = object_list;
   object_list = obj;
+  keyword_index_obj(obj);
 
   obj_index[i].number++;
 
@@ -2097,7 +2134,7 @@ void zone_update(void)
   for (update_u = reset_q.head; update_u; update_u = update_u->next)
     if ((zone_table[update_u->zone_to_reset].reset_mode == 2 ||
 	 is_empty(update_u->zone_to_reset)) &&
-	zone_table[update_u->zone_to_reset].permissions.flags == 0) {
+	!(zone_table[update_u->zone_to_reset].permissions.flags & (OLC_ZONEFLAGS_CLOSED | OLC_ZONEFLAGS_LOCKED))) {
       reset_zone(update_u->zone_to_reset);
       mudlog(CMP, LVL_GOD, FALSE, "Auto zone reset: %s", zone_table[update_u->zone_to_reset].name);
       /* dequeue */
@@ -2185,6 +2222,51 @@ void clean_zone(zone_rnum zone)
  * day.
  */
 
+/* Record that zones a and b have an exit between them. */
+static void add_zone_neighbor(zone_rnum a, zone_rnum b)
+{
+  struct zone_data *z = &zone_table[a];
+  int i;
+
+  for (i = 0; i < z->num_neighbors; i++)
+    if (z->neighbors[i] == b)
+      return;
+  RECREATE(z->neighbors, zone_rnum, z->num_neighbors + 1);
+  z->neighbors[z->num_neighbors++] = b;
+}
+
+
+/*
+ * Work out which zones border which from the exits between their rooms,
+ * either way, for deciding which zones have players near them.  Called
+ * at boot and whenever OLC saves a room.
+ */
+void build_zone_neighbors(void)
+{
+  room_rnum room, to;
+  zone_rnum zone;
+  int door;
+
+  for (zone = 0; zone <= top_of_zone_table; zone++) {
+    if (zone_table[zone].neighbors)
+      free(zone_table[zone].neighbors);
+    zone_table[zone].neighbors = NULL;
+    zone_table[zone].num_neighbors = 0;
+  }
+
+  for (room = 0; room <= top_of_world; room++)
+    for (door = 0; door < NUM_OF_DIRS; door++) {
+      if (!world[room].dir_option[door])
+        continue;
+      to = world[room].dir_option[door]->to_room;
+      if (to == NOWHERE || world[to].zone == world[room].zone)
+        continue;
+      add_zone_neighbor(world[room].zone, world[to].zone);
+      add_zone_neighbor(world[to].zone, world[room].zone);
+    }
+}
+
+
 /* execute the reset command table of a given zone */
 void reset_zone(zone_rnum zone)
 {
@@ -2330,6 +2412,7 @@ void reset_zone(zone_rnum zone)
   }
 
   zone_table[zone].age = 0;
+  webserver_feed_reset(zone);
 }
 
 
@@ -2497,6 +2580,7 @@ void store_to_char(struct char_file_u *st, struct char_data *ch)
     if (st->affected[i].type)
       affect_to_char(ch, &st->affected[i]);
   }
+  affect_total(ch);
 
   /*
    * If you're not poisioned and you've been away for more than an hour of
@@ -2523,6 +2607,7 @@ void char_to_store(struct char_data *ch, struct char_file_u *st)
 
   /* Unaffect everything a character can be affected by */
 
+  affect_batch_begin(ch);
   for (i = 0; i < NUM_WEARS; i++) {
     if (GET_EQ(ch, i))
       char_eq[i] = unequip_char(ch, i);
@@ -2557,8 +2642,6 @@ void char_to_store(struct char_data *ch, struct char_file_u *st)
   if ((i >= MAX_AFFECT) && af && af->next)
     log("SYSERR: WARNING: OUT OF STORE ROOM FOR AFFECTED TYPES!!!");
 
-  ch->aff_abils = ch->real_abils;
-
   st->birth = ch->player.time.birth;
   st->played = ch->player.time.played;
   st->played += time(0) - ch->player.time.logon;
@@ -2612,7 +2695,7 @@ void char_to_store(struct char_data *ch, struct char_file_u *st)
     if (char_eq[i])
       equip_char(ch, char_eq[i], i);
   }
-/*   affect_total(ch); unnecessary, I think !?! */
+  affect_batch_end(ch);
 }				/* Char to store */
 
 
@@ -2706,6 +2789,8 @@ void free_char(struct char_data *ch)
   int i;
   struct alias_data *a;
 
+  keyword_unindex_char(ch);
+
   if (ch->player_specials != NULL && ch->player_specials != &dummy_mob) {
     while ((a = GET_ALIASES(ch)) != NULL) {
       GET_ALIASES(ch) = (GET_ALIASES(ch))->next;
@@ -2762,6 +2847,8 @@ void free_obj(struct obj_data *obj)
 {
   int nr;
 
+  keyword_unindex_obj(obj);
+
   if ((nr = GET_OBJ_RNUM(obj)) == NOTHING) {
     if (obj->name)
       free(obj->name);
@@ -2889,6 +2976,7 @@ void reset_char(struct char_data *ch)
   ch->master = NULL;
   IN_ROOM(ch) = NOWHERE;
   ch->carrying = NULL;
+  ch->spec_objs = 0;
   ch->next = NULL;
   ch->next_fighting = NULL;
   ch->next_in_room = NULL;
@@ -3021,6 +3109,7 @@ void init_char(struct char_data *ch)
   ch->real_abils.str_add = 100;
   ch->real_abils.con = 25;
   ch->real_abils.cha = 25;
+  affect_total(ch);
 
   for (i = 0; i < 3; i++)
     GET_COND(ch, i) = (GET_LEVEL(ch) == LVL_IMPL ? -1 : 24);
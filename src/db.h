@@ -27,6 +27,7 @@
 #define LIB_PLRTEXT	":plrtext:"
 #define LIB_PLROBJS	":plrobjs:"
 #define LIB_PLRALIAS	":plralias:"
+#define LIB_PLRBUNDLES	":plrbundles:"
 #define LIB_HOUSE	":house:"
 #define LIB_PLRLOCKERS	":plrlockers:"
 #define SLASH		":"
@@ -40,6 +41,7 @@
 #define LIB_PLROBJS	"plrobjs/"
 #define LIB_PLRALIAS	"plralias/"
 #define LIB_PLREQSETS	"plreqsets/"
+#define LIB_PLRBUNDLES	"plrbundles/"
 #define LIB_HOUSE	"house/"
 #define LIB_PLRLOCKERS	"plrlockers/"
 #define SLASH		"/"
@@ -51,6 +53,7 @@
 #define SUF_TEXT	"text"
 #define SUF_ALIAS	"alias"
 #define SUF_EQSET	"eqset"
+#define SUF_BUNDLE	"bundle"
 
 #if defined(CIRCLE_AMIGA)
 #define FASTBOOT_FILE   "/.fastboot"    /* autorun: boot without sleep  */
@@ -109,6 +112,7 @@ void	boot_db(void);
 void	destroy_db(void);
 int	create_entry(char *name);
 void	zone_update(void);
+void	build_zone_neighbors(void);
 char	*fread_string(FILE *fl, const char *error);
 long	get_ptable_by_name(const char *name);
 long	get_id_by_name(const char *name);
@@ -195,6 +199,11 @@ struct zone_data {
    zone_vnum number;	    /* virtual number of this zone	  */
    struct reset_com *cmd;   /* command table for reset	          */
    struct olc_permissions_s permissions;
+
+   zone_rnum *neighbors;    /* zones with an exit into or out of it */
+   int  num_neighbors;
+   int  dormant;            /* no players in or next to it (mobact.c) */
+   int  idle;               /* PULSE_MOBILEs since there were       */
 };
 
 
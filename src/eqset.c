@@ -12,6 +12,7 @@
 #include "structs.h"
 #include "utils.h"
 #include "db.h"
+#include "bundle.h"
 
 void write_eqsets(struct char_data *ch);
 void read_eqsets(struct char_data *ch);
@@ -47,14 +48,15 @@ void write_eqsets(struct char_data *ch)
   struct eqset_data *s;
   int i;
 
-  get_filename(fn, sizeof(fn), EQSET_FILE, GET_NAME(ch));
+  plrfile_path(fn, sizeof(fn), EQSET_FILE, GET_NAME(ch));
   mkdir_for_file(fn);
-  remove(fn);
 
-  if (GET_EQSETS(ch) == NULL)
+  if (GET_EQSETS(ch) == NULL) {
+    plrfile_remove(EQSET_FILE, GET_NAME(ch));
     return;
+  }
 
-  if ((file = fopen(fn, "w")) == NULL) {
+  if ((file = plrfile_open(EQSET_FILE, GET_NAME(ch), "w")) == NULL) {
     log("SYSERR: Couldn't save eqsets for %s in '%s'.", GET_NAME(ch), fn);
     perror("SYSERR: write_eqsets");
     return;
@@ -66,7 +68,7 @@ void write_eqsets(struct char_data *ch)
       fprintf(file, "%d\n", (int)s->vnums[i]);
   }
 
-  fclose(file);
+  plrfile_close(file);
 }
 
 void read_eqsets(struct char_data *ch)
@@ -76,10 +78,9 @@ void read_eqsets(struct char_data *ch)
   struct eqset_data *s, *last = NULL;
   int i;
 
-  get_filename(buf, sizeof(buf), EQSET_FILE, GET_NAME(ch));
-
-  if ((file = fopen(buf, "r")) == NULL) {
+  if ((file = plrfile_open(EQSET_FILE, GET_NAME(ch), "r")) == NULL) {
     if (errno != ENOENT) {
+      plrfile_path(buf, sizeof(buf), EQSET_FILE, GET_NAME(ch));
       log("SYSERR: Couldn't open eqset file '%s' for %s.", buf, GET_NAME(ch));
       perror("SYSERR: read_eqsets");
     }
@@ -93,7 +94,7 @@ void read_eqsets(struct char_data *ch)
     for (i = 0; i < NUM_WEARS; i++) {
       if (!get_line(file, buf)) {
         free(s);
-        fclose(file);
+        plrfile_close(file);
         return;
       }
       s->vnums[i] = (obj_vnum)atoi(buf);
@@ -107,7 +108,7 @@ void read_eqsets(struct char_data *ch)
     last = s;
   }
 
-  fclose(file);
+  plrfile_close(file);
 }
 
 void free_eqsets(struct char_data *ch)
@@ -123,11 +124,6 @@ void free_eqsets(struct char_data *ch)
 
 void delete_eqsets(const char *charname)
 {
-  char filename[PATH_MAX];
-
-  if (!get_filename(filename, sizeof(filename), EQSET_FILE, charname))
-    return;
-
-  if (remove(filename) < 0 && errno != ENOENT)
-    log("SYSERR: deleting eqset file %s: %s", filename, strerror(errno));
+  if (plrfile_remove(EQSET_FILE, charname) < 0 && errno != ENOENT)
+    log("SYSERR: deleting eqset file for %s: %s", charname, strerror(errno));
 }
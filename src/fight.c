@@ -22,6 +22,7 @@
 #include "screen.h"
 #include "constants.h"
 #include "gmcp.h"
+#include "webserver.h"
 
 ACMD(do_assist);
 
@@ -85,6 +86,86 @@ struct attack_hit_type attack_hit_text[] =
 
 #define IS_WEAPON(type) (((type) >= TYPE_HIT) && ((type) < TYPE_SUFFERING))
 
+#define NUM_ATTACK_TYPES	((int) (sizeof(attack_hit_text) / sizeof(attack_hit_text[0])))
+#define NUM_DAM_TIERS		9
+
+static const struct dam_weapon_type {
+  const char *to_room;
+  const char *to_char;
+  const char *to_victim;
+} dam_weapons[NUM_DAM_TIERS] = {
+
+  /* use #w for singular (i.e. "slash") and #W for plural (i.e. "slashes") */
+
+  {
+    "$n tries to #w $N, but misses.",	/* 0: 0     */
+    "You try to #w $N, but miss.",
+    "$n tries to #w you, but misses."
+  },
+
+  {
+    "$n tickles $N as $e #W $M.",	/* 1: 1..2  */
+    "You tickle $N as you #w $M.",
+    "$n tickles you as $e #W you."
+  },
+
+  {
+    "$n barely #W $N.",		/* 2: 3..4  */
+    "You barely #w $N.",
+    "$n barely #W you."
+  },
+
+  {
+    "$n #W $N.",			/* 3: 5..6  */
+    "You #w $N.",
+    "$n #W you."
+  },
+
+  {
+    "$n #W $N hard.",			/* 4: 7..10  */
+    "You #w $N hard.",
+    "$n #W you hard."
+  },
+
+  {
+    "$n #W $N very hard.",		/* 5: 11..14  */
+    "You #w $N very hard.",
+    "$n #W you very hard."
+  },
+
+  {
+    "$n #W $N extremely hard.",	/* 6: 15..19  */
+    "You #w $N extremely hard.",
+    "$n #W you extremely hard."
+  },
+
+  {
+    "$n massacres $N to small fragments with $s #w.",	/* 7: 19..23 */
+    "You massacre $N to small fragments with your #w.",
+    "$n massacres you to small fragments with $s #w."
+  },
+
+  {
+    "$n OBLITERATES $N with $s deadly #w!!",	/* 8: > 23   */
+    "You OBLITERATE $N with your deadly #w!!",
+    "$n OBLITERATES you with $s deadly #w!!"
+  }
+};
+
+/*
+ * load_messages() puts the weapon verbs into the texts above once for
+ * every attack type, and indexes fight_messages[] by attack type with
+ * each type's messages in an array, so that dam_message() doesn't run
+ * replace_string() on every hit and skill_message() doesn't search.
+ */
+static struct dam_text {
+  char *to_room;
+  char *to_char;
+  char *to_victim;
+} dam_texts[NUM_ATTACK_TYPES][NUM_DAM_TIERS];
+
+static struct message_list *messages_by_type[TYPE_SUFFERING + 1];
+
 /* The Fight related routines */
 
 void appear(struct char_data *ch)
@@ -102,14 +183,65 @@ void appear(struct char_data *ch)
 }
 
 
-int compute_armor_class(struct char_data *ch)
+/*
+ * The numbers a character brings to every hit: THAC0, armor class and
+ * the damage bonus.  They only change with class, level, abilities and
+ * points, so compute_combat() keeps them in ch->combat until then.
+ */
+static void combat_values(struct char_data *ch, struct char_combat_data *cd)
 {
-  int armorclass = GET_AC(ch);
+  int str = STRENGTH_APPLY_INDEX(ch);
 
-  if (AWAKE(ch))
-    armorclass += dex_app[GET_DEX(ch)].defensive * 10;
+  cd->valid = TRUE;
+  cd->level = GET_LEVEL(ch);
+  cd->chclass = GET_CLASS(ch);
 
-  return (MAX(-100, armorclass));      /* -100 is lowest */
+  if (!IS_NPC(ch))
+    cd->thaco = thaco(GET_CLASS(ch), GET_LEVEL(ch));
+  else		/* THAC0 for monsters is set in the HitRoll */
+    cd->thaco = 20;
+  cd->thaco -= str_app[str].tohit;
+  cd->thaco -= GET_HITROLL(ch);
+  cd->thaco -= (int) ((GET_INT(ch) - 13) / 1.5);	/* Intelligence helps! */
+  cd->thaco -= (int) ((GET_WIS(ch) - 13) / 1.5);	/* So does wisdom */
+
+  /* -100 is lowest */
+  cd->ac_awake = MAX(-100, GET_AC(ch) + dex_app[GET_DEX(ch)].defensive * 10);
+  cd->ac_asleep = MAX(-100, GET_AC(ch));
+
+  cd->damroll = str_app[str].todam + GET_DAMROLL(ch);
+}
+
+
+static struct char_combat_data *compute_combat(struct char_data *ch)
+{
+  if (!ch->combat.valid || ch->combat.level != GET_LEVEL(ch) ||
+      ch->combat.chclass != GET_CLASS(ch))
+    combat_values(ch, &ch->combat);
+#if CHECK_AFFECTS
+  else {
+    struct char_combat_data cd;
+
+    combat_values(ch, &cd);
+    if (cd.thaco != ch->combat.thaco || cd.ac_awake != ch->combat.ac_awake ||
+	cd.ac_asleep != ch->combat.ac_asleep || cd.damroll != ch->combat.damroll) {
+      log("SYSERR: %s's cached THAC0/AC/damroll were %d/%d/%d/%d, recomputed %d/%d/%d/%d.",
+	  GET_NAME(ch), ch->combat.thaco, ch->combat.ac_awake,
+	  ch->combat.ac_asleep, ch->combat.damroll,
+	  cd.thaco, cd.ac_awake, cd.ac_asleep, cd.damroll);
+      ch->combat = cd;
+    }
+  }
+#endif
+  return (&ch->combat);
+}
+
+
+int compute_armor_class(struct char_data *ch)
+{
+  struct char_combat_data *cd = compute_combat(ch);
+
+  return (AWAKE(ch) ? cd->ac_awake : cd->ac_asleep);
 }
 
 
@@ -123,9 +255,22 @@ void free_messages_type(struct msg_type *msg)
 
 void free_messages(void)
 {
-  int i;
+  int i, j;
+
+  for (i = 0; i < NUM_ATTACK_TYPES; i++)
+    for (j = 0; j < NUM_DAM_TIERS; j++) {
+      free(dam_texts[i][j].to_room);
+      free(dam_texts[i][j].to_char);
+      free(dam_texts[i][j].to_victim);
+    }
+  memset(dam_texts, 0, sizeof(dam_texts));
+  memset(messages_by_type, 0, sizeof(messages_by_type));
+
+  for (i = 0; i < MAX_MESSAGES; i++) {
+    if (fight_messages[i].by_number)
+      free(fight_messages[i].by_number);
+    fight_messages[i].by_number = NULL;
 
-  for (i = 0; i < MAX_MESSAGES; i++)
     while (fight_messages[i].msg) {
       struct message_type *former = fight_messages[i].msg;
 
@@ -137,6 +282,32 @@ void free_messages(void)
       fight_messages[i].msg = fight_messages[i].msg->next;
       free(former);
     }
+  }
+}
+
+
+/* Build the tables described above dam_texts[]. */
+static void compile_messages(void)
+{
+  struct message_type *msg;
+  int i, j;
+
+  for (i = 0; i < NUM_ATTACK_TYPES; i++)
+    for (j = 0; j < NUM_DAM_TIERS; j++) {
+      dam_texts[i][j].to_room = strdup(replace_string(dam_weapons[j].to_room,
+		attack_hit_text[i].singular, attack_hit_text[i].plural));
+      dam_texts[i][j].to_char = strdup(replace_string(dam_weapons[j].to_char,
+		attack_hit_text[i].singular, attack_hit_text[i].plural));
+      dam_texts[i][j].to_victim = strdup(replace_string(dam_weapons[j].to_victim,
+		attack_hit_text[i].singular, attack_hit_text[i].plural));
+    }
+
+  for (i = 0; i < MAX_MESSAGES && fight_messages[i].a_type; i++) {
+    CREATE(fight_messages[i].by_number, struct message_type *, fight_messages[i].number_of_attacks);
+    for (j = 0, msg = fight_messages[i].msg; msg; j++, msg = msg->next)
+      fight_messages[i].by_number[j] = msg;
+    messages_by_type[fight_messages[i].a_type] = &fight_messages[i];
+  }
 }
 
 
@@ -156,6 +327,7 @@ void load_messages(void)
     fight_messages[i].a_type = 0;
     fight_messages[i].number_of_attacks = 0;
     fight_messages[i].msg = NULL;
+    fight_messages[i].by_number = NULL;
   }
 
   char *p = fgets(chk, 128, fl);
@@ -167,6 +339,10 @@ void load_messages(void)
     if (p == NULL)
 	break;
     sscanf(chk, " %d\n", &type);
+    if (type < 0 || type > TYPE_SUFFERING) {
+      log("SYSERR: Combat message for attack type %d, which is out of range.", type);
+      exit(1);
+    }
     for (i = 0; (i < MAX_MESSAGES) && (fight_messages[i].a_type != type) &&
 	 (fight_messages[i].a_type); i++);
     if (i >= MAX_MESSAGES) {
@@ -197,6 +373,7 @@ void load_messages(void)
   }
 
   fclose(fl);
+  compile_messages();
 }
 
 
@@ -286,6 +463,7 @@ void make_corpse(struct char_data *ch)
   corpse->item_number = NOTHING;
   IN_ROOM(corpse) = NOWHERE;
   corpse->name = strdup("corpse");
+  keyword_index_obj(corpse);
 
   snprintf(buf2, sizeof(buf2), "The corpse of %s is lying here.", GET_NAME(ch));
   corpse->description = strdup(buf2);
@@ -332,6 +510,7 @@ void make_corpse(struct char_data *ch)
     GET_GOLD(ch) = 0;
   }
   ch->carrying = NULL;
+  ch->spec_objs = 0;
   IS_CARRYING_N(ch) = 0;
   IS_CARRYING_W(ch) = 0;
 
@@ -367,6 +546,8 @@ void death_cry(struct char_data *ch)
 
 void raw_kill(struct char_data *ch)
 {
+  webserver_feed_death(ch, FIGHTING(ch));
+
   if (FIGHTING(ch))
     stop_fighting(ch);
 
@@ -503,75 +684,12 @@ char *replace_string(const char *str, const char *weapon_singular, const char *w
 void dam_message(int dam, struct char_data *ch, struct char_data *victim,
 		      int w_type)
 {
-  char *buf;
+  const struct dam_text *msg;
   int msgnum;
 
-  static struct dam_weapon_type {
-    const char *to_room;
-    const char *to_char;
-    const char *to_victim;
-  } dam_weapons[] = {
-
-    /* use #w for singular (i.e. "slash") and #W for plural (i.e. "slashes") */
-
-    {
-      "$n tries to #w $N, but misses.",	/* 0: 0     */
-      "You try to #w $N, but miss.",
-      "$n tries to #w you, but misses."
-    },
-
-    {
-      "$n tickles $N as $e #W $M.",	/* 1: 1..2  */
-      "You tickle $N as you #w $M.",
-      "$n tickles you as $e #W you."
-    },
-
-    {
-      "$n barely #W $N.",		/* 2: 3..4  */
-      "You barely #w $N.",
-      "$n barely #W you."
-    },
-
-    {
-      "$n #W $N.",			/* 3: 5..6  */
-      "You #w $N.",
-      "$n #W you."
-    },
-
-    {
-      "$n #W $N hard.",			/* 4: 7..10  */
-      "You #w $N hard.",
-      "$n #W you hard."
-    },
-
-    {
-      "$n #W $N very hard.",		/* 5: 11..14  */
-      "You #w $N very hard.",
-      "$n #W you very hard."
-    },
-
-    {
-      "$n #W $N extremely hard.",	/* 6: 15..19  */
-      "You #w $N extremely hard.",
-      "$n #W you extremely hard."
-    },
-
-    {
-      "$n massacres $N to small fragments with $s #w.",	/* 7: 19..23 */
-      "You massacre $N to small fragments with your #w.",
-      "$n massacres you to small fragments with $s #w."
-    },
-
-    {
-      "$n OBLITERATES $N with $s deadly #w!!",	/* 8: > 23   */
-      "You OBLITERATE $N with your deadly #w!!",
-      "$n OBLITERATES you with $s deadly #w!!"
-    }
-  };
 
 
   w_type -= TYPE_HIT;		/* Change to base of table with text */
-
   if (dam == 0)		msgnum = 0;
   else if (dam <= 2)    msgnum = 1;
   else if (dam <= 4)    msgnum = 2;
@@ -582,23 +700,19 @@ void dam_message(int dam, struct char_data *ch, struct char_data *victim,
   else if (dam <= 23)   msgnum = 7;
   else			msgnum = 8;
 
+  msg = &dam_texts[w_type][msgnum];
+
   /* damage message to onlookers */
-  buf = replace_string(dam_weapons[msgnum].to_room,
-	  attack_hit_text[w_type].singular, attack_hit_text[w_type].plural);
-  act(buf, FALSE, ch, NULL, victim, TO_NOTVICT);
+  act(msg->to_room, FALSE, ch, NULL, victim, TO_NOTVICT);
 
   /* damage message to damager */
   send_to_char(ch, CCYEL(ch, C_CMP));
-  buf = replace_string(dam_weapons[msgnum].to_char,
-	  attack_hit_text[w_type].singular, attack_hit_text[w_type].plural);
-  act(buf, FALSE, ch, NULL, victim, TO_CHAR);
+  act(msg->to_char, FALSE, ch, NULL, victim, TO_CHAR);
   send_to_char(ch, CCNRM(ch, C_CMP));
 
   /* damage message to damagee */
   send_to_char(victim, CCRED(victim, C_CMP));
-  buf = replace_string(dam_weapons[msgnum].to_victim,
-	  attack_hit_text[w_type].singular, attack_hit_text[w_type].plural);
-  act(buf, FALSE, ch, NULL, victim, TO_VICT | TO_SLEEP);
+  act(msg->to_victim, FALSE, ch, NULL, victim, TO_VICT | TO_SLEEP);
   send_to_char(victim, CCNRM(victim, C_CMP));
 }
 
@@ -610,68 +724,65 @@ void dam_message(int dam, struct char_data *ch, struct char_data *victim,
 int skill_message(int dam, struct char_data *ch, struct char_data *vict,
 		      int attacktype)
 {
-  int i, j, nr;
+  struct message_list *list;
   struct message_type *msg;
 
   struct obj_data *weap = GET_EQ(ch, WEAR_WIELD);
 
-  for (i = 0; i < MAX_MESSAGES; i++) {
-    if (fight_messages[i].a_type == attacktype) {
-      nr = dice(1, fight_messages[i].number_of_attacks);
-      for (j = 1, msg = fight_messages[i].msg; (j < nr) && msg; j++)
-	msg = msg->next;
-
-      if (!IS_NPC(vict) && (GET_LEVEL(vict) >= LVL_IMMORT)) {
-	act(msg->god_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
-	act(msg->god_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT);
-	act(msg->god_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
-      } else if (dam != 0) {
-        /*
-         * Don't send redundant color codes for TYPE_SUFFERING & other types
-         * of damage without attacker_msg.
-         */
-	if (GET_POS(vict) == POS_DEAD) {
-          if (msg->die_msg.attacker_msg) {
-            send_to_char(ch, CCYEL(ch, C_CMP));
-            act(msg->die_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
-            send_to_char(ch, CCNRM(ch, C_CMP));
-          }
-
-	  send_to_char(vict, CCRED(vict, C_CMP));
-	  act(msg->die_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT | TO_SLEEP);
-	  send_to_char(vict, CCNRM(vict, C_CMP));
-
-	  act(msg->die_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
-	} else {
-          if (msg->hit_msg.attacker_msg) {
-	    send_to_char(ch, CCYEL(ch, C_CMP));
-	    act(msg->hit_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
-	    send_to_char(ch, CCNRM(ch, C_CMP));
-          }
-
-	  send_to_char(vict, CCRED(vict, C_CMP));
-	  act(msg->hit_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT | TO_SLEEP);
-	  send_to_char(vict, CCNRM(vict, C_CMP));
-
-	  act(msg->hit_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
-	}
-      } else if (ch != vict) {	/* Dam == 0 */
-        if (msg->miss_msg.attacker_msg) {
-	  send_to_char(ch, CCYEL(ch, C_CMP));
-	  act(msg->miss_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
-	  send_to_char(ch, CCNRM(ch, C_CMP));
-        }
-
-	send_to_char(vict, CCRED(vict, C_CMP));
-	act(msg->miss_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT | TO_SLEEP);
-	send_to_char(vict, CCNRM(vict, C_CMP));
-
-	act(msg->miss_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
+  if (attacktype < 0 || attacktype > TYPE_SUFFERING ||
+      (list = messages_by_type[attacktype]) == NULL)
+    return (0);
+
+  msg = list->by_number[dice(1, list->number_of_attacks) - 1];
+
+  if (!IS_NPC(vict) && (GET_LEVEL(vict) >= LVL_IMMORT)) {
+    act(msg->god_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
+    act(msg->god_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT);
+    act(msg->god_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
+  } else if (dam != 0) {
+    /*
+     * Don't send redundant color codes for TYPE_SUFFERING & other types
+     * of damage without attacker_msg.
+     */
+    if (GET_POS(vict) == POS_DEAD) {
+      if (msg->die_msg.attacker_msg) {
+	send_to_char(ch, CCYEL(ch, C_CMP));
+	act(msg->die_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
+	send_to_char(ch, CCNRM(ch, C_CMP));
+      }
+
+      send_to_char(vict, CCRED(vict, C_CMP));
+      act(msg->die_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT | TO_SLEEP);
+      send_to_char(vict, CCNRM(vict, C_CMP));
+
+      act(msg->die_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
+    } else {
+      if (msg->hit_msg.attacker_msg) {
+	send_to_char(ch, CCYEL(ch, C_CMP));
+	act(msg->hit_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
+	send_to_char(ch, CCNRM(ch, C_CMP));
       }
-      return (1);
+
+      send_to_char(vict, CCRED(vict, C_CMP));
+      act(msg->hit_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT | TO_SLEEP);
+      send_to_char(vict, CCNRM(vict, C_CMP));
+
+      act(msg->hit_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
+    }
+  } else if (ch != vict) {  /* Dam == 0 */
+    if (msg->miss_msg.attacker_msg) {
+      send_to_char(ch, CCYEL(ch, C_CMP));
+      act(msg->miss_msg.attacker_msg, FALSE, ch, weap, vict, TO_CHAR);
+      send_to_char(ch, CCNRM(ch, C_CMP));
     }
+
+    send_to_char(vict, CCRED(vict, C_CMP));
+    act(msg->miss_msg.victim_msg, FALSE, ch, weap, vict, TO_VICT | TO_SLEEP);
+    send_to_char(vict, CCNRM(vict, C_CMP));
+
+    act(msg->miss_msg.room_msg, FALSE, ch, weap, vict, TO_NOTVICT);
   }
-  return (0);
+  return (1);
 }
 
 /*
@@ -856,18 +967,7 @@ int damage(struct char_data *ch, struct char_data *victim, int dam, int attackty
  */
 int compute_thaco(struct char_data *ch, struct char_data *victim)
 {
-  int calc_thaco;
-
-  if (!IS_NPC(ch))
-    calc_thaco = thaco(GET_CLASS(ch), GET_LEVEL(ch));
-  else		/* THAC0 for monsters is set in the HitRoll */
-    calc_thaco = 20;
-  calc_thaco -= str_app[STRENGTH_APPLY_INDEX(ch)].tohit;
-  calc_thaco -= GET_HITROLL(ch);
-  calc_thaco -= (int) ((GET_INT(ch) - 13) / 1.5);	/* Intelligence helps! */
-  calc_thaco -= (int) ((GET_WIS(ch) - 13) / 1.5);	/* So does wisdom */
-
-  return calc_thaco;
+  return (compute_combat(ch)->thaco);
 }
 
 
@@ -924,8 +1024,7 @@ void hit(struct char_data *ch, struct char_data *victim, int type)
     /* okay, we know the guy has been hit.  now calculate damage. */
 
     /* Start with the damage bonuses: the damroll and strength apply */
-    dam = str_app[STRENGTH_APPLY_INDEX(ch)].todam;
-    dam += GET_DAMROLL(ch);
+    dam = compute_combat(ch)->damroll;
 
     /* Maybe holding arrow? */
     if (wielded && GET_OBJ_TYPE(wielded) == ITEM_WEAPON) {
@@ -1023,9 +1122,131 @@ void perform_violence(void)
     }
     if (ch->desc) gmcp_send_char_vitals(ch);
     if (FIGHTING(ch) && FIGHTING(ch)->desc) gmcp_send_char_vitals(FIGHTING(ch));
-    if (MOB_FLAGGED(ch, MOB_SPEC) && GET_MOB_SPEC(ch) && !MOB_FLAGGED(ch, MOB_NOTDEADYET)) {
+    if (MOB_FLAGGED(ch, MOB_SPEC) && GET_MOB_SPEC(ch) && !MOB_FLAGGED(ch, MOB_NOTDEADYET) &&
+        SPEC_WANTS(GET_MOB_SPEC_TRIG(ch), 0)) {
       char actbuf[MAX_INPUT_LENGTH] = "";
       (GET_MOB_SPEC(ch)) (ch, ch, 0, actbuf);
     }
   }
 }
+
+
+/*
+ * Time combat between prototype mobs: BENCH_ROUNDS calls of
+ * perform_violence(), with a new pair of mobs stepping in every
+ * BENCH_PAIR_ROUNDS so that most attack types get used.  A third mob
+ * watches, and all three share a dummy descriptor, so every message is
+ * written out as it would be for players.  Run with 'circle -f'.
+ */
+#define BENCH_ROUNDS		10000
+#define BENCH_PAIR_ROUNDS	50
+#define BENCH_LOOKUPS		1000000
+
+static void combat_bench_end(struct char_data **mob)
+{
+  int i;
+
+  for (i = 0; i < 3; i++) {
+    if (FIGHTING(mob[i]))
+      stop_fighting(mob[i]);
+    mob[i]->desc = NULL;
+    extract_char(mob[i]);
+  }
+  extract_pending_chars();
+}
+
+
+void combat_benchmark(void)
+{
+  struct descriptor_data d;
+  struct char_data *mob[3];
+  struct timeval start, end;
+  room_rnum room;
+  long bytes = 0, found_old = 0, found_new = 0, differ = 0;
+  int round, i, type, tier;
+  double t_rounds = 0, t_old, t_new;
+
+  load_messages();
+
+  for (room = 0; room <= top_of_world; room++)
+    if (!ROOM_FLAGGED(room, ROOM_PEACEFUL))
+      break;
+  if (room > top_of_world || top_of_mobt < 2) {
+    log("SYSERR: Combat benchmark needs a room to fight in and three mobiles.");
+    return;
+  }
+
+  memset(&d, 0, sizeof(d));
+  CREATE(d.output, char, LARGE_BUFSIZE);
+  d.bufspace = LARGE_BUFSIZE - 1;
+  d.connected = CON_PLAYING;
+  circle_srandom(1);	/* The same fights every time. */
+
+  for (round = 0; round < BENCH_ROUNDS; round += BENCH_PAIR_ROUNDS) {
+    for (i = 0; i < 3; i++) {
+      mob[i] = read_mobile((round / BENCH_PAIR_ROUNDS * 3 + i) % (top_of_mobt + 1), REAL);
+      char_to_room(mob[i], room);
+      REMOVE_BIT(MOB_FLAGS(mob[i]), MOB_WIMPY);
+      GET_POS(mob[i]) = POS_STANDING;
+      mob[i]->desc = &d;
+    }
+    set_fighting(mob[0], mob[1]);
+    set_fighting(mob[1], mob[0]);
+
+    for (i = 0; i < BENCH_PAIR_ROUNDS; i++) {
+      /* Nobody dies; that would be a different benchmark. */
+      GET_HIT(mob[0]) = GET_MAX_HIT(mob[0]) = 30000;
+      GET_HIT(mob[1]) = GET_MAX_HIT(mob[1]) = 30000;
+
+      gettimeofday(&start, NULL);
+      perform_violence();
+      gettimeofday(&end, NULL);
+      t_rounds += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_usec - start.tv_usec) * 1e3;
+
+      bytes += d.bufptr;
+      d.bufptr = 0;
+      d.bufspace = LARGE_BUFSIZE - 1;
+      *d.output = '\0';
+    }
+    combat_bench_end(mob);
+  }
+
+  /* The text lookup alone, against expanding it on every hit as we did. */
+  gettimeofday(&start, NULL);
+  for (i = 0; i < BENCH_LOOKUPS; i++) {
+    type = i % NUM_ATTACK_TYPES;
+    tier = i % NUM_DAM_TIERS;
+    found_old += *replace_string(dam_weapons[tier].to_char,
+		attack_hit_text[type].singular, attack_hit_text[type].plural);
+  }
+  gettimeofday(&end, NULL);
+  t_old = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_usec - start.tv_usec) * 1e3;
+
+  gettimeofday(&start, NULL);
+  for (i = 0; i < BENCH_LOOKUPS; i++)
+    found_new += *dam_texts[i % NUM_ATTACK_TYPES][i % NUM_DAM_TIERS].to_char;
+  gettimeofday(&end, NULL);
+  t_new = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_usec - start.tv_usec) * 1e3;
+
+  log("Combat benchmark: %d rounds, %d pairs of mobiles, %ld bytes of messages.",
+	BENCH_ROUNDS, BENCH_ROUNDS / BENCH_PAIR_ROUNDS, bytes);
+  log("  perform_violence: %10.1f us/round, %.0f rounds/sec",
+	t_rounds / BENCH_ROUNDS / 1e3, BENCH_ROUNDS / (t_rounds / 1e9));
+  log("  replace_string:   %10.1f ns/message", t_old / BENCH_LOOKUPS);
+  log("  message table:    %10.1f ns/message", t_new / BENCH_LOOKUPS);
+
+  for (type = 0; type < NUM_ATTACK_TYPES; type++)
+    for (tier = 0; tier < NUM_DAM_TIERS; tier++) {
+      differ += !!strcmp(dam_texts[type][tier].to_room, replace_string(dam_weapons[tier].to_room,
+		attack_hit_text[type].singular, attack_hit_text[type].plural));
+      differ += !!strcmp(dam_texts[type][tier].to_char, replace_string(dam_weapons[tier].to_char,
+		attack_hit_text[type].singular, attack_hit_text[type].plural));
+      differ += !!strcmp(dam_texts[type][tier].to_victim, replace_string(dam_weapons[tier].to_victim,
+		attack_hit_text[type].singular, attack_hit_text[type].plural));
+    }
+  if (differ || found_old != found_new)
+    log("SYSERR: the message table and replace_string() disagree on %ld texts.", differ);
+
+  free(d.output);
+  free_messages();
+}
@@ -13,6 +13,7 @@
 #include "constants.h"
 #include "spells.h"
 #include "gmcp.h"
+#include "mccp.h"
 
 #ifdef HAVE_ARPA_TELNET_H
 #include <arpa/telnet.h>
@@ -71,7 +72,7 @@ done:
 static void gmcp_raw_send(struct descriptor_data *d,
                            const unsigned char *buf, size_t len)
 {
-  if (write_to_descriptor_n(d->descriptor, (const char *)buf, len) < 0)
+  if (write_to_client(d, (const char *)buf, len) < 0)
     d->connected = CON_DISCONNECT;
 }
 
@@ -115,11 +116,12 @@ static void gmcp_send_packet(struct descriptor_data *d,
  * Telnet negotiation
  * ----------------------------------------------------------------------- */
 
-/* Send IAC WILL GMCP — call from new_descriptor() to advertise support. */
+/* Send IAC WILL GMCP — call from new_descriptor() to advertise support.
+ * MCCP v2 is offered in the same breath if it's turned on. */
 void gmcp_send_will(struct descriptor_data *d)
 {
-  unsigned char will_gmcp[3] = { IAC, WILL, TELOPT_GMCP };
-  gmcp_raw_send(d, will_gmcp, 3);
+  unsigned char will[6] = { IAC, WILL, TELOPT_GMCP, IAC, WILL, TELOPT_COMPRESS2 };
+  gmcp_raw_send(d, will, mccp_offered() ? 6 : 3);
 }
 
 /* Called when IAC DO GMCP is received from the client. */
@@ -180,6 +182,10 @@ int gmcp_strip_iac(struct descriptor_data *d, char *buf, int len)
     case IAC_GOT_CMD:
       if (d->gmcp_sb_cmd == DO && c == TELOPT_GMCP)
         gmcp_negotiate(d);
+      else if (d->gmcp_sb_cmd == DO && c == TELOPT_COMPRESS2)
+        mccp_start(d);
+      else if (d->gmcp_sb_cmd == DONT && c == TELOPT_COMPRESS2)
+        mccp_stop(d);
       d->gmcp_iac_state = IAC_NORMAL;
       break;
 
@@ -21,9 +21,12 @@
 #include "spells.h"
 #include "olc.h"
 #include "gmcp.h"
+#include "webserver.h"
 
 /* local vars */
 int extractions_pending = 0;
+struct char_data *char_lists[NUM_CHAR_LISTS];		/* worklist heads */
+struct char_data *char_list_next[NUM_CHAR_LISTS];	/* see char_list_unlink() */
 
 /* external vars */
 extern struct char_data *combat_list;
@@ -84,6 +87,557 @@ int isname(const char *str, const char *namelist)
 }
 
 
+/*
+ * Precompiled keyword sets.  See struct keyword_set in structs.h.
+ */
+
+static unsigned int keyword_hash(const char *s, int len)
+{
+  unsigned int h = 2166136261U;		/* FNV-1a */
+
+  while (len-- > 0)
+    h = (h ^ (unsigned char) *(s++)) * 16777619U;
+  return (h);
+}
+
+
+struct keyword_set *keyword_set_build(const char *namelist)
+{
+  struct keyword_set *ks;
+  const char *p, *q;
+  char *t;
+  int count = 0, len, i;
+
+  /* Only letters and single spaces; anything else stays with isname(). */
+  for (p = namelist; *p; p = q) {
+    for (q = p; isalpha(*q); q++);
+    if (q == p || q - p >= MAX_KEYWORD_LENGTH || (*q && (*q != ' ' || !q[1])))
+      break;
+    count++;
+    if (*q)
+      q++;
+  }
+
+  if (*p) {
+    CREATE(ks, struct keyword_set, 1);
+    ks->source = namelist;
+    ks->count = -1;
+    return (ks);
+  }
+
+  /* One block: the set, the hashes, then the length-prefixed text. */
+  CREATE(t, char, sizeof(struct keyword_set) + count * sizeof(unsigned int) + strlen(namelist) + 1);
+  ks = (struct keyword_set *) t;
+  ks->source = namelist;
+  ks->count = count;
+  ks->hash = (unsigned int *) (ks + 1);
+  ks->text = (char *) (ks->hash + count);
+
+  for (i = 0, p = namelist, t = ks->text; i < count; i++, p++) {
+    for (q = p, len = 0; isalpha(*q); q++, len++)
+      t[len + 1] = LOWER(*q);
+    *t = len;
+    ks->hash[i] = keyword_hash(t + 1, len);
+    t += len + 1;
+    p = q;
+  }
+
+  return (ks);
+}
+
+
+void keyword_set_free(struct keyword_set *ks)
+{
+  if (ks)
+    free(ks);
+}
+
+
+void keyword_query_init(struct keyword_query *kq, const char *str)
+{
+  int len;
+
+  kq->str = str;
+  kq->len = 0;
+
+  for (len = 0; isalpha(str[len]); len++) {
+    if (len >= MAX_KEYWORD_LENGTH)
+      return;
+    kq->text[len] = LOWER(str[len]);
+  }
+  if (len == 0 || str[len])
+    return;
+
+  kq->len = len;
+  kq->hash = keyword_hash(kq->text, len);
+}
+
+
+/* Same answer as isname(kq->str, ks->source). */
+int keyword_set_match(const struct keyword_query *kq, const struct keyword_set *ks)
+{
+  const char *t;
+  int i;
+
+  if (ks->count < 0 || kq->len == 0)
+    return (isname(kq->str, ks->source));
+
+  for (i = 0, t = ks->text; i < ks->count; t += *t + 1, i++)
+    if (ks->hash[i] == kq->hash && *t == kq->len && !memcmp(t + 1, kq->text, kq->len))
+      return (1);
+
+  return (0);
+}
+
+
+/* The prototype's set, rebuilt if OLC has given it a new name since. */
+static struct keyword_set *proto_keywords(struct index_data *idx, const char *name)
+{
+  if (!idx->keywords || idx->keywords->source != name) {
+    keyword_set_free(idx->keywords);
+    idx->keywords = keyword_set_build(name);
+  }
+  return (idx->keywords);
+}
+
+
+/* Call when a prototype's namelist is freed or replaced. */
+void proto_keywords_changed(struct index_data *idx)
+{
+  keyword_set_free(idx->keywords);
+  idx->keywords = NULL;
+}
+
+
+int isname_obj(const struct keyword_query *kq, struct obj_data *obj)
+{
+  obj_rnum nr = GET_OBJ_RNUM(obj);
+
+  /* Restrung objects have their own name, so parse it the old way. */
+  if (!VALID_OBJ_RNUM(obj) || obj->name != obj_proto[nr].name)
+    return (isname(kq->str, obj->name));
+
+  return (keyword_set_match(kq, proto_keywords(&obj_index[nr], obj->name)));
+}
+
+
+int isname_char(const struct keyword_query *kq, struct char_data *ch)
+{
+  mob_rnum nr = GET_MOB_RNUM(ch);
+
+  if (!IS_MOB(ch) || ch->player.name != mob_proto[nr].player.name)
+    return (isname(kq->str, ch->player.name));
+
+  return (keyword_set_match(kq, proto_keywords(&mob_index[nr], ch->player.name)));
+}
+
+
+/*
+ * Keyword index: every live character and object filed under each keyword
+ * of its name, so the world-wide lookups only look at the ones that can
+ * match.  Each list is kept in the same order as character_list or
+ * object_list (newest first, by kw_seq) so that 3.sword still finds the
+ * same sword as before.  Names that aren't plain words can't be split the
+ * way isname() would, so those go on a separate list that is always
+ * searched as well.
+ */
+#define KEYWORD_INDEX_SIZE	4096	/* must be a power of 2 */
+
+struct keyword_ref {
+  struct keyword_ref *prev, *next;
+  struct keyword_entry *entry;	/* NULL if on one of the odd lists */
+  void *thing;			/* char_data or obj_data */
+  long seq;
+};
+
+struct keyword_entry {
+  char *word;
+  int len;
+  unsigned int hash;
+  struct keyword_ref *chars;
+  struct keyword_ref *objs;
+  struct keyword_entry *next;	/* same bucket */
+};
+
+static struct keyword_entry *keyword_index[KEYWORD_INDEX_SIZE];
+static struct keyword_ref *odd_chars, *odd_objs;
+static long keyword_seq = 0;
+
+
+static struct keyword_entry *kwi_find(const char *word, int len, unsigned int hash)
+{
+  struct keyword_entry *e;
+
+  for (e = keyword_index[hash & (KEYWORD_INDEX_SIZE - 1)]; e; e = e->next)
+    if (e->hash == hash && e->len == len && !memcmp(e->word, word, len))
+      return (e);
+  return (NULL);
+}
+
+
+static struct keyword_ref **kwi_list(struct keyword_entry *e, bool is_obj)
+{
+  if (!e)
+    return (is_obj ? &odd_objs : &odd_chars);
+  return (is_obj ? &e->objs : &e->chars);
+}
+
+
+/* Newest first; a new thing normally goes straight in at the head. */
+static void kwi_link(struct keyword_ref *r, bool is_obj)
+{
+  struct keyword_ref **list = kwi_list(r->entry, is_obj), *prev = NULL, *cur;
+
+  for (cur = *list; cur && cur->seq > r->seq; cur = cur->next)
+    prev = cur;
+
+  r->prev = prev;
+  r->next = cur;
+  if (cur)
+    cur->prev = r;
+  if (prev)
+    prev->next = r;
+  else
+    *list = r;
+}
+
+
+static void kwi_unlink(struct keyword_ref *refs, int nrefs, bool is_obj)
+{
+  struct keyword_entry *e, **pe;
+  struct keyword_ref *r;
+  int i;
+
+  for (i = 0, r = refs; i < nrefs; i++, r++) {
+    if (r->next)
+      r->next->prev = r->prev;
+    if (r->prev)
+      r->prev->next = r->next;
+    else
+      *kwi_list(r->entry, is_obj) = r->next;
+
+    /* Drop keywords nothing is called any more. */
+    if ((e = r->entry) != NULL && !e->chars && !e->objs) {
+      for (pe = &keyword_index[e->hash & (KEYWORD_INDEX_SIZE - 1)]; *pe != e; pe = &(*pe)->next);
+      *pe = e->next;
+      free(e->word);
+      free(e);
+    }
+  }
+  if (refs)
+    free(refs);
+}
+
+
+/* File something under each distinct keyword in its name. */
+static struct keyword_ref *kwi_add(void *thing, bool is_obj, long seq,
+			const struct keyword_set *ks, int *nrefs)
+{
+  struct keyword_ref *refs;
+  struct keyword_entry *e;
+  const char *t, *u;
+  int i, j, n = 0;
+
+  if (ks->count < 0) {
+    CREATE(refs, struct keyword_ref, 1);
+    refs->thing = thing;
+    refs->seq = seq;
+    kwi_link(refs, is_obj);
+    *nrefs = 1;
+    return (refs);
+  }
+
+  if (ks->count == 0) {
+    *nrefs = 0;
+    return (NULL);
+  }
+
+  CREATE(refs, struct keyword_ref, ks->count);
+  for (i = 0, t = ks->text; i < ks->count; t += *t + 1, i++) {
+    /* "guard guard" should only be counted once. */
+    for (j = 0, u = ks->text; j < i; u += *u + 1, j++)
+      if (ks->hash[j] == ks->hash[i] && *u == *t && !memcmp(u + 1, t + 1, *t))
+	break;
+    if (j < i)
+      continue;
+
+    if (!(e = kwi_find(t + 1, *t, ks->hash[i]))) {
+      CREATE(e, struct keyword_entry, 1);
+      CREATE(e->word, char, *t + 1);
+      memcpy(e->word, t + 1, *t);
+      e->len = *t;
+      e->hash = ks->hash[i];
+      e->next = keyword_index[e->hash & (KEYWORD_INDEX_SIZE - 1)];
+      keyword_index[e->hash & (KEYWORD_INDEX_SIZE - 1)] = e;
+    }
+    refs[n].entry = e;
+    refs[n].thing = thing;
+    refs[n].seq = seq;
+    kwi_link(&refs[n++], is_obj);
+  }
+  *nrefs = n;
+  return (refs);
+}
+
+
+/*
+ * (Re)file a character under its current name.  Call when it goes onto
+ * character_list, and again whenever its name is changed.
+ */
+void keyword_index_char(struct char_data *ch)
+{
+  struct keyword_set *ks;
+
+  kwi_unlink(ch->kw_refs, ch->kw_nrefs, FALSE);
+  ch->kw_refs = NULL;
+  ch->kw_nrefs = 0;
+  if (!ch->kw_seq)
+    ch->kw_seq = ++keyword_seq;
+  if (!ch->player.name)
+    return;
+
+  if (IS_MOB(ch) && ch->player.name == mob_proto[GET_MOB_RNUM(ch)].player.name)
+    ch->kw_refs = kwi_add(ch, FALSE, ch->kw_seq,
+	proto_keywords(&mob_index[GET_MOB_RNUM(ch)], ch->player.name), &ch->kw_nrefs);
+  else {
+    ks = keyword_set_build(ch->player.name);
+    ch->kw_refs = kwi_add(ch, FALSE, ch->kw_seq, ks, &ch->kw_nrefs);
+    keyword_set_free(ks);
+  }
+}
+
+
+void keyword_index_obj(struct obj_data *obj)
+{
+  struct keyword_set *ks;
+
+  kwi_unlink(obj->kw_refs, obj->kw_nrefs, TRUE);
+  obj->kw_refs = NULL;
+  obj->kw_nrefs = 0;
+  if (!obj->kw_seq)
+    obj->kw_seq = ++keyword_seq;
+  if (!obj->name)
+    return;
+
+  if (VALID_OBJ_RNUM(obj) && obj->name == obj_proto[GET_OBJ_RNUM(obj)].name)
+    obj->kw_refs = kwi_add(obj, TRUE, obj->kw_seq,
+	proto_keywords(&obj_index[GET_OBJ_RNUM(obj)], obj->name), &obj->kw_nrefs);
+  else {
+    ks = keyword_set_build(obj->name);
+    obj->kw_refs = kwi_add(obj, TRUE, obj->kw_seq, ks, &obj->kw_nrefs);
+    keyword_set_free(ks);
+  }
+}
+
+
+/* Call when it comes off character_list / object_list. */
+void keyword_unindex_char(struct char_data *ch)
+{
+  kwi_unlink(ch->kw_refs, ch->kw_nrefs, FALSE);
+  ch->kw_refs = NULL;
+  ch->kw_nrefs = 0;
+  ch->kw_seq = 0;
+}
+
+
+void keyword_unindex_obj(struct obj_data *obj)
+{
+  kwi_unlink(obj->kw_refs, obj->kw_nrefs, TRUE);
+  obj->kw_refs = NULL;
+  obj->kw_nrefs = 0;
+  obj->kw_seq = 0;
+}
+
+
+/*
+ * Walk the candidates for a query newest first, merging the keyword's own
+ * list with the odd one.  Callers still check isname_char/obj(), but that
+ * only weeds out things that don't match; a thing renamed without being
+ * refiled is on its old keywords' lists only, and a walk for a new one
+ * never reaches it.  So whatever changes a live name must call
+ * keyword_index_char/obj() again.
+ */
+struct keyword_walk {
+  struct keyword_ref *a, *b;
+};
+
+static void kwi_start(struct keyword_walk *w, const struct keyword_query *kq, bool is_obj)
+{
+  struct keyword_entry *e = kwi_find(kq->text, kq->len, kq->hash);
+
+  w->a = e ? *kwi_list(e, is_obj) : NULL;
+  w->b = *kwi_list(NULL, is_obj);
+}
+
+static void *kwi_next(struct keyword_walk *w)
+{
+  struct keyword_ref *r;
+
+  if (w->a && (!w->b || w->a->seq > w->b->seq)) {
+    r = w->a;
+    w->a = r->next;
+  } else if (w->b) {
+    r = w->b;
+    w->b = r->next;
+  } else
+    return (NULL);
+  return (r->thing);
+}
+
+
+/*
+ * Time isname() against the keyword sets over every prototype namelist in
+ * the world, searching each one for the first keyword of every other one.
+ * Run with 'circle -k'; it also checks that both give the same answers.
+ */
+void keyword_benchmark(void)
+{
+  struct keyword_query *queries;
+  struct keyword_set **sets;
+  const char **lists;
+  char **words;
+  struct timeval start, mid, end;
+  long found_old = 0, found_new = 0, compiled = 0, differ = 0;
+  int nlists = 0, pass, i, j;
+  const int passes = 10;
+  double calls, t_old, t_new;
+
+  CREATE(lists, const char *, top_of_mobt + top_of_objt + 2);
+  for (i = 0; i <= top_of_mobt; i++)
+    if (mob_proto[i].player.name)
+      lists[nlists++] = mob_proto[i].player.name;
+  for (i = 0; i <= top_of_objt; i++)
+    if (obj_proto[i].name)
+      lists[nlists++] = obj_proto[i].name;
+
+  CREATE(sets, struct keyword_set *, nlists);
+  CREATE(queries, struct keyword_query, nlists);
+  CREATE(words, char *, nlists);
+  for (i = 0; i < nlists; i++) {
+    sets[i] = keyword_set_build(lists[i]);
+    if (sets[i]->count >= 0)
+      compiled++;
+    words[i] = strdup(fname(lists[i]));
+    keyword_query_init(&queries[i], words[i]);
+  }
+
+  gettimeofday(&start, NULL);
+  for (pass = 0; pass < passes; pass++)
+    for (i = 0; i < nlists; i++)
+      for (j = 0; j < nlists; j++)
+	found_old += isname(words[i], lists[j]);
+  gettimeofday(&mid, NULL);
+  for (pass = 0; pass < passes; pass++)
+    for (i = 0; i < nlists; i++)
+      for (j = 0; j < nlists; j++)
+	found_new += keyword_set_match(&queries[i], sets[j]);
+  gettimeofday(&end, NULL);
+
+  for (i = 0; i < nlists; i++)
+    for (j = 0; j < nlists; j++)
+      if (isname(words[i], lists[j]) != keyword_set_match(&queries[i], sets[j]))
+	differ++;
+
+  calls = (double) passes * nlists * nlists;
+  t_old = (mid.tv_sec - start.tv_sec) * 1e9 + (mid.tv_usec - start.tv_usec) * 1e3;
+  t_new = (end.tv_sec - mid.tv_sec) * 1e9 + (end.tv_usec - mid.tv_usec) * 1e3;
+
+  log("Keyword benchmark: %d namelists (%ld compiled), %.0f lookups.", nlists, compiled, calls);
+  log("  isname:       %7.1f ns/lookup, %ld matches", t_old / calls, found_old);
+  log("  keyword sets: %7.1f ns/lookup, %ld matches", t_new / calls, found_new);
+  if (differ)
+    log("SYSERR: keyword sets and isname() disagree on %ld lookups.", differ);
+
+  for (i = 0; i < nlists; i++) {
+    keyword_set_free(sets[i]);
+    free(words[i]);
+  }
+  free(sets);
+  free(queries);
+  free(words);
+  free(lists);
+}
+
+
+
+/*
+ * Equipment and affects change a character's abilities through abil_mods,
+ * and aff_abils is worked out from those and real_abils whenever they
+ * change, so wearing or removing something only costs what it applies.
+ * Everything else an apply touches is a plain sum, adjusted in place.
+ */
+static bool abil_mods_add(struct char_ability_mods *mods, byte loc, int mod)
+{
+  switch (loc) {
+  case APPLY_STR:	mods->str += mod;	break;
+  case APPLY_DEX:	mods->dex += mod;	break;
+  case APPLY_INT:	mods->intel += mod;	break;
+  case APPLY_WIS:	mods->wis += mod;	break;
+  case APPLY_CON:	mods->con += mod;	break;
+  case APPLY_CHA:	mods->cha += mod;	break;
+  default:
+    return (FALSE);
+  }
+  return (TRUE);
+}
+
+
+/* Make certain values are between 0..25, not < 0 and not > 25! */
+static void affect_abils(struct char_data *ch)
+{
+  int i, str;
+
+  INVALIDATE_COMBAT(ch);
+  i = (IS_NPC(ch) || GET_LEVEL(ch) >= LVL_GRGOD) ? 25 : 18;
+
+  GET_DEX(ch) = MAX(0, MIN(ch->real_abils.dex + ch->abil_mods.dex, i));
+  GET_INT(ch) = MAX(0, MIN(ch->real_abils.intel + ch->abil_mods.intel, i));
+  GET_WIS(ch) = MAX(0, MIN(ch->real_abils.wis + ch->abil_mods.wis, i));
+  GET_CON(ch) = MAX(0, MIN(ch->real_abils.con + ch->abil_mods.con, i));
+  GET_CHA(ch) = MAX(0, MIN(ch->real_abils.cha + ch->abil_mods.cha, i));
+  GET_ADD(ch) = ch->real_abils.str_add;
+  str = MAX(0, ch->real_abils.str + ch->abil_mods.str);
+
+  if (IS_NPC(ch)) {
+    str = MIN(str, i);
+  } else {
+    if (str > 18) {
+      i = GET_ADD(ch) + ((str - 18) * 10);
+      GET_ADD(ch) = MIN(i, 100);
+      str = 18;
+    }
+  }
+  GET_STR(ch) = str;
+}
+
+
+/*
+ * Taking an affect bit away takes it from everything that gives it, so
+ * put back what the character's other equipment and affects still give.
+ */
+static void affect_restore_bits(struct char_data *ch, bitvector_t bitv)
+{
+  struct affected_type *af;
+  int i;
+
+  if (!bitv)
+    return;
+
+  for (i = 0; i < NUM_WEARS; i++)
+    if (GET_EQ(ch, i))
+      SET_BIT(AFF_FLAGS(ch), GET_OBJ_AFFECT(GET_EQ(ch, i)) & bitv);
+
+  for (af = ch->affected; af; af = af->next)
+    SET_BIT(AFF_FLAGS(ch), af->bitvector & bitv);
+}
+
+
+#if CHECK_AFFECTS
+static void affect_check(struct char_data *ch, const char *where);
+#else
+#define affect_check(ch, where)	/* nothing */
+#endif
+
 
 void affect_modify(struct char_data *ch, byte loc, sbyte mod,
                    bitvector_t bitv, bool add)
@@ -94,30 +648,17 @@ void affect_modify(struct char_data *ch, byte loc, sbyte mod,
     REMOVE_BIT(AFF_FLAGS(ch), bitv);
     mod = -mod;
   }
+  INVALIDATE_COMBAT(ch);
+
+  if (abil_mods_add(&ch->abil_mods, loc, mod)) {
+    affect_abils(ch);
+    return;
+  }
 
   switch (loc) {
   case APPLY_NONE:
     break;
 
-  case APPLY_STR:
-    GET_STR(ch) += mod;
-    break;
-  case APPLY_DEX:
-    GET_DEX(ch) += mod;
-    break;
-  case APPLY_INT:
-    GET_INT(ch) += mod;
-    break;
-  case APPLY_WIS:
-    GET_WIS(ch) += mod;
-    break;
-  case APPLY_CON:
-    GET_CON(ch) += mod;
-    break;
-  case APPLY_CHA:
-    GET_CHA(ch) += mod;
-    break;
-
   case APPLY_CLASS:
     /* ??? GET_CLASS(ch) += mod; */
     break;
@@ -205,61 +746,97 @@ void affect_modify(struct char_data *ch, byte loc, sbyte mod,
 
 
 
-/* This updates a character by subtracting everything he is affected by */
-/* restoring original abilities, and then affecting all again           */
+/*
+ * Works out a character's abilities and affect bits again from scratch.
+ * Equipment and affects keep them up to date as they come and go, so this
+ * is for when real_abils or the level changes.
+ */
 void affect_total(struct char_data *ch)
 {
   struct affected_type *af;
   int i, j;
 
+  memset(&ch->abil_mods, 0, sizeof(ch->abil_mods));
+
   for (i = 0; i < NUM_WEARS; i++) {
-    if (GET_EQ(ch, i))
+    if (GET_EQ(ch, i)) {
+      SET_BIT(AFF_FLAGS(ch), GET_OBJ_AFFECT(GET_EQ(ch, i)));
       for (j = 0; j < MAX_OBJ_AFFECT; j++)
-	affect_modify(ch, GET_EQ(ch, i)->affected[j].location,
-		      GET_EQ(ch, i)->affected[j].modifier,
-		      GET_OBJ_AFFECT(GET_EQ(ch, i)), FALSE);
+	abil_mods_add(&ch->abil_mods, GET_EQ(ch, i)->affected[j].location,
+		      GET_EQ(ch, i)->affected[j].modifier);
+    }
   }
 
+  for (af = ch->affected; af; af = af->next) {
+    SET_BIT(AFF_FLAGS(ch), af->bitvector);
+    abil_mods_add(&ch->abil_mods, af->location, af->modifier);
+  }
 
-  for (af = ch->affected; af; af = af->next)
-    affect_modify(ch, af->location, af->modifier, af->bitvector, FALSE);
+  affect_abils(ch);
+}
 
-  ch->aff_abils = ch->real_abils;
 
-  for (i = 0; i < NUM_WEARS; i++) {
-    if (GET_EQ(ch, i))
-      for (j = 0; j < MAX_OBJ_AFFECT; j++)
-	affect_modify(ch, GET_EQ(ch, i)->affected[j].location,
-		      GET_EQ(ch, i)->affected[j].modifier,
-		      GET_OBJ_AFFECT(GET_EQ(ch, i)), TRUE);
+/*
+ * For putting on or taking off several things at once (an equipment set,
+ * a player's rent file): until the matching affect_batch_end(), removing
+ * equipment leaves its affect bits for the end and GMCP gets one
+ * Char.Status instead of one per item.  Batches may nest.
+ */
+void affect_batch_begin(struct char_data *ch)
+{
+  if (ch->affect_batch++ == 0)
+    ch->affect_batch_eq = FALSE;
+}
+
+
+void affect_batch_end(struct char_data *ch)
+{
+  if (ch->affect_batch <= 0) {
+    log("SYSERR: affect_batch_end() for %s without affect_batch_begin().", GET_NAME(ch));
+    return;
   }
+  if (--ch->affect_batch > 0)
+    return;
 
+  affect_restore_bits(ch, ~(bitvector_t)0);
+  affect_check(ch, "affect_batch_end");
+  if (ch->affect_batch_eq)
+    gmcp_send_char_status(ch);
+}
 
-  for (af = ch->affected; af; af = af->next)
-    affect_modify(ch, af->location, af->modifier, af->bitvector, TRUE);
 
-  /* Make certain values are between 0..25, not < 0 and not > 25! */
+#if CHECK_AFFECTS
+/*
+ * Compare the ability applies and affect bits kept up to date as things
+ * come and go against a full affect_total().  (aff_abils itself can be
+ * out of step for a while where real_abils is set directly, as when a
+ * character is created.)
+ */
+static void affect_check(struct char_data *ch, const char *where)
+{
+  struct char_ability_mods mods = ch->abil_mods;
+  bitvector_t bits = AFF_FLAGS(ch);
+  extern const char *affected_bits[];
 
-  i = (IS_NPC(ch) || GET_LEVEL(ch) >= LVL_GRGOD) ? 25 : 18;
+  if (ch->affect_batch)
+    return;
 
-  GET_DEX(ch) = MAX(0, MIN(GET_DEX(ch), i));
-  GET_INT(ch) = MAX(0, MIN(GET_INT(ch), i));
-  GET_WIS(ch) = MAX(0, MIN(GET_WIS(ch), i));
-  GET_CON(ch) = MAX(0, MIN(GET_CON(ch), i));
-  GET_CHA(ch) = MAX(0, MIN(GET_CHA(ch), i));
-  GET_STR(ch) = MAX(0, GET_STR(ch));
+  affect_total(ch);
 
-  if (IS_NPC(ch)) {
-    GET_STR(ch) = MIN(GET_STR(ch), i);
-  } else {
-    if (GET_STR(ch) > 18) {
-      i = GET_ADD(ch) + ((GET_STR(ch) - 18) * 10);
-      GET_ADD(ch) = MIN(i, 100);
-      GET_STR(ch) = 18;
-    }
+  if (memcmp(&mods, &ch->abil_mods, sizeof(mods)))
+    log("SYSERR: %s: %s's ability applies were %d %d %d %d %d %d, "
+	"recomputed %d %d %d %d %d %d.", where, GET_NAME(ch),
+	mods.str, mods.intel, mods.wis, mods.dex, mods.con, mods.cha,
+	ch->abil_mods.str, ch->abil_mods.intel, ch->abil_mods.wis,
+	ch->abil_mods.dex, ch->abil_mods.con, ch->abil_mods.cha);
+  if (bits != AFF_FLAGS(ch)) {
+    char missing[MAX_STRING_LENGTH];
+
+    sprintbit(AFF_FLAGS(ch) & ~bits, affected_bits, missing, sizeof(missing));
+    log("SYSERR: %s: %s was missing affect bits %s.", where, GET_NAME(ch), missing);
   }
 }
-
+#endif
 
 
 /* Insert an affect_type in a char_data structure
@@ -279,7 +856,7 @@ void affect_to_char(struct char_data *ch, struct affected_type *af)
   {
     long aff_before = AFF_FLAGS(ch) & GMCP_AFFLICTION_BITS;
     affect_modify(ch, af->location, af->modifier, af->bitvector, TRUE);
-    affect_total(ch);
+    affect_check(ch, "affect_to_char");
     long newly_set = (AFF_FLAGS(ch) & GMCP_AFFLICTION_BITS) & ~aff_before;
     if (newly_set)
       gmcp_send_char_afflictions_add(ch, newly_set);
@@ -300,6 +877,7 @@ void affect_remove(struct char_data *ch, struct affected_type *af)
 {
   struct affected_type *temp;
   int spell_type = af->type;
+  bitvector_t bitv = af->bitvector;
 
   if (ch->affected == NULL) {
     core_dump();
@@ -311,7 +889,8 @@ void affect_remove(struct char_data *ch, struct affected_type *af)
     affect_modify(ch, af->location, af->modifier, af->bitvector, FALSE);
     REMOVE_FROM_LIST(af, ch->affected, next);
     free(af);
-    affect_total(ch);
+    affect_restore_bits(ch, bitv);
+    affect_check(ch, "affect_remove");
     long newly_cleared = aff_before & ~(AFF_FLAGS(ch) & GMCP_AFFLICTION_BITS);
     if (newly_cleared)
       gmcp_send_char_afflictions_remove(ch, newly_cleared);
@@ -403,6 +982,9 @@ void char_from_room(struct char_data *ch)
       if (GET_OBJ_VAL(GET_EQ(ch, WEAR_LIGHT), 2))	/* Light is ON */
 	world[IN_ROOM(ch)].light--;
 
+  if (GET_MOB_SPEC(ch))
+    world[IN_ROOM(ch)].spec_count--;
+
   gmcp_notify_room_players_remove(ch);
   REMOVE_FROM_LIST(ch, world[IN_ROOM(ch)].people, next_in_room);
   IN_ROOM(ch) = NOWHERE;
@@ -410,6 +992,32 @@ void char_from_room(struct char_data *ch)
 }
 
 
+/*
+ * Somebody has come into the room.  Aggressive and memory mobs there get
+ * to size up a player, or a mob like that the players it finds, at the
+ * end of the pulse (mobile_entry_checks()) instead of on their next scan.
+ * Mobs with spec procs are left to mobile_activity(), where the spec
+ * proc gets the first say.
+ */
+static void queue_entry_checks(struct char_data *ch, room_rnum room)
+{
+  const int watch = (1 << CHAR_LIST_AGGRESSIVE) | (1 << CHAR_LIST_MEMORY);
+  struct char_data *tch;
+
+  if (!IS_NPC(ch)) {
+    for (tch = world[room].people; tch; tch = tch->next_in_room)
+      if ((tch->in_lists & watch) && !(tch->in_lists & (1 << CHAR_LIST_SPEC)))
+        char_list_add(tch, CHAR_LIST_ENTERED);
+  } else if ((ch->in_lists & watch) && !(ch->in_lists & (1 << CHAR_LIST_SPEC))) {
+    for (tch = world[room].people; tch; tch = tch->next_in_room)
+      if (!IS_NPC(tch)) {
+        char_list_add(ch, CHAR_LIST_ENTERED);
+        break;
+      }
+  }
+}
+
+
 /* place a character in a room */
 void char_to_room(struct char_data *ch, room_rnum room)
 {
@@ -423,6 +1031,8 @@ void char_to_room(struct char_data *ch, room_rnum room)
     ch->next_in_room = world[room].people;
     world[room].people = ch;
     IN_ROOM(ch) = room;
+    if (GET_MOB_SPEC(ch))
+      world[room].spec_count++;
 
     if (GET_EQ(ch, WEAR_LIGHT))
       if (GET_OBJ_TYPE(GET_EQ(ch, WEAR_LIGHT)) == ITEM_LIGHT)
@@ -438,6 +1048,8 @@ void char_to_room(struct char_data *ch, room_rnum room)
     if (!IS_NPC(ch) && GET_LEVEL(ch) < LVL_IMMORT)
       zone_table[world[room].zone].empty_age = 0;
 
+    queue_entry_checks(ch, room);
+
     gmcp_send_room_info(ch);
     gmcp_send_room_players(ch);
     gmcp_notify_room_players_add(ch);
@@ -461,6 +1073,8 @@ void obj_to_char(struct obj_data *object, struct char_data *ch)
     IN_ROOM(object) = NOWHERE;
     IS_CARRYING_W(ch) += GET_OBJ_WEIGHT(object);
     IS_CARRYING_N(ch)++;
+    if (GET_OBJ_SPEC(object))
+      ch->spec_objs++;
 
     /* set flag for crash-save system, but not on mobs! */
     if (!IS_NPC(ch))
@@ -491,6 +1105,8 @@ void obj_from_char(struct obj_data *object)
 
   IS_CARRYING_W(object->carried_by) -= GET_OBJ_WEIGHT(object);
   IS_CARRYING_N(object->carried_by)--;
+  if (GET_OBJ_SPEC(object))
+    object->carried_by->spec_objs--;
   object->carried_by = NULL;
   object->next_content = NULL;
 
@@ -575,9 +1191,13 @@ void equip_char(struct char_data *ch, struct obj_data *obj, int pos)
   GET_EQ(ch, pos) = obj;
   obj->worn_by = ch;
   obj->worn_on = pos;
+  if (GET_OBJ_SPEC(obj))
+    ch->spec_objs++;
 
-  if (GET_OBJ_TYPE(obj) == ITEM_ARMOR)
+  if (GET_OBJ_TYPE(obj) == ITEM_ARMOR) {
     GET_AC(ch) -= apply_ac(ch, pos);
+    INVALIDATE_COMBAT(ch);
+  }
 
   if (IN_ROOM(ch) != NOWHERE) {
     if (pos == WEAR_LIGHT && GET_OBJ_TYPE(obj) == ITEM_LIGHT)
@@ -591,9 +1211,13 @@ void equip_char(struct char_data *ch, struct obj_data *obj, int pos)
 		  obj->affected[j].modifier,
 		  GET_OBJ_AFFECT(obj), TRUE);
 
-  affect_total(ch);
   gmcp_send_char_items_add(ch, obj);
-  gmcp_send_char_status(ch);
+  if (ch->affect_batch)
+    ch->affect_batch_eq = TRUE;
+  else {
+    affect_check(ch, "equip_char");
+    gmcp_send_char_status(ch);
+  }
 }
 
 
@@ -611,9 +1235,13 @@ struct obj_data *unequip_char(struct char_data *ch, int pos)
   obj = GET_EQ(ch, pos);
   obj->worn_by = NULL;
   obj->worn_on = -1;
+  if (GET_OBJ_SPEC(obj))
+    ch->spec_objs--;
 
-  if (GET_OBJ_TYPE(obj) == ITEM_ARMOR)
+  if (GET_OBJ_TYPE(obj) == ITEM_ARMOR) {
     GET_AC(ch) += apply_ac(ch, pos);
+    INVALIDATE_COMBAT(ch);
+  }
 
   if (IN_ROOM(ch) != NOWHERE) {
     if (pos == WEAR_LIGHT && GET_OBJ_TYPE(obj) == ITEM_LIGHT)
@@ -629,9 +1257,14 @@ struct obj_data *unequip_char(struct char_data *ch, int pos)
 		  obj->affected[j].modifier,
 		  GET_OBJ_AFFECT(obj), FALSE);
 
-  affect_total(ch);
   gmcp_send_char_items_remove(ch, obj);
-  gmcp_send_char_status(ch);
+  if (ch->affect_batch)
+    ch->affect_batch_eq = TRUE;
+  else {
+    affect_restore_bits(ch, GET_OBJ_AFFECT(obj));
+    affect_check(ch, "unequip_char");
+    gmcp_send_char_status(ch);
+  }
 
   return (obj);
 }
@@ -693,18 +1326,20 @@ struct obj_data *get_obj_num(obj_rnum nr)
 struct char_data *get_char_room(char *name, int *number, room_rnum room)
 {
   struct char_data *i;
+  struct keyword_query kq;
   int num;
 
   if (!number) {
     number = &num;
     num = get_number(&name);
   }
+  keyword_query_init(&kq, name);
 
   if (*number == 0)
     return (NULL);
 
   for (i = world[room].people; i && *number; i = i->next_in_room)
-    if (isname(name, i->player.name))
+    if (isname_char(&kq, i))
       if (--(*number) == 0)
 	return (i);
 
@@ -738,6 +1373,8 @@ void obj_to_room(struct obj_data *object, room_rnum room)
     world[room].contents = object;
     IN_ROOM(object) = room;
     object->carried_by = NULL;
+    if (GET_OBJ_SPEC(object))
+      world[room].spec_count++;
     if (ROOM_FLAGGED(room, ROOM_HOUSE))
       SET_BIT(ROOM_FLAGS(room), ROOM_HOUSE_CRASH);
   }
@@ -756,6 +1393,8 @@ void obj_from_room(struct obj_data *object)
   }
 
   REMOVE_FROM_LIST(object, world[IN_ROOM(object)].contents, next_content);
+  if (GET_OBJ_SPEC(object))
+    world[IN_ROOM(object)].spec_count--;
 
   if (ROOM_FLAGGED(IN_ROOM(object), ROOM_HOUSE))
     SET_BIT(ROOM_FLAGS(IN_ROOM(object)), ROOM_HOUSE_CRASH);
@@ -852,6 +1491,7 @@ void extract_obj(struct obj_data *obj)
   }
 
   REMOVE_FROM_LIST(obj, object_list, next);
+  keyword_unindex_obj(obj);
 
   if (GET_OBJ_RNUM(obj) != NOTHING)
     (obj_index[GET_OBJ_RNUM(obj)].number)--;
@@ -898,6 +1538,110 @@ void update_char_objects(struct char_data *ch)
 }
 
 
+/*
+ * The worklists (CHAR_LIST_xxx) a character belongs on, going by what it
+ * is and its flags.
+ */
+static int char_lists_wanted(struct char_data *ch)
+{
+  int want = 0;
+
+  if (!IS_NPC(ch))
+    return (1 << CHAR_LIST_PLAYERS);
+
+  /* A spec proc that only answers commands gets nothing from a pulse. */
+  if (MOB_FLAGGED(ch, MOB_SPEC) && (!GET_MOB_SPEC(ch) || SPEC_WANTS(GET_MOB_SPEC_TRIG(ch), 0)))
+    want |= (1 << CHAR_LIST_SPEC);
+  if (MOB_FLAGGED(ch, MOB_SCAVENGER))
+    want |= (1 << CHAR_LIST_SCAVENGER);
+  if (!MOB_FLAGGED(ch, MOB_SENTINEL))
+    want |= (1 << CHAR_LIST_WANDERER);
+  if (MOB_FLAGGED(ch, MOB_AGGRESSIVE | MOB_AGGR_EVIL | MOB_AGGR_NEUTRAL | MOB_AGGR_GOOD))
+    want |= (1 << CHAR_LIST_AGGRESSIVE);
+  if (MOB_FLAGGED(ch, MOB_MEMORY))
+    want |= (1 << CHAR_LIST_MEMORY);
+  if (MOB_FLAGGED(ch, MOB_HELPER))
+    want |= (1 << CHAR_LIST_HELPER);
+  if (ch->master)
+    want |= (1 << CHAR_LIST_FOLLOWER);
+
+  return (want);
+}
+
+
+static void char_list_link(struct char_data *ch, int list)
+{
+  ch->prev_in_list[list] = NULL;
+  ch->next_in_list[list] = char_lists[list];
+  if (char_lists[list])
+    char_lists[list]->prev_in_list[list] = ch;
+  char_lists[list] = ch;
+  ch->in_lists |= (1 << list);
+}
+
+
+/*
+ * Whoever is walking a list keeps the next one to look at in
+ * char_list_next[], as with next_combat_list, so it can lose anybody
+ * along the way.
+ */
+static void char_list_unlink(struct char_data *ch, int list)
+{
+  if (char_list_next[list] == ch)
+    char_list_next[list] = ch->next_in_list[list];
+  if (ch->prev_in_list[list])
+    ch->prev_in_list[list]->next_in_list[list] = ch->next_in_list[list];
+  else
+    char_lists[list] = ch->next_in_list[list];
+  if (ch->next_in_list[list])
+    ch->next_in_list[list]->prev_in_list[list] = ch->prev_in_list[list];
+  ch->next_in_list[list] = ch->prev_in_list[list] = NULL;
+  ch->in_lists &= ~(1 << list);
+}
+
+
+/*
+ * Put a character in the game on the worklists it belongs on and take it
+ * off the rest.  Call it when it enters character_list and whenever its
+ * MOB_xxx flags or its master change.  The lists from CHAR_LIST_ENTERED
+ * on are queues of things to do, not kept by this.
+ */
+void char_lists_update(struct char_data *ch)
+{
+  int want = char_lists_wanted(ch), list;
+
+  for (list = 0; list < CHAR_LIST_ENTERED; list++)
+    if ((want & (1 << list)) && !(ch->in_lists & (1 << list)))
+      char_list_link(ch, list);
+    else if (!(want & (1 << list)) && (ch->in_lists & (1 << list)))
+      char_list_unlink(ch, list);
+}
+
+
+void char_list_add(struct char_data *ch, int list)
+{
+  if (!(ch->in_lists & (1 << list)))
+    char_list_link(ch, list);
+}
+
+
+void char_list_del(struct char_data *ch, int list)
+{
+  if (ch->in_lists & (1 << list))
+    char_list_unlink(ch, list);
+}
+
+
+void char_lists_remove(struct char_data *ch)
+{
+  int list;
+
+  for (list = 0; list < NUM_CHAR_LISTS; list++)
+    if (ch->in_lists & (1 << list))
+      char_list_unlink(ch, list);
+}
+
+
 /* Extract a ch completely from the world, and leave his stuff behind */
 void extract_char_final(struct char_data *ch)
 {
@@ -912,6 +1656,13 @@ void extract_char_final(struct char_data *ch)
     exit(1);
   }
 
+  /* It's about to come off character_list. */
+  keyword_unindex_char(ch);
+
+  /* Dying and being purged or deleted leave the game too. */
+  if (!IS_NPC(ch))
+    webserver_feed_logout(ch, "extract");
+
   /*
    * We're booting the character of someone who has switched so first we
    * need to stuff them back into their own body.  This will set ch->desc
@@ -1002,6 +1753,9 @@ void extract_char_final(struct char_data *ch)
     Crash_delete_crashfile(ch);
   }
 
+  /* Last, as die_follower() above would have put it back on some. */
+  char_lists_remove(ch);
+
   /* If there's a descriptor, they're in the menu now. */
   if (IS_NPC(ch) || !ch->desc)
     free_char(ch);
@@ -1094,9 +1848,7 @@ struct char_data *get_player_vis(struct char_data *ch, char *name, int *number,
     num = get_number(&name);
   }
 
-  for (i = character_list; i; i = i->next) {
-    if (IS_NPC(i))
-      continue;
+  for (i = char_lists[CHAR_LIST_PLAYERS]; i; i = i->next_in_list[CHAR_LIST_PLAYERS]) {
     if (inroom == FIND_CHAR_ROOM && IN_ROOM(i) != IN_ROOM(ch))
       continue;
     if (str_cmp(i->player.name, name)) /* If not same, continue */
@@ -1115,12 +1867,14 @@ struct char_data *get_player_vis(struct char_data *ch, char *name, int *number,
 struct char_data *get_char_room_vis(struct char_data *ch, char *name, int *number)
 {
   struct char_data *i;
+  struct keyword_query kq;
   int num;
 
   if (!number) {
     number = &num;
     num = get_number(&name);
   }
+  keyword_query_init(&kq, name);
 
   /* JE 7/18/94 :-) :-) */
   if (!str_cmp(name, "self") || !str_cmp(name, "me"))
@@ -1131,7 +1885,7 @@ struct char_data *get_char_room_vis(struct char_data *ch, char *name, int *numbe
     return (get_player_vis(ch, name, NULL, FIND_CHAR_ROOM));
 
   for (i = world[IN_ROOM(ch)].people; i && *number; i = i->next_in_room)
-    if (isname(name, i->player.name))
+    if (isname_char(&kq, i))
       if (CAN_SEE(ch, i))
 	if (--(*number) == 0)
 	  return (i);
@@ -1143,12 +1897,15 @@ struct char_data *get_char_room_vis(struct char_data *ch, char *name, int *numbe
 struct char_data *get_char_world_vis(struct char_data *ch, char *name, int *number)
 {
   struct char_data *i;
+  struct keyword_walk walk = { NULL, NULL };
+  struct keyword_query kq;
   int num;
 
   if (!number) {
     number = &num;
     num = get_number(&name);
   }
+  keyword_query_init(&kq, name);
 
   if ((i = get_char_room_vis(ch, name, number)) != NULL)
     return (i);
@@ -1156,10 +1913,16 @@ struct char_data *get_char_world_vis(struct char_data *ch, char *name, int *numb
   if (*number == 0)
     return get_player_vis(ch, name, NULL, 0);
 
-  for (i = character_list; i && *number; i = i->next) {
+  if (kq.len) {
+    kwi_start(&walk, &kq, FALSE);
+    i = kwi_next(&walk);
+  } else
+    i = character_list;
+
+  for (; i && *number; i = kq.len ? kwi_next(&walk) : i->next) {
     if (IN_ROOM(ch) == IN_ROOM(i))
       continue;
-    if (!isname(name, i->player.name))
+    if (!isname_char(&kq, i))
       continue;
     if (!CAN_SEE(ch, i))
       continue;
@@ -1186,18 +1949,20 @@ struct char_data *get_char_vis(struct char_data *ch, char *name, int *number, in
 struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *number, struct obj_data *list)
 {
   struct obj_data *i;
+  struct keyword_query kq;
   int num;
 
   if (!number) {
     number = &num;
     num = get_number(&name);
   }
+  keyword_query_init(&kq, name);
 
   if (*number == 0)
     return (NULL);
 
   for (i = list; i && *number; i = i->next_content)
-    if (isname(name, i->name))
+    if (isname_obj(&kq, i))
       if (CAN_SEE_OBJ(ch, i))
 	if (--(*number) == 0)
 	  return (i);
@@ -1210,12 +1975,15 @@ struct obj_data *get_obj_in_list_vis(struct char_data *ch, char *name, int *numb
 struct obj_data *get_obj_vis(struct char_data *ch, char *name, int *number)
 {
   struct obj_data *i;
+  struct keyword_walk walk = { NULL, NULL };
+  struct keyword_query kq;
   int num;
 
   if (!number) {
     number = &num;
     num = get_number(&name);
   }
+  keyword_query_init(&kq, name);
 
   if (*number == 0)
     return (NULL);
@@ -1229,8 +1997,14 @@ struct obj_data *get_obj_vis(struct char_data *ch, char *name, int *number)
     return (i);
 
   /* ok.. no luck yet. scan the entire obj list   */
-  for (i = object_list; i && *number; i = i->next)
-    if (isname(name, i->name))
+  if (kq.len) {
+    kwi_start(&walk, &kq, TRUE);
+    i = kwi_next(&walk);
+  } else
+    i = object_list;
+
+  for (; i && *number; i = kq.len ? kwi_next(&walk) : i->next)
+    if (isname_obj(&kq, i))
       if (CAN_SEE_OBJ(ch, i))
 	if (--(*number) == 0)
 	  return (i);
@@ -1241,18 +2015,20 @@ struct obj_data *get_obj_vis(struct char_data *ch, char *name, int *number)
 
 struct obj_data *get_obj_in_equip_vis(struct char_data *ch, char *arg, int *number, struct obj_data *equipment[])
 {
+  struct keyword_query kq;
   int j, num;
 
   if (!number) {
     number = &num;
     num = get_number(&arg);
   }
+  keyword_query_init(&kq, arg);
 
   if (*number == 0)
     return (NULL);
 
   for (j = 0; j < NUM_WEARS; j++)
-    if (equipment[j] && CAN_SEE_OBJ(ch, equipment[j]) && isname(arg, equipment[j]->name))
+    if (equipment[j] && CAN_SEE_OBJ(ch, equipment[j]) && isname_obj(&kq, equipment[j]))
       if (--(*number) == 0)
         return (equipment[j]);
 
@@ -1262,18 +2038,20 @@ struct obj_data *get_obj_in_equip_vis(struct char_data *ch, char *arg, int *numb
 
 int get_obj_pos_in_equip_vis(struct char_data *ch, char *arg, int *number, struct obj_data *equipment[])
 {
+  struct keyword_query kq;
   int j, num;
 
   if (!number) {
     number = &num;
     num = get_number(&arg);
   }
+  keyword_query_init(&kq, arg);
 
   if (*number == 0)
     return (-1);
 
   for (j = 0; j < NUM_WEARS; j++)
-    if (equipment[j] && CAN_SEE_OBJ(ch, equipment[j]) && isname(arg, equipment[j]->name))
+    if (equipment[j] && CAN_SEE_OBJ(ch, equipment[j]) && isname_obj(&kq, equipment[j]))
       if (--(*number) == 0)
         return (j);
 
@@ -1360,6 +2138,7 @@ struct obj_data *create_money(int amount)
 
   new_descr->next = NULL;
   obj->ex_description = new_descr;
+  keyword_index_obj(obj);
 
   GET_OBJ_TYPE(obj) = ITEM_MONEY;
   GET_OBJ_WEAR(obj) = ITEM_WEAR_TAKE;
@@ -1390,6 +2169,7 @@ struct obj_data *create_money(int amount)
 int generic_find(char *arg, bitvector_t bitvector, struct char_data *ch,
 		     struct char_data **tar_ch, struct obj_data **tar_obj)
 {
+  struct keyword_query kq;
   int i, found, number;
   char name_val[MAX_INPUT_LENGTH];
   char *name = name_val;
@@ -1415,8 +2195,9 @@ int generic_find(char *arg, bitvector_t bitvector, struct char_data *ch,
   }
 
   if (IS_SET(bitvector, FIND_OBJ_EQUIP)) {
+    keyword_query_init(&kq, name);
     for (found = FALSE, i = 0; i < NUM_WEARS && !found; i++)
-      if (GET_EQ(ch, i) && isname(name, GET_EQ(ch, i)->name) && --number == 0) {
+      if (GET_EQ(ch, i) && isname_obj(&kq, GET_EQ(ch, i)) && --number == 0) {
 	*tar_obj = GET_EQ(ch, i);
 	found = TRUE;
       }
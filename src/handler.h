@@ -10,6 +10,8 @@
 
 /* handling the affected-structures */
 void	affect_total(struct char_data *ch);
+void	affect_batch_begin(struct char_data *ch);
+void	affect_batch_end(struct char_data *ch);
 void	affect_modify(struct char_data *ch, byte loc, sbyte mod, bitvector_t bitv, bool add);
 void	affect_to_char(struct char_data *ch, struct affected_type *af);
 void	affect_remove(struct char_data *ch, struct affected_type *af);
@@ -23,6 +25,18 @@ bool add_dur, bool avg_dur, bool add_mod, bool avg_mod);
 const char *money_desc(int amount);
 struct obj_data *create_money(int amount);
 int	isname(const char *str, const char *namelist);
+struct keyword_set *keyword_set_build(const char *namelist);
+void	keyword_set_free(struct keyword_set *ks);
+void	keyword_query_init(struct keyword_query *kq, const char *str);
+int	keyword_set_match(const struct keyword_query *kq, const struct keyword_set *ks);
+void	proto_keywords_changed(struct index_data *idx);
+int	isname_obj(const struct keyword_query *kq, struct obj_data *obj);
+int	isname_char(const struct keyword_query *kq, struct char_data *ch);
+void	keyword_index_char(struct char_data *ch);
+void	keyword_index_obj(struct obj_data *obj);
+void	keyword_unindex_char(struct char_data *ch);
+void	keyword_unindex_obj(struct obj_data *obj);
+void	keyword_benchmark(void);
 char	*fname(const char *namelist);
 int	get_number(char **name);
 
@@ -53,6 +67,10 @@ void	char_to_room(struct char_data *ch, room_rnum room);
 void	extract_char(struct char_data *ch);
 void	extract_char_final(struct char_data *ch);
 void	extract_pending_chars(void);
+void	char_lists_update(struct char_data *ch);
+void	char_lists_remove(struct char_data *ch);
+void	char_list_add(struct char_data *ch, int list);
+void	char_list_del(struct char_data *ch, int list);
 
 /* find if character can see */
 struct char_data *get_player_vis(struct char_data *ch, char *name, int *number, int inroom);
@@ -95,6 +113,7 @@ int	generic_find(char *arg, bitvector_t bitvector, struct char_data *ch,
 int	Crash_delete_file(char *name);
 int	Crash_delete_crashfile(struct char_data *ch);
 int	Crash_clean_file(char *name);
+void	Crash_sweep_pulse(void);
 void	Crash_listrent(struct char_data *ch, char *name);
 int	Crash_load(struct char_data *ch);
 void	Crash_crashsave(struct char_data *ch);
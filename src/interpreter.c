@@ -24,6 +24,9 @@
 #include "screen.h"
 #include "olc.h"
 #include "gmcp.h"
+#include "bundle.h"
+#include "pwhash.h"
+#include "webserver.h"
 
 /* external variables */
 extern room_rnum r_mortal_start_room;
@@ -41,6 +44,7 @@ extern int top_of_p_table;
 extern int circle_restrict;
 extern int no_specials;
 extern int max_bad_pws;
+extern struct char_data *char_lists[NUM_CHAR_LISTS];
 
 /* external functions */
 void echo_on(struct descriptor_data *d);
@@ -1106,33 +1110,44 @@ int special(struct char_data *ch, int cmd, char *arg)
   int j;
 
   /* special in room? */
-  if (GET_ROOM_SPEC(IN_ROOM(ch)) != NULL)
+  if (GET_ROOM_SPEC(IN_ROOM(ch)) != NULL && SPEC_WANTS(GET_ROOM_SPEC_TRIG(IN_ROOM(ch)), cmd))
     if (GET_ROOM_SPEC(IN_ROOM(ch)) (ch, world + IN_ROOM(ch), cmd, arg))
       return (1);
 
-  /* special in equipment list? */
-  for (j = 0; j < NUM_WEARS; j++)
-    if (GET_EQ(ch, j) && GET_OBJ_SPEC(GET_EQ(ch, j)) != NULL)
-      if (GET_OBJ_SPEC(GET_EQ(ch, j)) (ch, GET_EQ(ch, j), cmd, arg))
-	return (1);
-
-  /* special in inventory? */
-  for (i = ch->carrying; i; i = i->next_content)
-    if (GET_OBJ_SPEC(i) != NULL)
-      if (GET_OBJ_SPEC(i) (ch, i, cmd, arg))
-	return (1);
-
-  /* special in mobile present? */
-  for (k = world[IN_ROOM(ch)].people; k; k = k->next_in_room)
-    if (!MOB_FLAGGED(k, MOB_NOTDEADYET))
-      if (GET_MOB_SPEC(k) && GET_MOB_SPEC(k) (ch, k, cmd, arg))
-	return (1);
-
-  /* special in object present? */
-  for (i = world[IN_ROOM(ch)].contents; i; i = i->next_content)
-    if (GET_OBJ_SPEC(i) != NULL)
-      if (GET_OBJ_SPEC(i) (ch, i, cmd, arg))
-	return (1);
+  /*
+   * Most rooms have nothing with a spec proc in them, and most characters
+   * carry nothing with one, so the counts kept by the handler.c list
+   * functions let us skip the walks below.
+   */
+  if (ch->spec_objs) {
+    /* special in equipment list? */
+    for (j = 0; j < NUM_WEARS; j++)
+      if (GET_EQ(ch, j) && GET_OBJ_SPEC(GET_EQ(ch, j)) != NULL &&
+          SPEC_WANTS(GET_OBJ_SPEC_TRIG(GET_EQ(ch, j)), cmd))
+        if (GET_OBJ_SPEC(GET_EQ(ch, j)) (ch, GET_EQ(ch, j), cmd, arg))
+	  return (1);
+
+    /* special in inventory? */
+    for (i = ch->carrying; i; i = i->next_content)
+      if (GET_OBJ_SPEC(i) != NULL && SPEC_WANTS(GET_OBJ_SPEC_TRIG(i), cmd))
+        if (GET_OBJ_SPEC(i) (ch, i, cmd, arg))
+	  return (1);
+  }
+
+  if (world[IN_ROOM(ch)].spec_count) {
+    /* special in mobile present? */
+    for (k = world[IN_ROOM(ch)].people; k; k = k->next_in_room)
+      if (!MOB_FLAGGED(k, MOB_NOTDEADYET))
+        if (GET_MOB_SPEC(k) && MOB_SPEC_WANTS(k, ch, cmd) &&
+            GET_MOB_SPEC(k) (ch, k, cmd, arg))
+	  return (1);
+
+    /* special in object present? */
+    for (i = world[IN_ROOM(ch)].contents; i; i = i->next_content)
+      if (GET_OBJ_SPEC(i) != NULL && SPEC_WANTS(GET_OBJ_SPEC_TRIG(i), cmd))
+        if (GET_OBJ_SPEC(i) (ch, i, cmd, arg))
+	  return (1);
+  }
 
   return (0);
 }
@@ -1226,11 +1241,9 @@ int perform_dupe_check(struct descriptor_data *d)
   * duplicates, though theoretically none should be able to exist).
   */
 
-  for (ch = character_list; ch; ch = next_ch) {
-    next_ch = ch->next;
+  for (ch = char_lists[CHAR_LIST_PLAYERS]; ch; ch = next_ch) {
+    next_ch = ch->next_in_list[CHAR_LIST_PLAYERS];
 
-    if (IS_NPC(ch))
-      continue;
     if (GET_IDNUM(ch) != id)
       continue;
 
@@ -1279,6 +1292,8 @@ int perform_dupe_check(struct descriptor_data *d)
   gmcp_send_char_afflictions_list(d->character);
   gmcp_send_discord_status(d->character);
 
+  webserver_feed_login(d->character, TRUE);
+
   switch (mode) {
   case RECON:
     write_to_output(d, "Reconnecting.\r\n");
@@ -1304,11 +1319,27 @@ int perform_dupe_check(struct descriptor_data *d)
 
 
 
+/*
+ * The hash of a password typed at one of nanny()'s prompts, or NULL if it
+ * has been handed to a worker thread.  In that case the connection sits
+ * in CON_VERIFYING until pwhash_poll() calls us again with the same line.
+ */
+static const char *nanny_crypt(struct descriptor_data *d, const char *arg, const char *salt)
+{
+  static char hash[MAX_PWD_LENGTH + 1];
+
+  if (!pwhash_request(d, arg, salt, hash, sizeof(hash)))
+    return (NULL);
+  return (hash);
+}
+
+
 /* deal with newcomers and other non-playing sockets */
 void nanny(struct descriptor_data *d, char *arg)
 {
   int load_result;	/* Overloaded variable */
   int iarg;
+  const char *pwd;
 
   skip_spaces(&arg);
 
@@ -1333,6 +1364,11 @@ void nanny(struct descriptor_data *d, char *arg)
 	write_to_output(d, "Invalid name, please try another.\r\nName: ");
 	return;
       }
+      /*
+       * The player record itself is still read here, not prefetched: it is
+       * one record from the already open player_fl, which save_char() also
+       * writes from the game loop, and the next prompt depends on it.
+       */
       if ((player_i = load_char(tmp_name, &tmp_store)) > -1) {
 	store_to_char(&tmp_store, d->character);
 	GET_PFILEPOS(d->character) = player_i;
@@ -1359,6 +1395,9 @@ void nanny(struct descriptor_data *d, char *arg)
 	  REMOVE_BIT(PLR_FLAGS(d->character),
 		     PLR_WRITING | PLR_MAILING | PLR_CRYO);
 	  REMOVE_BIT(AFF_FLAGS(d->character), AFF_GROUP);
+	  /* Read their rent, aliases and eqsets while they type. */
+	  plrfile_prefetch_cancel(d->prefetch);
+	  d->prefetch = plrfile_prefetch(GET_NAME(d->character));
 	  write_to_output(d, "Password: ");
 	  echo_off(d);
 	  d->idle_tics = 0;
@@ -1417,6 +1456,17 @@ void nanny(struct descriptor_data *d, char *arg)
      * re-add the code to cut off duplicates when a player quits.  JE 6 Feb 96
      */
 
+    if (*arg) {
+      if (login_fail_check(d->ip)) {
+	write_to_output(d, "\r\nToo many failed logins from your site.  Try again later.\r\n");
+	STATE(d) = CON_CLOSE;
+	mudlog(NRM, LVL_GOD, TRUE, "Login for %s refused from [%s] (too many bad passwords)", GET_NAME(d->character), d->host);
+	return;
+      }
+      if (!(pwd = nanny_crypt(d, arg, GET_PASSWD(d->character))))
+	return;
+    }
+
     echo_on(d);    /* turn echo back on */
 
     /* New echo_on() eats the return on telnet. Extra space better than none. */
@@ -1425,8 +1475,11 @@ void nanny(struct descriptor_data *d, char *arg)
     if (!*arg)
       STATE(d) = CON_CLOSE;
     else {
-      if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
+      if (strncmp(pwd, GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
 	mudlog(BRF, LVL_GOD, TRUE, "Bad PW: %s [%s]", GET_NAME(d->character), d->host);
+	login_fail_note(d->ip);
+	plrfile_prefetch_cancel(d->prefetch);
+	d->prefetch = NULL;
 	GET_BAD_PWS(d->character)++;
 	save_char(d->character);
 	if (++(d->bad_pws) >= max_bad_pws) {	/* 3 strikes and you're out. */
@@ -1458,8 +1511,11 @@ void nanny(struct descriptor_data *d, char *arg)
 	return;
       }
       /* check and make sure no other copies of this player are logged in */
-      if (perform_dupe_check(d))
+      if (perform_dupe_check(d)) {
+	plrfile_prefetch_cancel(d->prefetch);
+	d->prefetch = NULL;
 	return;
+      }
 
       if (GET_LEVEL(d->character) >= LVL_IMMORT)
 	write_to_output(d, "%s", imotd);
@@ -1487,8 +1543,9 @@ void nanny(struct descriptor_data *d, char *arg)
       write_to_output(d, "\r\nIllegal password.\r\nPassword: ");
       return;
     }
-    strncpy(GET_PASSWD(d->character), CRYPT(arg, GET_PC_NAME(d->character)), MAX_PWD_LENGTH);	/* strncpy: OK (G_P:MAX_PWD_LENGTH+1) */
-    *(GET_PASSWD(d->character) + MAX_PWD_LENGTH) = '\0';
+    if (!(pwd = nanny_crypt(d, arg, GET_PC_NAME(d->character))))
+      return;
+    strlcpy(GET_PASSWD(d->character), pwd, MAX_PWD_LENGTH + 1);
 
     write_to_output(d, "\r\nPlease retype password: ");
     if (STATE(d) == CON_NEWPASSWD)
@@ -1499,8 +1556,9 @@ void nanny(struct descriptor_data *d, char *arg)
 
   case CON_CNFPASSWD:
   case CON_CHPWD_VRFY:
-    if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character),
-		MAX_PWD_LENGTH)) {
+    if (!(pwd = nanny_crypt(d, arg, GET_PASSWD(d->character))))
+      return;
+    if (strncmp(pwd, GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
       write_to_output(d, "\r\nPasswords don't match... start over.\r\nPassword: ");
       if (STATE(d) == CON_CNFPASSWD)
 	STATE(d) = CON_NEWPASSWD;
@@ -1575,6 +1633,8 @@ void nanny(struct descriptor_data *d, char *arg)
 
     case '1':
       reset_char(d->character);
+      plrfile_prefetch_use(d->prefetch);
+      d->prefetch = NULL;
       read_aliases(d->character);
       read_eqsets(d->character);
 
@@ -1602,8 +1662,11 @@ void nanny(struct descriptor_data *d, char *arg)
       send_to_char(d->character, "%s", WELC_MESSG);
       d->character->next = character_list;
       character_list = d->character;
+      keyword_index_char(d->character);
+      char_lists_update(d->character);
       char_to_room(d->character, load_room);
       load_result = Crash_load(d->character);
+      plrfile_prefetch_done();
 
       /* Clear their load room if it's not persistant. */
       if (!PLR_FLAGGED(d->character, PLR_LOADROOM))
@@ -1611,6 +1674,7 @@ void nanny(struct descriptor_data *d, char *arg)
       save_char(d->character);
 
       act("$n has entered the game.", TRUE, d->character, 0, 0, TO_ROOM);
+      webserver_feed_login(d->character, FALSE);
 
       STATE(d) = CON_PLAYING;
       if (GET_LEVEL(d->character) == 0) {
@@ -1673,7 +1737,9 @@ void nanny(struct descriptor_data *d, char *arg)
   }
 
   case CON_CHPWD_GETOLD:
-    if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
+    if (!(pwd = nanny_crypt(d, arg, GET_PASSWD(d->character))))
+      return;
+    if (strncmp(pwd, GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
       echo_on(d);
       write_to_output(d, "\r\nIncorrect password.\r\n%s", MENU);
       STATE(d) = CON_MENU;
@@ -1684,8 +1750,10 @@ void nanny(struct descriptor_data *d, char *arg)
     return;
 
   case CON_DELCNF1:
+    if (!(pwd = nanny_crypt(d, arg, GET_PASSWD(d->character))))
+      return;
     echo_on(d);
-    if (strncmp(CRYPT(arg, GET_PASSWD(d->character)), GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
+    if (strncmp(pwd, GET_PASSWD(d->character), MAX_PWD_LENGTH)) {
       write_to_output(d, "\r\nIncorrect password.\r\n%s", MENU);
       STATE(d) = CON_MENU;
     } else {
@@ -1728,6 +1796,10 @@ void nanny(struct descriptor_data *d, char *arg)
   case CON_CLOSE:
     break;
 
+  /* game_loop() doesn't give us input while a password is being hashed. */
+  case CON_VERIFYING:
+    break;
+
   case CON_REMORT_ROLL:
     iarg = atoi(arg);
 
@@ -0,0 +1,700 @@
+/* ************************************************************************
+*   File: json.c                                        Part of CircleMUD *
+*  Usage: a small single-pass JSON tokenizer for web OLC request bodies   *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include "structs.h"
+#include "utils.h"
+#include "json.h"
+
+/*
+ * The web OLC used to find each field with strstr() on "\"key\"", which
+ * went over the whole body again for every field and happily matched a
+ * key that was really part of some string value.  Here the body is read
+ * once, into tokens in document order, and a key is only ever looked for
+ * among the members of the object it belongs to.
+ */
+
+#define JS_VALUE	0	/* a value is next				*/
+#define JS_FIRST_VALUE	1	/* just after '[': a value or ']'		*/
+#define JS_KEY		2	/* after ',' in an object: a key		*/
+#define JS_FIRST_KEY	3	/* just after '{': a key or '}'			*/
+#define JS_COLON	4	/* after a key					*/
+#define JS_AFTER	5	/* after a value: ',' or the closing bracket	*/
+
+#define JSON_WS(c)	((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+
+static int json_new_token(struct json_doc *doc, int type, int start)
+{
+  struct json_token *t;
+
+  if (doc->num == doc->cap) {
+    /* Roughly one token per 8 bytes of the sort of thing OLC sends. */
+    doc->cap = doc->cap ? doc->cap * 2 : doc->len / 8 + 16;
+    RECREATE(doc->tok, struct json_token, doc->cap);
+  }
+  t = &doc->tok[doc->num];
+  t->type = type;
+  t->start = t->end = start;
+  t->size = 0;
+  t->next = doc->num + 1;
+  return (doc->num++);
+}
+
+
+#define JSON_ONES	0x0101010101010101ULL
+#define JSON_HIGHS	0x8080808080808080ULL
+#define JSON_ZERO_BYTE(x)	(((x) - JSON_ONES) & ~(x) & JSON_HIGHS)
+
+/* The first '"' or '\\' in [p, end), or end; eight bytes at a time. */
+static const char *json_special(const char *p, const char *end)
+{
+  unsigned long long x;
+
+  for (; end - p >= 8; p += 8) {
+    memcpy(&x, p, 8);
+    if (JSON_ZERO_BYTE(x ^ (JSON_ONES * '"')) | JSON_ZERO_BYTE(x ^ (JSON_ONES * '\\')))
+      break;
+  }
+  while (p < end && *p != '"' && *p != '\\')
+    p++;
+  return (p);
+}
+
+
+/*
+ * text[pos] is the opening quote; returns the closing one, or -1.  Long
+ * descriptions are most of what OLC sends, so the plain runs between
+ * escapes are skipped a word at a time.  Raw control characters are let
+ * through, as the old parser did.
+ */
+static int json_scan_string(const char *text, int len, int pos)
+{
+  int i;
+
+  for (pos++; pos < len; pos++) {
+    pos = json_special(text + pos, text + len) - text;
+    if (pos >= len)
+      return (-1);
+    if (text[pos] == '"')
+      return (pos);
+
+    if (++pos >= len)
+      return (-1);
+    switch (text[pos]) {
+    case '"': case '\\': case '/': case 'b':
+    case 'f': case 'n': case 'r': case 't':
+      break;
+    case 'u':
+      for (i = 1; i <= 4; i++)
+	if (pos + i >= len || !isxdigit((unsigned char) text[pos + i]))
+	  return (-1);
+      pos += 4;
+      break;
+    default:
+      return (-1);
+    }
+  }
+  return (-1);
+}
+
+
+/* A number or literal starting at text[pos]; returns the end, or -1. */
+static int json_scan_primitive(const char *text, int len, int pos)
+{
+  static const char *literals[] = { "true", "false", "null" };
+  int i, n, digits;
+
+  for (i = 0; i < 3; i++) {
+    n = strlen(literals[i]);
+    if (len - pos >= n && !strncmp(text + pos, literals[i], n))
+      return (pos + n);
+  }
+
+  if (pos < len && text[pos] == '-')
+    pos++;
+  for (digits = 0; pos < len && isdigit((unsigned char) text[pos]); pos++)
+    digits++;
+  if (!digits)
+    return (-1);
+  if (pos < len && text[pos] == '.') {
+    for (pos++, digits = 0; pos < len && isdigit((unsigned char) text[pos]); pos++)
+      digits++;
+    if (!digits)
+      return (-1);
+  }
+  if (pos < len && (text[pos] == 'e' || text[pos] == 'E')) {
+    pos++;
+    if (pos < len && (text[pos] == '+' || text[pos] == '-'))
+      pos++;
+    for (digits = 0; pos < len && isdigit((unsigned char) text[pos]); pos++)
+      digits++;
+    if (!digits)
+      return (-1);
+  }
+  return (pos);
+}
+
+
+/*
+ * Tokenize text[0..len).  Returns 0, or -1 if it isn't one well-formed
+ * JSON value (or nests deeper than JSON_MAX_DEPTH); the tokens are kept
+ * either way until json_free().
+ */
+int json_parse(struct json_doc *doc, const char *text, size_t len)
+{
+  int stack[JSON_MAX_DEPTH], depth = 0, state = JS_VALUE, pos, end, t;
+  char c;
+
+  memset(doc, 0, sizeof(*doc));
+  doc->text = text;
+  doc->len = len;
+
+  for (pos = 0; pos < doc->len; pos++) {
+    if (JSON_WS(text[pos]))
+      continue;
+    c = text[pos];
+
+    switch (state) {
+    case JS_FIRST_VALUE:
+      if (c == ']')
+	goto close;
+      /* fall through */
+    case JS_VALUE:
+      if (depth && doc->tok[stack[depth - 1]].type == JSON_ARRAY)
+	doc->tok[stack[depth - 1]].size++;
+
+      if (c == '{' || c == '[') {
+	if (depth == JSON_MAX_DEPTH)
+	  return (-1);
+	stack[depth++] = json_new_token(doc, c == '{' ? JSON_OBJECT : JSON_ARRAY, pos);
+	state = (c == '{') ? JS_FIRST_KEY : JS_FIRST_VALUE;
+      } else if (c == '"') {
+	if ((end = json_scan_string(text, doc->len, pos)) < 0)
+	  return (-1);
+	t = json_new_token(doc, JSON_STRING, pos + 1);
+	doc->tok[t].end = end;
+	pos = end;
+	state = JS_AFTER;
+      } else {
+	if ((end = json_scan_primitive(text, doc->len, pos)) < 0)
+	  return (-1);
+	t = json_new_token(doc, JSON_PRIMITIVE, pos);
+	doc->tok[t].end = end;
+	pos = end - 1;
+	state = JS_AFTER;
+      }
+      break;
+
+    case JS_FIRST_KEY:
+      if (c == '}')
+	goto close;
+      /* fall through */
+    case JS_KEY:
+      if (c != '"' || (end = json_scan_string(text, doc->len, pos)) < 0)
+	return (-1);
+      t = json_new_token(doc, JSON_STRING, pos + 1);
+      doc->tok[t].end = end;
+      doc->tok[stack[depth - 1]].size++;
+      pos = end;
+      state = JS_COLON;
+      break;
+
+    case JS_COLON:
+      if (c != ':')
+	return (-1);
+      state = JS_VALUE;
+      break;
+
+    case JS_AFTER:
+      if (!depth)
+	return (-1);		/* something after the value */
+      if (c == ',') {
+	state = (doc->tok[stack[depth - 1]].type == JSON_OBJECT) ? JS_KEY : JS_VALUE;
+	break;
+      }
+      if (c != (doc->tok[stack[depth - 1]].type == JSON_OBJECT ? '}' : ']'))
+	return (-1);
+    close:
+      if ((doc->tok[stack[depth - 1]].type == JSON_OBJECT) != (c == '}'))
+	return (-1);
+      t = stack[--depth];
+      doc->tok[t].end = pos + 1;
+      doc->tok[t].next = doc->num;
+      state = JS_AFTER;
+      break;
+    }
+  }
+
+  return ((state == JS_AFTER && !depth) ? 0 : -1);
+}
+
+
+void json_free(struct json_doc *doc)
+{
+  if (doc->tok)
+    free(doc->tok);
+  doc->tok = NULL;
+  doc->num = doc->cap = 0;
+}
+
+
+/*
+ * The value of obj's member called key, or -1.  Keys are compared as
+ * they appear in the text, so one written with escapes won't match.
+ */
+int json_find(const struct json_doc *doc, int obj, const char *key)
+{
+  int t, i, n = strlen(key);
+
+  if (obj < 0 || obj >= doc->num || doc->tok[obj].type != JSON_OBJECT)
+    return (-1);
+
+  for (t = obj + 1, i = 0; i < doc->tok[obj].size; i++, t = doc->tok[t + 1].next)
+    if (doc->tok[t].end - doc->tok[t].start == n &&
+	doc->text[doc->tok[t].start] == *key &&
+	!strncmp(doc->text + doc->tok[t].start, key, n))
+      return (t + 1);
+  return (-1);
+}
+
+
+/* An array's first element, or an object's first key (its value follows). */
+int json_first(const struct json_doc *doc, int parent)
+{
+  if (parent < 0 || parent >= doc->num || doc->tok[parent].size == 0)
+    return (-1);
+  if (doc->tok[parent].type != JSON_OBJECT && doc->tok[parent].type != JSON_ARRAY)
+    return (-1);
+  return (parent + 1);
+}
+
+
+int json_next(const struct json_doc *doc, int parent, int child)
+{
+  int next;
+
+  if (child < 0)
+    return (-1);
+  if (doc->tok[parent].type == JSON_OBJECT)
+    next = doc->tok[child + 1].next;	/* past the key's value */
+  else
+    next = doc->tok[child].next;
+  return (next < doc->tok[parent].next ? next : -1);
+}
+
+
+static void json_put_utf8(char *out, int *pos, unsigned long cp)
+{
+  if (cp < 0x80)
+    out[(*pos)++] = cp;
+  else if (cp < 0x800) {
+    out[(*pos)++] = 0xC0 | (cp >> 6);
+    out[(*pos)++] = 0x80 | (cp & 0x3F);
+  } else if (cp < 0x10000) {
+    out[(*pos)++] = 0xE0 | (cp >> 12);
+    out[(*pos)++] = 0x80 | ((cp >> 6) & 0x3F);
+    out[(*pos)++] = 0x80 | (cp & 0x3F);
+  } else {
+    out[(*pos)++] = 0xF0 | (cp >> 18);
+    out[(*pos)++] = 0x80 | ((cp >> 12) & 0x3F);
+    out[(*pos)++] = 0x80 | ((cp >> 6) & 0x3F);
+    out[(*pos)++] = 0x80 | (cp & 0x3F);
+  }
+}
+
+
+static unsigned long json_hex4(const char *p)
+{
+  char hex[5];
+
+  memcpy(hex, p, 4);
+  hex[4] = '\0';
+  return (strtoul(hex, NULL, 16));
+}
+
+
+/* A string token, unescaped into a new string; NULL if t isn't one. */
+char *json_str(const struct json_doc *doc, int t)
+{
+  const char *p, *end;
+  unsigned long cp, lo;
+  char *out;
+  int pos = 0;
+
+  if (t < 0 || t >= doc->num || doc->tok[t].type != JSON_STRING)
+    return (NULL);
+
+  p = doc->text + doc->tok[t].start;
+  end = doc->text + doc->tok[t].end;
+  /* Nothing unescapes to more bytes than it took to write. */
+  CREATE(out, char, end - p + 1);
+
+  while (p < end) {
+    const char *run = json_special(p, end);
+
+    memcpy(out + pos, p, run - p);
+    pos += run - p;
+    if ((p = run) == end)
+      break;
+    switch (*++p) {
+    case 'b': out[pos++] = '\b'; break;
+    case 'f': out[pos++] = '\f'; break;
+    case 'n': out[pos++] = '\n'; break;
+    case 'r': out[pos++] = '\r'; break;
+    case 't': out[pos++] = '\t'; break;
+    case 'u':
+      cp = json_hex4(p + 1);
+      p += 4;
+      if (cp >= 0xD800 && cp < 0xDC00 && end - p > 6 && p[1] == '\\' && p[2] == 'u' &&
+	  (lo = json_hex4(p + 3)) >= 0xDC00 && lo < 0xE000) {
+	cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+	p += 6;
+      } else if (cp >= 0xD800 && cp < 0xE000)
+	cp = '?';		/* half a surrogate pair */
+      if (cp == 0)
+	cp = '?';		/* we're making a C string */
+      json_put_utf8(out, &pos, cp);
+      break;
+    default: out[pos++] = *p; break;
+    }
+    p++;
+  }
+  out[pos] = '\0';
+  return (out);
+}
+
+
+/* A number (or true/false as 1/0) that fits in an int. */
+int json_int(const struct json_doc *doc, int t, int *out)
+{
+  const char *p, *end;
+  char buf[32];
+  long v = 0;
+  int neg;
+
+  if (t < 0 || t >= doc->num || doc->tok[t].type != JSON_PRIMITIVE)
+    return (0);
+
+  p = doc->text + doc->tok[t].start;
+  end = doc->text + doc->tok[t].end;
+  if (*p == 't' || *p == 'f') {
+    *out = (*p == 't');
+    return (1);
+  }
+  if (*p == 'n')
+    return (0);
+
+  /* Plain integers, which is nearly everything, without a copy. */
+  if ((neg = (*p == '-')))
+    p++;
+  for (; p < end && isdigit((unsigned char) *p) && v <= INT_MAX; p++)
+    v = v * 10 + (*p - '0');
+  if (p < end) {		/* a fraction, exponent or huge number */
+    int n = end - (doc->text + doc->tok[t].start);
+    if (n >= (int) sizeof(buf))
+      return (0);
+    memcpy(buf, doc->text + doc->tok[t].start, n);
+    buf[n] = '\0';
+    v = (long) strtod(buf, NULL);
+    neg = 0;
+  }
+  if (neg)
+    v = -v;
+  if (v < INT_MIN || v > INT_MAX)
+    return (0);
+  *out = (int) v;
+  return (1);
+}
+
+
+int json_is_null(const struct json_doc *doc, int t)
+{
+  return (t >= 0 && t < doc->num && doc->tok[t].type == JSON_PRIMITIVE &&
+	  doc->text[doc->tok[t].start] == 'n');
+}
+
+
+char *json_get_str(const struct json_doc *doc, int obj, const char *key)
+{
+  return (json_str(doc, json_find(doc, obj, key)));
+}
+
+
+int json_get_int(const struct json_doc *doc, int obj, const char *key, int *out)
+{
+  return (json_int(doc, json_find(doc, obj, key), out));
+}
+
+
+/* The array obj has under key, or -1. */
+int json_get_array(const struct json_doc *doc, int obj, const char *key)
+{
+  int t = json_find(doc, obj, key);
+
+  return ((t >= 0 && doc->tok[t].type == JSON_ARRAY) ? t : -1);
+}
+
+
+/*
+ * Benchmark and fuzz test: ./bin/circle -j.  Times the tokenizer on a
+ * mob like the ones the web OLC sends, with longer and longer
+ * descriptions, against finding each field with strstr() the way it
+ * used to, then throws mangled and random bodies at it and checks that
+ * whatever it accepts makes sense.
+ */
+#define BENCH_BYTES	(16 * 1024 * 1024)	/* parsed per size */
+#define FUZZ_ROUNDS	200000
+
+static const char *bench_mob_keys[] = {
+  "act_flags", "aff_flags", "alignment", "level", "hitroll", "ac",
+  "hp_nodice", "hp_sizedice", "hp_extra", "dam_nodice", "dam_sizedice",
+  "gold", "exp", "position", "default_pos", "sex", "attack_type",
+  "str", "str_add", "intel", "wis", "dex", "con", "cha", NULL
+};
+
+
+/*
+ * A mob with a description of about pad bytes.  With trap, an extra
+ * description called "level" comes first, as it can, and strstr() finds
+ * the wrong things.
+ */
+static char *bench_mob(int pad, int trap)
+{
+  static const char *extra = "\"extra_descs\":[{\"keyword\":\"level\","
+	"\"description\":\"It says [1,{2}].\"}]";
+  char *buf;
+  int i, pos, size = pad + 4096;
+
+  CREATE(buf, char, size);
+  pos = snprintf(buf, size, "{\"vnum\":3001,%s%s\"aliases\":\"guard cityguard\","
+	"\"short_desc\":\"the cityguard\","
+	"\"long_desc\":\"A cityguard stands here.\\r\\n\","
+	"\"description\":\"Set \\\"gold\\\": 0 in \\u00e9dit.\\r\\n",
+	trap ? extra : "", trap ? "," : "");
+  while (pad > 0 && pos < size - 1024) {
+    pos += snprintf(buf + pos, size - pos, "He looks like he could use a drink.\\r\\n");
+    pad -= 39;
+  }
+  pos += snprintf(buf + pos, size - pos, "\"");
+  for (i = 0; bench_mob_keys[i]; i++)
+    pos += snprintf(buf + pos, size - pos, ",\"%s\":%d", bench_mob_keys[i], i * 7 - 3);
+  snprintf(buf + pos, size - pos, ",\"exits\":[null,null,{\"to_room\":3002}]%s%s}",
+	trap ? "" : ",", trap ? "" : extra);
+  return (buf);
+}
+
+
+static const char *bench_mob_strings[] = {
+  "aliases", "short_desc", "long_desc", "description", NULL
+};
+
+
+/* The old way: find "\"key\"" anywhere, then a colon. */
+static const char *bench_strstr_find(const char *json, const char *key)
+{
+  char q[64];
+  const char *p;
+
+  snprintf(q, sizeof(q), "\"%s\"", key);
+  if (!(p = strstr(json, q)))
+    return (NULL);
+  for (p += strlen(q); JSON_WS(*p); p++);
+  return (*p == ':' ? p + 1 : NULL);
+}
+
+
+static int bench_strstr_int(const char *json, const char *key, int *out)
+{
+  const char *p = bench_strstr_find(json, key);
+  char *end;
+
+  if (!p)
+    return (0);
+  *out = strtol(p, &end, 10);
+  return (end != p);
+}
+
+
+/* ...and copy a string out a character at a time into a growing buffer. */
+static char *bench_strstr_str(const char *json, const char *key)
+{
+  const char *p = bench_strstr_find(json, key);
+  int cap = 4096, pos = 0;
+  char *out;
+
+  for (; p && JSON_WS(*p); p++);
+  if (!p || *p++ != '"')
+    return (NULL);
+  CREATE(out, char, cap);
+  while (*p && *p != '"') {
+    if (pos + 8 >= cap)
+      RECREATE(out, char, cap *= 2);
+    if (*p == '\\' && *++p)
+      out[pos++] = (*p == 'n') ? '\n' : (*p == 'r') ? '\r' : *p;
+    else
+      out[pos++] = *p;
+    p++;
+  }
+  out[pos] = '\0';
+  return (out);
+}
+
+
+/* Everything json_parse() accepted should hang together. */
+static int fuzz_check(const struct json_doc *doc)
+{
+  int i, t, n, v;
+  char *s;
+
+  for (i = 0; i < doc->num; i++) {
+    const struct json_token *k = &doc->tok[i];
+
+    if (k->start < 0 || k->end < k->start || k->end > doc->len)
+      return (0);
+    if (k->next <= i || k->next > doc->num)
+      return (0);
+    if (k->type == JSON_OBJECT || k->type == JSON_ARRAY) {
+      for (n = 0, t = json_first(doc, i); t >= 0; t = json_next(doc, i, t))
+	n++;
+      if (n != k->size)
+	return (0);
+    } else if (k->next != i + 1)
+      return (0);
+    if (k->type == JSON_STRING) {
+      s = json_str(doc, i);
+      if (strlen(s) > (size_t) (k->end - k->start))
+	return (0);
+      free(s);
+    }
+    json_int(doc, i, &v);
+  }
+  json_find(doc, 0, "vnum");
+  return (doc->tok[0].next == doc->num);
+}
+
+
+void json_benchmark(void)
+{
+  static const char junk[] = "{}[]\",:\\ 0123456789-.eEtruefalsn\t\n";
+  static const int pads[] = { 0, 4096, 32768, -1 };
+  struct json_doc doc;
+  struct timeval start, end;
+  double t_parse, t_old;
+  char *mob, *buf;
+  long found_old, found_new, accepted = 0, bad = 0;
+  int i, j, k, p, len, docs, v = 0, n;
+
+  /* What it should find, including where strstr() gets it wrong. */
+  mob = bench_mob(0, TRUE);
+  len = strlen(mob);
+  if (json_parse(&doc, mob, len) < 0)
+    log("SYSERR: json: the benchmark mob didn't parse.");
+  else {
+    for (i = 0; bench_mob_keys[i]; i++)
+      if (!json_get_int(&doc, 0, bench_mob_keys[i], &v) || v != i * 7 - 3)
+	log("SYSERR: json: %s came back wrong.", bench_mob_keys[i]);
+    if (json_find(&doc, json_first(&doc, json_get_array(&doc, 0, "extra_descs")), "vnum") >= 0)
+      log("SYSERR: json: found a key in the wrong object.");
+    buf = json_get_str(&doc, 0, "description");
+    if (!buf || strcmp(buf, "Set \"gold\": 0 in \xc3\xa9" "dit.\r\n"))
+      log("SYSERR: json: description came back as '%s'.", buf ? buf : "(null)");
+    if (buf)
+      free(buf);
+    log("JSON benchmark: %d fields; strstr() %s level, the tokenizer reads it as %d.",
+	doc.tok[0].size, bench_strstr_int(mob, "level", &v) ? "finds" : "can't find",
+	(json_get_int(&doc, 0, "level", &v), v));
+  }
+  json_free(&doc);
+
+  for (p = 0; pads[p] >= 0; p++) {
+    free(mob);
+    mob = bench_mob(pads[p], FALSE);
+    len = strlen(mob);
+    docs = BENCH_BYTES / len;
+
+    /* What wolc_handle_set_mob() does: the strings, then the numbers. */
+    found_new = 0;
+    gettimeofday(&start, NULL);
+    for (i = 0; i < docs; i++) {
+      json_parse(&doc, mob, len);
+      for (j = 0; bench_mob_strings[j]; j++)
+	if ((buf = json_get_str(&doc, 0, bench_mob_strings[j]))) {
+	  found_new++;
+	  free(buf);
+	}
+      for (j = 0; bench_mob_keys[j]; j++)
+	found_new += json_get_int(&doc, 0, bench_mob_keys[j], &v);
+      json_free(&doc);
+    }
+    gettimeofday(&end, NULL);
+    t_parse = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+
+    found_old = 0;
+    gettimeofday(&start, NULL);
+    for (i = 0; i < docs; i++) {
+      for (j = 0; bench_mob_strings[j]; j++)
+	if ((buf = bench_strstr_str(mob, bench_mob_strings[j]))) {
+	  found_old++;
+	  free(buf);
+	}
+      for (j = 0; bench_mob_keys[j]; j++)
+	found_old += bench_strstr_int(mob, bench_mob_keys[j], &v);
+    }
+    gettimeofday(&end, NULL);
+    t_old = (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_usec - start.tv_usec);
+
+    log("  %6d byte mob: strstr per field %8.2f us (%ld found), tokenizer %8.2f us (%ld found), %.0f MB/s",
+	len, t_old / docs, found_old / docs, t_parse / docs, found_new / docs,
+	(double) len * docs / t_parse);
+  }
+  free(mob);
+  mob = bench_mob(0, TRUE);
+  len = strlen(mob);
+
+  /* Mangle the mob, or make something up, and see what happens. */
+  circle_srandom(1);
+  CREATE(buf, char, len + 64);
+  for (i = 0; i < FUZZ_ROUNDS; i++) {
+    if (i % 4 == 0) {
+      n = rand_number(0, 63);
+      for (j = 0; j < n; j++)
+	buf[j] = junk[rand_number(0, sizeof(junk) - 2)];
+    } else {
+      memcpy(buf, mob, len);
+      n = len;
+      for (k = rand_number(1, 4); k > 0 && n > 1; k--) {
+	j = rand_number(0, n - 1);
+	switch (rand_number(0, 3)) {
+	case 0: buf[j] = junk[rand_number(0, sizeof(junk) - 2)]; break;
+	case 1: buf[j] = rand_number(0, 255); break;
+	case 2: memmove(buf + j, buf + j + 1, n - j - 1); n--; break;
+	case 3: n = j + 1; break;
+	}
+      }
+    }
+    /* No terminator: nothing may look past len. */
+    if (json_parse(&doc, buf, n) == 0) {
+      accepted++;
+      if (!fuzz_check(&doc))
+	bad++;
+    }
+    json_free(&doc);
+  }
+  free(buf);
+  free(mob);
+
+  if (bad)
+    log("SYSERR: json: %ld of %ld accepted fuzz bodies had inconsistent tokens.", bad, accepted);
+  else
+    log("  fuzz: %d bodies, %ld accepted, all consistent.", FUZZ_ROUNDS, accepted);
+}
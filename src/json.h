@@ -0,0 +1,59 @@
+/* ************************************************************************
+*   File: json.h                                        Part of CircleMUD *
+*  Usage: header file for the JSON tokenizer used by the web OLC          *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+/*
+ * json_parse() walks a buffer once and leaves a flat array of tokens that
+ * point back into it; nothing is copied until a string is asked for.  An
+ * object's token is followed by its keys, each followed by its value, and
+ * an array's by its elements.  A token's 'next' is the index just past
+ * everything inside it, so siblings can be stepped over without looking
+ * inside them.
+ */
+
+#define JSON_OBJECT	1
+#define JSON_ARRAY	2
+#define JSON_STRING	3	/* span excludes the quotes, still escaped */
+#define JSON_PRIMITIVE	4	/* number, true, false or null */
+
+#define JSON_MAX_DEPTH	64
+
+struct json_token {
+  int type;
+  int start, end;	/* text[start..end) */
+  int size;		/* object members or array elements */
+  int next;		/* first token after this one's contents */
+};
+
+struct json_doc {
+  const char *text;	/* not ours; must outlive the doc */
+  int len;
+  struct json_token *tok;
+  int num, cap;
+};
+
+int	json_parse(struct json_doc *doc, const char *text, size_t len);
+void	json_free(struct json_doc *doc);
+
+/* Stepping through objects and arrays; -1 when there's nothing there. */
+int	json_find(const struct json_doc *doc, int obj, const char *key);
+int	json_first(const struct json_doc *doc, int parent);
+int	json_next(const struct json_doc *doc, int parent, int child);
+
+/* Values. */
+char	*json_str(const struct json_doc *doc, int t);
+int	json_int(const struct json_doc *doc, int t, int *out);
+int	json_is_null(const struct json_doc *doc, int t);
+
+/* Shorthand for a member of an object. */
+char	*json_get_str(const struct json_doc *doc, int obj, const char *key);
+int	json_get_int(const struct json_doc *doc, int obj, const char *key, int *out);
+int	json_get_array(const struct json_doc *doc, int obj, const char *key);
+
+void	json_benchmark(void);
@@ -19,11 +19,13 @@
 #include "handler.h"
 #include "interpreter.h"
 #include "gmcp.h"
+#include "webserver.h"
 
 
 /* external variables */
 extern int max_exp_gain;
 extern int max_exp_loss;
+extern struct char_data *char_lists[NUM_CHAR_LISTS];
 extern int idle_rent_time;
 extern int idle_max_level;
 extern int idle_void;
@@ -389,6 +391,7 @@ void check_idling(struct char_data *ch)
       if (IN_ROOM(ch) != NOWHERE)
 	char_from_room(ch);
       char_to_room(ch, 3);
+      webserver_feed_logout(ch, "idle");	/* Nothing if already linkless. */
       if (ch->desc) {
 	STATE(ch->desc) = CON_DISCONNECT;
 	/*
@@ -440,11 +443,17 @@ void point_update(void)
       if (damage(i, i, 2, TYPE_SUFFERING) == -1)
 	continue;
     }
-    if (!IS_NPC(i)) {
-      update_char_objects(i);
-      if (GET_LEVEL(i) < idle_max_level)
-	check_idling(i);
-    }
+  }
+
+  /* players (those who just died are already on their way out) */
+  for (i = char_lists[CHAR_LIST_PLAYERS]; i; i = next_char) {
+    next_char = i->next_in_list[CHAR_LIST_PLAYERS];
+
+    if (PLR_FLAGGED(i, PLR_NOTDEADYET))
+      continue;
+    update_char_objects(i);
+    if (GET_LEVEL(i) < idle_max_level)
+      check_idling(i);
   }
 
   /* objects */
@@ -784,6 +784,7 @@ void mag_summons(int level, struct char_data *ch, struct obj_data *obj,
     if (spellnum == SPELL_CLONE) {
       /* Don't mess up the prototype; use new string copies. */
       mob->player.name = strdup(GET_NAME(ch));
+      keyword_index_char(mob);
       mob->player.short_descr = strdup(GET_NAME(ch));
     }
     act(mag_summon_msgs[msg], FALSE, ch, 0, mob, TO_ROOM);
@@ -595,6 +595,7 @@ void postmaster_receive_mail(struct char_data *ch, struct char_data *mailman,
     obj = create_obj();
     obj->item_number = NOTHING;
     obj->name = strdup("mail paper letter");
+    keyword_index_obj(obj);
     obj->short_description = strdup("a piece of mail");
     obj->description = strdup("Someone has left a piece of mail here.");
 
@@ -0,0 +1,238 @@
+/* ************************************************************************
+*   File: mccp.c                                        Part of CircleMUD *
+*  Usage: compressing output to clients that ask for MCCP v2              *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#if defined(HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "mccp.h"
+
+#ifdef HAVE_ARPA_TELNET_H
+#include <arpa/telnet.h>
+#else
+#include "telnet.h"
+#endif
+
+/*
+ * MCCP v2: we offer IAC WILL COMPRESS2 along with GMCP, and a client that
+ * answers IAC DO COMPRESS2 gets IAC SB COMPRESS2 IAC SE followed by a zlib
+ * stream carrying everything else we send it.  write_to_client() feeds
+ * the stream; process_output() and the prompt code flush it once the
+ * prompt is in, and game_loop() flushes whatever GMCP has added since at
+ * the end of each pass, so the client never waits on bytes sitting in
+ * the compressor.
+ *
+ * Compressed bytes the socket won't take yet are kept in the stream and
+ * sent before anything else; process_output() leaves a descriptor's text
+ * alone until they've gone, just as it would for a full socket.
+ */
+
+extern int mccp_level;
+
+int mccp_streams = 0;			/* descriptors compressing now	*/
+unsigned long mccp_bytes_in = 0;	/* text fed to the compressors	*/
+unsigned long mccp_bytes_out = 0;	/* and what came out of them	*/
+
+#if defined(HAVE_ZLIB)
+
+#define MCCP_CHUNK		4096
+#define MCCP_PENDING_MAX	(256 * 1024)	/* client has stopped reading */
+
+struct mccp_stream {
+  z_stream z;
+  char *out;		/* compressed bytes the socket hasn't taken	*/
+  size_t len;		/* how many of them				*/
+  size_t size;		/* room in out					*/
+  int dirty;		/* fed since the last flush			*/
+};
+
+
+int mccp_offered(void)
+{
+  return (mccp_level > 0);
+}
+
+
+/* Run the compressor over txt, keeping what comes out. */
+static int mccp_deflate(struct mccp_stream *s, const char *txt, size_t len, int flush)
+{
+  size_t before = s->len;
+
+  s->z.next_in = (Bytef *) txt;
+  s->z.avail_in = len;
+
+  do {
+    if (s->size - s->len < MCCP_CHUNK) {
+      s->size = s->len + MCCP_CHUNK * 2;
+      RECREATE(s->out, char, s->size);
+    }
+    s->z.next_out = (Bytef *) s->out + s->len;
+    s->z.avail_out = s->size - s->len;
+
+    if (deflate(&s->z, flush) == Z_STREAM_ERROR)
+      return (-1);
+    s->len = s->size - s->z.avail_out;
+  } while (s->z.avail_out == 0);
+
+  mccp_bytes_in += len;
+  mccp_bytes_out += s->len - before;
+  return (0);
+}
+
+
+/* Hand the socket what it'll take: 1 if that was everything. */
+static int mccp_send(struct descriptor_data *d)
+{
+  struct mccp_stream *s = d->mccp;
+  int sent;
+
+  if (s->len == 0)
+    return (1);
+
+  if ((sent = write_to_descriptor_n(d->descriptor, s->out, s->len)) < 0)
+    return (-1);
+
+  s->len -= sent;
+  if (s->len > 0) {
+    memmove(s->out, s->out + sent, s->len);
+    return (0);
+  }
+
+  /* A big burst shouldn't hold on to its buffer. */
+  if (s->size > MCCP_CHUNK * 4) {
+    free(s->out);
+    s->out = NULL;
+    s->size = 0;
+  }
+  return (1);
+}
+
+
+void mccp_start(struct descriptor_data *d)
+{
+  static const char start[] = { (char) IAC, (char) SB, TELOPT_COMPRESS2, (char) IAC, (char) SE };
+  struct mccp_stream *s;
+
+  if (d->mccp || !mccp_offered())
+    return;
+
+  CREATE(s, struct mccp_stream, 1);
+  if (deflateInit(&s->z, MIN(mccp_level, Z_BEST_COMPRESSION)) != Z_OK) {
+    log("SYSERR: mccp: deflateInit: %s", s->z.msg ? s->z.msg : "failed");
+    free(s);
+    return;
+  }
+
+  /* The last thing the client gets uncompressed. */
+  if (write_to_descriptor_n(d->descriptor, start, sizeof(start)) < (int) sizeof(start)) {
+    deflateEnd(&s->z);
+    free(s);
+    STATE(d) = CON_DISCONNECT;
+    return;
+  }
+
+  d->mccp = s;
+  mccp_streams++;
+}
+
+
+/* Finish the stream, so the client knows the rest is plain text. */
+void mccp_stop(struct descriptor_data *d)
+{
+  struct mccp_stream *s = d->mccp;
+
+  if (s == NULL)
+    return;
+
+  if (mccp_deflate(s, "", 0, Z_FINISH) == 0)
+    mccp_send(d);
+
+  deflateEnd(&s->z);
+  if (s->out)
+    free(s->out);
+  free(s);
+  d->mccp = NULL;
+  mccp_streams--;
+}
+
+
+/*
+ * Compress txt for d.  All of it is taken unless there's an error, in
+ * which case the connection should go.
+ */
+int mccp_write(struct descriptor_data *d, const char *txt, size_t len)
+{
+  struct mccp_stream *s = d->mccp;
+
+  if (len == 0)
+    return (0);
+  if (s->len >= MCCP_PENDING_MAX || mccp_deflate(s, txt, len, Z_NO_FLUSH) < 0)
+    return (-1);
+  s->dirty = TRUE;
+
+  return (len);
+}
+
+
+/*
+ * Push everything fed so far out to the client.  Returns 1 if it all
+ * went, 0 if the socket is full and some is waiting, -1 on error.
+ */
+int mccp_flush(struct descriptor_data *d)
+{
+  struct mccp_stream *s = d->mccp;
+
+  if (s == NULL)
+    return (1);
+
+  if (s->dirty) {
+    if (mccp_deflate(s, "", 0, Z_SYNC_FLUSH) < 0)
+      return (-1);
+    s->dirty = FALSE;
+  }
+  return (mccp_send(d));
+}
+
+#else /* !HAVE_ZLIB */
+
+int mccp_offered(void)
+{
+  return (FALSE);
+}
+
+
+void mccp_start(struct descriptor_data *d)
+{
+}
+
+
+void mccp_stop(struct descriptor_data *d)
+{
+}
+
+
+int mccp_write(struct descriptor_data *d, const char *txt, size_t len)
+{
+  return (write_to_descriptor_n(d->descriptor, txt, len));
+}
+
+
+int mccp_flush(struct descriptor_data *d)
+{
+  return (1);
+}
+
+#endif /* HAVE_ZLIB */
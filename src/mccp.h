@@ -0,0 +1,20 @@
+/* ************************************************************************
+*   File: mccp.h                                        Part of CircleMUD *
+*  Usage: header file for MCCP v2 output compression                      *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+#define TELOPT_COMPRESS2  86	/* MCCP v2 */
+
+int	mccp_offered(void);
+void	mccp_start(struct descriptor_data *d);
+void	mccp_stop(struct descriptor_data *d);
+int	mccp_write(struct descriptor_data *d, const char *txt, size_t len);
+int	mccp_flush(struct descriptor_data *d);
+
+extern int mccp_streams;
+extern unsigned long mccp_bytes_in, mccp_bytes_out;
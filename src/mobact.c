@@ -24,6 +24,9 @@
 
 /* external globals */
 extern int no_specials;
+extern int dormant_zones, dormant_mob_pulses;
+extern struct char_data *char_lists[NUM_CHAR_LISTS];
+extern struct char_data *char_list_next[NUM_CHAR_LISTS];
 
 /* external functions */
 ACMD(do_get);
@@ -31,149 +34,311 @@ ACMD(do_action);
 
 /* local functions */
 void mobile_activity(void);
+void mobile_entry_checks(void);
 void clearMemory(struct char_data *ch);
 bool aggressive_mob_on_a_leash(struct char_data *slave, struct char_data *master, struct char_data *attack);
 
 #define MOB_AGGR_TO_ALIGN (MOB_AGGR_EVIL | MOB_AGGR_NEUTRAL | MOB_AGGR_GOOD)
 
-void mobile_activity(void)
+/* PULSE_MOBILEs a zone stays awake after the last player leaves it. */
+#define ZONE_DORMANT_DELAY	3
+
+/*
+ * A zone is dormant when nobody has been in it, or in a zone with an
+ * exit to it, for a little while.  Nobody would see what its mobiles do,
+ * so they act only every dormant_mob_pulses pulses.
+ */
+static void update_zone_activity(void)
 {
-  struct char_data *ch, *next_ch, *vict;
-  struct obj_data *obj, *best_obj;
-  int door, found, max;
-  memory_rec *names;
+  struct descriptor_data *d;
+  zone_rnum zone;
+  int i;
+
+  for (zone = 0; zone <= top_of_zone_table; zone++)
+    if (!dormant_zones || (zone_table[zone].permissions.flags & OLC_ZONEFLAGS_ACTIVE))
+      zone_table[zone].idle = 0;
+    else
+      zone_table[zone].idle++;
+
+  for (d = descriptor_list; d; d = d->next) {
+    if (STATE(d) != CON_PLAYING || !d->character || IN_ROOM(d->character) == NOWHERE)
+      continue;
+    zone = world[IN_ROOM(d->character)].zone;
+    zone_table[zone].idle = 0;
+    for (i = 0; i < zone_table[zone].num_neighbors; i++)
+      zone_table[zone_table[zone].neighbors[i]].idle = 0;
+  }
 
-  for (ch = character_list; ch; ch = next_ch) {
-    next_ch = ch->next;
+  for (zone = 0; zone <= top_of_zone_table; zone++)
+    zone_table[zone].dormant = (zone_table[zone].idle > ZONE_DORMANT_DELAY);
+}
 
-    if (!IS_MOB(ch))
-      continue;
 
-    /* Examine call for special procedure */
-    if (MOB_FLAGGED(ch, MOB_SPEC) && !no_specials) {
-      if (mob_index[GET_MOB_RNUM(ch)].func == NULL) {
-	log("SYSERR: %s (#%d): Attempting to call non-existing mob function.",
-		GET_NAME(ch), GET_MOB_VNUM(ch));
-	REMOVE_BIT(MOB_FLAGS(ch), MOB_SPEC);
-      } else {
-        char actbuf[MAX_INPUT_LENGTH] = "";
-	if ((mob_index[GET_MOB_RNUM(ch)].func) (ch, ch, 0, actbuf))
-	  continue;		/* go to next char */
+/* Scavenger (picking up objects) */
+static void mob_scavenge(struct char_data *ch)
+{
+  struct obj_data *obj, *best_obj;
+  int max;
+
+  if (world[IN_ROOM(ch)].contents && !rand_number(0, 10)) {
+    max = 1;
+    best_obj = NULL;
+    for (obj = world[IN_ROOM(ch)].contents; obj; obj = obj->next_content)
+      if (CAN_GET_OBJ(ch, obj) && GET_OBJ_COST(obj) > max) {
+	best_obj = obj;
+	max = GET_OBJ_COST(obj);
       }
+    if (best_obj != NULL) {
+      obj_from_room(best_obj);
+      obj_to_char(best_obj, ch);
+      act("$n gets $p.", FALSE, ch, best_obj, 0, TO_ROOM);
     }
+  }
+}
 
-    /* If the mob has no specproc, do the default actions */
-    if (FIGHTING(ch) || !AWAKE(ch))
+
+/* Mob Movement */
+static void mob_wander(struct char_data *ch)
+{
+  int door;
+
+  if ((GET_POS(ch) == POS_STANDING) &&
+      ((door = rand_number(0, 18)) < NUM_OF_DIRS) && CAN_GO(ch, door) &&
+      !ROOM_FLAGGED(EXIT(ch, door)->to_room, ROOM_NOMOB | ROOM_DEATH) &&
+      (!MOB_FLAGGED(ch, MOB_STAY_ZONE) ||
+       (world[EXIT(ch, door)->to_room].zone == world[IN_ROOM(ch)].zone))) {
+    perform_move(ch, door, 1);
+  }
+}
+
+
+/* Aggressive Mobs */
+static void mob_aggress(struct char_data *ch)
+{
+  struct char_data *vict;
+  int found = FALSE;
+
+  for (vict = world[IN_ROOM(ch)].people; vict && !found; vict = vict->next_in_room) {
+    if (IS_NPC(vict) || !CAN_SEE(ch, vict) || PRF_FLAGGED(vict, PRF_NOHASSLE))
       continue;
 
-    /* Scavenger (picking up objects) */
-    if (MOB_FLAGGED(ch, MOB_SCAVENGER))
-      if (world[IN_ROOM(ch)].contents && !rand_number(0, 10)) {
-	max = 1;
-	best_obj = NULL;
-	for (obj = world[IN_ROOM(ch)].contents; obj; obj = obj->next_content)
-	  if (CAN_GET_OBJ(ch, obj) && GET_OBJ_COST(obj) > max) {
-	    best_obj = obj;
-	    max = GET_OBJ_COST(obj);
-	  }
-	if (best_obj != NULL) {
-	  obj_from_room(best_obj);
-	  obj_to_char(best_obj, ch);
-	  act("$n gets $p.", FALSE, ch, best_obj, 0, TO_ROOM);
-	}
-      }
+    if (MOB_FLAGGED(ch, MOB_WIMPY) && AWAKE(vict))
+      continue;
 
-    /* Mob Movement */
-    if (!MOB_FLAGGED(ch, MOB_SENTINEL) && (GET_POS(ch) == POS_STANDING) &&
-	((door = rand_number(0, 18)) < NUM_OF_DIRS) && CAN_GO(ch, door) &&
-	!ROOM_FLAGGED(EXIT(ch, door)->to_room, ROOM_NOMOB | ROOM_DEATH) &&
-	(!MOB_FLAGGED(ch, MOB_STAY_ZONE) ||
-	 (world[EXIT(ch, door)->to_room].zone == world[IN_ROOM(ch)].zone))) {
-      perform_move(ch, door, 1);
+    if (MOB_FLAGGED(ch, MOB_AGGRESSIVE  ) ||
+       (MOB_FLAGGED(ch, MOB_AGGR_EVIL   ) && IS_EVIL(vict)) ||
+       (MOB_FLAGGED(ch, MOB_AGGR_NEUTRAL) && IS_NEUTRAL(vict)) ||
+       (MOB_FLAGGED(ch, MOB_AGGR_GOOD   ) && IS_GOOD(vict))) {
+
+      /* Can a master successfully control the charmed monster? */
+      if (aggressive_mob_on_a_leash(ch, ch->master, vict))
+        continue;
+
+      hit(ch, vict, TYPE_UNDEFINED);
+      found = TRUE;
     }
+  }
+}
 
-    /* Aggressive Mobs */
-    if (MOB_FLAGGED(ch, MOB_AGGRESSIVE | MOB_AGGR_TO_ALIGN)) {
-      found = FALSE;
-      for (vict = world[IN_ROOM(ch)].people; vict && !found; vict = vict->next_in_room) {
-	if (IS_NPC(vict) || !CAN_SEE(ch, vict) || PRF_FLAGGED(vict, PRF_NOHASSLE))
-	  continue;
 
-	if (MOB_FLAGGED(ch, MOB_WIMPY) && AWAKE(vict))
-	  continue;
+/* Mob Memory */
+static void mob_remember(struct char_data *ch)
+{
+  struct char_data *vict;
+  memory_rec *names;
+  int found = FALSE;
 
-	if (MOB_FLAGGED(ch, MOB_AGGRESSIVE  ) ||
-	   (MOB_FLAGGED(ch, MOB_AGGR_EVIL   ) && IS_EVIL(vict)) ||
-	   (MOB_FLAGGED(ch, MOB_AGGR_NEUTRAL) && IS_NEUTRAL(vict)) ||
-	   (MOB_FLAGGED(ch, MOB_AGGR_GOOD   ) && IS_GOOD(vict))) {
+  if (!MEMORY(ch))
+    return;
 
-          /* Can a master successfully control the charmed monster? */
-          if (aggressive_mob_on_a_leash(ch, ch->master, vict))
-            continue;
+  for (vict = world[IN_ROOM(ch)].people; vict && !found; vict = vict->next_in_room) {
+    if (IS_NPC(vict) || !CAN_SEE(ch, vict) || PRF_FLAGGED(vict, PRF_NOHASSLE))
+      continue;
 
-	  hit(ch, vict, TYPE_UNDEFINED);
-	  found = TRUE;
-	}
-      }
-    }
+    for (names = MEMORY(ch); names && !found; names = names->next) {
+      if (names->id != GET_IDNUM(vict))
+        continue;
 
-    /* Mob Memory */
-    if (MOB_FLAGGED(ch, MOB_MEMORY) && MEMORY(ch)) {
-      found = FALSE;
-      for (vict = world[IN_ROOM(ch)].people; vict && !found; vict = vict->next_in_room) {
-	if (IS_NPC(vict) || !CAN_SEE(ch, vict) || PRF_FLAGGED(vict, PRF_NOHASSLE))
-	  continue;
-
-	for (names = MEMORY(ch); names && !found; names = names->next) {
-	  if (names->id != GET_IDNUM(vict))
-            continue;
-
-          /* Can a master successfully control the charmed monster? */
-          if (aggressive_mob_on_a_leash(ch, ch->master, vict))
-            continue;
-
-          found = TRUE;
-          act("'Hey!  You're the fiend that attacked me!!!', exclaims $n.", FALSE, ch, 0, 0, TO_ROOM);
-          hit(ch, vict, TYPE_UNDEFINED);
-        }
-      }
+      /* Can a master successfully control the charmed monster? */
+      if (aggressive_mob_on_a_leash(ch, ch->master, vict))
+        continue;
+
+      found = TRUE;
+      act("'Hey!  You're the fiend that attacked me!!!', exclaims $n.", FALSE, ch, 0, 0, TO_ROOM);
+      hit(ch, vict, TYPE_UNDEFINED);
     }
+  }
+}
 
-    /*
-     * Charmed Mob Rebellion
-     *
-     * In order to rebel, there need to be more charmed monsters
-     * than the person can feasibly control at a time.  Then the
-     * mobiles have a chance based on the charisma of their leader.
-     *
-     * 1-4 = 0, 5-7 = 1, 8-10 = 2, 11-13 = 3, 14-16 = 4, 17-19 = 5, etc.
-     */
-    if (AFF_FLAGGED(ch, AFF_CHARM) && ch->master && num_followers_charmed(ch->master) > (GET_CHA(ch->master) - 2) / 3) {
-      if (!aggressive_mob_on_a_leash(ch, ch->master, ch->master)) {
-        if (CAN_SEE(ch, ch->master) && !PRF_FLAGGED(ch->master, PRF_NOHASSLE))
-          hit(ch, ch->master, TYPE_UNDEFINED);
-        stop_follower(ch);
-      }
+
+/*
+ * Charmed Mob Rebellion
+ *
+ * In order to rebel, there need to be more charmed monsters
+ * than the person can feasibly control at a time.  Then the
+ * mobiles have a chance based on the charisma of their leader.
+ *
+ * 1-4 = 0, 5-7 = 1, 8-10 = 2, 11-13 = 3, 14-16 = 4, 17-19 = 5, etc.
+ */
+static void mob_rebel(struct char_data *ch)
+{
+  if (AFF_FLAGGED(ch, AFF_CHARM) && ch->master && num_followers_charmed(ch->master) > (GET_CHA(ch->master) - 2) / 3) {
+    if (!aggressive_mob_on_a_leash(ch, ch->master, ch->master)) {
+      if (CAN_SEE(ch, ch->master) && !PRF_FLAGGED(ch->master, PRF_NOHASSLE))
+        hit(ch, ch->master, TYPE_UNDEFINED);
+      stop_follower(ch);
     }
+  }
+}
+
 
-    /* Helper Mobs */
-    if (MOB_FLAGGED(ch, MOB_HELPER) && !AFF_FLAGGED(ch, AFF_BLIND | AFF_CHARM)) {
-      found = FALSE;
-      for (vict = world[IN_ROOM(ch)].people; vict && !found; vict = vict->next_in_room) {
-	if (ch == vict || !IS_NPC(vict) || !FIGHTING(vict))
-	  continue;
-	if (IS_NPC(FIGHTING(vict)) || ch == FIGHTING(vict))
-	  continue;
-
-	act("$n jumps to the aid of $N!", FALSE, ch, 0, vict, TO_ROOM);
-	hit(ch, FIGHTING(vict), TYPE_UNDEFINED);
-	found = TRUE;
+/* Helper Mobs */
+static void mob_help(struct char_data *ch)
+{
+  struct char_data *vict;
+  int found = FALSE;
+
+  if (AFF_FLAGGED(ch, AFF_BLIND | AFF_CHARM))
+    return;
+
+  for (vict = world[IN_ROOM(ch)].people; vict && !found; vict = vict->next_in_room) {
+    if (ch == vict || !IS_NPC(vict) || !FIGHTING(vict))
+      continue;
+    if (IS_NPC(FIGHTING(vict)) || ch == FIGHTING(vict))
+      continue;
+
+    act("$n jumps to the aid of $N!", FALSE, ch, 0, vict, TO_ROOM);
+    hit(ch, FIGHTING(vict), TYPE_UNDEFINED);
+    found = TRUE;
+  }
+}
+
+
+/* If the mob has no specproc, do the default actions */
+static void mob_default_actions(struct char_data *ch)
+{
+  if (FIGHTING(ch) || !AWAKE(ch))
+    return;
+
+  if (MOB_FLAGGED(ch, MOB_SCAVENGER))
+    mob_scavenge(ch);
+  if (!MOB_FLAGGED(ch, MOB_SENTINEL))
+    mob_wander(ch);
+  if (MOB_FLAGGED(ch, MOB_AGGRESSIVE | MOB_AGGR_TO_ALIGN))
+    mob_aggress(ch);
+  if (MOB_FLAGGED(ch, MOB_MEMORY))
+    mob_remember(ch);
+  if (ch->master)
+    mob_rebel(ch);
+  if (MOB_FLAGGED(ch, MOB_HELPER))
+    mob_help(ch);
+
+  /* Add new mobile actions here, and a worklist for them in handler.c */
+}
+
+
+static int mob_may_act(struct char_data *ch, int dormant_turn)
+{
+  if (MOB_FLAGGED(ch, MOB_NOTDEADYET))
+    return (FALSE);
+  return (!zone_table[world[IN_ROOM(ch)].zone].dormant || dormant_turn);
+}
+
+
+/* Give one of the default actions to every mob on its worklist. */
+static void mob_stage(int list, void (*action)(struct char_data *ch), int dormant_turn)
+{
+  struct char_data *ch;
+
+  for (ch = char_lists[list]; ch; ch = char_list_next[list]) {
+    char_list_next[list] = ch->next_in_list[list];
+
+    /* Those with spec procs had their turn in mobile_activity(). */
+    if ((ch->in_lists & (1 << CHAR_LIST_SPEC)) || !mob_may_act(ch, dormant_turn))
+      continue;
+    if (FIGHTING(ch) || !AWAKE(ch))
+      continue;
+    action(ch);
+  }
+  char_list_next[list] = NULL;
+}
+
+
+/*
+ * Mobs with spec procs are done one at a time, since a spec proc that
+ * does something takes the place of the mob's other actions.  The rest
+ * are done a stage at a time, each stage walking only the mobs with the
+ * flag for it.
+ */
+void mobile_activity(void)
+{
+  struct char_data *ch;
+  int dormant_turn;
+  static int pulses = 0;
+
+  update_zone_activity();
+  pulses++;
+  dormant_turn = (dormant_mob_pulses > 0 && !(pulses % dormant_mob_pulses));
+
+  for (ch = char_lists[CHAR_LIST_SPEC]; ch; ch = char_list_next[CHAR_LIST_SPEC]) {
+    char_list_next[CHAR_LIST_SPEC] = ch->next_in_list[CHAR_LIST_SPEC];
+
+    if (!mob_may_act(ch, dormant_turn))
+      continue;
+
+    /* Examine call for special procedure */
+    if (!no_specials) {
+      if (mob_index[GET_MOB_RNUM(ch)].func == NULL) {
+	log("SYSERR: %s (#%d): Attempting to call non-existing mob function.",
+		GET_NAME(ch), GET_MOB_VNUM(ch));
+	REMOVE_BIT(MOB_FLAGS(ch), MOB_SPEC);
+	char_lists_update(ch);
+      } else {
+        char actbuf[MAX_INPUT_LENGTH] = "";
+	if ((mob_index[GET_MOB_RNUM(ch)].func) (ch, ch, 0, actbuf))
+	  continue;		/* go to next char */
       }
     }
 
-    /* Add new mobile actions here */
+    mob_default_actions(ch);
+  }
+  char_list_next[CHAR_LIST_SPEC] = NULL;
+
+  mob_stage(CHAR_LIST_SCAVENGER, mob_scavenge, dormant_turn);
+  mob_stage(CHAR_LIST_WANDERER, mob_wander, dormant_turn);
+  /*
+   * Still every pulse, though mobile_entry_checks() has seen to anybody
+   * coming in: a player turning visible, a light going out, a mob waking
+   * up or a fight ending all change who gets attacked without moving.
+   */
+  mob_stage(CHAR_LIST_AGGRESSIVE, mob_aggress, dormant_turn);
+  mob_stage(CHAR_LIST_MEMORY, mob_remember, dormant_turn);
+  mob_stage(CHAR_LIST_FOLLOWER, mob_rebel, dormant_turn);
+  mob_stage(CHAR_LIST_HELPER, mob_help, dormant_turn);
+}
+
+
 
-  }				/* end for() */
+/*
+ * Aggressive and memory mobs that someone came in on this pulse (see
+ * char_to_room()) size them up now, as they would on a scan.
+ */
+void mobile_entry_checks(void)
+{
+  struct char_data *ch;
+
+  for (ch = char_lists[CHAR_LIST_ENTERED]; ch; ch = char_list_next[CHAR_LIST_ENTERED]) {
+    char_list_next[CHAR_LIST_ENTERED] = ch->next_in_list[CHAR_LIST_ENTERED];
+    char_list_del(ch, CHAR_LIST_ENTERED);
+
+    if (MOB_FLAGGED(ch, MOB_NOTDEADYET) || FIGHTING(ch) || !AWAKE(ch))
+      continue;
+    if (MOB_FLAGGED(ch, MOB_AGGRESSIVE | MOB_AGGR_TO_ALIGN))
+      mob_aggress(ch);
+    if (MOB_FLAGGED(ch, MOB_MEMORY))
+      mob_remember(ch);
+  }
+  char_list_next[CHAR_LIST_ENTERED] = NULL;
 }
 
 
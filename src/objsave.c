@@ -11,6 +11,10 @@
 #include "conf.h"
 #include "sysdep.h"
 
+#if defined(CIRCLE_UNIX)
+#include <dirent.h>
+#include <fcntl.h>
+#endif
 
 #include "structs.h"
 #include "comm.h"
@@ -19,6 +23,8 @@
 #include "interpreter.h"
 #include "utils.h"
 #include "spells.h"
+#include "bundle.h"
+#include "webserver.h"
 
 /* these factors should be unique integers */
 #define RENT_FACTOR 	1
@@ -34,6 +40,8 @@ extern int rent_file_timeout, crash_file_timeout;
 extern int free_rent;
 extern int min_rent_cost;
 extern int max_obj_save;	/* change in config.c */
+extern int player_bundles;
+extern int rent_sweep_per_pulse;
 
 /* Extern functions */
 ACMD(do_action);
@@ -224,22 +232,11 @@ void auto_equip(struct char_data *ch, struct obj_data *obj, int location)
 
 int Crash_delete_file(char *name)
 {
-  char filename[50];
-  FILE *fl;
-
-  if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
-    return (0);
-  if (!(fl = fopen(filename, "rb"))) {
-    if (errno != ENOENT)	/* if it fails but NOT because of no file */
-      log("SYSERR: deleting crash file %s (1): %s", filename, strerror(errno));
+  if (plrfile_remove(CRASH_FILE, name) < 0) {
+    if (errno != ENOENT)	/* if it fails, NOT because of no file */
+      log("SYSERR: deleting crash file for %s: %s", name, strerror(errno));
     return (0);
   }
-  fclose(fl);
-
-  /* if it fails, NOT because of no file */
-  if (remove(filename) < 0 && errno != ENOENT)
-    log("SYSERR: deleting crash file %s (2): %s", filename, strerror(errno));
-
   return (1);
 }
 
@@ -251,15 +248,15 @@ int Crash_delete_crashfile(struct char_data *ch)
   int numread;
   FILE *fl;
 
-  if (!get_filename(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch)))
-    return (0);
-  if (!(fl = fopen(filename, "rb"))) {
-    if (errno != ENOENT)	/* if it fails, NOT because of no file */
+  if (!(fl = plrfile_open(CRASH_FILE, GET_NAME(ch), "rb"))) {
+    if (errno != ENOENT) {	/* if it fails, NOT because of no file */
+      plrfile_path(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch));
       log("SYSERR: checking for crash file %s (3): %s", filename, strerror(errno));
+    }
     return (0);
   }
   numread = fread(&rent, sizeof(struct rent_info), 1, fl);
-  fclose(fl);
+  plrfile_close(fl);
 
   if (numread == 0)
     return (0);
@@ -271,64 +268,240 @@ int Crash_delete_crashfile(struct char_data *ch)
 }
 
 
+/*
+ * Returns the kind of file ("crash", "rent", ...) if the rent header says
+ * the file has outlived its timeout and should be deleted, NULL otherwise.
+ */
+static const char *Crash_expired_type(const struct rent_info *rent)
+{
+  switch (rent->rentcode) {
+  case RENT_CRASH:
+  case RENT_FORCED:
+  case RENT_TIMEDOUT:
+    if (rent->time >= time(0) - (crash_file_timeout * SECS_PER_REAL_DAY))
+      return (NULL);
+    if (rent->rentcode == RENT_CRASH)
+      return ("crash");
+    else if (rent->rentcode == RENT_FORCED)
+      return ("forced rent");
+    return ("idlesave");
+  case RENT_RENTED:
+    /* Must retrieve rented items w/in 30 days */
+    if (rent->time < time(0) - (rent_file_timeout * SECS_PER_REAL_DAY))
+      return ("rent");
+    return (NULL);
+  default:
+    return (NULL);
+  }
+}
+
+
 int Crash_clean_file(char *name)
 {
   char filename[MAX_STRING_LENGTH];
   struct rent_info rent;
+  const char *filetype;
   int numread;
   FILE *fl;
 
-  if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
-    return (0);
   /*
    * open for write so that permission problems will be flagged now, at boot
    * time.
    */
-  if (!(fl = fopen(filename, "r+b"))) {
-    if (errno != ENOENT)	/* if it fails, NOT because of no file */
+  if (!(fl = plrfile_open(CRASH_FILE, name, "r+b"))) {
+    if (errno != ENOENT) {	/* if it fails, NOT because of no file */
+      plrfile_path(filename, sizeof(filename), CRASH_FILE, name);
       log("SYSERR: OPENING OBJECT FILE %s (4): %s", filename, strerror(errno));
+    }
     return (0);
   }
   numread = fread(&rent, sizeof(struct rent_info), 1, fl);
-  fclose(fl);
+  plrfile_close(fl);
 
   if (numread == 0)
     return (0);
 
-  if ((rent.rentcode == RENT_CRASH) ||
-      (rent.rentcode == RENT_FORCED) || (rent.rentcode == RENT_TIMEDOUT)) {
-    if (rent.time < time(0) - (crash_file_timeout * SECS_PER_REAL_DAY)) {
-      const char *filetype;
-
-      Crash_delete_file(name);
-      switch (rent.rentcode) {
-      case RENT_CRASH:
-        filetype = "crash";
-        break;
-      case RENT_FORCED:
-        filetype = "forced rent";
-        break;
-      case RENT_TIMEDOUT:
-        filetype = "idlesave";
-        break;
-      default:
-        filetype = "UNKNOWN!";
-        break;
-      }
-      log("    Deleting %s's %s file.", name, filetype);
-      return (1);
+  if ((filetype = Crash_expired_type(&rent)) == NULL)
+    return (0);
+
+  Crash_delete_file(name);
+  log("    Deleting %s's %s file.", name, filetype);
+  return (1);
+}
+
+
+/*
+ * Boot-time expiry sweep.  Probing a crash file for every entry in the
+ * player index costs a failed open() for each of the (usually many)
+ * players without one, so on CIRCLE_UNIX we list the plrobjs letter
+ * directories once and only look at files that exist.  Each header is
+ * read with a single unbuffered pread().
+ *
+ * If rent_sweep_per_pulse is non-zero the candidate list is built at boot
+ * and then worked through that many files per pulse from heartbeat(), so
+ * the game starts accepting connections right away.  While such a sweep
+ * is pending Crash_load() cleans the loading player's own file first.
+ */
+static char **rent_sweep_list = NULL;
+static int rent_sweep_count = 0, rent_sweep_pos = 0, rent_sweep_deleted = 0;
+
+#if defined(CIRCLE_UNIX)
+
+static int Crash_sweep_namecmp(const void *a, const void *b)
+{
+  return (strcmp(*(const char * const *)a, *(const char * const *)b));
+}
+
+
+/* Returns 1 if 'name's crash file had expired and was deleted. */
+static int Crash_sweep_file(char *name)
+{
+  char filename[MAX_STRING_LENGTH];
+  struct rent_info rent;
+  const char *filetype;
+  ssize_t numread;
+  int fd;
+
+  /* Bundles are read whole anyway; let the bundle cache do the work. */
+  if (player_bundles)
+    return (Crash_clean_file(name));
+
+  if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
+    return (0);
+  /* O_RDWR for the same permission check as Crash_clean_file(). */
+  if ((fd = open(filename, O_RDWR)) < 0) {
+    if (errno != ENOENT)
+      log("SYSERR: OPENING OBJECT FILE %s (4): %s", filename, strerror(errno));
+    return (0);
+  }
+  numread = pread(fd, &rent, sizeof(struct rent_info), 0);
+  close(fd);
+
+  if (numread != sizeof(struct rent_info))
+    return (0);
+
+  if ((filetype = Crash_expired_type(&rent)) == NULL)
+    return (0);
+
+  Crash_delete_file(name);
+  log("    Deleting %s's %s file.", name, filetype);
+  return (1);
+}
+
+
+/* Add the indexed players with a 'suffix' file under 'prefix' to the list. */
+static void Crash_sweep_scan_dir(const char *prefix, const char *suffix,
+				 char **names, int nnames, int *cap)
+{
+  const char *dirs[] = { "A-E", "F-J", "K-O", "P-T", "U-Z", "ZZZ" };
+  char path[PATH_MAX];
+  struct dirent *de;
+  size_t len, suflen = strlen(suffix);
+  int i;
+  DIR *dir;
+
+  for (i = 0; i < (int)(sizeof(dirs) / sizeof(dirs[0])); i++) {
+    snprintf(path, sizeof(path), "%s%s", prefix, dirs[i]);
+    if (!(dir = opendir(path))) {
+      if (errno != ENOENT)
+        log("SYSERR: Crash_sweep_scan: opening %s: %s", path, strerror(errno));
+      continue;
     }
-    /* Must retrieve rented items w/in 30 days */
-  } else if (rent.rentcode == RENT_RENTED)
-    if (rent.time < time(0) - (rent_file_timeout * SECS_PER_REAL_DAY)) {
-      Crash_delete_file(name);
-      log("    Deleting %s's rent file.", name);
-      return (1);
+    while ((de = readdir(dir)) != NULL) {
+      char *key = de->d_name;
+
+      len = strlen(key);
+      if (len <= suflen || strcmp(key + len - suflen, suffix))
+        continue;
+      key[len - suflen] = '\0';
+      if (!bsearch(&key, names, nnames, sizeof(char *), Crash_sweep_namecmp))
+        continue;
+      if (rent_sweep_count >= *cap) {
+        *cap = MAX(*cap * 2, 256);
+        RECREATE(rent_sweep_list, char *, *cap);
+      }
+      rent_sweep_list[rent_sweep_count++] = strdup(key);
     }
-  return (0);
+    closedir(dir);
+  }
+}
+
+
+/*
+ * Collect the names of indexed players that have a crash file on disk.
+ * With player_bundles on, players who haven't been converted yet still
+ * have theirs under plrobjs/, so both places are looked at.
+ */
+static void Crash_sweep_scan(void)
+{
+  char **names;
+  int i, nnames = 0, cap = 0;
+
+  if (top_of_p_table < 0)
+    return;
+
+  /* Sorted copy of the player index to check directory entries against. */
+  CREATE(names, char *, top_of_p_table + 1);
+  for (i = 0; i <= top_of_p_table; i++)
+    if (*player_table[i].name)
+      names[nnames++] = player_table[i].name;
+  qsort(names, nnames, sizeof(char *), Crash_sweep_namecmp);
+
+  Crash_sweep_scan_dir(LIB_PLROBJS, "." SUF_OBJS, names, nnames, &cap);
+  if (player_bundles)
+    Crash_sweep_scan_dir(LIB_PLRBUNDLES, "." SUF_BUNDLE, names, nnames, &cap);
+  free(names);
+}
+
+
+static void Crash_sweep_free(void)
+{
+  int i;
+
+  for (i = 0; i < rent_sweep_count; i++)
+    free(rent_sweep_list[i]);
+  free(rent_sweep_list);
+  rent_sweep_list = NULL;
+  rent_sweep_count = rent_sweep_pos = 0;
 }
 
 
+void update_obj_file(void)
+{
+  Crash_sweep_scan();
+  rent_sweep_deleted = 0;
+
+  if (rent_sweep_per_pulse > 0 && rent_sweep_count > 0) {
+    log("   Deferring %d rent files until after boot.", rent_sweep_count);
+    return;
+  }
+
+  while (rent_sweep_pos < rent_sweep_count)
+    rent_sweep_deleted += Crash_sweep_file(rent_sweep_list[rent_sweep_pos++]);
+  Crash_sweep_free();
+}
+
+
+/* Called every pulse to continue a sweep deferred by update_obj_file(). */
+void Crash_sweep_pulse(void)
+{
+  int n;
+
+  if (rent_sweep_pos >= rent_sweep_count)
+    return;
+
+  for (n = 0; n < rent_sweep_per_pulse && rent_sweep_pos < rent_sweep_count; n++)
+    rent_sweep_deleted += Crash_sweep_file(rent_sweep_list[rent_sweep_pos++]);
+
+  if (rent_sweep_pos >= rent_sweep_count) {
+    log("Rent file sweep done: %d of %d files deleted.",
+	rent_sweep_deleted, rent_sweep_count);
+    Crash_sweep_free();
+  }
+}
+
+#else /* !CIRCLE_UNIX */
+
 void update_obj_file(void)
 {
   int i;
@@ -339,6 +512,13 @@ void update_obj_file(void)
 }
 
 
+void Crash_sweep_pulse(void)
+{
+}
+
+#endif /* CIRCLE_UNIX */
+
+
 void Crash_listrent(struct char_data *ch, char *name)
 {
   FILE *fl;
@@ -348,9 +528,9 @@ void Crash_listrent(struct char_data *ch, char *name)
   struct rent_info rent;
   int numread;
 
-  if (!get_filename(filename, sizeof(filename), CRASH_FILE, name))
+  if (!plrfile_path(filename, sizeof(filename), CRASH_FILE, name))
     return;
-  if (!(fl = fopen(filename, "rb"))) {
+  if (!(fl = plrfile_open(CRASH_FILE, name, "rb"))) {
     send_to_char(ch, "%s has no rent file.\r\n", name);
     return;
   }
@@ -359,7 +539,7 @@ void Crash_listrent(struct char_data *ch, char *name)
   /* Oops, can't get the data, punt. */
   if (numread == 0) {
     send_to_char(ch, "Error reading rent information.\r\n");
-    fclose(fl);
+    plrfile_close(fl);
     return;
   }
 
@@ -385,7 +565,7 @@ void Crash_listrent(struct char_data *ch, char *name)
   while (!feof(fl)) {
     int n = fread(&object, sizeof(struct obj_file_elem), 1, fl);
     if (n < 1 || ferror(fl)) {
-      fclose(fl);
+      plrfile_close(fl);
       return;
     }
     if (!feof(fl))
@@ -403,7 +583,7 @@ void Crash_listrent(struct char_data *ch, char *name)
 	extract_obj(obj);
       }
   }
-  fclose(fl);
+  plrfile_close(fl);
 }
 
 
@@ -439,10 +619,13 @@ int Crash_load(struct char_data *ch)
   for (j = 0; j < MAX_BAG_ROWS; j++)
     cont_row[j] = NULL;
 
-  if (!get_filename(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch)))
-    return (1);
-  if (!(fl = fopen(filename, "r+b"))) {
+  /* The deferred boot sweep may not have reached this player's file yet. */
+  if (rent_sweep_pos < rent_sweep_count)
+    Crash_clean_file(GET_NAME(ch));
+
+  if (!(fl = plrfile_open(CRASH_FILE, GET_NAME(ch), "r+b"))) {
     if (errno != ENOENT) {	/* if it fails, NOT because of no file */
+      plrfile_path(filename, sizeof(filename), CRASH_FILE, GET_NAME(ch));
       log("SYSERR: READING OBJECT FILE %s (5): %s", filename, strerror(errno));
       send_to_char(ch,
 		"\r\n********************* NOTICE *********************\r\n"
@@ -456,11 +639,13 @@ int Crash_load(struct char_data *ch)
     int n = fread(&rent, sizeof(struct rent_info), 1, fl);
       if (n < 1) {
 	log("SYSERR: Crash_load: %s's rent file was empty!", GET_NAME(ch));
+	plrfile_close(fl);
 	return (1);
       }
   }
   else {
     log("SYSERR: Crash_load: %s's rent file was empty!", GET_NAME(ch));
+    plrfile_close(fl);
     return (1);
   }
 
@@ -468,7 +653,7 @@ int Crash_load(struct char_data *ch)
     num_of_days = (float) (time(0) - rent.time) / SECS_PER_REAL_DAY;
     cost = (int) (rent.net_cost_per_diem * num_of_days);
     if (cost > GET_GOLD(ch) + GET_BANK_GOLD(ch)) {
-      fclose(fl);
+      plrfile_close(fl);
       mudlog(BRF, MAX(LVL_IMMORT, GET_INVIS_LEV(ch)), TRUE, "%s entering game, rented equipment lost (no $).", GET_NAME(ch));
       Crash_crashsave(ch);
       return (2);
@@ -498,11 +683,13 @@ int Crash_load(struct char_data *ch)
     break;
   }
 
+  affect_batch_begin(ch);
   while (!feof(fl)) {
     int n = fread(&object, sizeof(struct obj_file_elem), 1, fl);
     if (ferror(fl)) {
       perror("SYSERR: Reading crash file: Crash_load");
-      fclose(fl);
+      affect_batch_end(ch);
+      plrfile_close(fl);
       return (1);
     }
     if (n < 1 || feof(fl))
@@ -607,6 +794,7 @@ int Crash_load(struct char_data *ch)
       }
     }
   }
+  affect_batch_end(ch);
 
   /* Little hoarding check. -gg 3/1/98 */
   mudlog(NRM, MAX(GET_INVIS_LEV(ch), LVL_GOD), TRUE, "%s (level %d) has %d object%s (max %d).",
@@ -618,7 +806,7 @@ int Crash_load(struct char_data *ch)
   rewind(fl);
   Crash_write_rentcode(ch, fl, &rent);
 
-  fclose(fl);
+  plrfile_close(fl);
 
   if ((orig_rent_code == RENT_RENTED) || (orig_rent_code == RENT_CRYO))
     return (0);
@@ -736,7 +924,6 @@ void Crash_calculate_rent(struct obj_data *obj, int *cost)
 
 void Crash_crashsave(struct char_data *ch)
 {
-  char buf[MAX_INPUT_LENGTH];
   struct rent_info rent;
   int j;
   FILE *fp;
@@ -744,41 +931,38 @@ void Crash_crashsave(struct char_data *ch)
   if (IS_NPC(ch))
     return;
 
-  if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
-    return;
-  if (!(fp = fopen(buf, "wb")))
+  if (!(fp = plrfile_open(CRASH_FILE, GET_NAME(ch), "wb")))
     return;
 
   rent.rentcode = RENT_CRASH;
   rent.time = time(0);
   if (!Crash_write_rentcode(ch, fp, &rent)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
 
   for (j = 0; j < NUM_WEARS; j++)
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch, j), fp, j + 1)) {
-	fclose(fp);
+	plrfile_close(fp);
 	return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
     }
 
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
   Crash_restore_weight(ch->carrying);
 
-  fclose(fp);
+  plrfile_close(fp);
   REMOVE_BIT(PLR_FLAGS(ch), PLR_CRASH);
 }
 
 
 void Crash_idlesave(struct char_data *ch)
 {
-  char buf[MAX_INPUT_LENGTH];
   struct rent_info rent;
   int j;
   int cost, cost_eq;
@@ -787,9 +971,7 @@ void Crash_idlesave(struct char_data *ch)
   if (IS_NPC(ch))
     return;
 
-  if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
-    return;
-  if (!(fp = fopen(buf, "wb")))
+  if (!(fp = plrfile_open(CRASH_FILE, GET_NAME(ch), "wb")))
     return;
 
   Crash_extract_norent_eq(ch);
@@ -821,7 +1003,7 @@ void Crash_idlesave(struct char_data *ch)
   if (ch->carrying == NULL) {
     for (j = 0; j < NUM_WEARS && GET_EQ(ch, j) == NULL; j++) /* Nothing */ ;
     if (j == NUM_WEARS) {	/* No equipment or inventory. */
-      fclose(fp);
+      plrfile_close(fp);
       Crash_delete_file(GET_NAME(ch));
       return;
     }
@@ -833,13 +1015,13 @@ void Crash_idlesave(struct char_data *ch)
   rent.gold = GET_GOLD(ch);
   rent.account = GET_BANK_GOLD(ch);
   if (!Crash_write_rentcode(ch, fp, &rent)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
   for (j = 0; j < NUM_WEARS; j++) {
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch, j), fp, j + 1)) {
-        fclose(fp);
+        plrfile_close(fp);
         return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
@@ -847,10 +1029,10 @@ void Crash_idlesave(struct char_data *ch)
     }
   }
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
-  fclose(fp);
+  plrfile_close(fp);
 
   Crash_extract_objs(ch->carrying);
 }
@@ -858,7 +1040,6 @@ void Crash_idlesave(struct char_data *ch)
 
 void Crash_rentsave(struct char_data *ch, int cost)
 {
-  char buf[MAX_INPUT_LENGTH];
   struct rent_info rent;
   int j;
   FILE *fp;
@@ -866,9 +1047,7 @@ void Crash_rentsave(struct char_data *ch, int cost)
   if (IS_NPC(ch))
     return;
 
-  if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
-    return;
-  if (!(fp = fopen(buf, "wb")))
+  if (!(fp = plrfile_open(CRASH_FILE, GET_NAME(ch), "wb")))
     return;
 
   Crash_extract_norent_eq(ch);
@@ -880,23 +1059,23 @@ void Crash_rentsave(struct char_data *ch, int cost)
   rent.gold = GET_GOLD(ch);
   rent.account = GET_BANK_GOLD(ch);
   if (!Crash_write_rentcode(ch, fp, &rent)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
   for (j = 0; j < NUM_WEARS; j++)
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch,j), fp, j + 1)) {
-        fclose(fp);
+        plrfile_close(fp);
         return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
       Crash_extract_objs(GET_EQ(ch, j));
     }
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
-  fclose(fp);
+  plrfile_close(fp);
 
   Crash_extract_objs(ch->carrying);
 }
@@ -904,7 +1083,6 @@ void Crash_rentsave(struct char_data *ch, int cost)
 
 void Crash_cryosave(struct char_data *ch, int cost)
 {
-  char buf[MAX_INPUT_LENGTH];
   struct rent_info rent;
   int j;
   FILE *fp;
@@ -912,9 +1090,7 @@ void Crash_cryosave(struct char_data *ch, int cost)
   if (IS_NPC(ch))
     return;
 
-  if (!get_filename(buf, sizeof(buf), CRASH_FILE, GET_NAME(ch)))
-    return;
-  if (!(fp = fopen(buf, "wb")))
+  if (!(fp = plrfile_open(CRASH_FILE, GET_NAME(ch), "wb")))
     return;
 
   Crash_extract_norent_eq(ch);
@@ -928,23 +1104,23 @@ void Crash_cryosave(struct char_data *ch, int cost)
   rent.account = GET_BANK_GOLD(ch);
   rent.net_cost_per_diem = 0;
   if (!Crash_write_rentcode(ch, fp, &rent)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
   for (j = 0; j < NUM_WEARS; j++)
     if (GET_EQ(ch, j)) {
       if (!Crash_save(GET_EQ(ch, j), fp, j + 1)) {
-        fclose(fp);
+        plrfile_close(fp);
         return;
       }
       Crash_restore_weight(GET_EQ(ch, j));
       Crash_extract_objs(GET_EQ(ch, j));
     }
   if (!Crash_save(ch->carrying, fp, 0)) {
-    fclose(fp);
+    plrfile_close(fp);
     return;
   }
-  fclose(fp);
+  plrfile_close(fp);
 
   Crash_extract_objs(ch->carrying);
   SET_BIT(PLR_FLAGS(ch), PLR_CRYO);
@@ -1133,6 +1309,7 @@ int gen_receptionist(struct char_data *ch, struct char_data *recep,
     }
 
     act("$n helps $N into $S private chamber.", FALSE, recep, 0, ch, TO_NOTVICT);
+    webserver_feed_logout(ch, "rent");
 
     GET_LOADROOM(ch) = GET_ROOM_VNUM(IN_ROOM(ch));
     extract_char(ch);	/* It saves. */
@@ -36,6 +36,7 @@
 #include "constants.h"
 #include "spells.h"
 #include "olc.h"
+#include "webserver_olc.h"
 
 extern int num_allocated_zone;
 extern int num_allocated_world;
@@ -54,6 +55,7 @@ const char *olc_zone_flags[] =
 {
     "CLOSED",
     "LOCKED",
+    "ACTIVE",
     "\n"
 };
 
@@ -151,6 +153,8 @@ void olc_load_permissions(void)
 
 void olc_save_permissions(int vnum)
 {
+    wolc_snapshot_touch(WOLC_SNAP_ZONE, vnum);
+
     FILE *fp = fopen("world/permission.dat", "r+");
     if (fp == NULL)
 	return;
@@ -1488,6 +1492,7 @@ static int olc_create_mob_proto(int vnum)
     mob_index[rnum].vnum = vnum;
     mob_index[rnum].number = 0;
     mob_index[rnum].func = NULL;
+    mob_index[rnum].keywords = NULL;
 
     struct char_data *mob = &mob_proto[rnum];
     clear_char(mob);
@@ -1531,6 +1536,7 @@ static int olc_create_obj_proto(int vnum)
     obj_index[rnum].vnum = vnum;
     obj_index[rnum].number = 0;
     obj_index[rnum].func = NULL;
+    obj_index[rnum].keywords = NULL;
 
     struct obj_data *obj = &obj_proto[rnum];
     clear_object(obj);
@@ -1726,6 +1732,7 @@ void olc_save_mobile(int vnum)
     if (rnum == NOBODY)
 	return;
 
+    wolc_snapshot_touch(WOLC_SNAP_MOB, vnum);
     struct char_data *mob = &mob_proto[rnum];
 
     FILE *fp = fopen("world/mob/medit.mob", "a");
@@ -1788,6 +1795,8 @@ void olc_save_object(int vnum)
     if (rnum == NOTHING)
 	return;
 
+    wolc_snapshot_touch(WOLC_SNAP_OBJ, vnum);
+
     struct obj_data *obj = &obj_proto[rnum];
 
     FILE *fp = fopen("world/obj/oedit.obj", "a");
@@ -1831,6 +1840,9 @@ void olc_save_room(int vnum)
     if (rnum == NOWHERE)
 	return;
 
+    wolc_snapshot_touch(WOLC_SNAP_ROOM, vnum);
+    build_zone_neighbors();	/* its exits may lead somewhere new */
+
     struct room_data *room = &world[rnum];
 
     FILE *fp = fopen("world/wld/redit.wld", "a");
@@ -1901,6 +1913,8 @@ int zedit_save_zone_file(int rnum)
     struct zone_data *z = &zone_table[rnum];
     char path[256], bakpath[256];
 
+    wolc_snapshot_touch(WOLC_SNAP_ZONE, z->number);
+
     snprintf(path, sizeof(path), "world/zon/%d.zon", z->number);
     snprintf(bakpath, sizeof(bakpath), "world/zon/%d.zon.bak", z->number);
 
@@ -2513,7 +2527,7 @@ void do_zedit(struct char_data *ch, char *argument, int cmd, int subcmd)
 	send_to_char(ch, "ZEDIT <zone> <command> ...\r\n"
 		     "Commands: info, open, close, lock, unlock, grant, revoke,\r\n"
 		     "          create, list, remove, mobile, object, give, equip,\r\n"
-		     "          put, door\r\n");
+		     "          put, door, active, dormant\r\n");
 	return;
     }
 
@@ -2697,12 +2711,33 @@ void do_zedit(struct char_data *ch, char *argument, int cmd, int subcmd)
 	if (!zedit_require_lock(ch, rnum)) { free(s1); return; }
 	zedit_remove(ch, rnum, zone, argument + nconsumed);
     }
+    else if (strncmp("active", s1, strlen(s1)) == 0 ||
+	     strncmp("dormant", s1, strlen(s1)) == 0)
+    {
+	int active = (*s1 == 'a');
+
+	if (GET_LEVEL(ch) < LVL_GRGOD)
+	{
+	    send_to_char(ch, "Only great gods can change that.\r\n");
+	    free(s1);
+	    return;
+	}
+	if (active)
+	    SET_BIT(zone_table[rnum].permissions.flags, OLC_ZONEFLAGS_ACTIVE);
+	else
+	    REMOVE_BIT(zone_table[rnum].permissions.flags, OLC_ZONEFLAGS_ACTIVE);
+	olc_save_permissions(zone);
+	send_to_char(ch, active ? "Zone %d will always be active.\r\n"
+		     : "Zone %d will go dormant when nobody is near.\r\n", zone);
+	mudlog(NRM, GET_LEVEL(ch), TRUE, "%s made zone %d %s", GET_NAME(ch), zone,
+	       active ? "always active" : "able to go dormant");
+    }
     else
     {
 	send_to_char(ch, "Unknown zedit command '%s'.\r\n"
 		     "Commands: info, open, close, lock, unlock, grant, revoke,\r\n"
 		     "          create, list, remove, mobile, object, give, equip,\r\n"
-		     "          put, door\r\n", s1);
+		     "          put, door, active, dormant\r\n", s1);
     }
 
     free(s1);
@@ -54,6 +54,7 @@
 
 #define OLC_ZONEFLAGS_CLOSED		(1 << 0)
 #define OLC_ZONEFLAGS_LOCKED		(1 << 1)
+#define OLC_ZONEFLAGS_ACTIVE		(1 << 2)	/* never dormant */
 
 #define OLC_ZONE_MAX_AUTHORS		10
 
@@ -0,0 +1,397 @@
+/* ************************************************************************
+*   File: pwhash.c                                      Part of CircleMUD *
+*  Usage: hashing passwords in the background; limiting failed logins     *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "interpreter.h"
+#include "pwhash.h"
+
+/*
+ * A modern crypt() is slow on purpose, and nanny() used to call it on
+ * the game thread, so a few people typing passwords at once (or one
+ * person guessing them) stalled everybody.  Now nanny() hands the work
+ * to a worker thread through pwhash_request() and the connection waits
+ * in CON_VERIFYING with its input held.  When the hash is ready,
+ * pwhash_poll(), run from the game loop, puts the connection back in the
+ * state it was in and runs nanny() again with the same line; this time
+ * pwhash_request() has the answer.
+ *
+ * login_fail_check() and login_fail_note() count wrong passwords by site,
+ * so a site that keeps guessing is turned away before anything is hashed.
+ * Sites are numeric addresses (d->ip, or the web server's remote_addr), so
+ * telnet and web guesses from one address count together whether or not
+ * its name has been looked up.
+ */
+
+extern int login_fail_limit;
+extern int login_fail_window;
+
+#define PWHASH_KEY_LENGTH	MAX_INPUT_LENGTH
+#define PWHASH_HASH_LENGTH	128	/* room for sha512-crypt and friends */
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+#if !defined(HAVE_CRYPT_R)
+/* crypt() keeps its answer in a static buffer, so only one at a time. */
+static pthread_mutex_t pwhash_crypt_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+static pthread_mutex_t login_fail_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define LOGIN_FAIL_LOCK()	pthread_mutex_lock(&login_fail_mutex)
+#define LOGIN_FAIL_UNLOCK()	pthread_mutex_unlock(&login_fail_mutex)
+#else
+#define LOGIN_FAIL_LOCK()
+#define LOGIN_FAIL_UNLOCK()
+#endif
+
+
+/*
+ * crypt(key, salt) into out; safe to call from any thread.  A salt that
+ * crypt() doesn't understand gives a hash that matches nothing.
+ */
+void pwhash(const char *key, const char *salt, char *out, size_t outsize)
+{
+#if defined(NOCRYPT) || !defined(CIRCLE_CRYPT)
+  strlcpy(out, key, outsize);
+#elif defined(HAVE_CRYPT_R)
+  struct crypt_data *data;
+  const char *hash;
+
+  CREATE(data, struct crypt_data, 1);
+  hash = crypt_r(key, salt, data);
+  strlcpy(out, hash ? hash : "*", outsize);
+  free(data);
+#else
+  const char *hash;
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+  pthread_mutex_lock(&pwhash_crypt_mutex);
+#endif
+  hash = crypt(key, salt);
+  strlcpy(out, hash ? hash : "*", outsize);
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+  pthread_mutex_unlock(&pwhash_crypt_mutex);
+#endif
+#endif
+}
+
+
+/* Failed logins by site. */
+#define LOGIN_FAIL_SIZE		256	/* hash buckets */
+#define LOGIN_FAIL_MAX		4096	/* sites before pruning */
+
+struct login_fail {
+  char host[HOST_LENGTH + 1];
+  int count;
+  time_t since;		/* first failure in this window */
+  struct login_fail *next;
+};
+
+static struct login_fail *login_fails[LOGIN_FAIL_SIZE];
+static int login_fail_count = 0;
+
+
+static int login_fail_hash(const char *host)
+{
+  unsigned int h = 0;
+
+  while (*host)
+    h = h * 31 + LOWER((unsigned char) *host++);
+  return (h & (LOGIN_FAIL_SIZE - 1));
+}
+
+
+/* Expired sites are dropped on the way.  Call with the lock held. */
+static struct login_fail *login_fail_find(const char *host, time_t now)
+{
+  struct login_fail *f, **prev;
+
+  for (prev = &login_fails[login_fail_hash(host)]; (f = *prev) != NULL; ) {
+    if (now - f->since >= login_fail_window) {
+      *prev = f->next;
+      free(f);
+      login_fail_count--;
+    } else if (!str_cmp(f->host, host))
+      return (f);
+    else
+      prev = &f->next;
+  }
+  return (NULL);
+}
+
+
+static void login_fail_prune(time_t now)
+{
+  struct login_fail *f, **prev;
+  int i;
+
+  for (i = 0; i < LOGIN_FAIL_SIZE; i++)
+    for (prev = &login_fails[i]; (f = *prev) != NULL; )
+      if (now - f->since >= login_fail_window || f->count < login_fail_limit) {
+	*prev = f->next;
+	free(f);
+	login_fail_count--;
+      } else
+	prev = &f->next;
+}
+
+
+/* TRUE if this site has had too many wrong passwords lately. */
+int login_fail_check(const char *host)
+{
+  struct login_fail *f;
+  int limited;
+
+  if (login_fail_limit <= 0)
+    return (FALSE);
+
+  LOGIN_FAIL_LOCK();
+  f = login_fail_find(host, time(0));
+  limited = (f && f->count >= login_fail_limit);
+  LOGIN_FAIL_UNLOCK();
+
+  return (limited);
+}
+
+
+void login_fail_note(const char *host)
+{
+  struct login_fail *f;
+  time_t now = time(0);
+
+  if (login_fail_limit <= 0)
+    return;
+
+  LOGIN_FAIL_LOCK();
+  if (!(f = login_fail_find(host, now))) {
+    if (login_fail_count >= LOGIN_FAIL_MAX)
+      login_fail_prune(now);
+    CREATE(f, struct login_fail, 1);
+    strlcpy(f->host, host, sizeof(f->host));
+    f->since = now;
+    f->next = login_fails[login_fail_hash(host)];
+    login_fails[login_fail_hash(host)] = f;
+    login_fail_count++;
+  }
+  f->count++;
+  LOGIN_FAIL_UNLOCK();
+}
+
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+
+#define PWHASH_THREADS		2
+
+#define PWHASH_QUEUED		0
+#define PWHASH_RUNNING		1
+#define PWHASH_DONE		2
+
+struct pwhash_request {
+  char key[PWHASH_KEY_LENGTH];
+  char salt[PWHASH_HASH_LENGTH];
+  char hash[PWHASH_HASH_LENGTH];
+  int state;
+  int connected;		/* STATE(d) to go back to */
+  struct descriptor_data *d;	/* NULL once nobody is waiting.  Game
+				 * thread only; the workers don't look. */
+  struct pwhash_request *next;
+};
+
+static pthread_mutex_t pwhash_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pwhash_work = PTHREAD_COND_INITIALIZER;
+static struct pwhash_request *pwhash_list = NULL;
+static int pwhash_threads = 0;
+
+/* The answer nanny() is being rerun for, during pwhash_poll(). */
+static struct pwhash_request *pwhash_ready = NULL;
+
+
+static void pwhash_free(struct pwhash_request *r)
+{
+  /* Don't leave passwords lying about in freed memory. */
+  memset(r, 0, sizeof(*r));
+  free(r);
+}
+
+
+static void *pwhash_thread(void *arg)
+{
+  struct pwhash_request *r;
+  char hash[PWHASH_HASH_LENGTH];
+
+  pthread_mutex_lock(&pwhash_mutex);
+  for (;;) {
+    for (r = pwhash_list; r; r = r->next)
+      if (r->state == PWHASH_QUEUED)
+	break;
+    if (r == NULL) {
+      pthread_cond_wait(&pwhash_work, &pwhash_mutex);
+      continue;
+    }
+    r->state = PWHASH_RUNNING;
+    pthread_mutex_unlock(&pwhash_mutex);
+
+    /* Nobody else touches key and salt while it's running. */
+    pwhash(r->key, r->salt, hash, sizeof(hash));
+
+    pthread_mutex_lock(&pwhash_mutex);
+    strlcpy(r->hash, hash, sizeof(r->hash));
+    r->state = PWHASH_DONE;
+  }
+  return (NULL);
+}
+
+
+static void pwhash_start(void)
+{
+  pthread_t thread;
+
+  while (pwhash_threads < PWHASH_THREADS) {
+    if (pthread_create(&thread, NULL, pwhash_thread, NULL) != 0) {
+      log("SYSERR: pwhash: can't start thread: %s", strerror(errno));
+      break;
+    }
+    pthread_detach(thread);
+    pwhash_threads++;
+  }
+}
+
+
+/*
+ * Hash key with salt for nanny().  If the answer is ready it goes in out
+ * and we return TRUE.  Otherwise the work is queued, the connection is
+ * put in CON_VERIFYING and we return FALSE; nanny() should return and
+ * will be called with the same input when the hash is done.
+ */
+int pwhash_request(struct descriptor_data *d, const char *key,
+		const char *salt, char *out, size_t outsize)
+{
+  struct pwhash_request *r;
+
+  if ((r = pwhash_ready) != NULL && r->d == d &&
+      !strcmp(r->key, key) && !strcmp(r->salt, salt)) {
+    strlcpy(out, r->hash, outsize);
+    r->d = NULL;
+    return (TRUE);
+  }
+
+  pwhash_start();
+  if (!pwhash_threads) {	/* Do it the old way. */
+    pwhash(key, salt, out, outsize);
+    return (TRUE);
+  }
+
+  pwhash_cancel(d);
+  CREATE(r, struct pwhash_request, 1);
+  strlcpy(r->key, key, sizeof(r->key));
+  strlcpy(r->salt, salt, sizeof(r->salt));
+  r->state = PWHASH_QUEUED;
+  r->connected = STATE(d);
+  r->d = d;
+  d->pwhash = r;
+  STATE(d) = CON_VERIFYING;
+
+  pthread_mutex_lock(&pwhash_mutex);
+  r->next = pwhash_list;
+  pwhash_list = r;
+  pthread_cond_signal(&pwhash_work);
+  pthread_mutex_unlock(&pwhash_mutex);
+
+  return (FALSE);
+}
+
+
+/* The connection is going away; a hash under way is thrown out later. */
+void pwhash_cancel(struct descriptor_data *d)
+{
+  struct pwhash_request *r = d->pwhash, **prev;
+
+  if (r == NULL)
+    return;
+
+  d->pwhash = NULL;
+  r->d = NULL;
+
+  pthread_mutex_lock(&pwhash_mutex);
+  if (r->state == PWHASH_QUEUED) {
+    for (prev = &pwhash_list; *prev; prev = &(*prev)->next)
+      if (*prev == r) {
+	*prev = r->next;
+	break;
+      }
+    pwhash_free(r);
+  }
+  pthread_mutex_unlock(&pwhash_mutex);
+}
+
+
+void pwhash_poll(void)
+{
+  struct pwhash_request *r, **prev, *done = NULL;
+  struct descriptor_data *d;
+  char arg[PWHASH_KEY_LENGTH];
+
+  if (!pwhash_list)
+    return;
+
+  pthread_mutex_lock(&pwhash_mutex);
+  for (prev = &pwhash_list; (r = *prev) != NULL; ) {
+    if (r->state == PWHASH_DONE) {
+      *prev = r->next;
+      r->next = done;
+      done = r;
+    } else
+      prev = &r->next;
+  }
+  pthread_mutex_unlock(&pwhash_mutex);
+
+  while ((r = done) != NULL) {
+    done = r->next;
+    if ((d = r->d) != NULL) {
+      d->pwhash = NULL;
+      if (STATE(d) == CON_VERIFYING) {
+	STATE(d) = r->connected;
+	strlcpy(arg, r->key, sizeof(arg));
+	pwhash_ready = r;
+	nanny(d, arg);
+	pwhash_ready = NULL;
+	memset(arg, 0, sizeof(arg));
+      }
+    }
+    pwhash_free(r);
+  }
+}
+
+#else /* !(CIRCLE_UNIX && HAVE_PTHREAD) */
+
+int pwhash_request(struct descriptor_data *d, const char *key,
+		const char *salt, char *out, size_t outsize)
+{
+  pwhash(key, salt, out, outsize);
+  return (TRUE);
+}
+
+
+void pwhash_cancel(struct descriptor_data *d)
+{
+}
+
+
+void pwhash_poll(void)
+{
+}
+
+#endif /* CIRCLE_UNIX && HAVE_PTHREAD */
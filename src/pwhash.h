@@ -0,0 +1,18 @@
+/* ************************************************************************
+*   File: pwhash.h                                      Part of CircleMUD *
+*  Usage: header file for background password hashing                     *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+void	pwhash(const char *key, const char *salt, char *out, size_t outsize);
+int	pwhash_request(struct descriptor_data *d, const char *key,
+		const char *salt, char *out, size_t outsize);
+void	pwhash_cancel(struct descriptor_data *d);
+void	pwhash_poll(void);
+
+int	login_fail_check(const char *host);
+void	login_fail_note(const char *host);
@@ -0,0 +1,370 @@
+/* ************************************************************************
+*   File: resolver.c                                    Part of CircleMUD *
+*  Usage: looking up the site names of new connections in the background *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#if defined(CIRCLE_UNIX)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#endif
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#endif
+
+#include "structs.h"
+#include "utils.h"
+#include "comm.h"
+#include "db.h"
+#include "resolver.h"
+
+/*
+ * new_descriptor() used to call gethostbyaddr() itself, which stops the
+ * whole game for as long as the nameserver takes to answer.  Now a new
+ * connection starts out with its numeric address (which is checked
+ * against the ban list straight away) and the name is looked up by a
+ * worker thread.  resolver_poll(), run from the game loop, fills in
+ * d->host when the answer comes back and checks the ban list again.
+ * game_loop() holds back a connection's input at the name prompt while
+ * the lookup is outstanding, so a banned site never gets further than
+ * that; if the nameserver hasn't answered within dns_timeout seconds the
+ * connection carries on under its number.
+ *
+ * Answers, including failures, are cached by address for dns_cache_ttl
+ * seconds.  The cache belongs to the game thread; the workers only ever
+ * touch their own request.
+ */
+
+extern int dns_cache_ttl;
+extern int dns_timeout;
+
+int isbanned(char *hostname);
+
+/* Failed lookups are retried sooner than successful ones expire. */
+#define DNS_NEGATIVE_TTL	300
+#define DNS_CACHE_SIZE		256	/* hash buckets */
+#define DNS_CACHE_MAX		4096	/* entries before pruning */
+
+struct dns_cache_entry {
+  struct in_addr addr;
+  char host[HOST_LENGTH + 1];	/* empty if the lookup failed */
+  time_t expires;
+  struct dns_cache_entry *next;
+};
+
+static struct dns_cache_entry *dns_cache[DNS_CACHE_SIZE];
+static int dns_cache_count = 0;
+
+/* Keep the number if the address has no name. */
+static void resolver_set_host(struct descriptor_data *d, const char *host)
+{
+  if (*host)
+    strlcpy(d->host, host, sizeof(d->host));
+}
+
+
+static int dns_hash(struct in_addr addr)
+{
+  unsigned long a = ntohl(addr.s_addr);
+
+  return ((a ^ (a >> 8) ^ (a >> 16) ^ (a >> 24)) & (DNS_CACHE_SIZE - 1));
+}
+
+
+static struct dns_cache_entry *dns_cache_find(struct in_addr addr)
+{
+  struct dns_cache_entry *e, **prev;
+  time_t now = time(0);
+
+  for (prev = &dns_cache[dns_hash(addr)]; (e = *prev) != NULL; ) {
+    if (e->expires <= now) {
+      *prev = e->next;
+      free(e);
+      dns_cache_count--;
+    } else if (e->addr.s_addr == addr.s_addr)
+      return (e);
+    else
+      prev = &e->next;
+  }
+  return (NULL);
+}
+
+
+static void dns_cache_prune(void)
+{
+  struct dns_cache_entry *e, **prev;
+  time_t now = time(0);
+  int i;
+
+  /* Expired entries first; if that isn't enough, start over. */
+  for (i = 0; i < DNS_CACHE_SIZE; i++)
+    for (prev = &dns_cache[i]; (e = *prev) != NULL; )
+      if (e->expires <= now || dns_cache_count >= DNS_CACHE_MAX * 2) {
+	*prev = e->next;
+	free(e);
+	dns_cache_count--;
+      } else
+	prev = &e->next;
+
+  if (dns_cache_count >= DNS_CACHE_MAX)
+    for (i = 0; i < DNS_CACHE_SIZE; i++)
+      while ((e = dns_cache[i]) != NULL) {
+	dns_cache[i] = e->next;
+	free(e);
+	dns_cache_count--;
+      }
+}
+
+
+static void dns_cache_add(struct in_addr addr, const char *host)
+{
+  struct dns_cache_entry *e;
+
+  if (dns_cache_ttl <= 0)
+    return;
+
+  if (!(e = dns_cache_find(addr))) {
+    if (dns_cache_count >= DNS_CACHE_MAX)
+      dns_cache_prune();
+    CREATE(e, struct dns_cache_entry, 1);
+    e->addr = addr;
+    e->next = dns_cache[dns_hash(addr)];
+    dns_cache[dns_hash(addr)] = e;
+    dns_cache_count++;
+  }
+  strlcpy(e->host, host, sizeof(e->host));
+  e->expires = time(0) + (*host ? dns_cache_ttl : MIN(dns_cache_ttl, DNS_NEGATIVE_TTL));
+}
+
+
+/* Reverse lookup; getnameinfo() is safe to call from any thread. */
+static int dns_resolve(struct in_addr addr, char *host, size_t hostsize)
+{
+  struct sockaddr_in sa;
+  char name[NI_MAXHOST];
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sin_family = AF_INET;
+  sa.sin_addr = addr;
+
+  if (getnameinfo((struct sockaddr *) &sa, sizeof(sa), name, sizeof(name),
+		  NULL, 0, NI_NAMEREQD) != 0) {
+    *host = '\0';
+    return (0);
+  }
+  strlcpy(host, name, hostsize);
+  return (1);
+}
+
+
+#if defined(CIRCLE_UNIX) && defined(HAVE_PTHREAD)
+
+/* A couple of threads, so one slow nameserver doesn't hold up everyone. */
+#define RESOLVER_THREADS	2
+
+#define DNS_QUEUED		0
+#define DNS_RUNNING		1
+#define DNS_DONE		2
+
+struct dns_request {
+  struct in_addr addr;
+  char host[HOST_LENGTH + 1];
+  int state;
+  time_t queued;
+  struct descriptor_data *d;	/* NULL once nobody is waiting.  Game
+				 * thread only; the workers don't look. */
+  struct dns_request *next;
+};
+
+static pthread_mutex_t resolver_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t resolver_work = PTHREAD_COND_INITIALIZER;
+static struct dns_request *resolver_list = NULL;
+static int resolver_threads = 0;
+
+
+static void *resolver_thread(void *arg)
+{
+  struct dns_request *r;
+  struct in_addr addr;
+  char host[HOST_LENGTH + 1];
+
+  pthread_mutex_lock(&resolver_mutex);
+  for (;;) {
+    for (r = resolver_list; r; r = r->next)
+      if (r->state == DNS_QUEUED)
+	break;
+    if (r == NULL) {
+      pthread_cond_wait(&resolver_work, &resolver_mutex);
+      continue;
+    }
+    r->state = DNS_RUNNING;
+    addr = r->addr;
+    pthread_mutex_unlock(&resolver_mutex);
+
+    dns_resolve(addr, host, sizeof(host));
+
+    pthread_mutex_lock(&resolver_mutex);
+    strlcpy(r->host, host, sizeof(r->host));
+    r->state = DNS_DONE;
+  }
+  return (NULL);
+}
+
+
+static void resolver_start(void)
+{
+  pthread_t thread;
+
+  while (resolver_threads < RESOLVER_THREADS) {
+    if (pthread_create(&thread, NULL, resolver_thread, NULL) != 0) {
+      log("SYSERR: resolver: can't start thread: %s", strerror(errno));
+      break;
+    }
+    pthread_detach(thread);
+    resolver_threads++;
+  }
+}
+
+
+void resolver_lookup(struct descriptor_data *d, struct in_addr addr)
+{
+  struct dns_cache_entry *e;
+  struct dns_request *r;
+
+  if ((e = dns_cache_find(addr)) != NULL) {
+    resolver_set_host(d, e->host);
+    return;
+  }
+
+  resolver_start();
+  if (!resolver_threads) {	/* Do it the old way. */
+    char host[HOST_LENGTH + 1];
+
+    dns_resolve(addr, host, sizeof(host));
+    dns_cache_add(addr, host);
+    resolver_set_host(d, host);
+    return;
+  }
+
+  resolver_cancel(d);
+  CREATE(r, struct dns_request, 1);
+  r->addr = addr;
+  r->state = DNS_QUEUED;
+  r->queued = time(0);
+  r->d = d;
+  d->dns = r;
+
+  pthread_mutex_lock(&resolver_mutex);
+  r->next = resolver_list;
+  resolver_list = r;
+  pthread_cond_signal(&resolver_work);
+  pthread_mutex_unlock(&resolver_mutex);
+}
+
+
+/* Nobody wants the answer any more; a lookup under way is still cached. */
+void resolver_cancel(struct descriptor_data *d)
+{
+  struct dns_request *r = d->dns, **prev;
+
+  if (r == NULL)
+    return;
+
+  d->dns = NULL;
+  r->d = NULL;
+
+  pthread_mutex_lock(&resolver_mutex);
+  if (r->state == DNS_QUEUED) {
+    for (prev = &resolver_list; *prev; prev = &(*prev)->next)
+      if (*prev == r) {
+	*prev = r->next;
+	break;
+      }
+    free(r);
+  }
+  pthread_mutex_unlock(&resolver_mutex);
+}
+
+
+void resolver_poll(void)
+{
+  struct dns_request *r, **prev, *done = NULL;
+  time_t now = time(0);
+
+  if (!resolver_list)
+    return;
+
+  pthread_mutex_lock(&resolver_mutex);
+  for (prev = &resolver_list; (r = *prev) != NULL; ) {
+    if (r->state == DNS_DONE) {
+      *prev = r->next;
+      r->next = done;
+      done = r;
+    } else
+      prev = &r->next;
+  }
+  pthread_mutex_unlock(&resolver_mutex);
+
+  while ((r = done) != NULL) {
+    done = r->next;
+    dns_cache_add(r->addr, r->host);
+    if (r->d) {
+      r->d->dns = NULL;
+      resolver_set_host(r->d, r->host);
+      /* new_descriptor() only had the number to check. */
+      if (*r->host && STATE(r->d) != CON_CLOSE && isbanned(r->d->host) == BAN_ALL) {
+	mudlog(CMP, LVL_GOD, TRUE, "Connection attempt denied from [%s]", r->d->host);
+	STATE(r->d) = CON_CLOSE;
+      }
+    }
+    free(r);
+  }
+
+  /* Don't keep anybody at the name prompt forever. */
+  pthread_mutex_lock(&resolver_mutex);
+  for (r = resolver_list; r; r = r->next)
+    if (r->d && now - r->queued >= dns_timeout) {
+      r->d->dns = NULL;
+      r->d = NULL;
+    }
+  pthread_mutex_unlock(&resolver_mutex);
+}
+
+#else /* !(CIRCLE_UNIX && HAVE_PTHREAD) */
+
+void resolver_lookup(struct descriptor_data *d, struct in_addr addr)
+{
+  struct dns_cache_entry *e;
+  char host[HOST_LENGTH + 1];
+
+  if ((e = dns_cache_find(addr)) != NULL)
+    resolver_set_host(d, e->host);
+  else {
+    dns_resolve(addr, host, sizeof(host));
+    dns_cache_add(addr, host);
+    resolver_set_host(d, host);
+  }
+}
+
+
+void resolver_cancel(struct descriptor_data *d)
+{
+}
+
+
+void resolver_poll(void)
+{
+}
+
+#endif /* CIRCLE_UNIX && HAVE_PTHREAD */
+
@@ -0,0 +1,13 @@
+/* ************************************************************************
+*   File: resolver.h                                    Part of CircleMUD *
+*  Usage: header file for background site name lookups                    *
+*                                                                         *
+*  All rights reserved.  See license.doc for complete information.        *
+*                                                                         *
+*  Copyright (C) 1993, 94 by the Trustees of the Johns Hopkins University *
+*  CircleMUD is based on DikuMUD, Copyright (C) 1990, 1991.               *
+************************************************************************ */
+
+void	resolver_lookup(struct descriptor_data *d, struct in_addr addr);
+void	resolver_cancel(struct descriptor_data *d);
+void	resolver_poll(void);
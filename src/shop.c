@@ -54,6 +54,7 @@ struct obj_data *get_hash_obj_vis(struct char_data *ch, char *name, struct obj_d
 struct obj_data *get_slide_obj_vis(struct char_data *ch, char *name, struct obj_data *list);
 void boot_the_shops(FILE *shop_f, char *filename, int rec_count);
 void assign_the_shopkeepers(void);
+int shop_keeper_has_func(mob_rnum keeper);
 char *customer_string(int shop_nr, int detailed);
 void list_all_shops(struct char_data *ch);
 void list_detailed_shop(struct char_data *ch, int shop_nr);
@@ -396,6 +397,7 @@ struct obj_data *get_slide_obj_vis(struct char_data *ch, char *name,
 				            struct obj_data *list)
 {
   struct obj_data *i, *last_match = NULL;
+  struct keyword_query kq;
   int j, number;
   char tmpname[MAX_INPUT_LENGTH];
   char *tmp;
@@ -404,9 +406,10 @@ struct obj_data *get_slide_obj_vis(struct char_data *ch, char *name,
   tmp = tmpname;
   if (!(number = get_number(&tmp)))
     return (NULL);
+  keyword_query_init(&kq, tmp);
 
   for (i = list, j = 1; i && (j <= number); i = i->next_content)
-    if (isname(tmp, i->name))
+    if (isname_obj(&kq, i))
       if (CAN_SEE_OBJ(ch, i) && !same_obj(last_match, i)) {
 	if (j == number)
 	  return (i);
@@ -1266,6 +1269,23 @@ void assign_the_shopkeepers(void)
 }
 
 
+/*
+ * Does this mob keep a shop with a spec proc of its own as well?  Then
+ * shop_keeper() passes everything on to it, so it has to be called for
+ * everything (see assign_spec_triggers()).
+ */
+int shop_keeper_has_func(mob_rnum keeper)
+{
+  int cindex;
+
+  for (cindex = 0; cindex <= top_shop; cindex++)
+    if (SHOP_KEEPER(cindex) == keeper && SHOP_FUNC(cindex))
+      return (TRUE);
+
+  return (FALSE);
+}
+
+
 char *customer_string(int shop_nr, int detailed)
 {
   int sindex = 0, flag = 1, nlen;
@@ -40,12 +40,26 @@ SPECIAL(magic_user);
 SPECIAL(bank);
 SPECIAL(gen_board);
 SPECIAL(room_of_introspection);
+SPECIAL(shop_keeper);
+SPECIAL(CastleGuard);
+SPECIAL(James);
+SPECIAL(cleaning);
+SPECIAL(DicknDavid);
+SPECIAL(tim);
+SPECIAL(tom);
+SPECIAL(king_welmar);
+SPECIAL(training_master);
+SPECIAL(peter);
+SPECIAL(jerry);
 void assign_kings_castle(void);
+int shop_keeper_has_func(mob_rnum keeper);
 
 /* local functions */
 void assign_mobiles(void);
 void assign_objects(void);
 void assign_rooms(void);
+void assign_spec_triggers(void);
+struct spec_trigger *find_spec_trigger(SPECIAL(*func));
 void ASSIGNROOM(room_vnum room, SPECIAL(fname));
 void ASSIGNMOB(mob_vnum mob, SPECIAL(fname));
 void ASSIGNOBJ(obj_vnum obj, SPECIAL(fname));
@@ -307,3 +321,116 @@ void assign_rooms(void)
       if (ROOM_FLAGGED(i, ROOM_DEATH))
 	world[i].func = dump;
 }
+
+
+
+/* ********************************************************************
+*  Triggers                                                           *
+******************************************************************** */
+
+/*
+ * What each spec proc wants to be called for: SPEC_PULSE for the calls
+ * with cmd 0 from mobile_activity() and perform_violence(), SPEC_MOVES
+ * for the direction commands, and the commands it answers to by name.
+ * special() and the pulse code skip a proc for anything else, so when
+ * you change what a proc looks at, change its entry here as well.  A
+ * proc left out of this table gets every call.
+ */
+static struct spec_trigger spec_triggers[] = {
+  /* mobiles */
+  { puff,		SPEC_PULSE,		"" },
+  { fido,		SPEC_PULSE,		"" },
+  { janitor,		SPEC_PULSE,		"" },
+  { mayor,		SPEC_PULSE,		"" },
+  { snake,		SPEC_PULSE,		"" },
+  { thief,		SPEC_PULSE,		"" },
+  { magic_user,		SPEC_PULSE,		"" },
+  { cityguard,		SPEC_PULSE,		"" },
+  { guild,		0,			"practice" },
+  { guild_guard,	SPEC_MOVES,		"" },
+  { postmaster,		0,			"mail check receive" },
+  { receptionist,	SPEC_PULSE,		"offer rent" },
+  { cryogenicist,	SPEC_PULSE,		"offer rent" },
+  { shop_keeper,	SPEC_SELF,		"steal buy sell value list" },
+
+  /* King Welmar's Castle (castle.c) */
+  { CastleGuard,	SPEC_PULSE,		"" },
+  { James,		SPEC_PULSE,		"" },
+  { cleaning,		SPEC_PULSE,		"" },
+  { king_welmar,	SPEC_PULSE,		"" },
+  { training_master,	SPEC_PULSE,		"" },
+  { peter,		SPEC_PULSE,		"" },
+  { jerry,		SPEC_PULSE,		"" },
+  { tim,		SPEC_PULSE | SPEC_MOVES, "" },
+  { tom,		SPEC_PULSE | SPEC_MOVES, "" },
+  { DicknDavid,		SPEC_PULSE | SPEC_MOVES, "" },
+
+  /* objects */
+  { gen_board,		0,			"write look examine read remove" },
+  { bank,		0,			"balance deposit withdraw" },
+
+  /* rooms */
+  { dump,		0,			"drop" },
+  { pet_shops,		0,			"list buy" },
+  { room_of_introspection, 0,			"pray" },
+
+  { NULL, 0, NULL }
+};
+
+
+struct spec_trigger *find_spec_trigger(SPECIAL(*func))
+{
+  int i;
+
+  for (i = 0; spec_triggers[i].func; i++)
+    if (spec_triggers[i].func == func)
+      return (spec_triggers + i);
+
+  return (NULL);
+}
+
+
+/*
+ * Turn the command names into a table by command number and point the
+ * mobs, objects and rooms at the entries for their procs.  This has to
+ * come after everything else that hands out spec procs.
+ */
+void assign_spec_triggers(void)
+{
+  struct spec_trigger *trig;
+  char word[MAX_INPUT_LENGTH];
+  const char *p;
+  int i, cmd, num_of_cmds = 0;
+
+  while (*cmd_info[num_of_cmds].command != '\n')
+    num_of_cmds++;
+
+  for (trig = spec_triggers; trig->func; trig++) {
+    if (!trig->cmd_set)
+      CREATE(trig->cmd_set, ubyte, num_of_cmds + 1);
+
+    if (IS_SET(trig->flags, SPEC_MOVES))
+      for (cmd = 1; cmd < num_of_cmds; cmd++)
+	if (IS_MOVE(cmd))
+	  trig->cmd_set[cmd] = TRUE;
+
+    for (p = any_one_arg((char *) trig->commands, word); *word; p = any_one_arg((char *) p, word)) {
+      if ((cmd = find_command(word)) > 0)
+	trig->cmd_set[cmd] = TRUE;
+      else
+	log("SYSERR: Spec trigger for unknown command '%s'.", word);
+    }
+  }
+
+  for (i = 0; i <= top_of_mobt; i++)
+    if (mob_index[i].func && !shop_keeper_has_func(i))
+      mob_index[i].spec_trig = find_spec_trigger(mob_index[i].func);
+
+  for (i = 0; i <= top_of_objt; i++)
+    if (obj_index[i].func)
+      obj_index[i].spec_trig = find_spec_trigger(obj_index[i].func);
+
+  for (i = 0; i <= top_of_world; i++)
+    if (world[i].func)
+      world[i].spec_trig = find_spec_trigger(world[i].func);
+}
@@ -690,6 +690,7 @@ SPECIAL(pet_shops)
       snprintf(buf, sizeof(buf), "%s %s", pet->player.name, pet_name);
       /* free(pet->player.name); don't free the prototype! */
       pet->player.name = strdup(buf);
+      keyword_index_char(pet);
 
       snprintf(buf, sizeof(buf), "%sA small sign on a chain around the neck says 'My name is %s'\r\n",
 	      pet->player.description, pet_name);
@@ -280,8 +280,10 @@ ASPELL(spell_charm)
     affect_to_char(victim, &af);
 
     act("Isn't $n just such a nice fellow?", FALSE, ch, 0, victim, TO_VICT);
-    if (IS_NPC(victim))
+    if (IS_NPC(victim)) {
       REMOVE_BIT(MOB_FLAGS(victim), MOB_SPEC);
+      char_lists_update(victim);
+    }
   }
 }
 
@@ -26,6 +26,16 @@
  */
 #define USE_AUTOEQ	1	/* TRUE/FALSE aren't defined yet. */
 
+/*
+ * Set to 1 (or build with -DCHECK_AFFECTS=1) to have handler.c check the
+ * abilities it keeps up to date as things are worn and removed, and
+ * fight.c the combat numbers it caches, against a full recompute, logging
+ * any difference.  For debugging; it is slow.
+ */
+#ifndef CHECK_AFFECTS
+#define CHECK_AFFECTS	0
+#endif
+
 
 /* preamble *************************************************************/
 
@@ -54,6 +64,15 @@
 #define SPECIAL(name) \
    int (name)(struct char_data *ch, void *me, int cmd, char *argument)
 
+/*
+ * What a spec proc wants to be called for (struct spec_trigger, from the
+ * table in spec_assign.c).  A proc that isn't in the table is called for
+ * every command and every pulse, as it always was.
+ */
+#define SPEC_PULSE	(1 << 0)   /* Called with cmd 0 (mobile/violence)  */
+#define SPEC_MOVES	(1 << 1)   /* Called for the direction commands    */
+#define SPEC_SELF	(1 << 2)   /* Called for the mob's own commands    */
+
 
 /* room-related defines *************************************************/
 
@@ -266,6 +285,7 @@
 #define CON_REMORT_STAT1 19	/* Remort increase stat			*/
 #define CON_REMORT_STAT2 20	/* Remort increase stat			*/
 #define CON_OLC_EDIT	 21	/* Used for MEDIT, REDIT, OEDIT		*/
+#define CON_VERIFYING	 22	/* Waiting for a password to be hashed	*/
 
 /* Character equipment positions: used as index for char_data.equipment[] */
 /* NOTE: Don't confuse these constants with the ITEM_ bitvectors
@@ -487,6 +507,7 @@
 #define PULSE_IDLEPWD	(15 RL_SEC)
 #define PULSE_SANITY	(30 RL_SEC)
 #define PULSE_USAGE	(5 * 60 RL_SEC)	/* 5 mins */
+#define PULSE_USAGE_FEED	(60 RL_SEC)	/* 1 min */
 #define PULSE_TIMESAVE	(30 * 60 RL_SEC) /* should be >= SECS_PER_MUD_HOUR */
 
 /* Variables for the output buffering system */
@@ -625,6 +646,10 @@ struct obj_data {
    struct obj_data *next_content; /* For 'contains' lists             */
    struct obj_data *next;         /* For the object list              */
 
+   struct keyword_ref *kw_refs;   /* Its entries in the keyword index */
+   int kw_nrefs;
+   long kw_seq;			  /* Order in object_list, 0 if unindexed */
+
    int zone_cmd_no;		  /* The zone cmd that loaded this object */
    int zone_num;		  /* The zone that loaded this object */
 };
@@ -682,6 +707,15 @@ struct room_direction_data {
 };
 
 
+/* What a spec proc wants to be called for; see SPEC_xxx. */
+struct spec_trigger {
+   SPECIAL(*func);
+   int flags;			/* SPEC_xxx				*/
+   const char *commands;	/* Commands it answers to		*/
+   ubyte *cmd_set;		/* The same, by command number		*/
+};
+
+
 /* ================== Memory Structure for room ======================= */
 struct room_data {
    room_vnum number;		/* Rooms number	(vnum)		      */
@@ -695,9 +729,11 @@ struct room_data {
 
    byte light;                  /* Number of lightsources in room     */
    SPECIAL(*func);
+   struct spec_trigger *spec_trig; /* When func wants calling        */
 
    struct obj_data *contents;   /* List of items in room              */
    struct char_data *people;    /* List of NPC / PC in room           */
+   int spec_count;              /* Mobs and objects here with specs   */
 };
 /* ====================================================================== */
 
@@ -760,6 +796,37 @@ struct char_ability_data {
 };
 
 
+/*
+ * The ability applies from a character's equipment and affects, summed.
+ * aff_abils is real_abils plus these, kept in range (see affect_abils()).
+ */
+struct char_ability_mods {
+   int str;
+   int intel;
+   int wis;
+   int dex;
+   int con;
+   int cha;
+};
+
+
+/*
+ * Combat numbers worked out from a character's class, level, abilities
+ * and points, kept until one of those changes: see compute_combat() in
+ * fight.c.  Level and class are checked each time, everything else
+ * clears 'valid' through INVALIDATE_COMBAT().
+ */
+struct char_combat_data {
+   bool valid;
+   byte level;		/* Level and class they were worked out for */
+   byte chclass;
+   sh_int thaco;	/* compute_thaco(), hitroll and abilities included */
+   sh_int ac_awake;	/* compute_armor_class() while AWAKE() */
+   sh_int ac_asleep;	/* ... and while not */
+   sh_int damroll;	/* Damroll plus the strength bonus */
+};
+
+
 /* Char's points.  Used in char_file_u *DO*NOT*CHANGE* */
 struct char_point_data {
    sh_int mana;
@@ -883,6 +950,7 @@ struct player_special_data {
    struct alias_data *aliases;	/* Character's aliases			*/
    long last_tell;		/* idnum of last tell from		*/
    struct eqset_data *eqsets;	/* Named equipment sets			*/
+   bool feed_online;		/* Login posted to /mud/events, no logout */
 };
 
 
@@ -919,6 +987,22 @@ struct follow_type {
 };
 
 
+/*
+ * Worklists of the characters each heartbeat stage acts on, so it need
+ * not pick them out of all of character_list (see char_lists_update()).
+ */
+#define CHAR_LIST_PLAYERS	0	/* every PC in the game		*/
+#define CHAR_LIST_SPEC		1	/* MOB_SPEC			*/
+#define CHAR_LIST_SCAVENGER	2	/* MOB_SCAVENGER		*/
+#define CHAR_LIST_WANDERER	3	/* mobs without MOB_SENTINEL	*/
+#define CHAR_LIST_AGGRESSIVE	4	/* MOB_AGGRESSIVE or MOB_AGGR_*	*/
+#define CHAR_LIST_MEMORY	5	/* MOB_MEMORY			*/
+#define CHAR_LIST_HELPER	6	/* MOB_HELPER			*/
+#define CHAR_LIST_FOLLOWER	7	/* mobs following someone	*/
+#define CHAR_LIST_ENTERED	8	/* mobs to size up a newcomer	*/
+#define NUM_CHAR_LISTS		9
+
+
 /* ================== Structure for player/non-player ===================== */
 struct char_data {
    int pfilepos;			 /* playerfile pos		  */
@@ -931,20 +1015,32 @@ struct char_data {
    struct char_ability_data real_abils;	 /* Abilities without modifiers   */
    struct char_ability_data aff_abils;	 /* Abils with spells/stones/etc  */
    struct char_ability_data new_abils;	 /* Proposed rerolled abilities   */
+   struct char_ability_mods abil_mods;	 /* Applies making up aff_abils   */
    struct char_point_data points;        /* Points                        */
+   struct char_combat_data combat;	 /* Cached from the above         */
    struct char_special_data char_specials;	/* PC/NPC specials	  */
    struct player_special_data *player_specials; /* PC specials		  */
    struct mob_special_data mob_specials;	/* NPC specials		  */
 
    struct affected_type *affected;       /* affected by what spells       */
    struct obj_data *equipment[NUM_WEARS];/* Equipment array               */
+   int affect_batch;			 /* Depth of affect_batch_begin() */
+   bool affect_batch_eq;		 /* Equipment changed in the batch */
 
    struct obj_data *carrying;            /* Head of list                  */
+   int spec_objs;			 /* Carried/worn objs with specs  */
    struct descriptor_data *desc;         /* NULL for mobiles              */
 
    struct char_data *next_in_room;     /* For room->people - list         */
    struct char_data *next;             /* For either monster or ppl-list  */
    struct char_data *next_fighting;    /* For fighting list               */
+   struct char_data *next_in_list[NUM_CHAR_LISTS]; /* Worklists          */
+   struct char_data *prev_in_list[NUM_CHAR_LISTS];
+   int in_lists;			 /* Bit per worklist it's on      */
+
+   struct keyword_ref *kw_refs;		 /* Its entries in the keyword index */
+   int kw_nrefs;
+   long kw_seq;				 /* Order in character_list, 0 if unindexed */
 
    struct follow_type *followers;        /* List of chars followers       */
    struct char_data *master;             /* Who is char following?        */
@@ -1009,6 +1105,7 @@ struct txt_q {
 struct descriptor_data {
    socket_t	descriptor;	/* file descriptor for socket		*/
    char	host[HOST_LENGTH+1];	/* hostname				*/
+   char	ip[HOST_LENGTH+1];	/* numeric address, even once resolved	*/
    byte	bad_pws;		/* number of bad pw attemps this login	*/
    byte idle_tics;		/* tics idle at password prompt		*/
    int	connected;		/* mode of 'connectedness'		*/
@@ -1047,6 +1144,11 @@ struct descriptor_data {
    int  gmcp_sb_cmd;               /* command byte saved in IAC_GOT_CMD state */
    char gmcp_sb_buf[4096];         /* accumulator for IAC SB subneg data */
    int  gmcp_sb_len;               /* bytes currently in gmcp_sb_buf */
+   struct plrfile_prefetch *prefetch; /* player files being read ahead */
+   struct dns_request *dns;	/* site name lookup in progress		*/
+   struct pwhash_request *pwhash; /* password being hashed		*/
+   struct conn_site *site;	/* address counted for connection limits */
+   struct mccp_stream *mccp;	/* output compressor, if MCCP is on	*/
 };
 
 
@@ -1073,6 +1175,7 @@ struct message_list {
    int	a_type;			/* Attack type				*/
    int	number_of_attacks;	/* How many attack messages to chose from. */
    struct message_type *msg;	/* List of messages.			*/
+   struct message_type **by_number; /* The same list, as an array.	*/
 };
 
 
@@ -1133,6 +1236,35 @@ struct index_data {
    mob_vnum	vnum;	/* virtual number of this mob/obj		*/
    int		number;	/* number of existing units of this mob/obj	*/
    SPECIAL(*func);
+   struct spec_trigger *spec_trig;	/* when func wants calling	*/
+   struct keyword_set *keywords;	/* prototype's namelist, compiled */
+};
+
+
+/*
+ * A prototype's namelist broken into keywords once, so that isname_obj()
+ * and isname_char() can compare hashes instead of re-parsing the string
+ * for every object and mobile they look at.  Only namelists made of
+ * letters and single spaces are compiled (count is -1 for anything
+ * else), since those are the ones where an exact word match is all
+ * isname() does.  Instances share the set through their rnum for as long
+ * as their name is still the prototype's.
+ */
+#define MAX_KEYWORD_LENGTH	64
+
+struct keyword_set {
+   const char *source;	/* namelist this was built from		*/
+   int count;		/* number of keywords, -1 if not compiled	*/
+   unsigned int *hash;	/* one per keyword				*/
+   char *text;		/* length byte + lower-cased keyword, each	*/
+};
+
+/* A search string prepared once for matching against keyword sets. */
+struct keyword_query {
+   const char *str;	/* what the player typed			*/
+   int len;		/* 0 if only isname() can handle it		*/
+   unsigned int hash;
+   char text[MAX_KEYWORD_LENGTH];
 };
 
 struct guild_info_type {
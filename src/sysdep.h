@@ -585,6 +585,10 @@ struct in_addr {
    int accept(socket_t s, struct sockaddr *addr, int *addrlen);
 #endif
 
+#if defined(HAVE_ACCEPT4) && defined(NEED_ACCEPT4_PROTO)
+   int accept4(socket_t s, struct sockaddr *addr, socklen_t *addrlen, int flags);
+#endif
+
 #ifdef NEED_BIND_PROTO
    int bind(socket_t s, const struct sockaddr *name, int namelen);
 #endif
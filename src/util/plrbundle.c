@@ -0,0 +1,319 @@
+/* ************************************************************************
+*  file: plrbundle.c                                    Part of CircleMUD *
+*  Usage: convert player rent/alias/eqset files to and from bundles       *
+*  All Rights Reserved                                                    *
+*  Copyright (C) 1993 The Trustees of The Johns Hopkins University        *
+************************************************************************* */
+
+/*
+ * Run from the lib directory with the MUD shut down.
+ *
+ *   plrbundle        move plrobjs/, plralias/ and plreqsets/ files into
+ *                    plrbundles/ (see player_bundles in config.c)
+ *   plrbundle -u     split plrbundles/ back out into the old files
+ *   -k               keep the files that were converted from
+ */
+
+#include "conf.h"
+#include "sysdep.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "structs.h"
+#include "db.h"
+#include "bundle.h"
+
+const char *letter_dirs[] = { "A-E", "F-J", "K-O", "P-T", "U-Z", "ZZZ" };
+#define NUM_LETTER_DIRS	(int)(sizeof(letter_dirs) / sizeof(letter_dirs[0]))
+
+/* Old-style file for each bundle section type. */
+const struct {
+  const char *prefix;
+  const char *suffix;
+} section_files[NUM_BUNDLE_SECTIONS] = {
+  { LIB_PLROBJS,   SUF_OBJS  },	/* BUNDLE_OBJECTS */
+  { LIB_PLRALIAS,  SUF_ALIAS },	/* BUNDLE_ALIASES */
+  { LIB_PLREQSETS, SUF_EQSET }	/* BUNDLE_EQSETS  */
+};
+
+int keep_old = 0;
+
+void *xalloc(void *ptr, size_t size);
+
+int read_file(const char *path, char **data, size_t *length);
+int write_file(const char *path, const char *data, size_t length);
+void make_dir(const char *prefix, int dir);
+int bundle(int dir);
+int unbundle(int dir);
+
+
+int main(int argc, char **argv)
+{
+  int i, undo = 0, done = 0;
+
+  for (i = 1; i < argc; i++) {
+    if (!strcmp(argv[i], "-u"))
+      undo = 1;
+    else if (!strcmp(argv[i], "-k"))
+      keep_old = 1;
+    else {
+      fprintf(stderr, "Usage: %s [-u] [-k]\n", argv[0]);
+      exit(1);
+    }
+  }
+
+  for (i = 0; i < NUM_LETTER_DIRS; i++)
+    done += undo ? unbundle(i) : bundle(i);
+
+  printf("%d player%s %s.\n", done, done == 1 ? "" : "s",
+	undo ? "unbundled" : "bundled");
+  return (0);
+}
+
+
+void *xalloc(void *ptr, size_t size)
+{
+  if (!(ptr = realloc(ptr, size))) {
+    perror("plrbundle");
+    exit(1);
+  }
+  return (ptr);
+}
+
+
+/* Read a whole file.  Returns -1 (errno set) if it can't be read. */
+int read_file(const char *path, char **data, size_t *length)
+{
+  FILE *fl;
+  long size;
+
+  *data = NULL;
+  *length = 0;
+
+  if (!(fl = fopen(path, "rb")))
+    return (-1);
+  fseek(fl, 0L, SEEK_END);
+  size = ftell(fl);
+  rewind(fl);
+
+  if (size > 0) {
+    *data = xalloc(NULL, size);
+    if (fread(*data, 1, size, fl) != (size_t)size) {
+      free(*data);
+      *data = NULL;
+      fclose(fl);
+      errno = EIO;
+      return (-1);
+    }
+    *length = size;
+  }
+  fclose(fl);
+  return (0);
+}
+
+
+/* Write a file under a temporary name and rename it into place. */
+int write_file(const char *path, const char *data, size_t length)
+{
+  char tmpname[PATH_MAX + 8];
+  FILE *fl;
+
+  snprintf(tmpname, sizeof(tmpname), "%s.new", path);
+  if (!(fl = fopen(tmpname, "wb"))) {
+    perror(tmpname);
+    return (-1);
+  }
+  if (fwrite(data, 1, length, fl) != length || fclose(fl) != 0 ||
+      rename(tmpname, path) < 0) {
+    perror(path);
+    remove(tmpname);
+    return (-1);
+  }
+  return (0);
+}
+
+
+/* plreqsets/ only gets created once somebody saves a set. */
+void make_dir(const char *prefix, int dir)
+{
+  char path[PATH_MAX];
+
+  mkdir(prefix, 0755);
+  snprintf(path, sizeof(path), "%s%s", prefix, letter_dirs[dir]);
+  mkdir(path, 0755);
+}
+
+
+static int namecmp(const void *a, const void *b)
+{
+  return (strcmp(*(const char * const *)a, *(const char * const *)b));
+}
+
+
+int bundle(int dir)
+{
+  char path[PATH_MAX], **names = NULL, *data[NUM_BUNDLE_SECTIONS];
+  size_t length[NUM_BUNDLE_SECTIONS], len, suflen, total;
+  struct bundle_header hdr;
+  struct bundle_section sect;
+  struct dirent *de;
+  int i, n, t, nnames = 0, cap = 0, done = 0, ok;
+  DIR *dp;
+  char *buf, *p;
+
+  /* Everyone in this letter directory with at least one old-style file. */
+  for (t = 0; t < NUM_BUNDLE_SECTIONS; t++) {
+    snprintf(path, sizeof(path), "%s%s", section_files[t].prefix, letter_dirs[dir]);
+    if (!(dp = opendir(path)))
+      continue;
+    suflen = strlen(section_files[t].suffix) + 1;
+    while ((de = readdir(dp)) != NULL) {
+      len = strlen(de->d_name);
+      if (len <= suflen || de->d_name[len - suflen] != '.' ||
+	  strcmp(de->d_name + len - suflen + 1, section_files[t].suffix))
+	continue;
+      if (nnames >= cap) {
+	cap = cap ? cap * 2 : 64;
+	names = xalloc(names, cap * sizeof(char *));
+      }
+      names[nnames] = strdup(de->d_name);
+      names[nnames++][len - suflen] = '\0';
+    }
+    closedir(dp);
+  }
+  qsort(names, nnames, sizeof(char *), namecmp);
+
+  for (n = 0; n < nnames; n++) {
+    if (n > 0 && !strcmp(names[n], names[n - 1]))
+      continue;
+
+    snprintf(path, sizeof(path), "%s%s/%s.%s", LIB_PLRBUNDLES, letter_dirs[dir], names[n], SUF_BUNDLE);
+    if (access(path, F_OK) == 0) {
+      printf("%s already has a bundle, skipping.\n", names[n]);
+      continue;
+    }
+
+    ok = 1;
+    hdr.magic = BUNDLE_MAGIC;
+    hdr.version = BUNDLE_VERSION;
+    hdr.num_sections = 0;
+    total = sizeof(hdr);
+    for (t = 0; t < NUM_BUNDLE_SECTIONS; t++) {
+      char oldpath[PATH_MAX];
+
+      snprintf(oldpath, sizeof(oldpath), "%s%s/%s.%s", section_files[t].prefix, letter_dirs[dir], names[n], section_files[t].suffix);
+      if (read_file(oldpath, &data[t], &length[t]) < 0 && errno != ENOENT) {
+	perror(oldpath);
+	ok = 0;
+      }
+      if (length[t]) {
+	hdr.num_sections++;
+	total += sizeof(sect) + length[t];
+      }
+    }
+
+    if (ok && hdr.num_sections) {
+      make_dir(LIB_PLRBUNDLES, dir);
+      buf = xalloc(NULL, total);
+      memcpy(buf, &hdr, sizeof(hdr));
+      p = buf + sizeof(hdr);
+      for (t = 0; t < NUM_BUNDLE_SECTIONS; t++) {
+	if (!length[t])
+	  continue;
+	sect.type = t;
+	sect.length = length[t];
+	memcpy(p, &sect, sizeof(sect));
+	memcpy(p + sizeof(sect), data[t], length[t]);
+	p += sizeof(sect) + length[t];
+      }
+      ok = (write_file(path, buf, total) == 0);
+      free(buf);
+    }
+
+    for (t = 0; t < NUM_BUNDLE_SECTIONS; t++) {
+      if (ok && !keep_old) {
+	snprintf(path, sizeof(path), "%s%s/%s.%s", section_files[t].prefix, letter_dirs[dir], names[n], section_files[t].suffix);
+	remove(path);
+      }
+      if (data[t])
+	free(data[t]);
+    }
+    if (ok)
+      done++;
+    else
+      printf("%s not converted.\n", names[n]);
+  }
+
+  for (i = 0; i < nnames; i++)
+    free(names[i]);
+  if (names)
+    free(names);
+  return (done);
+}
+
+
+int unbundle(int dir)
+{
+  char path[PATH_MAX], oldpath[PATH_MAX], *buf;
+  struct bundle_header hdr;
+  struct bundle_section sect;
+  struct dirent *de;
+  size_t len, pos, suflen = strlen("." SUF_BUNDLE);
+  int i, done = 0, ok;
+  DIR *dp;
+
+  snprintf(path, sizeof(path), "%s%s", LIB_PLRBUNDLES, letter_dirs[dir]);
+  if (!(dp = opendir(path)))
+    return (0);
+
+  while ((de = readdir(dp)) != NULL) {
+    len = strlen(de->d_name);
+    if (len <= suflen || strcmp(de->d_name + len - suflen, "." SUF_BUNDLE))
+      continue;
+
+    snprintf(path, sizeof(path), "%s%s/%s", LIB_PLRBUNDLES, letter_dirs[dir], de->d_name);
+    de->d_name[len - suflen] = '\0';
+    if (read_file(path, &buf, &len) < 0) {
+      perror(path);
+      continue;
+    }
+
+    ok = (len >= sizeof(hdr));
+    if (ok) {
+      memcpy(&hdr, buf, sizeof(hdr));
+      ok = (hdr.magic == BUNDLE_MAGIC && hdr.version == BUNDLE_VERSION);
+    }
+    for (pos = sizeof(hdr), i = 0; ok && i < hdr.num_sections; i++) {
+      if (len - pos < sizeof(sect)) {
+	ok = 0;
+	break;
+      }
+      memcpy(&sect, buf + pos, sizeof(sect));
+      pos += sizeof(sect);
+      if (sect.length < 0 || len - pos < (size_t)sect.length) {
+	ok = 0;
+	break;
+      }
+      if (sect.type >= 0 && sect.type < NUM_BUNDLE_SECTIONS) {
+	make_dir(section_files[sect.type].prefix, dir);
+	snprintf(oldpath, sizeof(oldpath), "%s%s/%s.%s", section_files[sect.type].prefix, letter_dirs[dir], de->d_name, section_files[sect.type].suffix);
+	if (write_file(oldpath, buf + pos, sect.length) < 0)
+	  ok = 0;
+      }
+      pos += sect.length;
+    }
+
+    if (buf)
+      free(buf);
+    if (!ok) {
+      printf("%s: bad or unwritable bundle, left in place.\n", path);
+      continue;
+    }
+    if (!keep_old)
+      remove(path);
+    done++;
+  }
+  closedir(dp);
+  return (done);
+}
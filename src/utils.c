@@ -458,6 +458,7 @@ void stop_follower(struct char_data *ch)
 
   ch->master = NULL;
   REMOVE_BIT(AFF_FLAGS(ch), AFF_CHARM | AFF_GROUP);
+  char_lists_update(ch);
 }
 
 
@@ -502,6 +503,7 @@ void add_follower(struct char_data *ch, struct char_data *leader)
   }
 
   ch->master = leader;
+  char_lists_update(ch);
 
   CREATE(k, struct follow_type, 1);
 
@@ -574,6 +576,10 @@ int get_filename(char *filename, size_t fbufsize, int mode, const char *orig_nam
     prefix = LIB_PLREQSETS;
     suffix = SUF_EQSET;
     break;
+  case BUNDLE_FILE:
+    prefix = LIB_PLRBUNDLES;
+    suffix = SUF_BUNDLE;
+    break;
   default:
     return (0);
   }
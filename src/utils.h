@@ -107,6 +107,7 @@ void	update_pos(struct char_data *victim);
 #define ETEXT_FILE	1
 #define ALIAS_FILE	2
 #define EQSET_FILE	3
+#define BUNDLE_FILE	4
 
 /* breadth-first searching */
 #define BFS_ERROR		(-1)
@@ -250,6 +251,7 @@ void	update_pos(struct char_data *victim);
 	((room_vnum)(VALID_ROOM_RNUM(rnum) ? world[(rnum)].number : NOWHERE))
 #define GET_ROOM_SPEC(room) \
 	(VALID_ROOM_RNUM(room) ? world[(room)].func : NULL)
+#define GET_ROOM_SPEC_TRIG(room)	(world[(room)].spec_trig)
 
 
 /* char utils ************************************************************/
@@ -302,6 +304,9 @@ void	update_pos(struct char_data *victim);
 #define GET_HITROLL(ch)	  ((ch)->points.hitroll)
 #define GET_DAMROLL(ch)   ((ch)->points.damroll)
 
+/* Anything changing what compute_combat() reads calls this. */
+#define INVALIDATE_COMBAT(ch)	((ch)->combat.valid = FALSE)
+
 #define GET_POS(ch)	  ((ch)->char_specials.position)
 #define GET_IDNUM(ch)	  ((ch)->char_specials.saved.idnum)
 #define IS_CARRYING_W(ch) ((ch)->char_specials.carry_weight)
@@ -331,6 +336,7 @@ void	update_pos(struct char_data *victim);
 #define GET_EQ(ch, i)		((ch)->equipment[i])
 
 #define GET_MOB_SPEC(ch)	(IS_MOB(ch) ? mob_index[(ch)->nr].func : NULL)
+#define GET_MOB_SPEC_TRIG(ch)	(mob_index[(ch)->nr].spec_trig)
 #define GET_MOB_RNUM(mob)	((mob)->nr)
 #define GET_MOB_VNUM(mob)	(IS_MOB(mob) ? \
 				 mob_index[GET_MOB_RNUM(mob)].vnum : NOBODY)
@@ -395,6 +401,17 @@ void	update_pos(struct char_data *victim);
 				obj_index[GET_OBJ_RNUM(obj)].vnum : NOTHING)
 #define GET_OBJ_SPEC(obj)	(VALID_OBJ_RNUM(obj) ? \
 				obj_index[GET_OBJ_RNUM(obj)].func : NULL)
+#define GET_OBJ_SPEC_TRIG(obj)	(obj_index[GET_OBJ_RNUM(obj)].spec_trig)
+
+/*
+ * Does a spec proc with these triggers want calling for cmd (0 for a
+ * pulse)?  A mob's proc with SPEC_SELF also hears the mob's own commands.
+ */
+#define SPEC_WANTS(trig, cmd) \
+	(!(trig) || ((cmd) ? (trig)->cmd_set[(cmd)] : IS_SET((trig)->flags, SPEC_PULSE)))
+#define MOB_SPEC_WANTS(mob, ch, cmd) \
+	(SPEC_WANTS(GET_MOB_SPEC_TRIG(mob), (cmd)) || \
+	 ((mob) == (ch) && IS_SET(GET_MOB_SPEC_TRIG(mob)->flags, SPEC_SELF)))
 
 #define IS_CORPSE(obj)		(GET_OBJ_TYPE(obj) == ITEM_CONTAINER && \
 					GET_OBJ_VAL((obj), 3) == 1)
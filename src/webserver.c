@@ -15,12 +15,12 @@
 #ifdef HAVE_CIVETWEB
 
 #include <civetweb.h>
-#include <pthread.h>
 #include <string.h>
 #include <stdio.h>
 
 #define WEB_PORT   "127.0.0.1:4445"
 #define MUDWHO_URI "/mud/who.html"
+#define MUDWHO_JSON_URI "/mud/who.json"
 #define WHO_MAX    200
 
 extern struct descriptor_data *descriptor_list;
@@ -40,20 +40,182 @@ struct who_snapshot {
   int count;
 };
 
-static struct who_snapshot who_snap;
-static pthread_mutex_t     who_mutex = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * The who list changes once a second at most, so the game loop renders
+ * it (as HTML and as JSON) only when it does change, and the HTTP
+ * threads just send the current page, or a 304 if the client already
+ * has it.  Pages are never changed once published.
+ *
+ * Readers don't lock.  They count themselves in who_readers, load
+ * who_page and take a reference on it; the game loop swaps in a new page
+ * and frees a retired one only when it has no references and nobody is
+ * between loading the pointer and taking one.
+ */
+struct who_page {
+  int refs;			/* readers sending it */
+  unsigned long gen;
+  char etag[48];
+  char modified[40];		/* Last-Modified */
+  char *html, *json;
+  int html_len, json_len;
+  struct who_page *next;	/* on the retired list */
+};
+
+static struct who_page *who_page = NULL;
+static struct who_page *who_retired = NULL;	/* game thread only */
+static int who_readers = 0;
+static unsigned long who_gen = 0;
+
+/* Growing output buffer for rendering a page. */
+struct who_buf {
+  char *data;
+  int len, size;
+};
+
+static void wb_printf(struct who_buf *b, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+static void wb_printf(struct who_buf *b, const char *fmt, ...)
+{
+  va_list args;
+  int n;
+
+  for (;;) {
+    va_start(args, fmt);
+    n = vsnprintf(b->data + b->len, b->size - b->len, fmt, args);
+    va_end(args);
+    if (n < b->size - b->len)
+      break;
+    b->size = b->size * 2 + n;
+    RECREATE(b->data, char, b->size);
+  }
+  b->len += n;
+}
+
+/* Titles are whatever players typed, so escape them. */
+static void wb_escape(struct who_buf *b, const char *s, int json)
+{
+  for (; *s; s++)
+    switch (*s) {
+    case '<':  wb_printf(b, json ? "\\u003c" : "&lt;"); break;
+    case '>':  wb_printf(b, json ? "\\u003e" : "&gt;"); break;
+    case '&':  wb_printf(b, json ? "&" : "&amp;"); break;
+    case '"':  wb_printf(b, json ? "\\\"" : "&quot;"); break;
+    case '\\': wb_printf(b, json ? "\\\\" : "\\"); break;
+    default:
+      if ((unsigned char) *s < 0x20)
+        wb_printf(b, json ? "\\u%04x" : " ", (unsigned char) *s);
+      else
+        wb_printf(b, "%c", *s);
+      break;
+    }
+}
+
+static char *who_render_html(const struct who_snapshot *snap, int *len)
+{
+  struct who_buf b = { NULL, 0, 0 };
+  int i;
+
+  CREATE(b.data, char, b.size = 4096);
+  wb_printf(&b, "<!DOCTYPE html>\n<html>\n<head><title>Who is on the Mud?</title>\n<style>\n");
+  wb_printf(&b, "body { font-weight: 300; }\n");
+  wb_printf(&b, "table { border-collapse: collapse; }\n");
+  wb_printf(&b, "td { border: 2px solid lightblue; padding: 1px 1em; font-size: 16pt; font-weight: bold; }\n");
+  wb_printf(&b, "</style>\n</head>\n<body>\n<h1>Who is playing right now?</h1>\n<table>\n");
+
+  if (snap->count == 0)
+    wb_printf(&b, "<tr><td colspan=\"4\">Nobody is logged on at the moment.</td></tr>\n");
+  for (i = 0; i < snap->count; i++) {
+    wb_printf(&b, "<tr><td>%d</td><td>%s</td><td>%s</td><td>",
+              snap->entries[i].level, snap->entries[i].cls, snap->entries[i].name);
+    wb_escape(&b, snap->entries[i].title, FALSE);
+    wb_printf(&b, "</td></tr>\n");
+  }
+
+  wb_printf(&b, "</table>\n</body></html>\n");
+  *len = b.len;
+  return (b.data);
+}
+
+static char *who_render_json(const struct who_snapshot *snap, unsigned long gen, int *len)
+{
+  struct who_buf b = { NULL, 0, 0 };
+  int i;
+
+  CREATE(b.data, char, b.size = 4096);
+  wb_printf(&b, "{\"generation\":%lu,\"count\":%d,\"players\":[", gen, snap->count);
+  for (i = 0; i < snap->count; i++) {
+    wb_printf(&b, "%s{\"level\":%d,\"class\":\"%s\",\"name\":\"%s\",\"title\":\"",
+              i ? "," : "", snap->entries[i].level, snap->entries[i].cls,
+              snap->entries[i].name);
+    wb_escape(&b, snap->entries[i].title, TRUE);
+    wb_printf(&b, "\"}");
+  }
+  wb_printf(&b, "]}\n");
+  *len = b.len;
+  return (b.data);
+}
+
+static void who_page_free(struct who_page *page)
+{
+  free(page->html);
+  free(page->json);
+  free(page);
+}
+
+/* Free the retired pages nobody can be sending any more. */
+static void who_reap(void)
+{
+  struct who_page **pp = &who_retired, *page;
+
+  if (__atomic_load_n(&who_readers, __ATOMIC_SEQ_CST))
+    return;
+  while ((page = *pp)) {
+    if (__atomic_load_n(&page->refs, __ATOMIC_SEQ_CST))
+      pp = &page->next;
+    else {
+      *pp = page->next;
+      who_page_free(page);
+    }
+  }
+}
+
+static void who_publish(const struct who_snapshot *snap)
+{
+  static time_t boot = 0;
+  struct who_page *page, *old;
+  time_t now = time(0);
+  struct tm tm;
+
+  if (!boot)
+    boot = now;
+
+  CREATE(page, struct who_page, 1);
+  page->gen = ++who_gen;
+  /* The boot time keeps one run's generation 1 from matching another's. */
+  snprintf(page->etag, sizeof(page->etag), "\"%lx-%lu\"", (unsigned long) boot, page->gen);
+  gmtime_r(&now, &tm);
+  strftime(page->modified, sizeof(page->modified), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+  page->html = who_render_html(snap, &page->html_len);
+  page->json = who_render_json(snap, page->gen, &page->json_len);
+
+  old = __atomic_exchange_n(&who_page, page, __ATOMIC_SEQ_CST);
+  if (old) {
+    old->next = who_retired;
+    who_retired = old;
+  }
+}
 
 /*
  * Called from the game loop (single-threaded) — reads MUD data structures
- * without any lock, then swaps the result into who_snap under a brief mutex.
+ * without any lock, and publishes a new page only if the list changed.
  */
 void webserver_refresh_who(void)
 {
+  static struct who_snapshot last;
   struct who_snapshot snap;
   struct descriptor_data *d;
   struct char_data *ch;
 
-  snap.count = 0;
+  memset(&snap, 0, sizeof(snap));
   for (d = descriptor_list; d && snap.count < WHO_MAX; d = d->next) {
     if (d->connected)
       continue;
@@ -70,61 +232,275 @@ void webserver_refresh_who(void)
             sizeof(snap.entries[0].name)  - 1);
     strncpy(snap.entries[snap.count].title, GET_TITLE(ch) ? GET_TITLE(ch) : "",
             sizeof(snap.entries[0].title) - 1);
-    snap.entries[snap.count].cls  [sizeof(snap.entries[0].cls)   - 1] = '\0';
-    snap.entries[snap.count].name [sizeof(snap.entries[0].name)  - 1] = '\0';
-    snap.entries[snap.count].title[sizeof(snap.entries[0].title) - 1] = '\0';
     snap.count++;
   }
 
-  pthread_mutex_lock(&who_mutex);
-  who_snap = snap;
-  pthread_mutex_unlock(&who_mutex);
+  who_reap();
+  if (who_page && snap.count == last.count &&
+      !memcmp(snap.entries, last.entries, snap.count * sizeof(struct who_entry)))
+    return;
+
+  who_publish(&snap);
+  last = snap;
+}
+
+/* Does the client already have this page? */
+static int who_not_modified(struct mg_connection *conn, const struct who_page *page)
+{
+  const char *inm = mg_get_header(conn, "If-None-Match");
+  const char *ims = mg_get_header(conn, "If-Modified-Since");
+
+  if (inm)
+    return (!strcmp(inm, "*") || strstr(inm, page->etag) != NULL);
+  /* Clients send back the Last-Modified they were given. */
+  return (ims && !strcmp(ims, page->modified));
+}
+
+static void who_send(struct mg_connection *conn, int json)
+{
+  struct who_page *page;
+
+  __atomic_add_fetch(&who_readers, 1, __ATOMIC_SEQ_CST);
+  page = __atomic_load_n(&who_page, __ATOMIC_SEQ_CST);
+  if (page)
+    __atomic_add_fetch(&page->refs, 1, __ATOMIC_SEQ_CST);
+  __atomic_sub_fetch(&who_readers, 1, __ATOMIC_SEQ_CST);
+
+  if (!page) {
+    mg_printf(conn, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+    return;
+  }
+
+  if (who_not_modified(conn, page))
+    mg_printf(conn,
+        "HTTP/1.1 304 Not Modified\r\n"
+        "ETag: %s\r\n"
+        "Last-Modified: %s\r\n"
+        "Cache-Control: no-cache\r\n"
+        "\r\n", page->etag, page->modified);
+  else {
+    mg_printf(conn,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: %s; charset=utf-8\r\n"
+        "Content-Length: %d\r\n"
+        "ETag: %s\r\n"
+        "Last-Modified: %s\r\n"
+        "Cache-Control: no-cache\r\n"
+        "\r\n", json ? "application/json" : "text/html",
+        json ? page->json_len : page->html_len, page->etag, page->modified);
+    mg_write(conn, json ? page->json : page->html, json ? page->json_len : page->html_len);
+  }
+
+  __atomic_sub_fetch(&page->refs, 1, __ATOMIC_SEQ_CST);
 }
 
 static int mudwho_handler(struct mg_connection *conn, void *cbdata)
 {
-  struct who_snapshot snap;
-  char *buf;
-  int pos = 0, i;
+  who_send(conn, FALSE);
+  return 1;
+}
 
-  pthread_mutex_lock(&who_mutex);
-  snap = who_snap;
-  pthread_mutex_unlock(&who_mutex);
+static int mudwho_json_handler(struct mg_connection *conn, void *cbdata)
+{
+  who_send(conn, TRUE);
+  return 1;
+}
+
+/*
+ * Live status feed, as server-sent events on /mud/events.
+ *
+ * The game loop appends events to a ring and never waits for anyone.
+ * Each slot carries the number of the event in it; the game loop zeroes
+ * that before rewriting the slot and sets it when done, so a reader that
+ * copies a slot and finds the number unchanged knows it got a whole event.
+ * Every listener has its own HTTP thread and position; one that falls a
+ * whole ring behind has missed events and is cut off.
+ */
+#define MUDEVENTS_URI	"/mud/events"
+#define FEED_SIZE	1024		/* must be a power of two */
+#define FEED_LINE	320
+#define FEED_CLIENTS	8		/* each ties up an HTTP thread */
+#define FEED_IDLE_MS	100
+#define FEED_KEEPALIVE	150		/* idle polls between keepalives */
+
+struct feed_slot {
+  unsigned long seq;		/* 0 while being written */
+  int len;
+  char line[FEED_LINE];
+};
 
-#define RESPONSE_BUF_SIZE 65536
-  buf = malloc(RESPONSE_BUF_SIZE);
-  if (!buf) {
-    mg_printf(conn, "HTTP/1.1 500 Internal Server Error\r\nContent-Length: 0\r\n\r\n");
+static struct feed_slot feed_ring[FEED_SIZE];
+static unsigned long feed_head = 0;	/* last event written */
+static int feed_clients = 0;
+static int feed_stopping = 0;
+
+static void feed_post(const char *type, const char *fmt, ...) __attribute__ ((format (printf, 2, 3)));
+static void feed_post(const char *type, const char *fmt, ...)
+{
+  struct feed_slot *slot;
+  unsigned long seq;
+  va_list args;
+  int len;
+
+  /* Nobody would see it. */
+  if (!web_ctx || !__atomic_load_n(&feed_clients, __ATOMIC_RELAXED))
+    return;
+
+  seq = feed_head + 1;
+  slot = &feed_ring[seq & (FEED_SIZE - 1)];
+  __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  len = snprintf(slot->line, FEED_LINE, "id: %lu\nevent: %s\ndata: ", seq, type);
+  va_start(args, fmt);
+  len += vsnprintf(slot->line + len, FEED_LINE - len, fmt, args);
+  va_end(args);
+  if (len > FEED_LINE - 3)	/* cut short; still end the event */
+    len = FEED_LINE - 3;
+  strcpy(slot->line + len, "\n\n");
+  slot->len = len + 2;
+
+  __atomic_store_n(&slot->seq, seq, __ATOMIC_RELEASE);
+  __atomic_store_n(&feed_head, seq, __ATOMIC_RELEASE);
+}
+
+/* Copy event 'seq' out of the ring; FALSE if it has been overwritten. */
+static int feed_read(unsigned long seq, char *line, int *len)
+{
+  struct feed_slot *slot = &feed_ring[seq & (FEED_SIZE - 1)];
+
+  if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != seq)
+    return (FALSE);
+  *len = MIN(slot->len, FEED_LINE);
+  memcpy(line, slot->line, *len);
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  return (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) == seq);
+}
+
+/* Names and zone names go into JSON strings. */
+static const char *feed_escape(const char *s, char *buf, size_t size)
+{
+  size_t i = 0;
+
+  for (; s && *s && i + 7 < size; s++)
+    if (*s == '"' || *s == '\\')
+      i += sprintf(buf + i, "\\%c", *s);
+    else if ((unsigned char) *s < 0x20)
+      i += sprintf(buf + i, "\\u%04x", (unsigned char) *s);
+    else
+      buf[i++] = *s;
+  buf[i] = '\0';
+  return (buf);
+}
+
+static int feed_hidden(struct char_data *ch)
+{
+  return (!IS_NPC(ch) && GET_LEVEL(ch) >= LVL_IMMORT && GET_INVIS_LEV(ch));
+}
+
+/*
+ * Each login a listener sees is matched by exactly one logout: whoever
+ * posts the logout first (quit, lost link, rent, idling out or
+ * extract_char_final()) clears feed_online and the rest post nothing.
+ */
+void webserver_feed_login(struct char_data *ch, int reconnect)
+{
+  if (IS_NPC(ch) || ch->player_specials->feed_online || feed_hidden(ch))
+    return;
+  ch->player_specials->feed_online = TRUE;
+  feed_post("login", "{\"name\":\"%s\",\"level\":%d,\"class\":\"%s\",\"reconnect\":%s}",
+	GET_NAME(ch), GET_LEVEL(ch), CLASS_ABBR(ch), reconnect ? "true" : "false");
+}
+
+void webserver_feed_logout(struct char_data *ch, const char *how)
+{
+  if (IS_NPC(ch) || !ch->player_specials->feed_online)
+    return;
+  ch->player_specials->feed_online = FALSE;
+  feed_post("logout", "{\"name\":\"%s\",\"how\":\"%s\"}", GET_NAME(ch), how);
+}
+
+void webserver_feed_death(struct char_data *ch, struct char_data *killer)
+{
+  char name[2 * MAX_INPUT_LENGTH], by[2 * MAX_INPUT_LENGTH];
+
+  feed_post("death", "{\"name\":\"%s\",\"npc\":%s,\"vnum\":%d,\"room\":%d,\"killer\":%s%s%s}",
+	feed_escape(GET_NAME(ch), name, sizeof(name)),
+	IS_NPC(ch) ? "true" : "false", IS_NPC(ch) ? GET_MOB_VNUM(ch) : -1,
+	GET_ROOM_VNUM(IN_ROOM(ch)), killer ? "\"" : "",
+	killer ? feed_escape(GET_NAME(killer), by, sizeof(by)) : "null", killer ? "\"" : "");
+}
+
+void webserver_feed_reset(zone_rnum zone)
+{
+  char name[2 * MAX_INPUT_LENGTH];
+
+  feed_post("reset", "{\"zone\":%d,\"name\":\"%s\"}", zone_table[zone].number,
+	feed_escape(zone_table[zone].name, name, sizeof(name)));
+}
+
+void webserver_feed_usage(int connected, int playing)
+{
+  feed_post("usage", "{\"sockets\":%d,\"playing\":%d}", connected, playing);
+}
+
+/*
+ * One listener.  This runs on its HTTP thread until the client goes away,
+ * falls behind, or the server stops; the game loop never sees it.
+ */
+static int mudevents_handler(struct mg_connection *conn, void *cbdata)
+{
+  const char *last = mg_get_header(conn, "Last-Event-ID");
+  char line[FEED_LINE];
+  unsigned long next, head;
+  int len, idle = 0;
+
+  if (__atomic_add_fetch(&feed_clients, 1, __ATOMIC_SEQ_CST) > FEED_CLIENTS) {
+    __atomic_sub_fetch(&feed_clients, 1, __ATOMIC_SEQ_CST);
+    mg_printf(conn, "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
     return 1;
   }
 
-#define W(fmt, ...) pos += snprintf(buf + pos, RESPONSE_BUF_SIZE - pos, fmt, ##__VA_ARGS__)
-
-  W("<!DOCTYPE html>\n<html>\n<head><title>Who is on the Mud?</title>\n<style>\n");
-  W("body { font-weight: 300; }\n");
-  W("table { border-collapse: collapse; }\n");
-  W("td { border: 2px solid lightblue; padding: 1px 1em; font-size: 16pt; font-weight: bold; }\n");
-  W("</style>\n</head>\n<body>\n<h1>Who is playing right now?</h1>\n<table>\n");
-
-  if (snap.count == 0) {
-    W("<tr><td colspan=\"4\">Nobody is logged on at the moment.</td></tr>\n");
-  } else {
-    for (i = 0; i < snap.count; i++)
-      W("<tr><td>%d</td><td>%s</td><td>%s</td><td>%s</td></tr>\n",
-        snap.entries[i].level, snap.entries[i].cls,
-        snap.entries[i].name,  snap.entries[i].title);
+  mg_printf(conn,
+	"HTTP/1.1 200 OK\r\n"
+	"Content-Type: text/event-stream; charset=utf-8\r\n"
+	"Cache-Control: no-cache\r\n"
+	"Connection: close\r\n"
+	"\r\n"
+	"retry: 5000\n\n");
+
+  /* A reconnecting client picks up where it left off, if it still can. */
+  head = __atomic_load_n(&feed_head, __ATOMIC_ACQUIRE);
+  next = head + 1;
+  if (last && *last) {
+    unsigned long seen = strtoul(last, NULL, 10);
+
+    if (seen <= head && head - seen < FEED_SIZE)
+      next = seen + 1;
   }
 
-  W("</table>\n</body></html>\n");
-#undef W
+  while (!__atomic_load_n(&feed_stopping, __ATOMIC_RELAXED)) {
+    head = __atomic_load_n(&feed_head, __ATOMIC_ACQUIRE);
+    if (next > head) {
+      if (++idle >= FEED_KEEPALIVE) {	/* also notices a closed socket */
+	idle = 0;
+	if (mg_printf(conn, ": keepalive\n\n") <= 0)
+	  break;
+      }
+      usleep(FEED_IDLE_MS * 1000);
+      continue;
+    }
+    idle = 0;
+    if (head - next >= FEED_SIZE || !feed_read(next, line, &len)) {
+      mg_printf(conn, "event: overflow\ndata: {\"missed\":%lu}\n\n", head - next + 1);
+      break;
+    }
+    if (mg_write(conn, line, len) <= 0)
+      break;
+    next++;
+  }
 
-  mg_printf(conn,
-      "HTTP/1.1 200 OK\r\n"
-      "Content-Type: text/html; charset=utf-8\r\n"
-      "Content-Length: %d\r\n"
-      "\r\n", pos);
-  mg_write(conn, buf, pos);
-  free(buf);
+  __atomic_sub_fetch(&feed_clients, 1, __ATOMIC_SEQ_CST);
   return 1;
 }
 
@@ -148,7 +524,10 @@ void webserver_init(const char *data_dir)
     return;
   }
 
+  webserver_refresh_who();	/* so there's a page from the start */
   mg_set_request_handler(web_ctx, MUDWHO_URI, mudwho_handler, NULL);
+  mg_set_request_handler(web_ctx, MUDWHO_JSON_URI, mudwho_json_handler, NULL);
+  mg_set_request_handler(web_ctx, MUDEVENTS_URI, mudevents_handler, NULL);
   wolc_register_handlers(web_ctx);
   log("WEBSERVER: Listening on http://%s/", WEB_PORT);
 }
@@ -156,11 +535,20 @@ void webserver_init(const char *data_dir)
 void webserver_shutdown(void)
 {
   if (web_ctx) {
+    __atomic_store_n(&feed_stopping, 1, __ATOMIC_RELAXED);	/* let listeners go */
     mg_stop(web_ctx);
     web_ctx = NULL;
     log("WEBSERVER: Stopped.");
   }
   wolc_shutdown();
+
+  /* The HTTP threads are gone, so nobody holds a page now. */
+  if (who_page) {
+    who_page->next = who_retired;
+    who_retired = who_page;
+    who_page = NULL;
+  }
+  who_reap();
 }
 
 #else /* HAVE_CIVETWEB not defined — empty stubs */
@@ -168,5 +556,10 @@ void webserver_shutdown(void)
 void webserver_init(const char *data_dir) { }
 void webserver_shutdown(void)             { }
 void webserver_refresh_who(void)          { }
+void webserver_feed_login(struct char_data *ch, int reconnect) { }
+void webserver_feed_logout(struct char_data *ch, const char *how) { }
+void webserver_feed_death(struct char_data *ch, struct char_data *killer) { }
+void webserver_feed_reset(zone_rnum zone) { }
+void webserver_feed_usage(int connected, int playing) { }
 
 #endif /* HAVE_CIVETWEB */
@@ -11,4 +11,11 @@ void webserver_shutdown(void);
 void webserver_refresh_who(void);
 void webserver_olc_heartbeat(void);
 
+/* Events for the live status feed; game loop only. */
+void webserver_feed_login(struct char_data *ch, int reconnect);
+void webserver_feed_logout(struct char_data *ch, const char *how);
+void webserver_feed_death(struct char_data *ch, struct char_data *killer);
+void webserver_feed_reset(zone_rnum zone);
+void webserver_feed_usage(int connected, int playing);
+
 #endif /* __WEBSERVER_H__ */
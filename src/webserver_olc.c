@@ -9,7 +9,10 @@
 #include "utils.h"
 #include "comm.h"
 #include "db.h"
+#include "handler.h"
 #include "olc.h"
+#include "pwhash.h"
+#include "json.h"
 #include "webserver_olc.h"
 
 #ifdef HAVE_CIVETWEB
@@ -38,17 +41,13 @@ extern struct obj_data *obj_proto;
 extern struct index_data *obj_index;
 extern obj_rnum top_of_objt;
 
-/* request types */
+/* request types; reads don't need one (see the snapshot below) */
 #define WOLC_REQ_AUTH         1
-#define WOLC_REQ_GET_ZONES    2
-#define WOLC_REQ_GET_ROOM     3
-#define WOLC_REQ_SET_ROOM     4
-#define WOLC_REQ_GET_MOB      5
-#define WOLC_REQ_SET_MOB      6
-#define WOLC_REQ_GET_OBJ      7
-#define WOLC_REQ_SET_OBJ      8
-#define WOLC_REQ_GET_ZCMDS    9
-#define WOLC_REQ_SET_ZCMDS   10
+#define WOLC_REQ_SET_ROOM     2
+#define WOLC_REQ_SET_MOB      3
+#define WOLC_REQ_SET_OBJ      4
+#define WOLC_REQ_SET_ZCMDS    5
+#define WOLC_REQ_BULK         6
 
 /* status codes */
 #define WOLC_OK           0
@@ -57,19 +56,27 @@ extern obj_rnum top_of_objt;
 #define WOLC_ERR_BADPW    3
 #define WOLC_ERR_NOUSER   4
 #define WOLC_ERR_INTERNAL 5
+#define WOLC_ERR_BADREQ   6
 
 #define WOLC_MAX_SESSIONS 64
 #define WOLC_SESSION_TTL  3600
 #define WOLC_TOKEN_LEN    32
 
+#define WOLC_BULK_MAX     (4 * 1024 * 1024)   /* largest bulk PUT body */
+#define WOLC_CHUNK        16384               /* bulk GET chunk size */
+
 struct wolc_request {
     int  type;
     int  vnum;
+    int  lo, hi;            /* bulk: vnum range when vnum (a zone) is -1 */
     int  pfilepos;
     int  level;
     char *json_body;
+    struct json_doc json;   /* tokens over json_body */
+    int  json_obj;          /* the object to apply */
     char auth_name[MAX_NAME_LENGTH + 1];
     char auth_pw[MAX_INPUT_LENGTH];
+    char auth_pwd[MAX_PWD_LENGTH + 1];
     /* response */
     int  status;
     char *response_json;
@@ -164,121 +171,6 @@ static void jb_escape_str(struct jbuf *b, const char *src)
     jb_append(b, "\"");
 }
 
-/* ======================================================================
- * JSON parser (minimal)
- * ====================================================================== */
-
-static const char *jp_skip(const char *p)
-{
-    while (p && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) p++;
-    return p;
-}
-
-static const char *jp_find_key(const char *json, const char *key)
-{
-    char q[256];
-    snprintf(q, sizeof(q), "\"%s\"", key);
-    const char *p = strstr(json, q);
-    if (!p) return NULL;
-    p += strlen(q);
-    p = jp_skip(p);
-    if (!p || *p != ':') return NULL;
-    return jp_skip(p + 1);
-}
-
-static char *json_get_str(const char *json, const char *key)
-{
-    const char *p = jp_find_key(json, key);
-    if (!p || *p != '"') return NULL;
-    p++;
-    int cap = 4096;
-    char *out = malloc(cap);
-    int pos = 0;
-    while (*p && *p != '"') {
-        if (pos + 8 >= cap) { cap *= 2; out = realloc(out, cap); }
-        if (*p == '\\') {
-            p++;
-            switch (*p) {
-                case '"':  out[pos++] = '"';  break;
-                case '\\': out[pos++] = '\\'; break;
-                case '/':  out[pos++] = '/';  break;
-                case 'n':  out[pos++] = '\n'; break;
-                case 'r':  out[pos++] = '\r'; break;
-                case 't':  out[pos++] = '\t'; break;
-                default:   out[pos++] = *p;   break;
-            }
-            if (*p) p++;
-        } else {
-            out[pos++] = *p++;
-        }
-    }
-    out[pos] = '\0';
-    return out;
-}
-
-static int json_get_int(const char *json, const char *key, int *out)
-{
-    const char *p = jp_find_key(json, key);
-    if (!p) return 0;
-    char *end;
-    long v = strtol(p, &end, 10);
-    if (end == p) return 0;
-    *out = (int)v;
-    return 1;
-}
-
-static const char *json_get_array(const char *json, const char *key)
-{
-    const char *p = jp_find_key(json, key);
-    if (!p || *p != '[') return NULL;
-    return p;
-}
-
-/* Skip a JSON value, returning pointer past it */
-static const char *jp_skip_value(const char *p)
-{
-    p = jp_skip(p);
-    if (!p) return p;
-    if (*p == '"') {
-        p++;
-        while (*p && *p != '"') { if (*p == '\\' && *(p+1)) p++; p++; }
-        if (*p == '"') p++;
-    } else if (*p == '{' || *p == '[') {
-        char open = *p, close = (*p == '{') ? '}' : ']';
-        int d = 0;
-        while (*p) {
-            if (*p == open)  d++;
-            else if (*p == close) { d--; if (!d) { p++; break; } }
-            else if (*p == '"') { p++; while (*p && *p != '"') { if (*p=='\\' && *(p+1)) p++; p++; } }
-            p++;
-        }
-    } else {
-        while (*p && *p != ',' && *p != '}' && *p != ']') p++;
-    }
-    return p;
-}
-
-/* Extract a JSON object at 'p' (pointing at '{') into a malloc'd string */
-static char *jp_extract_object(const char **pp)
-{
-    const char *p = *pp;
-    if (*p != '{') return NULL;
-    const char *start = p;
-    int d = 0;
-    while (*p) {
-        if (*p == '{') d++;
-        else if (*p == '}') { d--; if (!d) { p++; break; } }
-        else if (*p == '"') { p++; while (*p && *p != '"') { if (*p=='\\' && *(p+1)) p++; p++; } }
-        p++;
-    }
-    int len = (int)(p - start);
-    char *obj = malloc(len + 1);
-    memcpy(obj, start, len);
-    obj[len] = '\0';
-    *pp = p;
-    return obj;
-}
-
 /* ======================================================================
  * Extra description helpers
  * ====================================================================== */
@@ -297,26 +189,20 @@ static void jb_extra_descs(struct jbuf *b, struct extra_descr_data *ed)
     jb_append(b, "]");
 }
 
-static struct extra_descr_data *parse_extra_descs(const char *json)
+static struct extra_descr_data *parse_extra_descs(const struct json_doc *doc, int arr)
 {
-    const char *arr = json_get_array(json, "extra_descs");
-    if (!arr) return NULL;
-    arr++;  /* skip '[' */
     struct extra_descr_data *head = NULL, **tail = &head;
-    while (*(arr = jp_skip(arr)) && *arr != ']') {
-        if (*arr != '{') { arr = jp_skip_value(arr); continue; }
-        char *obj = jp_extract_object(&arr);
-        char *kw   = json_get_str(obj, "keyword");
-        char *desc = json_get_str(obj, "description");
+    for (int e = json_first(doc, arr); e >= 0; e = json_next(doc, arr, e)) {
+        char *kw   = json_get_str(doc, e, "keyword");
+        char *desc = json_get_str(doc, e, "description");
         if (kw && desc) {
-            struct extra_descr_data *e = calloc(1, sizeof(*e));
-            e->keyword     = strdup(kw);
-            e->description = strdup(desc);
-            *tail = e; tail = &e->next;
+            struct extra_descr_data *x = calloc(1, sizeof(*x));
+            x->keyword     = kw;
+            x->description = desc;
+            *tail = x; tail = &x->next;
+        } else {
+            free(kw); free(desc);
         }
-        free(kw); free(desc); free(obj);
-        arr = jp_skip(arr);
-        if (*arr == ',') arr++;
     }
     return head;
 }
@@ -338,6 +224,7 @@ static struct wolc_request *wolc_request_alloc(int type)
 static void wolc_request_free(struct wolc_request *r)
 {
     if (!r) return;
+    json_free(&r->json);
     free(r->json_body);
     free(r->response_json);
     pthread_mutex_destroy(&r->lock);
@@ -448,62 +335,16 @@ static int wolc_check_perm(int pfilepos, int level, int vnum)
 }
 
 /* ======================================================================
- * Game-loop handlers (called ONLY from wolc_process_requests)
+ * Renderers for the snapshot (game thread)
  * ====================================================================== */
 
-static void wolc_handle_auth(struct wolc_request *req)
-{
-    struct char_file_u cbuf;
-    long pi = get_ptable_by_name(req->auth_name);
-    if (pi < 0) { req->status = WOLC_ERR_NOUSER; return; }
-    if (load_char(req->auth_name, &cbuf) < 0) { req->status = WOLC_ERR_NOUSER; return; }
-    if (strncmp(CRYPT(req->auth_pw, cbuf.pwd), cbuf.pwd, MAX_PWD_LENGTH) != 0) {
-        req->status = WOLC_ERR_BADPW; return;
-    }
-    if (cbuf.level < LVL_IMMORT) { req->status = WOLC_ERR_NOPERM; return; }
-    req->out_pfilepos = (int)pi;
-    req->out_level    = (int)(unsigned char)cbuf.level;
-    strncpy(req->out_name, cbuf.name, MAX_NAME_LENGTH);
-    req->out_name[MAX_NAME_LENGTH] = '\0';
-    req->status = WOLC_OK;
-}
-
-static void wolc_handle_get_zones(struct wolc_request *req)
-{
-    struct jbuf b;
-    jb_init(&b, 8192);
-    jb_append(&b, "[");
-    for (int i = 0; i <= top_of_zone_table; i++) {
-        if (i > 0) jb_append(&b, ",");
-        int can_edit = wolc_check_perm(req->pfilepos, req->level, zone_table[i].bot);
-        jb_append(&b, "{");
-        jb_appendf(&b, "\"number\":%d,", zone_table[i].number);
-        jb_append(&b, "\"name\":"); jb_escape_str(&b, zone_table[i].name);
-        jb_appendf(&b, ",\"bot\":%d,\"top\":%d", zone_table[i].bot, zone_table[i].top);
-        jb_appendf(&b, ",\"lifespan\":%d,\"reset_mode\":%d",
-                   zone_table[i].lifespan, zone_table[i].reset_mode);
-        jb_appendf(&b, ",\"closed\":%d,\"can_edit\":%d",
-                   (zone_table[i].permissions.flags & OLC_ZONEFLAGS_CLOSED) ? 1 : 0,
-                   can_edit ? 1 : 0);
-        jb_append(&b, "}");
-    }
-    jb_append(&b, "]");
-    req->response_json = b.data;
-    req->status = WOLC_OK;
-}
-
-static void wolc_handle_get_room(struct wolc_request *req)
+static char *wolc_render_room(room_rnum rnum)
 {
-    room_rnum rnum = real_room(req->vnum);
-    if (rnum == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
     struct room_data *rm = &world[rnum];
     struct jbuf b;
     jb_init(&b, 4096);
     jb_append(&b, "{");
-    jb_appendf(&b, "\"vnum\":%d,", req->vnum);
+    jb_appendf(&b, "\"vnum\":%d,", (int)rm->number);
     jb_append(&b, "\"name\":"); jb_escape_str(&b, rm->name);
     jb_append(&b, ",\"description\":"); jb_escape_str(&b, rm->description);
     jb_appendf(&b, ",\"room_flags\":%d,\"sector_type\":%d", rm->room_flags, rm->sector_type);
@@ -527,93 +368,15 @@ static void wolc_handle_get_room(struct wolc_request *req)
     jb_append(&b, "]");
     jb_append(&b, ",\"extra_descs\":"); jb_extra_descs(&b, rm->ex_description);
     jb_append(&b, "}");
-    req->response_json = b.data;
-    req->status = WOLC_OK;
-}
-
-static void wolc_handle_set_room(struct wolc_request *req)
-{
-    room_rnum rnum = real_room(req->vnum);
-    if (rnum == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
-    const char *j = req->json_body;
-    struct room_data *rm = &world[rnum];
-    int ival;
-    char *s;
-
-    if ((s = json_get_str(j, "name")))        { free(rm->name);        rm->name        = s; }
-    if ((s = json_get_str(j, "description"))) { free(rm->description); rm->description = s; }
-    if (json_get_int(j, "room_flags",  &ival)) rm->room_flags  = ival;
-    if (json_get_int(j, "sector_type", &ival)) rm->sector_type = ival;
-
-    /* exits */
-    const char *exits_arr = json_get_array(j, "exits");
-    if (exits_arr) {
-        exits_arr++;
-        for (int d = 0; d < NUM_OF_DIRS; d++) {
-            exits_arr = jp_skip(exits_arr);
-            if (!*exits_arr || *exits_arr == ']') break;
-            if (strncmp(exits_arr, "null", 4) == 0) {
-                if (rm->dir_option[d]) {
-                    free(rm->dir_option[d]->general_description);
-                    free(rm->dir_option[d]->keyword);
-                    free(rm->dir_option[d]);
-                    rm->dir_option[d] = NULL;
-                }
-                exits_arr += 4;
-            } else if (*exits_arr == '{') {
-                char *obj = jp_extract_object(&exits_arr);
-                char *gdesc = json_get_str(obj, "general_description");
-                char *kw    = json_get_str(obj, "keyword");
-                int ei = 0, key_vnum = -1, to_vnum = -1;
-                json_get_int(obj, "exit_info", &ei);
-                json_get_int(obj, "key",       &key_vnum);
-                json_get_int(obj, "to_room",   &to_vnum);
-                free(obj);
-
-                if (!rm->dir_option[d]) {
-                    rm->dir_option[d] = calloc(1, sizeof(struct room_direction_data));
-                } else {
-                    free(rm->dir_option[d]->general_description);
-                    free(rm->dir_option[d]->keyword);
-                    rm->dir_option[d]->general_description = NULL;
-                    rm->dir_option[d]->keyword = NULL;
-                }
-                rm->dir_option[d]->general_description = gdesc;
-                rm->dir_option[d]->keyword  = kw;
-                rm->dir_option[d]->exit_info = ei;
-                rm->dir_option[d]->key = (key_vnum >= 0) ? (obj_vnum)key_vnum : NOTHING;
-                rm->dir_option[d]->to_room = (to_vnum >= 0) ? real_room(to_vnum) : NOWHERE;
-            }
-            exits_arr = jp_skip(exits_arr);
-            if (*exits_arr == ',') exits_arr++;
-        }
-    }
-
-    /* extra descs */
-    if (json_get_array(j, "extra_descs")) {
-        free_extra_descriptions(rm->ex_description);
-        rm->ex_description = parse_extra_descs(j);
-    }
-
-    olc_save_room(req->vnum);
-    req->response_json = strdup("{\"ok\":true}");
-    req->status = WOLC_OK;
+    return b.data;
 }
 
-static void wolc_handle_get_mob(struct wolc_request *req)
+static char *wolc_render_mob(mob_rnum rnum)
 {
-    mob_rnum rnum = real_mobile(req->vnum);
-    if (rnum == NOBODY) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
     struct char_data *mob = &mob_proto[rnum];
     struct jbuf b;
     jb_init(&b, 2048);
-    jb_appendf(&b, "{\"vnum\":%d,", req->vnum);
+    jb_appendf(&b, "{\"vnum\":%d,", (int)mob_index[rnum].vnum);
     jb_append(&b, "\"aliases\":"); jb_escape_str(&b, mob->player.name);
     jb_append(&b, ",\"short_desc\":"); jb_escape_str(&b, mob->player.short_descr);
     jb_append(&b, ",\"long_desc\":"); jb_escape_str(&b, mob->player.long_descr);
@@ -641,68 +404,15 @@ static void wolc_handle_get_mob(struct wolc_request *req)
                (int)mob->real_abils.dex, (int)mob->real_abils.con,
                (int)mob->real_abils.cha);
     jb_append(&b, "}");
-    req->response_json = b.data;
-    req->status = WOLC_OK;
-}
-
-static void wolc_handle_set_mob(struct wolc_request *req)
-{
-    mob_rnum rnum = real_mobile(req->vnum);
-    if (rnum == NOBODY) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
-    const char *j = req->json_body;
-    struct char_data *mob = &mob_proto[rnum];
-    int ival;
-    char *s;
-
-    if ((s = json_get_str(j, "aliases")))    { free(mob->player.name);        mob->player.name        = s; }
-    if ((s = json_get_str(j, "short_desc"))) { free(mob->player.short_descr); mob->player.short_descr = s; }
-    if ((s = json_get_str(j, "long_desc")))  { free(mob->player.long_descr);  mob->player.long_descr  = s; }
-    if ((s = json_get_str(j, "description"))){ free(mob->player.description); mob->player.description = s; }
-
-    if (json_get_int(j, "act_flags",   &ival)) MOB_FLAGS(mob) = (long)ival;
-    if (json_get_int(j, "aff_flags",   &ival)) AFF_FLAGS(mob) = (long)ival;
-    if (json_get_int(j, "alignment",   &ival)) GET_ALIGNMENT(mob) = ival;
-    if (json_get_int(j, "level",       &ival)) mob->player.level = (byte)ival;
-    if (json_get_int(j, "hitroll",     &ival)) mob->points.hitroll = (sbyte)ival;
-    if (json_get_int(j, "ac",          &ival)) mob->points.armor = (sh_int)ival;
-    if (json_get_int(j, "hp_nodice",   &ival)) mob->mob_specials.hpnodice   = ival;
-    if (json_get_int(j, "hp_sizedice", &ival)) mob->mob_specials.hpsizedice = ival;
-    if (json_get_int(j, "hp_extra",    &ival)) mob->mob_specials.hpextra    = ival;
-    if (json_get_int(j, "dam_nodice",  &ival)) mob->mob_specials.damnodice  = ival;
-    if (json_get_int(j, "dam_sizedice",&ival)) mob->mob_specials.damsizedice= ival;
-    if (json_get_int(j, "gold",        &ival)) mob->points.gold = ival;
-    if (json_get_int(j, "exp",         &ival)) mob->points.exp  = ival;
-    if (json_get_int(j, "position",    &ival)) mob->char_specials.position    = ival;
-    if (json_get_int(j, "default_pos", &ival)) mob->mob_specials.default_pos  = ival;
-    if (json_get_int(j, "sex",         &ival)) mob->player.sex                = ival;
-    if (json_get_int(j, "attack_type", &ival)) mob->mob_specials.attack_type  = ival;
-    if (json_get_int(j, "str",         &ival)) mob->real_abils.str     = (sbyte)ival;
-    if (json_get_int(j, "str_add",     &ival)) mob->real_abils.str_add = (sbyte)ival;
-    if (json_get_int(j, "intel",       &ival)) mob->real_abils.intel   = (sbyte)ival;
-    if (json_get_int(j, "wis",         &ival)) mob->real_abils.wis     = (sbyte)ival;
-    if (json_get_int(j, "dex",         &ival)) mob->real_abils.dex     = (sbyte)ival;
-    if (json_get_int(j, "con",         &ival)) mob->real_abils.con     = (sbyte)ival;
-    if (json_get_int(j, "cha",         &ival)) mob->real_abils.cha     = (sbyte)ival;
-
-    olc_save_mobile(req->vnum);
-    req->response_json = strdup("{\"ok\":true}");
-    req->status = WOLC_OK;
+    return b.data;
 }
 
-static void wolc_handle_get_obj(struct wolc_request *req)
+static char *wolc_render_obj(obj_rnum rnum)
 {
-    obj_rnum rnum = real_object(req->vnum);
-    if (rnum == NOBODY) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
     struct obj_data *obj = &obj_proto[rnum];
     struct jbuf b;
     jb_init(&b, 2048);
-    jb_appendf(&b, "{\"vnum\":%d,", req->vnum);
+    jb_appendf(&b, "{\"vnum\":%d,", (int)obj_index[rnum].vnum);
     jb_append(&b, "\"aliases\":"); jb_escape_str(&b, obj->name);
     jb_append(&b, ",\"room_desc\":"); jb_escape_str(&b, obj->description);
     jb_append(&b, ",\"short_desc\":"); jb_escape_str(&b, obj->short_description);
@@ -724,74 +434,11 @@ static void wolc_handle_get_obj(struct wolc_request *req)
     jb_append(&b, "]");
     jb_append(&b, ",\"extra_descs\":"); jb_extra_descs(&b, obj->ex_description);
     jb_append(&b, "}");
-    req->response_json = b.data;
-    req->status = WOLC_OK;
-}
-
-static void wolc_handle_set_obj(struct wolc_request *req)
-{
-    obj_rnum rnum = real_object(req->vnum);
-    if (rnum == NOBODY) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
-    const char *j = req->json_body;
-    struct obj_data *obj = &obj_proto[rnum];
-    int ival;
-    char *s;
-
-    if ((s = json_get_str(j, "aliases")))    { free(obj->name);               obj->name               = s; }
-    if ((s = json_get_str(j, "room_desc")))  { free(obj->description);        obj->description        = s; }
-    if ((s = json_get_str(j, "short_desc"))) { free(obj->short_description);  obj->short_description  = s; }
-    if ((s = json_get_str(j, "action_desc"))){ free(obj->action_description); obj->action_description = s; }
-
-    if (json_get_int(j, "type",        &ival)) obj->obj_flags.type_flag    = ival;
-    if (json_get_int(j, "extra_flags", &ival)) obj->obj_flags.extra_flags  = ival;
-    if (json_get_int(j, "wear_flags",  &ival)) obj->obj_flags.wear_flags   = ival;
-    if (json_get_int(j, "weight",      &ival)) obj->obj_flags.weight       = ival;
-    if (json_get_int(j, "cost",        &ival)) obj->obj_flags.cost         = ival;
-    if (json_get_int(j, "rent",        &ival)) obj->obj_flags.cost_per_day = ival;
-    if (json_get_int(j, "val0",        &ival)) obj->obj_flags.value[0]     = ival;
-    if (json_get_int(j, "val1",        &ival)) obj->obj_flags.value[1]     = ival;
-    if (json_get_int(j, "val2",        &ival)) obj->obj_flags.value[2]     = ival;
-    if (json_get_int(j, "val3",        &ival)) obj->obj_flags.value[3]     = ival;
-
-    const char *aff_arr = json_get_array(j, "affects");
-    if (aff_arr) {
-        aff_arr++;
-        for (int i = 0; i < MAX_OBJ_AFFECT; i++) {
-            aff_arr = jp_skip(aff_arr);
-            if (!*aff_arr || *aff_arr == ']') break;
-            if (*aff_arr != '{') { aff_arr = jp_skip_value(aff_arr); i--; continue; }
-            char *aobj = jp_extract_object(&aff_arr);
-            int loc = 0, mod = 0;
-            json_get_int(aobj, "location", &loc);
-            json_get_int(aobj, "modifier", &mod);
-            free(aobj);
-            obj->affected[i].location = (byte)loc;
-            obj->affected[i].modifier = (sbyte)mod;
-            aff_arr = jp_skip(aff_arr);
-            if (*aff_arr == ',') aff_arr++;
-        }
-    }
-
-    if (json_get_array(j, "extra_descs")) {
-        free_extra_descriptions(obj->ex_description);
-        obj->ex_description = parse_extra_descs(j);
-    }
-
-    olc_save_object(req->vnum);
-    req->response_json = strdup("{\"ok\":true}");
-    req->status = WOLC_OK;
+    return b.data;
 }
 
-static void wolc_handle_get_zcmds(struct wolc_request *req)
+static char *wolc_render_zcmds(zone_rnum rnum)
 {
-    zone_rnum rnum = real_zone((zone_vnum)req->vnum);
-    if (rnum == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, zone_table[rnum].bot)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
     struct zone_data *z = &zone_table[rnum];
     struct jbuf b;
     jb_init(&b, 4096);
@@ -842,124 +489,692 @@ static void wolc_handle_get_zcmds(struct wolc_request *req)
         }
     }
     jb_append(&b, "]}");
-    req->response_json = b.data;
-    req->status = WOLC_OK;
+    return b.data;
 }
 
-static void wolc_handle_set_zcmds(struct wolc_request *req)
-{
-    zone_rnum rnum = real_zone((zone_vnum)req->vnum);
-    if (rnum == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
-    if (!wolc_check_perm(req->pfilepos, req->level, zone_table[rnum].bot)) {
-        req->status = WOLC_ERR_NOPERM; return;
-    }
-    const char *j = req->json_body;
-    const char *arr = json_get_array(j, "commands");
-    if (!arr) { req->status = WOLC_ERR_INTERNAL; return; }
-    arr++;
+/* ======================================================================
+ * Read-only snapshot
+ *
+ * GETs are answered on the civetweb thread from an immutable copy of the
+ * OLC data, so they never wait for a pulse.  Each room, mob, object and
+ * zone command list is rendered to JSON once and shared by every
+ * snapshot until OLC saves it again (wolc_snapshot_touch()); the next
+ * heartbeat then publishes a new snapshot that re-renders just those and
+ * reuses the rest.  Writes still go through the request queue.
+ *
+ * Readers take a reference under wolc_snap_mutex.  A snapshot nobody
+ * holds any more is handed back to the game thread to be freed, so only
+ * the game thread ever touches blob reference counts.
+ * ====================================================================== */
 
-    /* First pass: count commands */
-    int count = 0;
-    const char *p = arr;
-    while (*(p = jp_skip(p)) && *p != ']') {
-        if (*p == '{') { count++; p = jp_skip_value(p); }
-        else { p++; }
-        p = jp_skip(p);
-        if (*p == ',') p++;
-    }
+#define WOLC_TOUCH_MAX  256     /* past this, re-render everything */
 
-    struct reset_com *cmds = calloc(count + 1, sizeof(*cmds));
-    if (!cmds) { req->status = WOLC_ERR_INTERNAL; return; }
+struct wolc_blob {
+    int   refs;                 /* snapshots sharing it (game thread) */
+    int   vnum;
+    int   len;
+    char *json;
+};
 
-    int idx = 0;
-    const char *ap = arr;
-    while (*(ap = jp_skip(ap)) && *ap != ']' && idx < count) {
-        if (*ap != '{') { ap++; continue; }
-        char *obj = jp_extract_object(&ap);
-        char *cmd_str = json_get_str(obj, "command");
-        int if_flag = 0, a1 = 0, a2 = 0, a3 = -1;
-        json_get_int(obj, "if_flag", &if_flag);
-        json_get_int(obj, "arg1",    &a1);
-        json_get_int(obj, "arg2",    &a2);
-        json_get_int(obj, "arg3",    &a3);
-        free(obj);
+struct wolc_snap_zone {
+    int   number, bot, top, lifespan, reset_mode;
+    char *name;
+    struct olc_permissions_s permissions;
+    struct wolc_blob *cmds;
+};
 
-        char cmd_c = (cmd_str && cmd_str[0]) ? cmd_str[0] : 'S';
-        free(cmd_str);
+struct wolc_snapshot {
+    int refs;                   /* readers, plus one while current */
+    unsigned long version;
+    int num_zones;
+    struct wolc_snap_zone *zones;           /* zone_table order */
+    int num[WOLC_SNAP_ZONE];                /* rooms, mobs, objs */
+    struct wolc_blob **blobs[WOLC_SNAP_ZONE];   /* each sorted by vnum */
+    struct wolc_snapshot *next;             /* on the reap list */
+};
 
-        cmds[idx].command = cmd_c;
-        cmds[idx].if_flag = if_flag ? TRUE : FALSE;
-        cmds[idx].line    = 0;
-        switch (cmd_c) {
-            case 'M':
-                cmds[idx].arg1 = (int)real_mobile((mob_vnum)a1);
-                cmds[idx].arg2 = a2;
-                cmds[idx].arg3 = (a3 >= 0) ? (int)real_room((room_vnum)a3) : (int)NOWHERE;
-                break;
-            case 'O':
-                cmds[idx].arg1 = (int)real_object((obj_vnum)a1);
-                cmds[idx].arg2 = a2;
-                cmds[idx].arg3 = (a3 >= 0) ? (int)real_room((room_vnum)a3) : (int)NOWHERE;
-                break;
-            case 'E': case 'G':
-                cmds[idx].arg1 = (int)real_object((obj_vnum)a1);
-                cmds[idx].arg2 = a2;
-                cmds[idx].arg3 = a3;
-                break;
-            case 'P':
-                cmds[idx].arg1 = (int)real_object((obj_vnum)a1);
-                cmds[idx].arg2 = a2;
-                cmds[idx].arg3 = (int)real_object((obj_vnum)a3);
-                break;
-            case 'D':
-                cmds[idx].arg1 = (int)real_room((room_vnum)a1);
-                cmds[idx].arg2 = a2;
-                cmds[idx].arg3 = a3;
-                break;
-            default:
-                cmds[idx].arg1 = a1; cmds[idx].arg2 = a2; cmds[idx].arg3 = a3;
-                break;
-        }
-        idx++;
-        ap = jp_skip(ap);
-        if (*ap == ',') ap++;
-    }
-    cmds[idx].command = 'S';
+static struct wolc_snapshot *wolc_snap = NULL;
+static struct wolc_snapshot *wolc_snap_reap = NULL;
+static pthread_mutex_t      wolc_snap_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned long        wolc_snap_version = 0;
+static int                  wolc_snap_wanted = 0;  /* nobody reads until a login */
 
-    free(zone_table[rnum].cmd);
-    zone_table[rnum].cmd = cmds;
-    zedit_save_zone_file(rnum);
-    req->response_json = strdup("{\"ok\":true}");
-    req->status = WOLC_OK;
+static struct { int kind, vnum; } wolc_touched[WOLC_TOUCH_MAX];
+static int wolc_num_touched = 0;
+static int wolc_touched_all = 1;    /* nothing rendered yet */
+
+static struct wolc_snapshot *wolc_snapshot_get(void)
+{
+    pthread_mutex_lock(&wolc_snap_mutex);
+    struct wolc_snapshot *s = wolc_snap;
+    if (s) s->refs++;
+    pthread_mutex_unlock(&wolc_snap_mutex);
+    return s;
 }
 
-/* ======================================================================
- * Process queue (called ONLY from game loop thread)
- * ====================================================================== */
+static void wolc_snapshot_put(struct wolc_snapshot *s)
+{
+    pthread_mutex_lock(&wolc_snap_mutex);
+    if (--s->refs == 0) {
+        s->next = wolc_snap_reap;
+        wolc_snap_reap = s;
+    }
+    pthread_mutex_unlock(&wolc_snap_mutex);
+}
 
-void wolc_process_requests(void)
+static struct wolc_blob *wolc_blob_make(int vnum, char *json)
 {
-    pthread_mutex_lock(&wolc_queue_mutex);
-    struct wolc_request *q = wolc_queue_head;
-    wolc_queue_head = wolc_queue_tail = NULL;
-    pthread_mutex_unlock(&wolc_queue_mutex);
+    struct wolc_blob *b = calloc(1, sizeof(*b));
+    b->refs = 1;
+    b->vnum = vnum;
+    b->json = json;
+    b->len  = (int)strlen(json);
+    return b;
+}
 
-    while (q) {
-        struct wolc_request *next = q->next;
-        switch (q->type) {
-            case WOLC_REQ_AUTH:      wolc_handle_auth(q);      break;
-            case WOLC_REQ_GET_ZONES: wolc_handle_get_zones(q); break;
-            case WOLC_REQ_GET_ROOM:  wolc_handle_get_room(q);  break;
-            case WOLC_REQ_SET_ROOM:  wolc_handle_set_room(q);  break;
-            case WOLC_REQ_GET_MOB:   wolc_handle_get_mob(q);   break;
-            case WOLC_REQ_SET_MOB:   wolc_handle_set_mob(q);   break;
-            case WOLC_REQ_GET_OBJ:   wolc_handle_get_obj(q);   break;
-            case WOLC_REQ_SET_OBJ:   wolc_handle_set_obj(q);   break;
-            case WOLC_REQ_GET_ZCMDS: wolc_handle_get_zcmds(q); break;
-            case WOLC_REQ_SET_ZCMDS: wolc_handle_set_zcmds(q); break;
-            default: q->status = WOLC_ERR_INTERNAL; break;
-        }
-        pthread_mutex_lock(&q->lock);
+static void wolc_blob_unref(struct wolc_blob *b)
+{
+    if (b && --b->refs == 0) {
+        free(b->json);
+        free(b);
+    }
+}
+
+/* Free snapshots their last readers have let go of.  Game thread only. */
+static void wolc_snapshot_reap(void)
+{
+    pthread_mutex_lock(&wolc_snap_mutex);
+    struct wolc_snapshot *s = wolc_snap_reap, *next;
+    wolc_snap_reap = NULL;
+    pthread_mutex_unlock(&wolc_snap_mutex);
+
+    for (; s; s = next) {
+        next = s->next;
+        for (int k = 0; k < WOLC_SNAP_ZONE; k++) {
+            for (int i = 0; i < s->num[k]; i++)
+                wolc_blob_unref(s->blobs[k][i]);
+            free(s->blobs[k]);
+        }
+        for (int i = 0; i < s->num_zones; i++) {
+            free(s->zones[i].name);
+            wolc_blob_unref(s->zones[i].cmds);
+        }
+        free(s->zones);
+        free(s);
+    }
+}
+
+static int wolc_is_touched(int kind, int vnum)
+{
+    if (wolc_touched_all) return 1;
+    for (int i = 0; i < wolc_num_touched; i++)
+        if (wolc_touched[i].kind == kind && wolc_touched[i].vnum == vnum)
+            return 1;
+    return 0;
+}
+
+static int wolc_snap_count(int kind)
+{
+    switch (kind) {
+        case WOLC_SNAP_ROOM: return top_of_world + 1;
+        case WOLC_SNAP_MOB:  return top_of_mobt + 1;
+        default:             return top_of_objt + 1;
+    }
+}
+
+static int wolc_snap_vnum(int kind, int rnum)
+{
+    switch (kind) {
+        case WOLC_SNAP_ROOM: return (int)world[rnum].number;
+        case WOLC_SNAP_MOB:  return (int)mob_index[rnum].vnum;
+        default:             return (int)obj_index[rnum].vnum;
+    }
+}
+
+static char *wolc_snap_render(int kind, int rnum)
+{
+    switch (kind) {
+        case WOLC_SNAP_ROOM: return wolc_render_room(rnum);
+        case WOLC_SNAP_MOB:  return wolc_render_mob(rnum);
+        default:             return wolc_render_obj(rnum);
+    }
+}
+
+static struct wolc_snap_zone *wolc_snap_find_zone(struct wolc_snapshot *s, int number)
+{
+    for (int i = 0; i < s->num_zones; i++)
+        if (s->zones[i].number == number)
+            return &s->zones[i];
+    return NULL;
+}
+
+static struct wolc_blob *wolc_snap_find(struct wolc_snapshot *s, int kind, int vnum)
+{
+    int lo = 0, hi = s->num[kind] - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        struct wolc_blob *b = s->blobs[kind][mid];
+        if (b->vnum == vnum) return b;
+        if (b->vnum < vnum) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return NULL;
+}
+
+static int wolc_blob_cmp(const void *a, const void *b)
+{
+    int va = (*(struct wolc_blob * const *) a)->vnum;
+    int vb = (*(struct wolc_blob * const *) b)->vnum;
+    return (va > vb) - (va < vb);
+}
+
+/* wolc_check_perm() against the snapshot's copy of the zone permissions. */
+static int wolc_snap_check_perm(struct wolc_snapshot *s, int pfilepos, int level, int vnum)
+{
+    if (level >= LVL_GRGOD) return 1;
+    for (int i = 0; i < s->num_zones; i++) {
+        struct wolc_snap_zone *z = &s->zones[i];
+        if (z->bot > vnum || z->top < vnum) continue;
+        if (!(z->permissions.flags & OLC_ZONEFLAGS_CLOSED)) return 0;
+        for (int a = 0; a < OLC_ZONE_MAX_AUTHORS; a++)
+            if (z->permissions.authors[a] == pfilepos ||
+                z->permissions.editors[a] == pfilepos) return 1;
+        return 0;
+    }
+    return 0;
+}
+
+/* Build the next snapshot if OLC has saved anything since the last. */
+static void wolc_snapshot_publish(void)
+{
+    struct wolc_snapshot *old = wolc_snap, *s;
+
+    if (!wolc_snap_wanted || (!wolc_touched_all && !wolc_num_touched))
+        return;
+
+    s = calloc(1, sizeof(*s));
+    s->refs = 1;
+    s->version = ++wolc_snap_version;
+
+    /*
+     * Rooms, mobs and objects are walked in rnum order, which is vnum
+     * order only up to original_top_of_*: OLC appends new prototypes at
+     * the end whatever their vnum.  So look each one up in the old
+     * snapshot, and sort the new one for wolc_snap_find() and bulk GETs.
+     */
+    for (int k = 0; k < WOLC_SNAP_ZONE; k++) {
+        int n = wolc_snap_count(k);
+        s->num[k] = n;
+        s->blobs[k] = calloc(n > 0 ? n : 1, sizeof(struct wolc_blob *));
+        for (int i = 0; i < n; i++) {
+            int vnum = wolc_snap_vnum(k, i);
+            struct wolc_blob *b = old ? wolc_snap_find(old, k, vnum) : NULL;
+            if (b && !wolc_is_touched(k, vnum))
+                b->refs++;
+            else
+                b = wolc_blob_make(vnum, wolc_snap_render(k, i));
+            s->blobs[k][i] = b;
+        }
+        qsort(s->blobs[k], n, sizeof(struct wolc_blob *), wolc_blob_cmp);
+    }
+
+    /* Zones are few; copy them, sharing the rendered command lists. */
+    s->num_zones = top_of_zone_table + 1;
+    s->zones = calloc(s->num_zones > 0 ? s->num_zones : 1, sizeof(struct wolc_snap_zone));
+    for (int i = 0; i < s->num_zones; i++) {
+        struct zone_data *z = &zone_table[i];
+        struct wolc_snap_zone *sz = &s->zones[i];
+        struct wolc_snap_zone *oz = old ? wolc_snap_find_zone(old, z->number) : NULL;
+        sz->number      = z->number;
+        sz->bot         = z->bot;
+        sz->top         = z->top;
+        sz->lifespan    = z->lifespan;
+        sz->reset_mode  = z->reset_mode;
+        sz->name        = strdup(z->name ? z->name : "");
+        sz->permissions = z->permissions;
+        if (oz && !wolc_is_touched(WOLC_SNAP_ZONE, z->number)) {
+            sz->cmds = oz->cmds;
+            sz->cmds->refs++;
+        } else
+            sz->cmds = wolc_blob_make(z->number, wolc_render_zcmds(i));
+    }
+
+    wolc_num_touched = 0;
+    wolc_touched_all = 0;
+
+    pthread_mutex_lock(&wolc_snap_mutex);
+    wolc_snap = s;
+    if (old && --old->refs == 0) {
+        old->next = wolc_snap_reap;
+        wolc_snap_reap = old;
+    }
+    pthread_mutex_unlock(&wolc_snap_mutex);
+}
+
+/* ======================================================================
+ * Game-loop handlers (called ONLY from wolc_process_requests)
+ * ====================================================================== */
+
+/* Only looks the player up; wolc_http_login() checks the password itself,
+ * so the game loop never waits for crypt(). */
+static void wolc_handle_auth(struct wolc_request *req)
+{
+    struct char_file_u cbuf;
+    long pi = get_ptable_by_name(req->auth_name);
+    if (pi < 0) { req->status = WOLC_ERR_NOUSER; return; }
+    if (load_char(req->auth_name, &cbuf) < 0) { req->status = WOLC_ERR_NOUSER; return; }
+    strlcpy(req->auth_pwd, cbuf.pwd, sizeof(req->auth_pwd));
+    if (cbuf.level < LVL_IMMORT) { req->status = WOLC_ERR_NOPERM; return; }
+    req->out_pfilepos = (int)pi;
+    req->out_level    = (int)(unsigned char)cbuf.level;
+    strncpy(req->out_name, cbuf.name, MAX_NAME_LENGTH);
+    req->out_name[MAX_NAME_LENGTH] = '\0';
+    req->status = WOLC_OK;
+    wolc_snap_wanted = 1;   /* someone will be reading */
+}
+
+static void wolc_handle_set_room(struct wolc_request *req)
+{
+    room_rnum rnum = real_room(req->vnum);
+    if (rnum == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
+    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
+        req->status = WOLC_ERR_NOPERM; return;
+    }
+    const struct json_doc *doc = &req->json;
+    int j = req->json_obj;
+    struct room_data *rm = &world[rnum];
+    int ival;
+    char *s;
+
+    if ((s = json_get_str(doc, j, "name")))        { free(rm->name);        rm->name        = s; }
+    if ((s = json_get_str(doc, j, "description"))) { free(rm->description); rm->description = s; }
+    if (json_get_int(doc, j, "room_flags",  &ival)) rm->room_flags  = ival;
+    if (json_get_int(doc, j, "sector_type", &ival)) rm->sector_type = ival;
+
+    /* exits */
+    int exits = json_get_array(doc, j, "exits");
+    if (exits >= 0) {
+        int ex = json_first(doc, exits);
+        for (int d = 0; d < NUM_OF_DIRS && ex >= 0; d++, ex = json_next(doc, exits, ex)) {
+            if (json_is_null(doc, ex)) {
+                if (rm->dir_option[d]) {
+                    free(rm->dir_option[d]->general_description);
+                    free(rm->dir_option[d]->keyword);
+                    free(rm->dir_option[d]);
+                    rm->dir_option[d] = NULL;
+                }
+            } else if (doc->tok[ex].type == JSON_OBJECT) {
+                char *gdesc = json_get_str(doc, ex, "general_description");
+                char *kw    = json_get_str(doc, ex, "keyword");
+                int ei = 0, key_vnum = -1, to_vnum = -1;
+                json_get_int(doc, ex, "exit_info", &ei);
+                json_get_int(doc, ex, "key",       &key_vnum);
+                json_get_int(doc, ex, "to_room",   &to_vnum);
+
+                if (!rm->dir_option[d]) {
+                    rm->dir_option[d] = calloc(1, sizeof(struct room_direction_data));
+                } else {
+                    free(rm->dir_option[d]->general_description);
+                    free(rm->dir_option[d]->keyword);
+                    rm->dir_option[d]->general_description = NULL;
+                    rm->dir_option[d]->keyword = NULL;
+                }
+                rm->dir_option[d]->general_description = gdesc;
+                rm->dir_option[d]->keyword  = kw;
+                rm->dir_option[d]->exit_info = ei;
+                rm->dir_option[d]->key = (key_vnum >= 0) ? (obj_vnum)key_vnum : NOTHING;
+                rm->dir_option[d]->to_room = (to_vnum >= 0) ? real_room(to_vnum) : NOWHERE;
+            }
+        }
+    }
+
+    /* extra descs */
+    int descs = json_get_array(doc, j, "extra_descs");
+    if (descs >= 0) {
+        free_extra_descriptions(rm->ex_description);
+        rm->ex_description = parse_extra_descs(doc, descs);
+    }
+
+    olc_save_room(req->vnum);
+    req->response_json = strdup("{\"ok\":true}");
+    req->status = WOLC_OK;
+}
+
+static void wolc_handle_set_mob(struct wolc_request *req)
+{
+    mob_rnum rnum = real_mobile(req->vnum);
+    if (rnum == NOBODY) { req->status = WOLC_ERR_NOTFOUND; return; }
+    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
+        req->status = WOLC_ERR_NOPERM; return;
+    }
+    const struct json_doc *doc = &req->json;
+    int j = req->json_obj;
+    struct char_data *mob = &mob_proto[rnum];
+    int ival;
+    char *s;
+
+    if ((s = json_get_str(doc, j, "aliases")))    { free(mob->player.name);        mob->player.name        = s;
+                                               proto_keywords_changed(&mob_index[rnum]); }
+    if ((s = json_get_str(doc, j, "short_desc"))) { free(mob->player.short_descr); mob->player.short_descr = s; }
+    if ((s = json_get_str(doc, j, "long_desc")))  { free(mob->player.long_descr);  mob->player.long_descr  = s; }
+    if ((s = json_get_str(doc, j, "description"))){ free(mob->player.description); mob->player.description = s; }
+
+    if (json_get_int(doc, j, "act_flags",   &ival)) MOB_FLAGS(mob) = (long)ival;
+    if (json_get_int(doc, j, "aff_flags",   &ival)) AFF_FLAGS(mob) = (long)ival;
+    if (json_get_int(doc, j, "alignment",   &ival)) GET_ALIGNMENT(mob) = ival;
+    if (json_get_int(doc, j, "level",       &ival)) mob->player.level = (byte)ival;
+    if (json_get_int(doc, j, "hitroll",     &ival)) mob->points.hitroll = (sbyte)ival;
+    if (json_get_int(doc, j, "ac",          &ival)) mob->points.armor = (sh_int)ival;
+    if (json_get_int(doc, j, "hp_nodice",   &ival)) mob->mob_specials.hpnodice   = ival;
+    if (json_get_int(doc, j, "hp_sizedice", &ival)) mob->mob_specials.hpsizedice = ival;
+    if (json_get_int(doc, j, "hp_extra",    &ival)) mob->mob_specials.hpextra    = ival;
+    if (json_get_int(doc, j, "dam_nodice",  &ival)) mob->mob_specials.damnodice  = ival;
+    if (json_get_int(doc, j, "dam_sizedice",&ival)) mob->mob_specials.damsizedice= ival;
+    if (json_get_int(doc, j, "gold",        &ival)) mob->points.gold = ival;
+    if (json_get_int(doc, j, "exp",         &ival)) mob->points.exp  = ival;
+    if (json_get_int(doc, j, "position",    &ival)) mob->char_specials.position    = ival;
+    if (json_get_int(doc, j, "default_pos", &ival)) mob->mob_specials.default_pos  = ival;
+    if (json_get_int(doc, j, "sex",         &ival)) mob->player.sex                = ival;
+    if (json_get_int(doc, j, "attack_type", &ival)) mob->mob_specials.attack_type  = ival;
+    if (json_get_int(doc, j, "str",         &ival)) mob->real_abils.str     = (sbyte)ival;
+    if (json_get_int(doc, j, "str_add",     &ival)) mob->real_abils.str_add = (sbyte)ival;
+    if (json_get_int(doc, j, "intel",       &ival)) mob->real_abils.intel   = (sbyte)ival;
+    if (json_get_int(doc, j, "wis",         &ival)) mob->real_abils.wis     = (sbyte)ival;
+    if (json_get_int(doc, j, "dex",         &ival)) mob->real_abils.dex     = (sbyte)ival;
+    if (json_get_int(doc, j, "con",         &ival)) mob->real_abils.con     = (sbyte)ival;
+    if (json_get_int(doc, j, "cha",         &ival)) mob->real_abils.cha     = (sbyte)ival;
+
+    olc_save_mobile(req->vnum);
+    req->response_json = strdup("{\"ok\":true}");
+    req->status = WOLC_OK;
+}
+
+static void wolc_handle_set_obj(struct wolc_request *req)
+{
+    obj_rnum rnum = real_object(req->vnum);
+    if (rnum == NOBODY) { req->status = WOLC_ERR_NOTFOUND; return; }
+    if (!wolc_check_perm(req->pfilepos, req->level, req->vnum)) {
+        req->status = WOLC_ERR_NOPERM; return;
+    }
+    const struct json_doc *doc = &req->json;
+    int j = req->json_obj;
+    struct obj_data *obj = &obj_proto[rnum];
+    int ival;
+    char *s;
+
+    if ((s = json_get_str(doc, j, "aliases")))    { free(obj->name);               obj->name               = s;
+                                               proto_keywords_changed(&obj_index[rnum]); }
+    if ((s = json_get_str(doc, j, "room_desc")))  { free(obj->description);        obj->description        = s; }
+    if ((s = json_get_str(doc, j, "short_desc"))) { free(obj->short_description);  obj->short_description  = s; }
+    if ((s = json_get_str(doc, j, "action_desc"))){ free(obj->action_description); obj->action_description = s; }
+
+    if (json_get_int(doc, j, "type",        &ival)) obj->obj_flags.type_flag    = ival;
+    if (json_get_int(doc, j, "extra_flags", &ival)) obj->obj_flags.extra_flags  = ival;
+    if (json_get_int(doc, j, "wear_flags",  &ival)) obj->obj_flags.wear_flags   = ival;
+    if (json_get_int(doc, j, "weight",      &ival)) obj->obj_flags.weight       = ival;
+    if (json_get_int(doc, j, "cost",        &ival)) obj->obj_flags.cost         = ival;
+    if (json_get_int(doc, j, "rent",        &ival)) obj->obj_flags.cost_per_day = ival;
+    if (json_get_int(doc, j, "val0",        &ival)) obj->obj_flags.value[0]     = ival;
+    if (json_get_int(doc, j, "val1",        &ival)) obj->obj_flags.value[1]     = ival;
+    if (json_get_int(doc, j, "val2",        &ival)) obj->obj_flags.value[2]     = ival;
+    if (json_get_int(doc, j, "val3",        &ival)) obj->obj_flags.value[3]     = ival;
+
+    int affs = json_get_array(doc, j, "affects");
+    if (affs >= 0) {
+        int i = 0;
+        for (int a = json_first(doc, affs); a >= 0 && i < MAX_OBJ_AFFECT;
+             a = json_next(doc, affs, a)) {
+            if (doc->tok[a].type != JSON_OBJECT) continue;
+            int loc = 0, mod = 0;
+            json_get_int(doc, a, "location", &loc);
+            json_get_int(doc, a, "modifier", &mod);
+            obj->affected[i].location = (byte)loc;
+            obj->affected[i].modifier = (sbyte)mod;
+            i++;
+        }
+    }
+
+    int descs = json_get_array(doc, j, "extra_descs");
+    if (descs >= 0) {
+        free_extra_descriptions(obj->ex_description);
+        obj->ex_description = parse_extra_descs(doc, descs);
+    }
+
+    olc_save_object(req->vnum);
+    req->response_json = strdup("{\"ok\":true}");
+    req->status = WOLC_OK;
+}
+
+static void wolc_handle_set_zcmds(struct wolc_request *req)
+{
+    zone_rnum rnum = real_zone((zone_vnum)req->vnum);
+    if (rnum == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
+    if (!wolc_check_perm(req->pfilepos, req->level, zone_table[rnum].bot)) {
+        req->status = WOLC_ERR_NOPERM; return;
+    }
+    const struct json_doc *doc = &req->json;
+    int j = req->json_obj;
+    int arr = json_get_array(doc, j, "commands");
+    if (arr < 0) { req->status = WOLC_ERR_BADREQ; return; }
+
+    struct reset_com *cmds = calloc(doc->tok[arr].size + 1, sizeof(*cmds));
+    if (!cmds) { req->status = WOLC_ERR_INTERNAL; return; }
+
+    int idx = 0;
+    for (int c = json_first(doc, arr); c >= 0; c = json_next(doc, arr, c)) {
+        if (doc->tok[c].type != JSON_OBJECT) continue;
+        char *cmd_str = json_get_str(doc, c, "command");
+        int if_flag = 0, a1 = 0, a2 = 0, a3 = -1;
+        json_get_int(doc, c, "if_flag", &if_flag);
+        json_get_int(doc, c, "arg1",    &a1);
+        json_get_int(doc, c, "arg2",    &a2);
+        json_get_int(doc, c, "arg3",    &a3);
+
+        char cmd_c = (cmd_str && cmd_str[0]) ? cmd_str[0] : 'S';
+        free(cmd_str);
+
+        cmds[idx].command = cmd_c;
+        cmds[idx].if_flag = if_flag ? TRUE : FALSE;
+        cmds[idx].line    = 0;
+        switch (cmd_c) {
+            case 'M':
+                cmds[idx].arg1 = (int)real_mobile((mob_vnum)a1);
+                cmds[idx].arg2 = a2;
+                cmds[idx].arg3 = (a3 >= 0) ? (int)real_room((room_vnum)a3) : (int)NOWHERE;
+                break;
+            case 'O':
+                cmds[idx].arg1 = (int)real_object((obj_vnum)a1);
+                cmds[idx].arg2 = a2;
+                cmds[idx].arg3 = (a3 >= 0) ? (int)real_room((room_vnum)a3) : (int)NOWHERE;
+                break;
+            case 'E': case 'G':
+                cmds[idx].arg1 = (int)real_object((obj_vnum)a1);
+                cmds[idx].arg2 = a2;
+                cmds[idx].arg3 = a3;
+                break;
+            case 'P':
+                cmds[idx].arg1 = (int)real_object((obj_vnum)a1);
+                cmds[idx].arg2 = a2;
+                cmds[idx].arg3 = (int)real_object((obj_vnum)a3);
+                break;
+            case 'D':
+                cmds[idx].arg1 = (int)real_room((room_vnum)a1);
+                cmds[idx].arg2 = a2;
+                cmds[idx].arg3 = a3;
+                break;
+            default:
+                cmds[idx].arg1 = a1; cmds[idx].arg2 = a2; cmds[idx].arg3 = a3;
+                break;
+        }
+        idx++;
+    }
+    cmds[idx].command = 'S';
+
+    free(zone_table[rnum].cmd);
+    zone_table[rnum].cmd = cmds;
+    zedit_save_zone_file(rnum);
+    req->response_json = strdup("{\"ok\":true}");
+    req->status = WOLC_OK;
+}
+
+/*
+ * Bulk writes: {"rooms":[...],"mobs":[...],"objs":[...],"zones":[...]},
+ * each element what the matching GET returns.  Everything is checked
+ * before anything is changed, and the whole lot is applied in this one
+ * pass, so a client never sees (or leaves behind) half a zone.
+ */
+static const struct {
+    const char *key;            /* array in the body */
+    const char *vnum_key;       /* what identifies an element */
+    int set_type;
+    void (*handler)(struct wolc_request *);
+} wolc_bulk_kinds[] = {
+    { "rooms", "vnum",   WOLC_REQ_SET_ROOM,  wolc_handle_set_room  },
+    { "mobs",  "vnum",   WOLC_REQ_SET_MOB,   wolc_handle_set_mob   },
+    { "objs",  "vnum",   WOLC_REQ_SET_OBJ,   wolc_handle_set_obj   },
+    { "zones", "number", WOLC_REQ_SET_ZCMDS, wolc_handle_set_zcmds },
+};
+#define WOLC_BULK_KINDS  ((int)(sizeof(wolc_bulk_kinds) / sizeof(wolc_bulk_kinds[0])))
+
+struct wolc_bulk_item {
+    int kind;                   /* index into wolc_bulk_kinds */
+    int vnum;
+    int obj;                    /* its token in the body */
+};
+
+/* Why this element can't be written, or WOLC_OK. */
+static int wolc_bulk_check(struct wolc_request *req, int kind, int vnum, int obj)
+{
+    int perm_vnum = vnum;
+
+    switch (wolc_bulk_kinds[kind].set_type) {
+        case WOLC_REQ_SET_ROOM:
+            if (real_room(vnum) == NOWHERE) return WOLC_ERR_NOTFOUND;
+            break;
+        case WOLC_REQ_SET_MOB:
+            if (real_mobile(vnum) == NOBODY) return WOLC_ERR_NOTFOUND;
+            break;
+        case WOLC_REQ_SET_OBJ:
+            if (real_object(vnum) == NOTHING) return WOLC_ERR_NOTFOUND;
+            break;
+        default: {
+            zone_rnum z = real_zone((zone_vnum)vnum);
+            if (z == NOWHERE) return WOLC_ERR_NOTFOUND;
+            if (json_get_array(&req->json, obj, "commands") < 0) return WOLC_ERR_BADREQ;
+            if (zone_table[z].bot < req->lo || zone_table[z].top > req->hi)
+                return WOLC_ERR_BADREQ;
+            perm_vnum = zone_table[z].bot;
+            break;
+        }
+    }
+    if (perm_vnum < req->lo || perm_vnum > req->hi) return WOLC_ERR_BADREQ;
+    if (!wolc_check_perm(req->pfilepos, req->level, perm_vnum)) return WOLC_ERR_NOPERM;
+    return WOLC_OK;
+}
+
+static void wolc_handle_bulk(struct wolc_request *req)
+{
+    struct wolc_bulk_item *items = NULL;
+    int num = 0, cap = 0, counts[WOLC_BULK_KINDS] = { 0 };
+    char err[256] = "";
+
+    if (req->vnum >= 0) {
+        zone_rnum z = real_zone((zone_vnum)req->vnum);
+        if (z == NOWHERE) { req->status = WOLC_ERR_NOTFOUND; return; }
+        req->lo = zone_table[z].bot;
+        req->hi = zone_table[z].top;
+    }
+
+    req->status = WOLC_OK;
+    for (int k = 0; k < WOLC_BULK_KINDS && req->status == WOLC_OK; k++) {
+        int arr = json_get_array(&req->json, 0, wolc_bulk_kinds[k].key);
+        for (int e = json_first(&req->json, arr); e >= 0; e = json_next(&req->json, arr, e)) {
+            int vnum;
+            if (!json_get_int(&req->json, e, wolc_bulk_kinds[k].vnum_key, &vnum)) {
+                req->status = WOLC_ERR_BADREQ;
+                snprintf(err, sizeof(err), "%s: element without \\\"%s\\\"",
+                         wolc_bulk_kinds[k].key, wolc_bulk_kinds[k].vnum_key);
+                break;
+            }
+            if ((req->status = wolc_bulk_check(req, k, vnum, e)) != WOLC_OK) {
+                snprintf(err, sizeof(err), "%s %d: %s", wolc_bulk_kinds[k].key, vnum,
+                         req->status == WOLC_ERR_NOTFOUND ? "not found" :
+                         req->status == WOLC_ERR_NOPERM   ? "no edit permission" :
+                                                            "outside the requested range");
+                break;
+            }
+            if (num >= cap) {
+                cap = cap ? cap * 2 : 64;
+                items = realloc(items, cap * sizeof(*items));
+            }
+            items[num].kind = k;
+            items[num].vnum = vnum;
+            items[num].obj  = e;
+            num++;
+        }
+    }
+
+    /* All or nothing. */
+    for (int i = 0; i < num && req->status == WOLC_OK; i++) {
+        struct wolc_request sub;
+        memset(&sub, 0, sizeof(sub));
+        sub.type     = wolc_bulk_kinds[items[i].kind].set_type;
+        sub.vnum     = items[i].vnum;
+        sub.pfilepos = req->pfilepos;
+        sub.level    = req->level;
+        sub.json     = req->json;       /* shared, not freed by sub */
+        sub.json_obj = items[i].obj;
+        wolc_bulk_kinds[items[i].kind].handler(&sub);
+        free(sub.response_json);
+        counts[items[i].kind]++;
+    }
+    free(items);
+
+    struct jbuf b;
+    jb_init(&b, 256);
+    if (req->status != WOLC_OK) {
+        jb_append(&b, "{\"error\":\"");
+        jb_append(&b, err);
+        jb_append(&b, "\"}");
+    } else {
+        jb_append(&b, "{\"ok\":true");
+        for (int k = 0; k < WOLC_BULK_KINDS; k++)
+            jb_appendf(&b, ",\"%s\":%d", wolc_bulk_kinds[k].key, counts[k]);
+        jb_append(&b, "}");
+    }
+    req->response_json = b.data;
+}
+
+/* ======================================================================
+ * Process queue (called ONLY from game loop thread)
+ * ====================================================================== */
+
+void wolc_process_requests(void)
+{
+    pthread_mutex_lock(&wolc_queue_mutex);
+    struct wolc_request *q = wolc_queue_head, *r;
+    wolc_queue_head = wolc_queue_tail = NULL;
+    pthread_mutex_unlock(&wolc_queue_mutex);
+
+    for (r = q; r; r = r->next) {
+        switch (r->type) {
+            case WOLC_REQ_AUTH:      wolc_handle_auth(r);      break;
+            case WOLC_REQ_SET_ROOM:  wolc_handle_set_room(r);  break;
+            case WOLC_REQ_SET_MOB:   wolc_handle_set_mob(r);   break;
+            case WOLC_REQ_SET_OBJ:   wolc_handle_set_obj(r);   break;
+            case WOLC_REQ_SET_ZCMDS: wolc_handle_set_zcmds(r); break;
+            case WOLC_REQ_BULK:      wolc_handle_bulk(r);      break;
+            default: r->status = WOLC_ERR_INTERNAL; break;
+        }
+    }
+
+    /* Publish before anyone is told, so a GET after a write sees it. */
+    wolc_snapshot_publish();
+
+    while (q) {
+        /* The waiter may free it as soon as it's signalled. */
+        struct wolc_request *next = q->next;
+        pthread_mutex_lock(&q->lock);
         q->done = 1;
         pthread_cond_signal(&q->done_cond);
         pthread_mutex_unlock(&q->lock);
@@ -1050,6 +1265,20 @@ static int wolc_submit_and_wait(struct mg_connection *conn, struct wolc_request
     return 0;
 }
 
+/* Tokenize the body here rather than on the game thread.  On failure,
+ * frees r and sends a 400.  Returns 0 on success. */
+static int wolc_parse_body(struct mg_connection *conn, struct wolc_request *r)
+{
+    if (json_parse(&r->json, r->json_body, strlen(r->json_body)) != 0 ||
+        r->json.tok[0].type != JSON_OBJECT) {
+        wolc_request_free(r);
+        wolc_send_error(conn, 400, "Bad Request", "Body is not a JSON object");
+        return -1;
+    }
+    r->json_obj = 0;
+    return 0;
+}
+
 /* ======================================================================
  * HTTP handlers
  * ====================================================================== */
@@ -1066,13 +1295,23 @@ static int wolc_http_login(struct mg_connection *conn, void *cbdata)
     if (len <= 0) { wolc_send_error(conn, 400, "Bad Request", "Empty body"); return 1; }
     body[len] = '\0';
 
-    char *name = json_get_str(body, "name");
-    char *pw   = json_get_str(body, "password");
+    struct json_doc doc;
+    char *name = NULL, *pw = NULL;
+    if (json_parse(&doc, body, len) == 0) {
+        name = json_get_str(&doc, 0, "name");
+        pw   = json_get_str(&doc, 0, "password");
+    }
+    json_free(&doc);
     if (!name || !pw) {
         free(name); free(pw);
         wolc_send_error(conn, 400, "Bad Request", "Missing name or password");
         return 1;
     }
+    if (login_fail_check(ri->remote_addr)) {
+        free(name); free(pw);
+        wolc_send_error(conn, 429, "Too Many Requests", "Too many failed logins");
+        return 1;
+    }
 
     struct wolc_request *r = wolc_request_alloc(WOLC_REQ_AUTH);
     if (!r) { free(name); free(pw); wolc_send_error(conn, 503, "Service Unavailable", "OOM"); return 1; }
@@ -1082,6 +1321,17 @@ static int wolc_http_login(struct mg_connection *conn, void *cbdata)
 
     if (wolc_submit_and_wait(conn, r) != 0) return 1;
 
+    /* Password first, so a guess can't tell who is an immortal. */
+    if (r->status == WOLC_OK || r->status == WOLC_ERR_NOPERM) {
+        char hash[MAX_PWD_LENGTH + 1];
+        pwhash(r->auth_pw, r->auth_pwd, hash, sizeof(hash));
+        if (strncmp(hash, r->auth_pwd, MAX_PWD_LENGTH) != 0) {
+            login_fail_note(ri->remote_addr);
+            r->status = WOLC_ERR_BADPW;
+        }
+    }
+    memset(r->auth_pw, 0, sizeof(r->auth_pw));
+
     if (r->status != WOLC_OK) {
         const char *msg;
         switch (r->status) {
@@ -1130,6 +1380,21 @@ static int wolc_http_logout(struct mg_connection *conn, void *cbdata)
     return 1;
 }
 
+/* Send a JSON body from snapshot s, tagged with its version. */
+static void wolc_send_snapshot_json(struct mg_connection *conn,
+                                    struct wolc_snapshot *s,
+                                    const char *json, int len)
+{
+    mg_printf(conn,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json; charset=utf-8\r\n"
+        "Content-Length: %d\r\n"
+        "Cache-Control: no-cache\r\n"
+        "X-OLC-Version: %lu\r\n"
+        "\r\n", len, s->version);
+    mg_write(conn, json, len);
+}
+
 static int wolc_http_zones(struct mg_connection *conn, void *cbdata)
 {
     (void)cbdata;
@@ -1137,24 +1402,63 @@ static int wolc_http_zones(struct mg_connection *conn, void *cbdata)
     if (!wolc_validate_session(conn, &pfilepos, &level)) {
         wolc_send_error(conn, 401, "Unauthorized", "Invalid or expired session"); return 1;
     }
-    struct wolc_request *r = wolc_request_alloc(WOLC_REQ_GET_ZONES);
-    if (!r) { wolc_send_error(conn, 503, "Service Unavailable", "OOM"); return 1; }
-    r->pfilepos = pfilepos; r->level = level;
-    if (wolc_submit_and_wait(conn, r) != 0) return 1;
-    if (r->status != WOLC_OK) {
-        wolc_request_free(r);
-        wolc_send_error(conn, 500, "Internal Server Error", "Failed");
-        return 1;
+    struct wolc_snapshot *s = wolc_snapshot_get();
+    if (!s) { wolc_send_error(conn, 503, "Service Unavailable", "Not ready"); return 1; }
+
+    struct jbuf b;
+    jb_init(&b, 8192);
+    jb_append(&b, "[");
+    for (int i = 0; i < s->num_zones; i++) {
+        struct wolc_snap_zone *z = &s->zones[i];
+        if (i > 0) jb_append(&b, ",");
+        int can_edit = wolc_snap_check_perm(s, pfilepos, level, z->bot);
+        jb_append(&b, "{");
+        jb_appendf(&b, "\"number\":%d,", z->number);
+        jb_append(&b, "\"name\":"); jb_escape_str(&b, z->name);
+        jb_appendf(&b, ",\"bot\":%d,\"top\":%d", z->bot, z->top);
+        jb_appendf(&b, ",\"lifespan\":%d,\"reset_mode\":%d",
+                   z->lifespan, z->reset_mode);
+        jb_appendf(&b, ",\"closed\":%d,\"can_edit\":%d",
+                   (z->permissions.flags & OLC_ZONEFLAGS_CLOSED) ? 1 : 0,
+                   can_edit ? 1 : 0);
+        jb_append(&b, "}");
     }
-    wolc_send_json(conn, 200, "OK", r->response_json);
-    wolc_request_free(r);
+    jb_append(&b, "]");
+    wolc_send_snapshot_json(conn, s, b.data, b.pos);
+    free(b.data);
+    wolc_snapshot_put(s);
+    return 1;
+}
+
+/* GET for one room, mob, obj or zone's commands, straight from the snapshot. */
+static int wolc_http_snapshot_get(struct mg_connection *conn, int kind, int vnum,
+                                  int pfilepos, int level)
+{
+    struct wolc_snapshot *s = wolc_snapshot_get();
+    if (!s) { wolc_send_error(conn, 503, "Service Unavailable", "Not ready"); return 1; }
+
+    struct wolc_blob *blob = NULL;
+    int perm_vnum = vnum;
+    if (kind == WOLC_SNAP_ZONE) {
+        struct wolc_snap_zone *z = wolc_snap_find_zone(s, vnum);
+        if (z) { blob = z->cmds; perm_vnum = z->bot; }
+    } else
+        blob = wolc_snap_find(s, kind, vnum);
+
+    if (!blob)
+        wolc_send_error(conn, 404, "Not Found", "Vnum not found");
+    else if (!wolc_snap_check_perm(s, pfilepos, level, perm_vnum))
+        wolc_send_error(conn, 403, "Forbidden", "No edit permission");
+    else
+        wolc_send_snapshot_json(conn, s, blob->json, blob->len);
+    wolc_snapshot_put(s);
     return 1;
 }
 
 /* Generic GET/POST handler for room, mob, obj, zone commands */
 static int wolc_http_entity(struct mg_connection *conn,
                              const char *prefix,
-                             int get_type, int set_type,
+                             int kind, int set_type,
                              int body_size)
 {
     int pfilepos, level;
@@ -1166,22 +1470,24 @@ static int wolc_http_entity(struct mg_connection *conn,
     if (vnum < 0) { wolc_send_error(conn, 400, "Bad Request", "Invalid vnum/number"); return 1; }
 
     int is_post = (strcmp(ri->request_method, "POST") == 0);
-    struct wolc_request *r = wolc_request_alloc(is_post ? set_type : get_type);
+    if (!is_post)
+        return wolc_http_snapshot_get(conn, kind, vnum, pfilepos, level);
+
+    struct wolc_request *r = wolc_request_alloc(set_type);
     if (!r) { wolc_send_error(conn, 503, "Service Unavailable", "OOM"); return 1; }
     r->pfilepos = pfilepos; r->level = level; r->vnum = vnum;
 
-    if (is_post) {
-        char *body = malloc(body_size + 1);
-        if (!body) {
-            wolc_request_free(r);
-            wolc_send_error(conn, 503, "Service Unavailable", "OOM");
-            return 1;
-        }
-        int n = mg_read(conn, body, body_size);
-        if (n < 0) n = 0;
-        body[n] = '\0';
-        r->json_body = body;
+    char *body = malloc(body_size + 1);
+    if (!body) {
+        wolc_request_free(r);
+        wolc_send_error(conn, 503, "Service Unavailable", "OOM");
+        return 1;
     }
+    int n = mg_read(conn, body, body_size);
+    if (n < 0) n = 0;
+    body[n] = '\0';
+    r->json_body = body;
+    if (wolc_parse_body(conn, r) != 0) return 1;
 
     if (wolc_submit_and_wait(conn, r) != 0) return 1;
 
@@ -1191,6 +1497,9 @@ static int wolc_http_entity(struct mg_connection *conn,
     if (r->status == WOLC_ERR_NOPERM) {
         wolc_request_free(r); wolc_send_error(conn, 403, "Forbidden",  "No edit permission"); return 1;
     }
+    if (r->status == WOLC_ERR_BADREQ) {
+        wolc_request_free(r); wolc_send_error(conn, 400, "Bad Request", "Missing field"); return 1;
+    }
     if (r->status != WOLC_OK) {
         wolc_request_free(r); wolc_send_error(conn, 500, "Internal Server Error", "Failed"); return 1;
     }
@@ -1203,28 +1512,217 @@ static int wolc_http_room(struct mg_connection *conn, void *cbdata)
 {
     (void)cbdata;
     return wolc_http_entity(conn, "/olc/room/",
-                            WOLC_REQ_GET_ROOM, WOLC_REQ_SET_ROOM, 65535);
+                            WOLC_SNAP_ROOM, WOLC_REQ_SET_ROOM, 65535);
 }
 
 static int wolc_http_mob(struct mg_connection *conn, void *cbdata)
 {
     (void)cbdata;
     return wolc_http_entity(conn, "/olc/mob/",
-                            WOLC_REQ_GET_MOB, WOLC_REQ_SET_MOB, 32767);
+                            WOLC_SNAP_MOB, WOLC_REQ_SET_MOB, 32767);
 }
 
 static int wolc_http_obj(struct mg_connection *conn, void *cbdata)
 {
     (void)cbdata;
     return wolc_http_entity(conn, "/olc/obj/",
-                            WOLC_REQ_GET_OBJ, WOLC_REQ_SET_OBJ, 32767);
+                            WOLC_SNAP_OBJ, WOLC_REQ_SET_OBJ, 32767);
 }
 
 static int wolc_http_zone(struct mg_connection *conn, void *cbdata)
 {
     (void)cbdata;
     return wolc_http_entity(conn, "/olc/zone/",
-                            WOLC_REQ_GET_ZCMDS, WOLC_REQ_SET_ZCMDS, 65535);
+                            WOLC_SNAP_ZONE, WOLC_REQ_SET_ZCMDS, 65535);
+}
+
+/* ?zone=<number> or ?from=<vnum>&to=<vnum>; the zone number, or -1 and a range. */
+static int wolc_bulk_range(const struct mg_request_info *ri, int *zone, int *lo, int *hi)
+{
+    const char *q = ri->query_string;
+    char buf[32];
+    if (!q) return 0;
+    *zone = -1;
+    if (mg_get_var(q, strlen(q), "zone", buf, sizeof(buf)) > 0) {
+        *zone = atoi(buf);
+        return *zone >= 0;
+    }
+    if (mg_get_var(q, strlen(q), "from", buf, sizeof(buf)) <= 0) return 0;
+    *lo = atoi(buf);
+    if (mg_get_var(q, strlen(q), "to", buf, sizeof(buf)) <= 0) return 0;
+    *hi = atoi(buf);
+    return *lo >= 0 && *lo <= *hi;
+}
+
+/* Bulk GET output, sent as chunks of about WOLC_CHUNK bytes. */
+struct wolc_stream {
+    struct mg_connection *conn;
+    struct jbuf b;
+    int failed;
+};
+
+static void ws_flush(struct wolc_stream *ws)
+{
+    if (ws->b.pos > 0 && !ws->failed &&
+        mg_send_chunk(ws->conn, ws->b.data, (unsigned int)ws->b.pos) < 0)
+        ws->failed = 1;     /* client went away; stop sending */
+    ws->b.pos = 0;
+}
+
+static void ws_write(struct wolc_stream *ws, const char *data, int len)
+{
+    if (ws->b.pos + len >= WOLC_CHUNK) ws_flush(ws);
+    if (len >= WOLC_CHUNK) {
+        if (!ws->failed && mg_send_chunk(ws->conn, data, (unsigned int)len) < 0)
+            ws->failed = 1;
+        return;
+    }
+    memcpy(ws->b.data + ws->b.pos, data, len);
+    ws->b.pos += len;
+}
+
+/* Stream every room, mob and object in [lo, hi] the user may edit, and the
+ * zones lying wholly inside it, straight out of the snapshot. */
+static void wolc_bulk_get(struct mg_connection *conn, struct wolc_snapshot *s,
+                          int lo, int hi, int pfilepos, int level)
+{
+    static const char *keys[WOLC_SNAP_ZONE] = { "rooms", "mobs", "objs" };
+    struct wolc_stream ws;
+    char head[64];
+
+    mg_printf(conn,
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: application/json; charset=utf-8\r\n"
+        "Transfer-Encoding: chunked\r\n"
+        "Cache-Control: no-cache\r\n"
+        "X-OLC-Version: %lu\r\n"
+        "\r\n", s->version);
+
+    ws.conn = conn;
+    ws.failed = 0;
+    jb_init(&ws.b, WOLC_CHUNK);
+
+    snprintf(head, sizeof(head), "{\"version\":%lu", s->version);
+    ws_write(&ws, head, (int)strlen(head));
+
+    /* The blobs are sorted by vnum, OLC-created ones included, so the
+     * range is one contiguous run. */
+    for (int k = 0; k < WOLC_SNAP_ZONE && !ws.failed; k++) {
+        int i = 0, hi_i = s->num[k], first = 1;
+        while (i < hi_i) {              /* first blob with vnum >= lo */
+            int mid = (i + hi_i) / 2;
+            if (s->blobs[k][mid]->vnum < lo) i = mid + 1;
+            else hi_i = mid;
+        }
+        snprintf(head, sizeof(head), ",\"%s\":[", keys[k]);
+        ws_write(&ws, head, (int)strlen(head));
+        for (; i < s->num[k] && s->blobs[k][i]->vnum <= hi && !ws.failed; i++) {
+            struct wolc_blob *blob = s->blobs[k][i];
+            if (!wolc_snap_check_perm(s, pfilepos, level, blob->vnum)) continue;
+            if (!first) ws_write(&ws, ",", 1);
+            first = 0;
+            ws_write(&ws, blob->json, blob->len);
+        }
+        ws_write(&ws, "]", 1);
+    }
+
+    ws_write(&ws, ",\"zones\":[", 10);
+    for (int i = 0, first = 1; i < s->num_zones && !ws.failed; i++) {
+        struct wolc_snap_zone *z = &s->zones[i];
+        if (z->bot < lo || z->top > hi) continue;
+        if (!wolc_snap_check_perm(s, pfilepos, level, z->bot)) continue;
+        if (!first) ws_write(&ws, ",", 1);
+        first = 0;
+        ws_write(&ws, z->cmds->json, z->cmds->len);
+    }
+    ws_write(&ws, "]}", 2);
+    ws_flush(&ws);
+    if (!ws.failed) mg_send_chunk(conn, "", 0);
+    free(ws.b.data);
+}
+
+/* Read the whole request body, up to max bytes; NULL if it's bigger. */
+static char *wolc_read_body(struct mg_connection *conn, long long max)
+{
+    const struct mg_request_info *ri = mg_get_request_info(conn);
+    long long want = ri->content_length;
+    if (want < 0 || want > max) return NULL;
+    char *body = malloc(want + 1);
+    if (!body) return NULL;
+    long long got = 0;
+    while (got < want) {
+        int n = mg_read(conn, body + got, (size_t)(want - got));
+        if (n <= 0) break;
+        got += n;
+    }
+    body[got] = '\0';
+    return body;
+}
+
+/* GET or PUT (POST) a zone's worth, or a vnum range's worth, at once. */
+static int wolc_http_bulk(struct mg_connection *conn, void *cbdata)
+{
+    (void)cbdata;
+    int pfilepos, level, zone, lo = 0, hi = 0;
+    if (!wolc_validate_session(conn, &pfilepos, &level)) {
+        wolc_send_error(conn, 401, "Unauthorized", "Invalid or expired session"); return 1;
+    }
+    const struct mg_request_info *ri = mg_get_request_info(conn);
+    if (!wolc_bulk_range(ri, &zone, &lo, &hi)) {
+        wolc_send_error(conn, 400, "Bad Request", "Give ?zone=<n> or ?from=<vnum>&to=<vnum>");
+        return 1;
+    }
+
+    if (strcmp(ri->request_method, "GET") == 0) {
+        struct wolc_snapshot *s = wolc_snapshot_get();
+        if (!s) { wolc_send_error(conn, 503, "Service Unavailable", "Not ready"); return 1; }
+        struct wolc_snap_zone *z = zone >= 0 ? wolc_snap_find_zone(s, zone) : NULL;
+        if (zone >= 0 && !z)
+            wolc_send_error(conn, 404, "Not Found", "Zone not found");
+        else if (z && !wolc_snap_check_perm(s, pfilepos, level, z->bot))
+            wolc_send_error(conn, 403, "Forbidden", "No edit permission");
+        else if (z)
+            wolc_bulk_get(conn, s, z->bot, z->top, pfilepos, level);
+        else
+            wolc_bulk_get(conn, s, lo, hi, pfilepos, level);
+        wolc_snapshot_put(s);
+        return 1;
+    }
+    if (strcmp(ri->request_method, "PUT") != 0 && strcmp(ri->request_method, "POST") != 0) {
+        wolc_send_error(conn, 405, "Method Not Allowed", "Use GET or PUT"); return 1;
+    }
+
+    char *body = wolc_read_body(conn, WOLC_BULK_MAX);
+    if (!body) {
+        wolc_send_error(conn, 413, "Payload Too Large", "Body missing or too large");
+        return 1;
+    }
+
+    struct wolc_request *r = wolc_request_alloc(WOLC_REQ_BULK);
+    if (!r) { free(body); wolc_send_error(conn, 503, "Service Unavailable", "OOM"); return 1; }
+    r->pfilepos = pfilepos; r->level = level;
+    r->vnum = zone; r->lo = lo; r->hi = hi;
+    r->json_body = body;
+    if (wolc_parse_body(conn, r) != 0) return 1;
+
+    if (wolc_submit_and_wait(conn, r) != 0) return 1;
+
+    switch (r->status) {
+        case WOLC_OK:
+            wolc_send_json(conn, 200, "OK", r->response_json); break;
+        case WOLC_ERR_NOTFOUND:
+            wolc_send_json(conn, 404, "Not Found",
+                           r->response_json ? r->response_json : "{\"error\":\"Zone not found\"}");
+            break;
+        case WOLC_ERR_NOPERM:
+            wolc_send_json(conn, 403, "Forbidden", r->response_json); break;
+        case WOLC_ERR_BADREQ:
+            wolc_send_json(conn, 400, "Bad Request", r->response_json); break;
+        default:
+            wolc_send_error(conn, 500, "Internal Server Error", "Failed"); break;
+    }
+    wolc_request_free(r);
+    return 1;
 }
 
 /* ======================================================================
@@ -1245,6 +1743,7 @@ void wolc_register_handlers(struct mg_context *ctx)
     mg_set_request_handler(ctx, "/olc/mob/",   wolc_http_mob,    NULL);
     mg_set_request_handler(ctx, "/olc/obj/",   wolc_http_obj,    NULL);
     mg_set_request_handler(ctx, "/olc/zone/",  wolc_http_zone,   NULL);
+    mg_set_request_handler(ctx, "/olc/bulk",   wolc_http_bulk,   NULL);
 }
 
 void wolc_shutdown(void)
@@ -1261,7 +1760,24 @@ void webserver_olc_heartbeat(void)
 #ifdef HAVE_CIVETWEB
     static int tick = 0;
     wolc_process_requests();
+    wolc_snapshot_reap();
     if (!(++tick % 600))   /* ~once per minute at 10 pulses/sec */
         wolc_session_expire();
 #endif
 }
+
+/* OLC saved something; the snapshot will pick it up on the next pulse. */
+void wolc_snapshot_touch(int kind, int vnum)
+{
+#ifdef HAVE_CIVETWEB
+    if (wolc_touched_all)
+        return;
+    if (wolc_num_touched >= WOLC_TOUCH_MAX) {
+        wolc_touched_all = 1;
+        return;
+    }
+    wolc_touched[wolc_num_touched].kind = kind;
+    wolc_touched[wolc_num_touched].vnum = vnum;
+    wolc_num_touched++;
+#endif
+}
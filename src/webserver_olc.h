@@ -12,6 +12,13 @@ void wolc_register_handlers(struct mg_context *ctx);
 void wolc_shutdown(void);
 #endif
 
+/* What OLC saved, for wolc_snapshot_touch(); vnum is a zone number for zones */
+#define WOLC_SNAP_ROOM  0
+#define WOLC_SNAP_MOB   1
+#define WOLC_SNAP_OBJ   2
+#define WOLC_SNAP_ZONE  3
+
 void webserver_olc_heartbeat(void);
+void wolc_snapshot_touch(int kind, int vnum);
 
 #endif /* __WEBSERVER_OLC_H__ */
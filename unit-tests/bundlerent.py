@@ -0,0 +1,254 @@
+#!/usr/bin/env python3
+"""
+unit-tests/bundlerent.py — rent header rewrite in a player bundle
+==================================================================
+
+REQUIREMENTS
+    The MUD must be running with `player_bundles 1` and `free_rent 1` in
+    etc/config, and this script must be able to read and write its data
+    directory (--lib).  The login character must already exist and be
+    able to `load obj` (an implementor can); it should not be carrying
+    anything it would mind losing to a failed run.
+
+USAGE
+    python3 unit-tests/bundlerent.py --user NAME --password PASS [options]
+
+OPTIONS
+    --host HOST       MUD hostname or IP                  (default: 127.0.0.1)
+    --port PORT       MUD telnet port                     (default: 4000)
+    --user NAME       Character name to log in as         (required)
+    --password PASS   Character password                  (required)
+    --lib DIR         The MUD's data directory            (default: lib)
+    --vnum N          Object to rent with                 (default: 3010)
+    --timeout SECS    How long to wait for the MUD        (default: 5.0)
+
+WHAT IS CHECKED
+    Crash_load() rewrites the rent_info header at the front of the rent
+    file in place ("r+b").  With bundles on, that file is a section of
+    the player's bundle, read and written in memory.  A memory stream
+    must write exactly the bytes it is given: fmemopen() treats the
+    buffer as a string, and some C libraries store a NUL after the header,
+    over the first object's vnum, when the header's last byte is not zero.
+
+    The script loads --vnum, quits (free rent saves it), sets the last
+    spare field of the header in the bundle on disk to a non-zero value,
+    logs back in, and expects:
+
+    inventory     The object is carried again.
+    first_vnum    The first object record in the bundle still has --vnum.
+    header        The header on disk is now a crash header with the spare
+                  field intact.
+
+EXAMPLES
+    python3 unit-tests/bundlerent.py --port 4000 --lib lib-run \\
+        --user Builder --password secret
+"""
+
+import argparse
+import glob
+import os
+import re
+import socket
+import struct
+import sys
+import time
+
+IAC  = 0xFF
+SE   = 0xF0
+SB   = 0xFA
+WILL = 0xFB
+DONT = 0xFE
+
+BUNDLE_OBJECTS = 0
+RENT_INFO      = struct.Struct('<14i')     # struct rent_info
+RENT_CRASH     = 1
+SPARE7         = 13                        # index of spare7 in rent_info
+MARK           = 0x01020304
+
+
+# ---------------------------------------------------------------------------
+# Telnet
+# ---------------------------------------------------------------------------
+
+class Telnet:
+    """Just enough telnet to log in and type commands; options are ignored."""
+
+    def __init__(self, host: str, port: int, timeout: float):
+        self.s = socket.create_connection((host, port), timeout=timeout)
+        self.timeout = timeout
+        self.text = ''
+
+    def _recv(self):
+        data = self.s.recv(4096)
+        if not data:
+            raise RuntimeError('MUD closed the connection')
+        out, i = bytearray(), 0
+        while i < len(data):
+            if data[i] != IAC:
+                out.append(data[i])
+                i += 1
+            elif i + 1 < len(data) and data[i + 1] == SB:
+                end = data.find(bytes((IAC, SE)), i)
+                i = len(data) if end < 0 else end + 2
+            elif i + 1 < len(data) and WILL <= data[i + 1] <= DONT:
+                i += 3
+            else:
+                i += 2
+        self.text += out.decode('latin-1')
+
+    def expect(self, pattern: str, timeout: float = None) -> str:
+        deadline = time.monotonic() + (timeout or self.timeout)
+        while True:
+            m = re.search(pattern, self.text, re.I)
+            if m:
+                seen, self.text = self.text[:m.end()], self.text[m.end():]
+                return seen
+            left = deadline - time.monotonic()
+            if left <= 0:
+                raise TimeoutError(f'no {pattern!r} from the MUD; last: {self.text[-200:]!r}')
+            self.s.settimeout(left)
+            try:
+                self._recv()
+            except socket.timeout:
+                pass
+
+    def send(self, line: str):
+        self.s.sendall(line.encode('latin-1') + b'\r\n')
+
+    def cmd(self, line: str) -> str:
+        self.send(line)
+        return self.expect('> ')
+
+    def close(self):
+        self.s.close()
+
+
+def login(args) -> Telnet:
+    t = Telnet(args.host, args.port, args.timeout)
+    t.expect('known\\?')
+    t.send(args.user)
+    t.expect('assword')
+    t.send(args.password)
+    while True:
+        seen = t.expect('(press return|make your choice|reconnecting)', timeout=15).lower()
+        if seen.endswith('press return'):
+            t.send('')
+            continue
+        if seen.endswith('make your choice'):
+            t.send('1')
+        t.expect('> ')
+        return t
+
+
+# ---------------------------------------------------------------------------
+# Bundle file
+# ---------------------------------------------------------------------------
+
+def bundle_path(lib: str, name: str) -> str:
+    found = glob.glob(os.path.join(lib, 'plrbundles', '*', name.lower() + '.bundle'))
+    if not found:
+        raise RuntimeError(f'no bundle for {name} under {lib}/plrbundles')
+    return found[0]
+
+
+def objects_offset(data: bytes) -> int:
+    """Offset of the BUNDLE_OBJECTS section's data (the rent header)."""
+    _, _, count = struct.unpack_from('<3i', data, 0)
+    pos = 12
+    for _ in range(count):
+        kind, length = struct.unpack_from('<2i', data, pos)
+        pos += 8
+        if kind == BUNDLE_OBJECTS:
+            return pos
+        pos += length
+    raise RuntimeError('bundle has no objects section')
+
+
+def first_vnum(data: bytes, off: int):
+    """vnum of the first object record after the rent header, or None."""
+    pos = off + RENT_INFO.size
+    if len(data) < pos + 4:
+        return None
+    return struct.unpack_from('<i', data, pos)[0]
+
+
+# ---------------------------------------------------------------------------
+# Test
+# ---------------------------------------------------------------------------
+
+def run(args) -> int:
+    t = login(args)
+    t.cmd(f'load obj {args.vnum}')
+    t.cmd('get all')
+    short = t.cmd('inventory')
+    t.send('quit')
+    t.expect('make your choice|goodbye')
+    t.close()
+
+    path = bundle_path(args.lib, args.user)
+    with open(path, 'r+b') as f:
+        data = bytearray(f.read())
+        off = objects_offset(data)
+        rent = list(RENT_INFO.unpack_from(data, off))
+        rent[SPARE7] = MARK
+        RENT_INFO.pack_into(data, off, *rent)
+        first = first_vnum(data, off)
+        f.seek(0)
+        f.write(data)
+
+    t = login(args)
+    inv = t.cmd('inventory')
+    t.close()
+
+    with open(path, 'rb') as f:
+        data = f.read()
+    off = objects_offset(data)
+    rent = RENT_INFO.unpack_from(data, off)
+    after = first_vnum(data, off)
+
+    results = []
+
+    def check(name, cond, msg):
+        results.append(cond)
+        print(f'  {"PASS" if cond else "FAIL"}    {name}' + ('' if cond else f'  —  {msg}'),
+              flush=True)
+
+    carried = [l.strip() for l in short.splitlines()[1:] if l.strip() and '>' not in l]
+    check('inventory', all(l in inv for l in carried),
+          f'carried {carried} before renting, now {inv!r}')
+    check('first_vnum', first == args.vnum and after == args.vnum,
+          f'first object vnum {first} before logging in, {after} after')
+    check('header', rent[1] == RENT_CRASH and rent[SPARE7] == MARK,
+          f'rentcode {rent[1]}, spare7 {rent[SPARE7]:#x}')
+
+    print(f'\n{sum(results)}/{len(results)} passed')
+    return 0 if all(results) else 1
+
+
+# ---------------------------------------------------------------------------
+# Entry point
+# ---------------------------------------------------------------------------
+
+def main():
+    p = argparse.ArgumentParser(
+        description='Rent header rewrite in a player bundle',
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--host',     default='127.0.0.1',
+                   help='MUD hostname or IP (default: 127.0.0.1)')
+    p.add_argument('--port',     default=4000, type=int,
+                   help='MUD telnet port (default: 4000)')
+    p.add_argument('--user',     required=True,
+                   help='Character name to log in as')
+    p.add_argument('--password', required=True,
+                   help='Character password')
+    p.add_argument('--lib',      default='lib',
+                   help="The MUD's data directory (default: lib)")
+    p.add_argument('--vnum',     default=3010, type=int,
+                   help='Object to rent with (default: 3010)')
+    p.add_argument('--timeout',  default=5.0, type=float,
+                   help='How long to wait for the MUD in seconds (default: 5.0)')
+    sys.exit(run(p.parse_args()))
+
+
+if __name__ == '__main__':
+    main()
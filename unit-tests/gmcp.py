@@ -34,13 +34,15 @@ AVAILABLE TESTS
     move            Moving a character re-sends Room.Info, Room.Players, Discord.
     channel         Gossiping produces a Comm.Channel.Text packet back to sender.
     goodbye         Quitting sends Core.Goodbye before the TCP connection closes.
+    mccp            MCCP v2 is negotiated and the compressed stream inflates cleanly.
     ping            Core.Ping is received within 65 s (requires --slow).
 
 CONNECTION SHARING
     One persistent connection is used for: negotiation, login_burst, vitals,
     status, room_info, room_players, afflictions, discord, move, channel.
-    "goodbye" and "ping" each open a fresh connection/login so they do not
-    affect the shared session.
+    "goodbye", "mccp" and "ping" each open a fresh connection/login so they
+    do not affect the shared session; "mccp" accepts compression, the
+    others refuse it.
 
 EXAMPLES
     # Run all standard tests against a local MUD:
@@ -64,6 +66,7 @@ import socket
 import sys
 import threading
 import time
+import zlib
 
 # ---------------------------------------------------------------------------
 # Telnet / GMCP constants
@@ -76,6 +79,7 @@ DONT = 0xFE
 SB   = 0xFA
 SE   = 0xF0
 GMCP = 0xC9   # Telnet option 201
+MCCP2 = 0x56  # Telnet option 86 (COMPRESS2)
 
 # IAC parser states
 _ST_NORM    = 0
@@ -98,20 +102,48 @@ class _IACSplitter:
     Both lists must be cleared by the caller after inspection.
 
     Negotiation replies (IAC DO GMCP, IAC DONT X, IAC WONT X) are sent
-    automatically via send_fn.
+    automatically via send_fn.  With mccp=True the splitter also answers
+    IAC WILL COMPRESS2 with DO and inflates everything after the server's
+    IAC SB COMPRESS2 IAC SE; wire_bytes and inflated_bytes count the
+    compressed stream on either side.
     """
 
-    def __init__(self, send_fn):
+    def __init__(self, send_fn, mccp=False):
         self._send   = send_fn
         self._st     = _ST_NORM
         self._cmd    = 0
         self._sb     = bytearray()
         self.text    = bytearray()
         self.packets = []          # [(module, json_str), ...]
+        self._mccp   = mccp
+        self._z      = None        # zlib inflater while compressed
+        self.mccp_started  = False
+        self.mccp_ended    = False # server finished the stream cleanly
+        self.wire_bytes     = 0
+        self.inflated_bytes = 0
 
     def feed(self, data: bytes):
-        for b in data:
-            self._byte(b)
+        while data:
+            if self._z is not None:
+                self.wire_bytes += len(data)
+                plain = self._z.decompress(data)
+                self.inflated_bytes += len(plain)
+                data = b''
+                if self._z.eof:          # back to plain telnet
+                    data = self._z.unused_data
+                    self.wire_bytes -= len(data)
+                    self._z = None
+                    self.mccp_ended = True
+                for b in plain:
+                    self._byte(b)
+                continue
+            for i, b in enumerate(data):
+                self._byte(b)
+                if self._z is not None:  # the rest is compressed
+                    data = data[i + 1:]
+                    break
+            else:
+                data = b''
 
     def _byte(self, b: int):
         st = self._st
@@ -137,6 +169,8 @@ class _IACSplitter:
         elif st == _ST_GOT_CMD:
             if self._cmd == WILL and b == GMCP:
                 self._send(bytes([IAC, DO, GMCP]))   # accept GMCP
+            elif self._cmd == WILL and b == MCCP2 and self._mccp:
+                self._send(bytes([IAC, DO, MCCP2]))  # accept compression
             elif self._cmd == WILL:
                 self._send(bytes([IAC, DONT, b]))    # reject other WILLs
             elif self._cmd == DO:
@@ -162,6 +196,10 @@ class _IACSplitter:
                 self._st = _ST_NORM
 
     def _dispatch(self, payload: bytes):
+        if payload == bytes([MCCP2]) and self._mccp and not self.mccp_started:
+            self._z = zlib.decompressobj()
+            self.mccp_started = True
+            return
         if not payload or payload[0] != GMCP:
             return
         try:
@@ -186,11 +224,12 @@ class MUDConnection:
     packets from a previous action.
     """
 
-    def __init__(self, host: str, port: int, verbose: bool = False):
+    def __init__(self, host: str, port: int, verbose: bool = False,
+                 mccp: bool = False):
         self.verbose  = verbose
         self._sock    = socket.create_connection((host, port), timeout=15)
         self._sock.settimeout(None)             # background thread uses blocking recv
-        self._splitter = _IACSplitter(self._raw_send)
+        self._splitter = _IACSplitter(self._raw_send, mccp)
         # Packet store — append-only, protected by _lock
         self._lock    = threading.Lock()
         self._pkts    = []                      # [(module, json_str), …]
@@ -231,7 +270,11 @@ class MUDConnection:
                 break
             if not chunk:
                 break
-            self._splitter.feed(chunk)
+            try:
+                self._splitter.feed(chunk)
+            except zlib.error as e:
+                print(f'  [MCCP] bad compressed data: {e}', flush=True)
+                break
             with self._lock:
                 if self._splitter.packets:
                     for pkt in self._splitter.packets:
@@ -580,6 +623,40 @@ def test_goodbye(conn: MUDConnection, args):
         'Connection did not close within 5 s after Core.Goodbye'
 
 
+def test_mccp(conn: MUDConnection, args):
+    """MCCP v2 is negotiated, inflates cleanly, and ends with the stream."""
+    sp = conn._splitter
+    assert sp.mccp_started, \
+        'No IAC SB COMPRESS2 IAC SE after IAC DO COMPRESS2 (is mccp_level 0?)'
+
+    # Text and GMCP both have to come through the compressed stream.
+    start = conn.current_idx()
+    _, cursor = conn._text_snapshot(0)
+    conn.send_line('look')
+    conn.send_line('gossip mccp check')
+    conn.wait_for_gmcp('Comm.Channel.Text', start=start, timeout=args.timeout)
+    deadline = time.monotonic() + args.timeout
+    seen = ''
+    while 'mccp check' not in seen:
+        new_text, cursor = conn._text_snapshot(cursor)
+        seen += new_text
+        if time.monotonic() > deadline:
+            raise AssertionError(f'No output for look/gossip: {seen[-200:]!r}')
+        conn._text_ev.wait(timeout=0.25)
+        conn._text_ev.clear()
+
+    assert sp.inflated_bytes > 0, 'Nothing came out of the compressed stream'
+    assert sp.wire_bytes < sp.inflated_bytes, \
+        f'Compressed {sp.inflated_bytes} bytes into {sp.wire_bytes}'
+
+    # Leaving the game finishes the zlib stream before the socket closes.
+    conn.send_line('quit')
+    conn.send_line('0')
+    conn.closed.wait(timeout=5.0)
+    assert conn.closed.is_set(), 'Connection did not close after quit'
+    assert sp.mccp_ended, 'Compressed stream was not finished before close'
+
+
 def test_ping(conn: MUDConnection, args):
     """Core.Ping is received within 65 s (server pings every 60 s)."""
     start = conn.current_idx()
@@ -607,6 +684,7 @@ TESTS = [
     ('move',         test_move,         False, False),
     ('channel',      test_channel,      False, False),
     ('goodbye',      test_goodbye,      True,  False),  # own connection: closes it
+    ('mccp',         test_mccp,         True,  False),  # own, compressed connection
     ('ping',         test_ping,         True,  True),   # own connection + slow
 ]
 
@@ -617,9 +695,9 @@ TEST_NAMES = [name for name, *_ in TESTS]
 # Runner
 # ---------------------------------------------------------------------------
 
-def _make_conn(host, port, verbose, username, password):
+def _make_conn(host, port, verbose, username, password, mccp=False):
     """Open a fresh connection and log in.  Returns MUDConnection or raises."""
-    conn = MUDConnection(host, port, verbose)
+    conn = MUDConnection(host, port, verbose, mccp)
     login(conn, username, password)
     return conn
 
@@ -669,7 +747,8 @@ def run_suite(args) -> int:
         if own_conn:
             try:
                 conn = _make_conn(args.host, args.port,
-                                  args.verbose, args.user, args.password)
+                                  args.verbose, args.user, args.password,
+                                  mccp=(name == 'mccp'))
             except (OSError, RuntimeError, TimeoutError) as e:
                 msg = f'Setup failed: {e}'
                 results.append((name, 'FAIL', msg))
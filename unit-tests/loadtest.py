@@ -0,0 +1,556 @@
+#!/usr/bin/env python3
+"""
+unit-tests/loadtest.py — connection load generator for NewCirMUD
+=================================================================
+
+REQUIREMENTS
+    The MUD must be running and accepting connections.  Characters are
+    made as needed: session N plays <prefix><letters for N>, creating it
+    with --password on the first run and logging it in on later ones.
+    On a MUD with no players yet, make your own character first, or the
+    first load-test character becomes the implementor.
+
+    The MUD turns people away past max_playing (etc/config, default 300)
+    and never goes past what select() can watch (about 1000); raise
+    max_playing, and `ulimit -n` for both the MUD and this script, to go
+    beyond a few hundred sessions.
+
+USAGE
+    python3 unit-tests/loadtest.py [options]
+
+OPTIONS
+    --host HOST       MUD hostname or IP                  (default: 127.0.0.1)
+    --port PORT       MUD port                            (default: 4000)
+    --sessions N      Concurrent sessions                 (default: 100)
+    --ramp SECS       Spread the connects over SECS       (default: 10)
+    --duration SECS   How long each session plays         (default: 60)
+    --think SECS      Mean pause between commands         (default: 2.0)
+    --script NAME     walk, combat, chat, mixed or a file (default: mixed)
+    --prefix NAME     Start of every character name       (default: Load)
+    --password PASS   Password for the characters         (default: loadtest)
+    --gmcp            Accept GMCP (refused by default)
+    --timeout SECS    Wait this long for a prompt         (default: 30)
+    --seed N          Seed for the think-time jitter      (default: 1)
+    --json            Print the results as one JSON line
+
+WHAT IS MEASURED
+    latency      Time from sending a command to the end of the next prompt
+                 ("> ", the pager's, or the menu after dying), in
+                 milliseconds.  Output received while thinking is thrown
+                 away first, but a combat round or someone else's chat
+                 that is sent just after the command can still end a wait
+                 early, so busy scripts read a little low.
+    login        Time from connecting to the first prompt in the game.
+    disconnects  Sessions the MUD closed on us while playing.
+    refused      Connects that failed, or that the MUD turned away.
+    failed       Logins that went wrong (bad name, wrong password, ...).
+    timeouts     Commands with no prompt after --timeout seconds; the
+                 session is dropped.
+    deaths       Times a character died and went back in from the menu.
+
+    The exit status is 1 if any session was disconnected, refused, failed
+    or timed out.
+
+SCRIPTS
+    A script file has one command per line; blank lines and lines starting
+    with # are skipped.  Each session starts at its own place in the script
+    and goes round it until --duration is up, then quits.  New characters
+    start in the Temple of Midgaard, which the built-in scripts assume.
+
+EXAMPLES
+    # 200 sessions for two minutes:
+    python3 unit-tests/loadtest.py --port 4000 --sessions 200 --duration 120
+
+    # Only chatter, with GMCP, and the numbers as JSON for a dashboard:
+    python3 unit-tests/loadtest.py --script chat --gmcp --json
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import re
+import sys
+import time
+
+# ---------------------------------------------------------------------------
+# Telnet / GMCP constants
+# ---------------------------------------------------------------------------
+IAC  = 0xFF
+WILL = 0xFB
+WONT = 0xFC
+DO   = 0xFD
+DONT = 0xFE
+SB   = 0xFA
+SE   = 0xF0
+GMCP = 0xC9   # Telnet option 201
+
+# ---------------------------------------------------------------------------
+# Built-in scripts
+# ---------------------------------------------------------------------------
+SCRIPTS = {
+    # Temple, down to the market, along the main street and back.
+    'walk': ['look', 'south', 'south', 'east', 'look', 'west', 'west',
+             'east', 'north', 'exits', 'north'],
+    # Down to the market for a go at the blob.
+    'combat': ['south', 'south', 'kill blob', 'consider cityguard',
+               'score', 'north', 'north'],
+    'chat': ['say Hello there.', 'gossip Anyone about?', 'emote waves.',
+             'who', 'say Busy today.', 'time'],
+}
+SCRIPTS['mixed'] = ['look', 'south', 'say Hello there.', 'south',
+                    'kill blob', 'score', 'who', 'north', 'inventory',
+                    'north', 'equipment', 'emote waves.']
+
+# What ends a command's output: the prompt, the pager's, or the menu a
+# character goes back to on dying.
+_PROMPT_RE = re.compile(rb'(> |page number \(\d+/\d+\) \]|Make your choice: )$')
+_PAGER_RE  = re.compile(rb'page number \(\d+/\d+\) \]$')
+_MENU_RE   = re.compile(rb'Make your choice: $')
+
+CLASSES = 'ctwm'
+
+
+def char_name(prefix: str, n: int) -> str:
+    """Names are letters only, so number the sessions in base 26."""
+    suffix = ''
+    for _ in range(4):
+        suffix = chr(ord('a') + n % 26) + suffix
+        n //= 26
+    return prefix + suffix
+
+
+# ---------------------------------------------------------------------------
+# Results
+# ---------------------------------------------------------------------------
+
+class Stats:
+    def __init__(self):
+        self.latency     = []   # ms
+        self.login       = []   # ms
+        self.commands    = 0
+        self.created     = 0
+        self.in_game     = 0
+        self.peak        = 0
+        self.disconnects = 0
+        self.refused     = 0
+        self.failed      = 0
+        self.timeouts    = 0
+        self.deaths      = 0
+        self.gmcp        = 0    # GMCP packets received
+        self.bytes_in    = 0
+        self.errors      = {}   # reason -> count
+
+    def note(self, reason: str):
+        self.errors[reason] = self.errors.get(reason, 0) + 1
+
+
+def percentile(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    k = min(len(values) - 1, max(0, int(round(p / 100.0 * len(values) + 0.5)) - 1))
+    return values[k]
+
+
+def summary(values):
+    if not values:
+        return {'count': 0}
+    return {
+        'count': len(values),
+        'mean':  round(sum(values) / len(values), 2),
+        'p50':   round(percentile(values, 50), 2),
+        'p90':   round(percentile(values, 90), 2),
+        'p99':   round(percentile(values, 99), 2),
+        'p999':  round(percentile(values, 99.9), 2),
+        'max':   round(max(values), 2),
+    }
+
+
+# ---------------------------------------------------------------------------
+# One telnet session
+# ---------------------------------------------------------------------------
+
+class Closed(Exception):
+    """The MUD closed the connection."""
+
+
+class Session:
+    """A telnet connection that keeps the text and counts GMCP packets.
+
+    Like gmcp.py's reader thread, a task reads everything the MUD sends as
+    it arrives, so output that turned up while the session was thinking
+    (combat rounds, other players) is already in hand and clear() throws it
+    away before the next command is timed.  It is an asyncio task rather
+    than a thread so thousands of sessions can share one thread.  Only what
+    the load test needs is parsed: option negotiation is answered and
+    subnegotiations are skipped.
+    """
+
+    def __init__(self, reader, writer, stats: Stats, gmcp: bool):
+        self._r     = reader
+        self._w     = writer
+        self._stats = stats
+        self._gmcp  = gmcp
+        self._iac   = bytearray()   # an IAC sequence split across reads
+        self.text   = bytearray()   # since the last clear()
+        self._more  = asyncio.Event()
+        self._eof   = False
+        self._task  = asyncio.ensure_future(self._pump())
+
+    def send(self, line: str):
+        self._w.write((line + '\r\n').encode('latin-1', errors='replace'))
+
+    def clear(self):
+        self.text.clear()
+
+    def close(self):
+        self._task.cancel()
+        try:
+            self._w.close()
+        except Exception:
+            pass
+
+    async def _pump(self):
+        try:
+            while True:
+                data = await self._r.read(65536)
+                if not data:
+                    break
+                self._stats.bytes_in += len(data)
+                self._feed(data)
+                self._more.set()
+        except (OSError, ConnectionError):
+            pass
+        self._eof = True
+        self._more.set()
+
+    async def _wait(self, deadline: float):
+        """Wait for more text, or until the deadline."""
+        if self._eof:
+            raise Closed()
+        remaining = deadline - time.monotonic()
+        if remaining <= 0:
+            raise asyncio.TimeoutError()
+        self._more.clear()
+        await asyncio.wait_for(self._more.wait(), remaining)
+
+    def _feed(self, data: bytes):
+        if self._iac:
+            data = bytes(self._iac) + data
+            self._iac.clear()
+        while data:
+            i = data.find(IAC)
+            if i < 0:
+                self.text += data
+                return
+            self.text += data[:i]
+            data = data[i:]
+            if len(data) < 2:
+                self._iac += data
+                return
+            cmd = data[1]
+            if cmd == IAC:
+                self.text.append(IAC)
+                data = data[2:]
+            elif cmd in (WILL, WONT, DO, DONT):
+                if len(data) < 3:
+                    self._iac += data
+                    return
+                self._negotiate(cmd, data[2])
+                data = data[3:]
+            elif cmd == SB:
+                end = data.find(bytes([IAC, SE]))
+                if end < 0:
+                    self._iac += data
+                    return
+                if len(data) > 2 and data[2] == GMCP:
+                    self._stats.gmcp += 1
+                data = data[end + 2:]
+            else:
+                data = data[2:]          # GA, NOP and the like
+
+    def _negotiate(self, cmd: int, opt: int):
+        if cmd == WILL:
+            yes = (opt == GMCP and self._gmcp)
+            self._w.write(bytes([IAC, DO if yes else DONT, opt]))
+        elif cmd == DO:
+            self._w.write(bytes([IAC, WONT, opt]))
+
+    async def expect(self, *patterns, timeout: float):
+        """Read until one of the (lower-case) patterns turns up; return its index."""
+        deadline = time.monotonic() + timeout
+        while True:
+            low = self.text.lower()
+            for n, pat in enumerate(patterns):
+                if pat in low:
+                    return n
+            await self._wait(deadline)
+
+    async def prompt(self, timeout: float):
+        """Read until the output ends in a prompt."""
+        deadline = time.monotonic() + timeout
+        while not _PROMPT_RE.search(self.text[-80:]):
+            await self._wait(deadline)
+
+
+# ---------------------------------------------------------------------------
+# Login
+# ---------------------------------------------------------------------------
+
+class LoginFailed(Exception):
+    pass
+
+
+# The menus' prompts, refusals first: "Wrong password." comes with "Password: ".
+_LOGIN_REFUSED = [
+    b'invalid name',
+    b'wrong password',
+    b'new characters are not allowed',
+    b"can't be created at the moment",
+    b'temporarily restricted',
+    b'too many failed logins',
+]
+_LOGIN_STEPS = _LOGIN_REFUSED + [
+    b'is full right now',
+    b'did i get that right',
+    b'password for',           # a new character's
+    b'retype password',
+    b'sex (m/f)',
+    b'class:',
+    b'press return',
+    b'make your choice',
+    b'reconnecting',
+    b'password:',              # an old character's
+]
+
+
+async def login(s: Session, name: str, password: str, n: int, args, stats: Stats):
+    """Drive the login menus, creating the character if need be."""
+    await s.expect(b'known?', timeout=args.timeout)
+    s.clear()
+    s.send(name)
+
+    while True:
+        step = await s.expect(*_LOGIN_STEPS, timeout=args.timeout)
+        s.clear()
+        if step < len(_LOGIN_REFUSED):
+            raise LoginFailed(_LOGIN_STEPS[step].decode())
+        step = _LOGIN_STEPS[step]
+        if step == b'is full right now':
+            raise Closed()
+        elif step == b'did i get that right':
+            s.send('y')
+            stats.created += 1
+        elif step in (b'password for', b'retype password', b'password:'):
+            s.send(password)
+        elif step == b'sex (m/f)':
+            s.send('mf'[n % 2])
+        elif step == b'class:':
+            s.send(CLASSES[n % len(CLASSES)])
+        elif step == b'press return':
+            s.send('')
+        elif step == b'make your choice':
+            s.send('1')
+            break
+        elif step == b'reconnecting':
+            s.send('')
+            break
+
+    await s.prompt(args.timeout)
+
+
+# ---------------------------------------------------------------------------
+# Playing
+# ---------------------------------------------------------------------------
+
+async def command(s: Session, line: str, args, stats: Stats):
+    """Send one command and time it to the next prompt."""
+    s.clear()
+    start = time.monotonic()
+    s.send(line)
+    await s.prompt(args.timeout)
+    stats.latency.append((time.monotonic() - start) * 1000.0)
+    stats.commands += 1
+
+    # Out of the pager, and back in after dying.
+    if _PAGER_RE.search(s.text[-80:]):
+        s.clear()
+        s.send('q')
+        await s.prompt(args.timeout)
+    if _MENU_RE.search(s.text[-80:]):
+        stats.deaths += 1
+        s.clear()
+        s.send('1')
+        await s.prompt(args.timeout)
+
+
+async def session(n: int, script, args, stats: Stats, rng: random.Random):
+    name = char_name(args.prefix, n)
+    await asyncio.sleep(n * args.ramp / max(args.sessions, 1))
+
+    start = time.monotonic()
+    try:
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(args.host, args.port), args.timeout)
+    except (OSError, asyncio.TimeoutError) as e:
+        stats.refused += 1
+        stats.note(f'connect: {e.__class__.__name__}')
+        return
+    s = Session(reader, writer, stats, args.gmcp)
+
+    try:
+        try:
+            await login(s, name, args.password, n, args, stats)
+        except Closed:
+            stats.refused += 1
+            stats.note('turned away')
+            return
+        except LoginFailed as e:
+            stats.failed += 1
+            stats.note(f'login: {e}')
+            return
+        stats.login.append((time.monotonic() - start) * 1000.0)
+        stats.in_game += 1
+        stats.peak = max(stats.peak, stats.in_game)
+
+        until = time.monotonic() + args.duration
+        pos = n % len(script)
+        try:
+            while time.monotonic() < until:
+                await asyncio.sleep(args.think * rng.uniform(0.5, 1.5))
+                await command(s, script[pos], args, stats)
+                pos = (pos + 1) % len(script)
+            s.clear()
+            s.send('quit')
+            if await s.expect(b'make your choice', b'goodbye',
+                              b'fighting', timeout=args.timeout) == 0:
+                s.send('0')        # died on the way out; leave from the menu
+        finally:
+            stats.in_game -= 1
+    except asyncio.TimeoutError:
+        stats.timeouts += 1
+        stats.note('no prompt')
+    except (Closed, ConnectionError):
+        stats.disconnects += 1
+        stats.note('closed by the MUD')
+    finally:
+        s.close()
+
+
+def load_script(arg: str):
+    if arg in SCRIPTS:
+        return SCRIPTS[arg]
+    with open(arg) as f:
+        lines = [l.strip() for l in f]
+    lines = [l for l in lines if l and not l.startswith('#')]
+    if not lines:
+        raise ValueError(f'{arg}: no commands in it')
+    return lines
+
+
+async def run(args) -> int:
+    script = load_script(args.script)
+    stats  = Stats()
+    rng    = random.Random(args.seed)
+
+    started = time.monotonic()
+    await asyncio.gather(*(session(n, script, args, stats,
+                                   random.Random(rng.random()))
+                           for n in range(args.sessions)))
+    elapsed = time.monotonic() - started
+
+    result = {
+        'sessions':    args.sessions,
+        'seconds':     round(elapsed, 2),
+        'commands':    stats.commands,
+        'created':     stats.created,
+        'peak':        stats.peak,
+        'latency_ms':  summary(stats.latency),
+        'login_ms':    summary(stats.login),
+        'disconnects': stats.disconnects,
+        'refused':     stats.refused,
+        'failed':      stats.failed,
+        'timeouts':    stats.timeouts,
+        'deaths':      stats.deaths,
+        'gmcp':        stats.gmcp,
+        'bytes_in':    stats.bytes_in,
+        'errors':      stats.errors,
+    }
+
+    if args.json:
+        print(json.dumps(result))
+    else:
+        lat = result['latency_ms']
+        print(f'{args.sessions} sessions ({stats.peak} at once) for '
+              f'{elapsed:.1f} s, {stats.commands} commands, '
+              f'{stats.created} characters created')
+        if lat['count']:
+            print(f'  latency ms   p50 {lat["p50"]}  p90 {lat["p90"]}  '
+                  f'p99 {lat["p99"]}  p99.9 {lat["p999"]}  max {lat["max"]}')
+        log = result['login_ms']
+        if log['count']:
+            print(f'  login ms     p50 {log["p50"]}  p90 {log["p90"]}  '
+                  f'p99 {log["p99"]}  max {log["max"]}')
+        print(f'  disconnects {stats.disconnects}  refused {stats.refused}  '
+              f'failed {stats.failed}  timeouts {stats.timeouts}  '
+              f'deaths {stats.deaths}')
+        for reason, count in sorted(stats.errors.items()):
+            print(f'    {count:6d}  {reason}')
+
+    bad = stats.disconnects + stats.refused + stats.failed + stats.timeouts
+    return 0 if bad == 0 else 1
+
+
+# ---------------------------------------------------------------------------
+# Entry point
+# ---------------------------------------------------------------------------
+
+def main():
+    p = argparse.ArgumentParser(
+        description='Connection load generator for NewCirMUD',
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--host',     default='127.0.0.1',
+                   help='MUD hostname or IP (default: 127.0.0.1)')
+    p.add_argument('--port',     default=4000, type=int,
+                   help='MUD port (default: 4000)')
+    p.add_argument('--sessions', default=100, type=int,
+                   help='Concurrent sessions (default: 100)')
+    p.add_argument('--ramp',     default=10.0, type=float,
+                   help='Spread the connects over this many seconds (default: 10)')
+    p.add_argument('--duration', default=60.0, type=float,
+                   help='How long each session plays, in seconds (default: 60)')
+    p.add_argument('--think',    default=2.0, type=float,
+                   help='Mean pause between commands in seconds (default: 2.0)')
+    p.add_argument('--script',   default='mixed',
+                   help='walk, combat, chat, mixed or a file of commands (default: mixed)')
+    p.add_argument('--prefix',   default='Load',
+                   help='Start of every character name (default: Load)')
+    p.add_argument('--password', default='loadtest',
+                   help='Password for the characters (default: loadtest)')
+    p.add_argument('--gmcp',     action='store_true',
+                   help='Accept GMCP (refused by default)')
+    p.add_argument('--timeout',  default=30.0, type=float,
+                   help='Seconds to wait for a prompt (default: 30)')
+    p.add_argument('--seed',     default=1, type=int,
+                   help='Seed for the think-time jitter (default: 1)')
+    p.add_argument('--json',     action='store_true',
+                   help='Print the results as one JSON line')
+    args = p.parse_args()
+
+    if not args.prefix.isalpha() or len(args.prefix) > 16:
+        p.error('--prefix must be letters only, at most 16 of them')
+    if args.sessions < 1:
+        p.error('--sessions must be at least 1')
+    if args.sessions > 26 ** 4:
+        p.error(f'--sessions can be at most {26 ** 4}')
+    try:
+        load_script(args.script)
+    except (OSError, ValueError) as e:
+        p.error(str(e))
+
+    sys.exit(asyncio.run(run(args)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+unit-tests/webolc.py — web OLC read-path checks for NewCirMUD
+==============================================================
+
+REQUIREMENTS
+    The MUD must be running with the web server (built with libcivetweb).
+    The login character must already exist and be able to use redit,
+    medit and oedit on the zone given by --zone (an implementor can).
+
+USAGE
+    python3 unit-tests/webolc.py --user NAME --password PASS [options]
+
+OPTIONS
+    --host HOST       MUD hostname or IP                  (default: 127.0.0.1)
+    --port PORT       MUD telnet port                     (default: 4000)
+    --web-port PORT   Web OLC port                        (default: 4445)
+    --user NAME       Character name to log in as         (required)
+    --password PASS   Character password                  (required)
+    --zone N          Zone to make the new prototypes in  (default: 0)
+    --timeout SECS    How long to wait for the MUD        (default: 5.0)
+
+WHAT IS CHECKED
+    OLC puts a prototype made after boot at the end of world[], mob_proto[]
+    or obj_proto[], whatever its vnum.  For each of rooms, mobs and objects
+    this picks the lowest vnum in --zone that does not exist yet, makes it
+    with redit/medit/oedit over telnet, leaves the editor (which saves it)
+    and then expects:
+
+    get           GET /olc/<kind>/<vnum> returns it.
+    bulk          GET /olc/bulk?from=..&to=.. over the zone includes it,
+                  and lists every vnum once, in order.
+    boot          Prototypes loaded at boot with higher vnums are still
+                  found by GET.
+
+    Each run uses up the vnums it makes; they are saved to world/*/*edit.*
+    like any other OLC work.
+
+EXAMPLES
+    python3 unit-tests/webolc.py --port 4000 --user Builder --password secret
+"""
+
+import argparse
+import json
+import re
+import socket
+import sys
+import time
+import urllib.error
+import urllib.request
+
+IAC  = 0xFF
+SE   = 0xF0
+SB   = 0xFA
+WILL = 0xFB
+DONT = 0xFE
+
+KINDS = [
+    # (url part, bulk key, telnet editor)
+    ('room', 'rooms', 'redit'),
+    ('mob',  'mobs',  'medit'),
+    ('obj',  'objs',  'oedit'),
+]
+
+
+# ---------------------------------------------------------------------------
+# Telnet
+# ---------------------------------------------------------------------------
+
+class Telnet:
+    """Just enough telnet to log in and type commands; options are ignored."""
+
+    def __init__(self, host: str, port: int, timeout: float):
+        self.s = socket.create_connection((host, port), timeout=timeout)
+        self.timeout = timeout
+        self.text = ''
+
+    def _recv(self):
+        data = self.s.recv(4096)
+        if not data:
+            raise RuntimeError('MUD closed the connection')
+        out, i = bytearray(), 0
+        while i < len(data):
+            if data[i] != IAC:
+                out.append(data[i])
+                i += 1
+            elif i + 1 < len(data) and data[i + 1] == SB:
+                end = data.find(bytes((IAC, SE)), i)
+                i = len(data) if end < 0 else end + 2
+            elif i + 1 < len(data) and WILL <= data[i + 1] <= DONT:
+                i += 3
+            else:
+                i += 2
+        self.text += out.decode('latin-1')
+
+    def expect(self, pattern: str, timeout: float = None) -> str:
+        deadline = time.monotonic() + (timeout or self.timeout)
+        while True:
+            m = re.search(pattern, self.text, re.I)
+            if m:
+                seen, self.text = self.text[:m.end()], self.text[m.end():]
+                return seen
+            left = deadline - time.monotonic()
+            if left <= 0:
+                raise TimeoutError(f'no {pattern!r} from the MUD; last: {self.text[-200:]!r}')
+            self.s.settimeout(left)
+            try:
+                self._recv()
+            except socket.timeout:
+                pass
+
+    def send(self, line: str):
+        self.s.sendall(line.encode('latin-1') + b'\r\n')
+
+    def close(self):
+        self.s.close()
+
+
+def login(t: Telnet, user: str, password: str):
+    t.expect('known\\?')
+    t.send(user)
+    t.expect('assword')
+    t.send(password)
+    while True:
+        seen = t.expect('(press return|make your choice|reconnecting)', timeout=15).lower()
+        if seen.endswith('press return'):
+            t.send('')
+            continue
+        if seen.endswith('make your choice'):
+            t.send('1')
+        t.expect('> ')
+        return
+
+
+# ---------------------------------------------------------------------------
+# HTTP
+# ---------------------------------------------------------------------------
+
+class WebOLC:
+    def __init__(self, host: str, port: int, timeout: float):
+        self.base = f'http://{host}:{port}'
+        self.timeout = timeout
+        self.token = None
+
+    def request(self, method: str, path: str, body=None):
+        data = json.dumps(body).encode() if body is not None else None
+        req = urllib.request.Request(self.base + path, data=data, method=method)
+        if data is not None:
+            req.add_header('Content-Type', 'application/json')
+        if self.token:
+            req.add_header('Authorization', 'Bearer ' + self.token)
+        try:
+            with urllib.request.urlopen(req, timeout=self.timeout) as r:
+                return r.status, json.loads(r.read() or b'null')
+        except urllib.error.HTTPError as e:
+            return e.code, None
+
+    def get(self, path: str, want=(200, 404)):
+        """GET, waiting out the 503 before the first snapshot is made."""
+        deadline = time.monotonic() + self.timeout
+        while True:
+            status, doc = self.request('GET', path)
+            if status in want or time.monotonic() > deadline:
+                return status, doc
+            time.sleep(0.1)
+
+
+# ---------------------------------------------------------------------------
+# Tests
+# ---------------------------------------------------------------------------
+
+def run(args) -> int:
+    web = WebOLC(args.host, args.web_port, args.timeout)
+    status, doc = web.request('POST', '/olc/login',
+                              {'name': args.user, 'password': args.password})
+    if status != 200:
+        print(f'Setup failed: POST /olc/login returned {status}')
+        return 1
+    web.token = doc['token']
+
+    status, zone = web.get(f'/olc/zone/{args.zone}', want=(200, 403, 404))
+    if status != 200:
+        print(f'Setup failed: GET /olc/zone/{args.zone} returned {status}')
+        return 1
+    lo, hi = zone['bot'], zone['top']
+
+    status, before = web.get(f'/olc/bulk?from={lo}&to={hi}')
+    if status != 200:
+        print(f'Setup failed: bulk GET returned {status}')
+        return 1
+
+    t = Telnet(args.host, args.port, args.timeout)
+    login(t, args.user, args.password)
+
+    results = []
+
+    def check(name, cond, msg):
+        results.append(cond)
+        print(f'  {"PASS" if cond else "FAIL"}    {name}' + ('' if cond else f'  —  {msg}'),
+              flush=True)
+
+    for kind, key, editor in KINDS:
+        have = {p['vnum'] for p in before[key]}
+        vnum = next((v for v in range(max(lo, 1), hi + 1) if v not in have), None)
+        if vnum is None:
+            print(f'  SKIP    {kind}  —  zone {args.zone} has no free {kind} vnum')
+            continue
+        # Everything loaded at boot above it must still be found as well.
+        boot = sorted(v for v in have if v > vnum)
+
+        t.send(f'{editor} {vnum}')
+        t.expect('Enter Choice')
+        t.send('.')
+        t.expect('> ')
+
+        status, doc = web.get(f'/olc/{kind}/{vnum}')
+        check(f'{kind}_get', status == 200 and doc and doc.get('vnum') == vnum,
+              f'GET /olc/{kind}/{vnum} returned {status}')
+
+        status, bulk = web.get(f'/olc/bulk?from={lo}&to={hi}')
+        got = [p['vnum'] for p in bulk[key]] if status == 200 else []
+        check(f'{kind}_bulk', vnum in got and got == sorted(set(got)),
+              f'bulk {key} returned {status}, vnums {got}')
+
+        missing = [v for v in boot if web.get(f'/olc/{kind}/{v}')[0] != 200]
+        check(f'{kind}_boot', not missing, f'GET lost boot-time vnums {missing}')
+
+    t.send('quit')
+    t.close()
+    web.request('POST', '/olc/logout')
+
+    print(f'\n{sum(results)}/{len(results)} passed')
+    return 0 if all(results) else 1
+
+
+# ---------------------------------------------------------------------------
+# Entry point
+# ---------------------------------------------------------------------------
+
+def main():
+    p = argparse.ArgumentParser(
+        description='Web OLC read-path checks for NewCirMUD',
+        formatter_class=argparse.RawDescriptionHelpFormatter)
+    p.add_argument('--host',     default='127.0.0.1',
+                   help='MUD hostname or IP (default: 127.0.0.1)')
+    p.add_argument('--port',     default=4000, type=int,
+                   help='MUD telnet port (default: 4000)')
+    p.add_argument('--web-port', default=4445, type=int,
+                   help='Web OLC port (default: 4445)')
+    p.add_argument('--user',     required=True,
+                   help='Character name to log in as')
+    p.add_argument('--password', required=True,
+                   help='Character password')
+    p.add_argument('--zone',     default=0, type=int,
+                   help='Zone to make the new prototypes in (default: 0)')
+    p.add_argument('--timeout',  default=5.0, type=float,
+                   help='How long to wait for the MUD in seconds (default: 5.0)')
+    sys.exit(run(p.parse_args()))
+
+
+if __name__ == '__main__':
+    main()